@@ -0,0 +1,967 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file almanac.c
+*** \brief Headless almanac generator.
+*** \details Writes phase, rise/set and position tables for a date range
+***   and a list of sites, as CSV or binary (see almanac.h). The range is
+***   processed in blocks of days; within a block the sites (rise/set) or
+***   the sample times (positions) are spread over all cores when built
+***   with OpenMP, and the block is written in order once complete.
+***   Usage: moonphase-almanac [options] first-date last-date sites-file
+**/
+
+
+/** Identifier for almanac.c. **/
+#define   ALMANAC_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "almanac.h"
+
+#include  "calcephem.h"
+#include  "daynumber.h"
+#include  "errorcode.h"
+#include  "file.h"
+#include  "moonevent.h"
+
+#include  <math.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+#ifdef    _OPENMP
+#include  <omp.h>
+#endif    /* _OPENMP */
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Default interval.
+*** \details Default position interval (in minutes).
+**/
+#define   DEFAULT_INTERVAL    (60)
+
+/**
+*** \brief Default prefix.
+*** \details Default output pathname prefix.
+**/
+#define   DEFAULT_PREFIX      "almanac"
+
+/**
+*** \brief Site name size.
+*** \details Maximum site name length plus one.
+**/
+#define   SITE_NAMESIZE       (64)
+
+/**
+*** \brief Block records.
+*** \details Rough number of position records computed per block, which
+***   bounds the memory used whatever the site count.
+**/
+#define   BLOCK_RECORDS       (1L<<20)
+
+/**
+*** \brief Maximum block days.
+*** \details Maximum number of days per block.
+**/
+#define   BLOCK_MAXDAYS       (366)
+
+/**
+*** \brief Delta T.
+*** \details TDT minus UT (in seconds), as used by calcephem.c.
+**/
+#define   DELTAT              (59.0)
+
+/**
+*** \brief Table mask.
+*** \details Mask bit of a table (ALMANACTABLE_E).
+**/
+#define   TABLE_MASK(t)       (1<<(t))
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Site.
+*** \details One observer of the site list.
+**/
+typedef struct structSITE
+{
+  /**
+  *** \brief Name.
+  *** \details Site name.
+  **/
+  char pName[SITE_NAMESIZE];
+  /**
+  *** \brief Observer.
+  *** \details Observer (longitude west positive, time zone in hours to add
+  ***   to local time to get UT).
+  **/
+  EphemContext Context;
+} SITE_T;
+
+/**
+*** \brief Options.
+*** \details Command line options.
+**/
+typedef struct structOPTIONS
+{
+  /**
+  *** \brief First day.
+  *** \details Day number of the first date.
+  **/
+  long FirstDay;
+  /**
+  *** \brief Last day.
+  *** \details Day number of the last date (included).
+  **/
+  long LastDay;
+  /**
+  *** \brief Tables.
+  *** \details Tables to write (TABLE_MASK() bits).
+  **/
+  int Tables;
+  /**
+  *** \brief Interval.
+  *** \details Position interval (in minutes, divides a day).
+  **/
+  int Interval;
+  /**
+  *** \brief Binary flag.
+  *** \details Non-zero to write binary tables, zero for CSV.
+  **/
+  int BinaryFlag;
+  /**
+  *** \brief Accuracy tier.
+  *** \details Accuracy tier of the positions (EPHEMTIER_*).
+  **/
+  int Tier;
+  /**
+  *** \brief Thread count.
+  *** \details Number of threads, 0 for all cores.
+  **/
+  int ThreadCount;
+  /**
+  *** \brief Prefix.
+  *** \details Output pathname prefix.
+  **/
+  char const *pPrefix;
+  /**
+  *** \brief Sites pathname.
+  *** \details Pathname of the site list.
+  **/
+  char const *pSitesPathname;
+} OPTIONS_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static void Usage(char const *pProgram);
+static int ParseDate(char const *pText,long *pDayNumber);
+static int ParseOptions(int ArgC,char *ppArgV[],OPTIONS_T *pOptions);
+static ERRORCODE_T ReadSites(char const *pPathname,
+    SITE_T **ppSites,int *pCount);
+static FILE *OpenTable(OPTIONS_T const *pOptions,int Table,int SiteCount);
+static void FormatTime(double JD,char *pBuffer);
+static void FormatHour(double Hour,char *pBuffer);
+static int WritePhases(OPTIONS_T const *pOptions,long *pRecordCount);
+static int WriteTables(OPTIONS_T const *pOptions,
+    SITE_T const *pSites,int SiteCount,long *pRecordCount);
+static double Seconds(void);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Table names.
+*** \details Command line and file names of the tables.
+**/
+static char const *f_ppTableNames[ALMANACTABLE_COUNT]=
+    { "phases","riseset","positions" };
+
+/**
+*** \brief Phase names.
+*** \details CSV names of the principal phases.
+**/
+static char const *f_ppPhaseNames[4]=
+    { "new moon","first quarter","full moon","last quarter" };
+
+/**
+*** \brief Tier names.
+*** \details Command line names of the accuracy tiers.
+**/
+static char const *f_ppTierNames[EPHEMTIER_COUNT]=
+    { "icon","display","precise" };
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Prints the usage.
+*** \details Prints the command line syntax to stderr.
+*** \param pProgram Program name.
+**/
+static void Usage(char const *pProgram)
+{
+  fprintf(stderr,
+      "Usage: %s [options] first-date last-date sites-file\n"
+      "Dates are YYYY-MM-DD (both included). Each line of the sites file is\n"
+      "  name,latitude,longitude[,utc-offset]\n"
+      "in degrees (north and east positive) and hours (east positive, fixed\n"
+      "for the whole range). Empty lines and lines starting with # are\n"
+      "ignored.\n"
+      "Options:\n"
+      "  -t tables    comma separated list of phases, riseset, positions\n"
+      "               (default all)\n"
+      "  -i minutes   position interval, must divide a day (default %d)\n"
+      "  -a tier      position accuracy: icon, display or precise (default\n"
+      "               precise)\n"
+      "  -b           write binary tables (see almanac.h) instead of CSV\n"
+      "  -o prefix    output pathname prefix (default \"%s\"); tables go to\n"
+      "               prefix-phases.csv, prefix-riseset.csv, ...\n"
+      "  -j threads   number of threads (default all cores)\n",
+      pProgram,DEFAULT_INTERVAL,DEFAULT_PREFIX);
+  return;
+}
+
+/**
+*** \brief Parses a date.
+*** \details Converts a YYYY-MM-DD date to a day number.
+*** \param pText Date.
+*** \param pDayNumber Storage for the day number.
+*** \retval 0 Success.
+*** \retval 1 Invalid date.
+**/
+static int ParseDate(char const *pText,long *pDayNumber)
+{
+  int Year;
+  int Month;
+  int Day;
+  int CheckYear;
+  int CheckMonth;
+  int CheckDay;
+
+
+  if (sscanf(pText,"%d-%d-%d",&Year,&Month,&Day)!=3)
+    return(1);
+  *pDayNumber=DayNumber_FromDate(Year,Month,Day);
+
+  /* Reject dates that do not exist (e.g. 2015-02-30). */
+  DayNumber_ToDate(*pDayNumber,&CheckYear,&CheckMonth,&CheckDay);
+  if ( (CheckYear!=Year) || (CheckMonth!=Month) || (CheckDay!=Day) )
+    return(1);
+
+  return(0);
+}
+
+/**
+*** \brief Parses the command line.
+*** \details Fills in the options from the command line.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \param pOptions Storage for the options.
+*** \retval 0 Success.
+*** \retval 1 Invalid command line (the usage has been printed).
+**/
+static int ParseOptions(int ArgC,char *ppArgV[],OPTIONS_T *pOptions)
+{
+  int Index;
+  int PositionalCount;
+  int ErrorFlag;
+  int Table;
+  char const *pName;
+  size_t Length;
+
+
+  memset(pOptions,0,sizeof(*pOptions));
+  pOptions->Tables=TABLE_MASK(ALMANACTABLE_COUNT)-1;
+  pOptions->Interval=DEFAULT_INTERVAL;
+  pOptions->Tier=EPHEMTIER_PRECISE;
+  pOptions->pPrefix=DEFAULT_PREFIX;
+
+  PositionalCount=0;
+  ErrorFlag=0;
+  for(Index=1;(Index<ArgC) && (ErrorFlag==0);Index++)
+  {
+    if ( (ppArgV[Index][0]!='-') || (ppArgV[Index][1]==0) )
+    {
+      switch(PositionalCount++)
+      {
+        case 0:
+          ErrorFlag=ParseDate(ppArgV[Index],&pOptions->FirstDay);
+          break;
+        case 1:
+          ErrorFlag=ParseDate(ppArgV[Index],&pOptions->LastDay);
+          break;
+        case 2:
+          pOptions->pSitesPathname=ppArgV[Index];
+          break;
+        default:
+          ErrorFlag=1;
+          break;
+      }
+    }
+    else if (strcmp(ppArgV[Index],"-b")==0)
+      pOptions->BinaryFlag=1;
+    else if ( (ppArgV[Index][2]!=0) || (Index+1>=ArgC) )
+      ErrorFlag=1;
+    else
+    {
+      /* The other options take a value. */
+      Index++;
+      switch(ppArgV[Index-1][1])
+      {
+        case 't':
+          pOptions->Tables=0;
+          for(pName=ppArgV[Index];(*pName!=0) && (ErrorFlag==0);
+              pName+=Length+(pName[Length]==','))
+          {
+            Length=strcspn(pName,",");
+            for(Table=0;Table<ALMANACTABLE_COUNT;Table++)
+              if ( (strlen(f_ppTableNames[Table])==Length) &&
+                  (strncmp(pName,f_ppTableNames[Table],Length)==0) )
+                break;
+            if (Table==ALMANACTABLE_COUNT)
+              ErrorFlag=1;
+            else
+              pOptions->Tables|=TABLE_MASK(Table);
+          }
+          if (pOptions->Tables==0)
+            ErrorFlag=1;
+          break;
+        case 'i':
+          pOptions->Interval=atoi(ppArgV[Index]);
+          if ( (pOptions->Interval<=0) || (1440%pOptions->Interval!=0) )
+            ErrorFlag=1;
+          break;
+        case 'a':
+          for(pOptions->Tier=0;pOptions->Tier<EPHEMTIER_COUNT;
+              pOptions->Tier++)
+            if (strcmp(ppArgV[Index],f_ppTierNames[pOptions->Tier])==0)
+              break;
+          if (pOptions->Tier==EPHEMTIER_COUNT)
+            ErrorFlag=1;
+          break;
+        case 'o':
+          pOptions->pPrefix=ppArgV[Index];
+          break;
+        case 'j':
+          pOptions->ThreadCount=atoi(ppArgV[Index]);
+          if (pOptions->ThreadCount<=0)
+            ErrorFlag=1;
+          break;
+        default:
+          ErrorFlag=1;
+          break;
+      }
+    }
+  }
+
+  if ( (ErrorFlag!=0) || (PositionalCount!=3) ||
+      (pOptions->LastDay<pOptions->FirstDay) )
+  {
+    Usage(ppArgV[0]);
+    return(1);
+  }
+
+  return(0);
+}
+
+/**
+*** \brief Reads the site list.
+*** \details Reads and parses the sites file.
+*** \param pPathname Pathname of the sites file.
+*** \param ppSites Storage for a pointer to the sites. The caller must
+***   free() it.
+*** \param pCount Storage for the number of sites.
+*** \retval >0 Success.
+*** \retval <0 Failure (a message has been printed).
+**/
+static ERRORCODE_T ReadSites(char const *pPathname,
+    SITE_T **ppSites,int *pCount)
+{
+  ERRORCODE_T ErrorCode;
+  FILE_T File;
+  char *pText;
+  char *pLine;
+  char *pNext;
+  char *pComma;
+  SITE_T *pSites;
+  int Count;
+  int LineNumber;
+  double Latitude;
+  double Longitude;
+  double Offset;
+  int FieldCount;
+
+
+  *ppSites=NULL;
+  *pCount=0;
+  pText=NULL;
+  ErrorCode=File_Initialize(&File);
+  if (ErrorCode>=0)
+    ErrorCode=File_SetPathname(&File,pPathname);
+  if (ErrorCode>=0)
+    ErrorCode=File_ReadText(&File,&pText);
+  File_Uninitialize(&File);
+  if (ErrorCode<0)
+  {
+    fprintf(stderr,"Unable to read \"%s\".\n",pPathname);
+    return(ErrorCode);
+  }
+
+  /* One site per line at most. */
+  Count=1;
+  for(pLine=pText;*pLine!=0;pLine++)
+    Count+=(*pLine=='\n');
+  pSites=(SITE_T *)malloc(Count*sizeof(*pSites));
+  if (pSites==NULL)
+  {
+    fprintf(stderr,"Out of memory.\n");
+    free(pText);
+    return(ERRORCODE_OUTOFMEMORY);
+  }
+
+  Count=0;
+  LineNumber=0;
+  ErrorCode=ERRORCODE_SUCCESS;
+  for(pLine=pText;(pLine!=NULL) && (*pLine!=0);pLine=pNext)
+  {
+    LineNumber++;
+    pNext=strchr(pLine,'\n');
+    if (pNext!=NULL)
+      *pNext++=0;
+    pLine+=strspn(pLine," \t\r");
+    if ( (*pLine==0) || (*pLine=='#') )
+      continue;
+
+    pComma=strchr(pLine,',');
+    Offset=0.0;
+    FieldCount=(pComma==NULL) ? 0 :
+        sscanf(pComma+1,"%lf,%lf,%lf",&Latitude,&Longitude,&Offset);
+    if ( (FieldCount<2) || (pComma-pLine>=SITE_NAMESIZE) ||
+        (fabs(Latitude)>90.0) || (fabs(Offset)>14.0) )
+    {
+      fprintf(stderr,"%s:%d: invalid site.\n",pPathname,LineNumber);
+      ErrorCode=ERRORCODE_INVALIDDATA;
+      break;
+    }
+
+    memcpy(pSites[Count].pName,pLine,pComma-pLine);
+    pSites[Count].pName[pComma-pLine]=0;
+    EphemContext_Set(&pSites[Count].Context,Latitude,-Longitude,-Offset);
+    Count++;
+  }
+  free(pText);
+
+  if ( (ErrorCode>=0) && (Count==0) )
+  {
+    fprintf(stderr,"%s: no sites.\n",pPathname);
+    ErrorCode=ERRORCODE_INVALIDDATA;
+  }
+  if (ErrorCode<0)
+  {
+    free(pSites);
+    return(ErrorCode);
+  }
+
+  *ppSites=pSites;
+  *pCount=Count;
+  return(ERRORCODE_SUCCESS);
+}
+
+/**
+*** \brief Opens a table.
+*** \details Creates the output file of a table and writes its header (the
+***   binary header or the CSV column names).
+*** \param pOptions Options.
+*** \param Table Table (ALMANACTABLE_E).
+*** \param SiteCount Number of sites.
+*** \returns File, or NULL on failure (a message has been printed).
+**/
+static FILE *OpenTable(OPTIONS_T const *pOptions,int Table,int SiteCount)
+{
+  static char const *ppColumns[ALMANACTABLE_COUNT]=
+  {
+    "utc,phase\n",
+    "site,date,rise,set\n",
+    "site,utc,altitude,azimuth,ra,dec,distance,phase,age\n"
+  };
+  static int const pRecordSizes[ALMANACTABLE_COUNT]=
+  {
+    sizeof(ALMANACPHASE_T),
+    sizeof(ALMANACRISESET_T),
+    sizeof(ALMANACPOSITION_T)
+  };
+  char *pPathname;
+  FILE *pFile;
+  ALMANACHEADER_T Header;
+  int Success;
+
+
+  pPathname=(char *)malloc(strlen(pOptions->pPrefix)+32);
+  if (pPathname==NULL)
+  {
+    fprintf(stderr,"Out of memory.\n");
+    return(NULL);
+  }
+  sprintf(pPathname,"%s-%s.%s",pOptions->pPrefix,f_ppTableNames[Table],
+      (pOptions->BinaryFlag!=0) ? "bin" : "csv");
+
+  pFile=fopen(pPathname,(pOptions->BinaryFlag!=0) ? "wb" : "w");
+  if (pFile!=NULL)
+  {
+    if (pOptions->BinaryFlag!=0)
+    {
+      memset(&Header,0,sizeof(Header));
+      memcpy(Header.pMagic,ALMANAC_MAGIC,sizeof(Header.pMagic));
+      Header.Version=ALMANAC_VERSION;
+      Header.Table=Table;
+      Header.RecordSize=pRecordSizes[Table];
+      Header.SiteCount=(Table==ALMANACTABLE_PHASES) ? 0 : SiteCount;
+      Header.FirstDay=(int)pOptions->FirstDay;
+      Header.LastDay=(int)pOptions->LastDay;
+      Header.Interval=
+          (Table==ALMANACTABLE_POSITIONS) ? pOptions->Interval : 0;
+      Success=(fwrite(&Header,sizeof(Header),1,pFile)==1);
+    }
+    else
+      Success=(fputs(ppColumns[Table],pFile)>=0);
+    if (Success==0)
+    {
+      fclose(pFile);
+      pFile=NULL;
+    }
+  }
+  if (pFile==NULL)
+    fprintf(stderr,"Unable to write \"%s\".\n",pPathname);
+
+  free(pPathname);
+  return(pFile);
+}
+
+/**
+*** \brief Formats a time.
+*** \details Formats a Julian date as "YYYY-MM-DD hh:mm:ss" (to the nearest
+***   second).
+*** \param JD Julian date.
+*** \param pBuffer Storage for the text (at least 32 characters).
+**/
+static void FormatTime(double JD,char *pBuffer)
+{
+  long DayNumber;
+  long Second;
+  int Year;
+  int Month;
+  int Day;
+
+
+  DayNumber=(long)floor(JD+0.5);
+  Second=(long)floor((JD+0.5-DayNumber)*86400.0+0.5);
+  if (Second>=86400)
+  {
+    DayNumber++;
+    Second-=86400;
+  }
+  DayNumber_ToDate(DayNumber,&Year,&Month,&Day);
+  sprintf(pBuffer,"%04d-%02d-%02d %02ld:%02ld:%02ld",Year,Month,Day,
+      Second/3600,Second/60%60,Second%60);
+  return;
+}
+
+/**
+*** \brief Formats an hour.
+*** \details Formats a rise/set time as "hh:mm" (to the nearest minute), or
+***   as nothing if there is no event.
+*** \param Hour Time (in hours), or a negative value.
+*** \param pBuffer Storage for the text (at least 16 characters).
+**/
+static void FormatHour(double Hour,char *pBuffer)
+{
+  int Minute;
+
+
+  if (Hour<0.0)
+    *pBuffer=0;
+  else
+  {
+    Minute=(int)floor(Hour*60.0+0.5);
+    if (Minute>=1440)
+      Minute=1439;
+    sprintf(pBuffer,"%02d:%02d",Minute/60,Minute%60);
+  }
+  return;
+}
+
+/**
+*** \brief Writes the phase table.
+*** \details Finds the principal phases in the date range (UT days) and
+***   writes them.
+*** \param pOptions Options.
+*** \param pRecordCount Storage for the number of records written.
+*** \retval 0 Success.
+*** \retval 1 Failure (a message has been printed).
+**/
+static int WritePhases(OPTIONS_T const *pOptions,long *pRecordCount)
+{
+  FILE *pFile;
+  MOONEVENT_T *pEvents;
+  long EventCount;
+  long Index;
+  ALMANACPHASE_T Record;
+  char pTime[32];
+  int Success;
+
+
+  *pRecordCount=0;
+  if (MoonEvent_Find(
+      ((pOptions->FirstDay-0.5)+DELTAT/86400.0-2451545.0)/36525.0,
+      ((pOptions->LastDay+0.5)+DELTAT/86400.0-2451545.0)/36525.0,
+      MOONEVENT_MASK(MOONEVENTTYPE_NEWMOON)|
+      MOONEVENT_MASK(MOONEVENTTYPE_FIRSTQUARTER)|
+      MOONEVENT_MASK(MOONEVENTTYPE_FULLMOON)|
+      MOONEVENT_MASK(MOONEVENTTYPE_LASTQUARTER),&pEvents,&EventCount)<0)
+  {
+    fprintf(stderr,"MoonEvent_Find() failed.\n");
+    return(1);
+  }
+
+  pFile=OpenTable(pOptions,ALMANACTABLE_PHASES,0);
+  if (pFile==NULL)
+  {
+    free(pEvents);
+    return(1);
+  }
+
+  Success=1;
+  for(Index=0;(Index<EventCount) && (Success!=0);Index++)
+  {
+    Record.JD=pEvents[Index].T*36525.0+2451545.0-DELTAT/86400.0;
+    Record.Phase=pEvents[Index].Type;
+    Record.Reserved=0;
+    if (pOptions->BinaryFlag!=0)
+      Success=(fwrite(&Record,sizeof(Record),1,pFile)==1);
+    else
+    {
+      FormatTime(Record.JD,pTime);
+      Success=(fprintf(pFile,"%s,%s\n",pTime,
+          f_ppPhaseNames[Record.Phase])>0);
+    }
+  }
+  free(pEvents);
+
+  if ( (fclose(pFile)!=0) || (Success==0) )
+  {
+    fprintf(stderr,"Unable to write the %s table.\n",
+        f_ppTableNames[ALMANACTABLE_PHASES]);
+    return(1);
+  }
+
+  *pRecordCount=EventCount;
+  return(0);
+}
+
+/**
+*** \brief Writes the site tables.
+*** \details Computes and writes the rise/set and position tables, one
+***   block of days at a time.
+*** \param pOptions Options.
+*** \param pSites Sites.
+*** \param SiteCount Number of sites.
+*** \param pRecordCount Storage for the number of records written.
+*** \retval 0 Success.
+*** \retval 1 Failure (a message has been printed).
+**/
+static int WriteTables(OPTIONS_T const *pOptions,
+    SITE_T const *pSites,int SiteCount,long *pRecordCount)
+{
+  FILE *pRiseSetFile;
+  FILE *pPositionFile;
+  RiseSetRecord *pRiseSets;
+  EphemRecord *pPositions;
+  int SampleCount;
+  long BlockDays;
+  long FirstDay;
+  long DayCount;
+  long BlockSamples;
+  long Sample;
+  long Index;
+  int Site;
+  int Day;
+  int Year;
+  int Month;
+  int MonthDay;
+  double Rise;
+  double Set;
+  ALMANACRISESET_T RiseSet;
+  ALMANACPOSITION_T Position;
+  EphemGeocentric Geocentric;
+  char pRise[16];
+  char pSet[16];
+  char pTime[32];
+  int SetupFlag;
+  int Success;
+
+
+  *pRecordCount=0;
+  pRiseSetFile=NULL;
+  pPositionFile=NULL;
+  pRiseSets=NULL;
+  pPositions=NULL;
+  SampleCount=1440/pOptions->Interval;
+
+  /* Block length, so a block of positions stays around BLOCK_RECORDS. */
+  BlockDays=BLOCK_MAXDAYS;
+  if ((pOptions->Tables&TABLE_MASK(ALMANACTABLE_POSITIONS))!=0)
+  {
+    BlockDays=BLOCK_RECORDS/((long)SampleCount*SiteCount);
+    if (BlockDays<1)
+      BlockDays=1;
+    else if (BlockDays>BLOCK_MAXDAYS)
+      BlockDays=BLOCK_MAXDAYS;
+  }
+
+  Success=1;
+  if ((pOptions->Tables&TABLE_MASK(ALMANACTABLE_RISESET))!=0)
+  {
+    pRiseSetFile=OpenTable(pOptions,ALMANACTABLE_RISESET,SiteCount);
+    if (pRiseSetFile!=NULL)
+      pRiseSets=(RiseSetRecord *)
+          malloc((size_t)BlockDays*SiteCount*sizeof(*pRiseSets));
+    Success=(pRiseSets!=NULL);
+  }
+  if ( (Success!=0) &&
+      ((pOptions->Tables&TABLE_MASK(ALMANACTABLE_POSITIONS))!=0) )
+  {
+    pPositionFile=OpenTable(pOptions,ALMANACTABLE_POSITIONS,SiteCount);
+    if (pPositionFile!=NULL)
+      pPositions=(EphemRecord *)malloc(
+          (size_t)BlockDays*SampleCount*SiteCount*sizeof(*pPositions));
+    Success=(pPositions!=NULL);
+  }
+  SetupFlag=Success;
+
+  for(FirstDay=pOptions->FirstDay;
+      (Success!=0) && (FirstDay<=pOptions->LastDay);FirstDay+=BlockDays)
+  {
+    DayCount=pOptions->LastDay-FirstDay+1;
+    if (DayCount>BlockDays)
+      DayCount=BlockDays;
+    DayNumber_ToDate(FirstDay,&Year,&Month,&MonthDay);
+
+    if (pRiseSets!=NULL)
+    {
+      /* Each site is an independent run of days. */
+#ifdef    _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif    /* _OPENMP */
+      for(Site=0;Site<SiteCount;Site++)
+        MoonRiseRangeBuffer(Year,Month,MonthDay,(int)DayCount,
+            &pSites[Site].Context,&pRiseSets[(long)Site*DayCount]);
+
+      for(Day=0;(Day<DayCount) && (Success!=0);Day++)
+        for(Site=0;(Site<SiteCount) && (Success!=0);Site++)
+        {
+          Index=(long)Site*DayCount+Day;
+          Rise=pRiseSets[Index].UTRise;
+          Set=pRiseSets[Index].UTSet;
+          if (pOptions->BinaryFlag!=0)
+          {
+            RiseSet.Site=Site;
+            RiseSet.Date=(int)pRiseSets[Index].date;
+            RiseSet.Rise=(Rise<0.0) ? ALMANAC_NOEVENT : (float)Rise;
+            RiseSet.Set=(Set<0.0) ? ALMANAC_NOEVENT : (float)Set;
+            Success=(fwrite(&RiseSet,sizeof(RiseSet),1,pRiseSetFile)==1);
+          }
+          else
+          {
+            FormatHour(Rise,pRise);
+            FormatHour(Set,pSet);
+            Success=(fprintf(pRiseSetFile,"%s,%ld,%s,%s\n",
+                pSites[Site].pName,pRiseSets[Index].date,pRise,pSet)>0);
+          }
+        }
+      *pRecordCount+=DayCount*SiteCount;
+    }
+
+    if ( (Success!=0) && (pPositions!=NULL) )
+    {
+      /* The moon once per sample time, then the rotation for each site. */
+      BlockSamples=DayCount*SampleCount;
+#ifdef    _OPENMP
+#pragma omp parallel for schedule(dynamic) private(Geocentric,Site)
+#endif    /* _OPENMP */
+      for(Sample=0;Sample<BlockSamples;Sample++)
+      {
+        CalcEphemGeocentric(FirstDay-0.5+Sample*pOptions->Interval/1440.0,
+            pOptions->Tier,&Geocentric);
+        for(Site=0;Site<SiteCount;Site++)
+          EphemTopocentric(&Geocentric,&pSites[Site].Context,
+              &pPositions[Sample*SiteCount+Site]);
+      }
+
+      for(Index=0;(Index<BlockSamples*SiteCount) && (Success!=0);Index++)
+      {
+        Site=(int)(Index%SiteCount);
+        if (pOptions->BinaryFlag!=0)
+        {
+          Position.JD=pPositions[Index].JD;
+          Position.Site=Site;
+          Position.Altitude=(float)pPositions[Index].h_moon;
+          Position.Azimuth=(float)pPositions[Index].A_moon;
+          Position.RightAscension=(float)pPositions[Index].RA_moon;
+          Position.Declination=(float)pPositions[Index].DEC_moon;
+          Position.Distance=(float)pPositions[Index].EarthMoonDistance;
+          Position.Phase=(float)pPositions[Index].MoonPhase;
+          Position.Age=(float)pPositions[Index].MoonAge;
+          Success=(fwrite(&Position,sizeof(Position),1,pPositionFile)==1);
+        }
+        else
+        {
+          FormatTime(pPositions[Index].JD,pTime);
+          Success=(fprintf(pPositionFile,
+              "%s,%s,%.4f,%.4f,%.4f,%.4f,%.3f,%.5f,%.4f\n",
+              pSites[Site].pName,pTime,pPositions[Index].h_moon,
+              pPositions[Index].A_moon,pPositions[Index].RA_moon,
+              pPositions[Index].DEC_moon,
+              pPositions[Index].EarthMoonDistance,
+              pPositions[Index].MoonPhase,pPositions[Index].MoonAge)>0);
+        }
+      }
+      *pRecordCount+=BlockSamples*SiteCount;
+    }
+  }
+
+  if ( (pRiseSetFile!=NULL) && (fclose(pRiseSetFile)!=0) )
+    Success=0;
+  if ( (pPositionFile!=NULL) && (fclose(pPositionFile)!=0) )
+    Success=0;
+  free(pRiseSets);
+  free(pPositions);
+
+  if (Success==0)
+  {
+    if (SetupFlag==0)
+      fprintf(stderr,"Unable to set up the site tables.\n");
+    else
+      fprintf(stderr,"Unable to write the site tables.\n");
+    return(1);
+  }
+  return(0);
+}
+
+/**
+*** \brief Wall clock.
+*** \details Returns a wall clock time (in seconds). Without OpenMP the
+***   almanac runs on one core, so processor time serves.
+*** \returns Time (in seconds).
+**/
+static double Seconds(void)
+{
+#ifdef    _OPENMP
+  return(omp_get_wtime());
+#else     /* _OPENMP */
+  return((double)clock()/CLOCKS_PER_SEC);
+#endif    /* _OPENMP */
+}
+
+/**
+*** \brief Program entry.
+*** \details Generates the almanac.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  OPTIONS_T Options;
+  SITE_T *pSites;
+  int SiteCount;
+  long PhaseCount;
+  long SiteRecordCount;
+  double Start;
+  int Result;
+
+
+  if (ParseOptions(ArgC,ppArgV,&Options)!=0)
+    return(1);
+  if (ReadSites(Options.pSitesPathname,&pSites,&SiteCount)<0)
+    return(1);
+
+#ifdef    _OPENMP
+  if (Options.ThreadCount>0)
+    omp_set_num_threads(Options.ThreadCount);
+#endif    /* _OPENMP */
+
+  Start=Seconds();
+  PhaseCount=0;
+  SiteRecordCount=0;
+  Result=0;
+  if ((Options.Tables&TABLE_MASK(ALMANACTABLE_PHASES))!=0)
+    Result=WritePhases(&Options,&PhaseCount);
+  if ( (Result==0) && ((Options.Tables&
+      (TABLE_MASK(ALMANACTABLE_RISESET)|TABLE_MASK(ALMANACTABLE_POSITIONS)))!=0) )
+    Result=WriteTables(&Options,pSites,SiteCount,&SiteRecordCount);
+  free(pSites);
+
+  if (Result==0)
+    fprintf(stderr,"%d sites, %ld days, %ld records in %.3f seconds.\n",
+        SiteCount,Options.LastDay-Options.FirstDay+1,
+        PhaseCount+SiteRecordCount,Seconds()-Start);
+
+  return(Result);
+}
+
+
+#undef    ALMANAC_C
@@ -0,0 +1,277 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file almanac.h
+*** \brief Almanac binary tables.
+*** \details Layout of the binary tables written by moonphase-almanac. A
+***   table is an ALMANACHEADER_T followed by fixed size records up to the
+***   end of the file, in the byte order of the machine that wrote it.
+***   Rise/set records are ordered by date then site, position records by
+***   time then site.
+**/
+
+
+#ifndef   ALMANAC_H
+#define   ALMANAC_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Magic.
+*** \details First bytes of a binary table.
+**/
+#define   ALMANAC_MAGIC         "MPAL"
+
+/**
+*** \brief Version.
+*** \details Version of the binary table layout.
+**/
+#define   ALMANAC_VERSION       (1)
+
+/**
+*** \brief No event.
+*** \details Rise or set time of a day on which the moon does not rise
+***   (or set).
+**/
+#define   ALMANAC_NOEVENT       (-999.0f)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Tables.
+*** \details Tables the almanac can write.
+**/
+typedef enum enumALMANACTABLE
+{
+  /**
+  *** \brief Phases.
+  *** \details Times of the principal phases (ALMANACPHASE_T).
+  **/
+  ALMANACTABLE_PHASES=0,
+  /**
+  *** \brief Rise/set times.
+  *** \details Daily rise and set times per site (ALMANACRISESET_T).
+  **/
+  ALMANACTABLE_RISESET,
+  /**
+  *** \brief Positions.
+  *** \details Moon position per site at fixed intervals
+  ***   (ALMANACPOSITION_T).
+  **/
+  ALMANACTABLE_POSITIONS,
+  /**
+  *** \brief Table count.
+  *** \details Number of tables.
+  **/
+  ALMANACTABLE_COUNT
+} ALMANACTABLE_E;
+
+/**
+*** \brief Table header.
+*** \details Start of a binary table.
+**/
+typedef struct structALMANACHEADER
+{
+  /**
+  *** \brief Magic.
+  *** \details ALMANAC_MAGIC (not terminated).
+  **/
+  char pMagic[4];
+  /**
+  *** \brief Version.
+  *** \details ALMANAC_VERSION.
+  **/
+  int Version;
+  /**
+  *** \brief Table.
+  *** \details Table type (ALMANACTABLE_E).
+  **/
+  int Table;
+  /**
+  *** \brief Record size.
+  *** \details Size of one record (in bytes).
+  **/
+  int RecordSize;
+  /**
+  *** \brief Site count.
+  *** \details Number of sites (0 for the phase table).
+  **/
+  int SiteCount;
+  /**
+  *** \brief First day.
+  *** \details Day number (see daynumber.h) of the first date.
+  **/
+  int FirstDay;
+  /**
+  *** \brief Last day.
+  *** \details Day number of the last date (included).
+  **/
+  int LastDay;
+  /**
+  *** \brief Interval.
+  *** \details Position interval (in minutes), 0 for other tables.
+  **/
+  int Interval;
+} ALMANACHEADER_T;
+
+/**
+*** \brief Phase record.
+*** \details One principal phase.
+**/
+typedef struct structALMANACPHASE
+{
+  /**
+  *** \brief Time.
+  *** \details Julian date (UT).
+  **/
+  double JD;
+  /**
+  *** \brief Phase.
+  *** \details Phase (MOONEVENTTYPE_NEWMOON to MOONEVENTTYPE_LASTQUARTER,
+  ***   see moonevent.h).
+  **/
+  int Phase;
+  /**
+  *** \brief Reserved.
+  *** \details Padding, 0.
+  **/
+  int Reserved;
+} ALMANACPHASE_T;
+
+/**
+*** \brief Rise/set record.
+*** \details Rise and set times of one site on one day.
+**/
+typedef struct structALMANACRISESET
+{
+  /**
+  *** \brief Site.
+  *** \details Index of the site in the site list.
+  **/
+  int Site;
+  /**
+  *** \brief Date.
+  *** \details Local date (YYYYMMDD).
+  **/
+  int Date;
+  /**
+  *** \brief Rise.
+  *** \details Rise time (in local hours), or ALMANAC_NOEVENT.
+  **/
+  float Rise;
+  /**
+  *** \brief Set.
+  *** \details Set time (in local hours), or ALMANAC_NOEVENT.
+  **/
+  float Set;
+} ALMANACRISESET_T;
+
+/**
+*** \brief Position record.
+*** \details The moon as seen from one site at one time.
+**/
+typedef struct structALMANACPOSITION
+{
+  /**
+  *** \brief Time.
+  *** \details Julian date (UT).
+  **/
+  double JD;
+  /**
+  *** \brief Site.
+  *** \details Index of the site in the site list.
+  **/
+  int Site;
+  /**
+  *** \brief Altitude.
+  *** \details Altitude (in degrees).
+  **/
+  float Altitude;
+  /**
+  *** \brief Azimuth.
+  *** \details Azimuth (in degrees, as in CTrans).
+  **/
+  float Azimuth;
+  /**
+  *** \brief Right ascension.
+  *** \details Right ascension (in degrees).
+  **/
+  float RightAscension;
+  /**
+  *** \brief Declination.
+  *** \details Declination (in degrees).
+  **/
+  float Declination;
+  /**
+  *** \brief Distance.
+  *** \details Earth-moon distance (in earth radii).
+  **/
+  float Distance;
+  /**
+  *** \brief Phase.
+  *** \details Phase (0-1).
+  **/
+  float Phase;
+  /**
+  *** \brief Age.
+  *** \details Age (in days).
+  **/
+  float Age;
+} ALMANACPOSITION_T;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+
+#endif    /* ALMANAC_H */
@@ -0,0 +1,879 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file benchmark.c
+*** \brief Engine and formatting microbenchmarks.
+*** \details Times the main entry points of the engine and of the text
+***   formatting with fixed inputs, and reports the mean time per
+***   operation, the allocations per operation, the Moon() evaluations of
+***   the phase solver per operation and percentiles of the time per
+***   operation, as text or JSON. Each benchmark is timed as a number of
+***   samples of a fixed batch of operations, after a warm up that sizes the
+***   batch. Allocations are counted on glibc only (by wrapping malloc()).
+***   Usage: moonphase-bench [-t seconds] [-o file] [benchmark ...]
+**/
+
+
+/** Identifier for benchmark.c. **/
+#define   BENCHMARK_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "information.h"
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+#ifdef    _WIN32
+#include  <windows.h>
+#endif    /* _WIN32 */
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Default time.
+*** \details Default time per benchmark (in seconds).
+**/
+#define   DEFAULT_SECONDS     (0.5)
+
+/**
+*** \brief Sample count.
+*** \details Number of timed samples per benchmark.
+**/
+#define   SAMPLE_COUNT        (1000)
+
+/**
+*** \brief Warm up time.
+*** \details Least time spent sizing the batch (in nanoseconds).
+**/
+#define   WARMUP_NS           (10e6)
+
+/**
+*** \brief Input count.
+*** \details Number of distinct inputs the benchmarks cycle through.
+**/
+#define   INPUT_COUNT         (1000)
+
+/**
+*** \brief Base time.
+*** \details Time of the first input, 2015-06-15 0h UT (in seconds since
+***   1970-01-01).
+**/
+#define   BASE_UTC            (1434326400L)
+
+/**
+*** \brief Base date.
+*** \details Julian date of BASE_UTC.
+**/
+#define   BASE_JD             (2457188.5)
+
+/**
+*** \brief Base century.
+*** \details Julian centuries since J2000 of BASE_UTC.
+**/
+#define   BASE_T              ((BASE_JD-2451545.0)/36525.0)
+
+/**
+*** \brief Hour.
+*** \details One hour (in Julian centuries).
+**/
+#define   HOUR_T              (1.0/(24.0*36525.0))
+
+/**
+*** \brief Observer.
+*** \details Observer latitude and longitude (in degrees). The CalcEphem()
+***   and MoonRise() benchmarks use the default longitude (0).
+**/
+#define   LATITUDE            (51.48)
+#define   LONGITUDE           (0.0)
+
+/**
+*** \brief Date format.
+*** \details Date format printed (the first style of the application).
+**/
+#define   DATE_FORMAT         "%b. %d, %y"
+
+/**
+*** \brief Allocation counting.
+*** \details Defined if allocations are counted.
+**/
+#ifdef    __GLIBC__
+#define   COUNT_ALLOCATIONS
+#endif    /* __GLIBC__ */
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Benchmark.
+*** \details One timed operation.
+**/
+typedef struct structBENCHMARK
+{
+  /**
+  *** \brief Name.
+  *** \details Name of the benchmark (the function timed).
+  **/
+  char const *pName;
+  /**
+  *** \brief Operation.
+  *** \details Performs one operation, with the inputs selected by the
+  ***   iteration number.
+  **/
+  void (*pOperation)(long Iteration);
+} BENCHMARK_T;
+
+/**
+*** \brief Result.
+*** \details Measurements of one benchmark.
+**/
+typedef struct structRESULT
+{
+  /**
+  *** \brief Operation count.
+  *** \details Number of operations timed.
+  **/
+  long OperationCount;
+  /**
+  *** \brief Batch size.
+  *** \details Number of operations per sample.
+  **/
+  long BatchSize;
+  /**
+  *** \brief Mean.
+  *** \details Mean time per operation (in nanoseconds).
+  **/
+  double Mean;
+  /**
+  *** \brief Allocations.
+  *** \details Mean number of allocations per operation.
+  **/
+  double Allocations;
+  /**
+  *** \brief Evaluations.
+  *** \details Mean number of Moon() evaluations of MoonPhaseEvent() per
+  ***   operation (from the solver statistics hook).
+  **/
+  double Evaluations;
+  /**
+  *** \brief Percentiles.
+  *** \details Minimum, median, 90th, 99th percentile and maximum of the
+  ***   time per operation of the samples (in nanoseconds).
+  **/
+  double Minimum;
+  double P50;
+  double P90;
+  double P99;
+  double Maximum;
+} RESULT_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static void Usage(char const *pProgram);
+static double Nanoseconds(void);
+static unsigned long GetAllocationCount(void);
+static void CountEvaluations(int Evaluations,void *pData);
+static int CompareDoubles(void const *pA,void const *pB);
+static void Run(BENCHMARK_T const *pBenchmark,double Seconds,
+    RESULT_T *pResult);
+static int Setup(void);
+static void BenchCalcEphem(long Iteration);
+static void BenchMoon(long Iteration);
+static void BenchMiniMoon(long Iteration);
+static void BenchMoonPhaseEvent(long Iteration);
+static void BenchMoonRise(long Iteration);
+static void BenchMoonDataRecalculate(long Iteration);
+static void BenchInformationPrint(long Iteration);
+static void BenchDateTimePrint(long Iteration);
+static int WriteJSON(FILE *pFile,double Seconds,int const *pSelected,
+    RESULT_T const *pResults);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Benchmarks.
+*** \details All benchmarks, in the order they run.
+**/
+static BENCHMARK_T const f_pBenchmarks[]=
+{
+  { "CalcEphem", BenchCalcEphem },
+  { "Moon", BenchMoon },
+  { "MiniMoon", BenchMiniMoon },
+  { "MoonPhaseEvent", BenchMoonPhaseEvent },
+  { "MoonRise", BenchMoonRise },
+  { "MoonData_Recalculate", BenchMoonDataRecalculate },
+  { "Information_Print", BenchInformationPrint },
+  { "DateTime_Print", BenchDateTimePrint }
+};
+
+/**
+*** \brief Benchmark count.
+*** \details Number of benchmarks.
+**/
+#define   BENCHMARK_COUNT \
+              ((int)(sizeof(f_pBenchmarks)/sizeof(*f_pBenchmarks)))
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+/**
+*** \brief Allocation count.
+*** \details Number of malloc(), calloc() and realloc() calls so far.
+**/
+static unsigned long f_AllocationCount;
+
+/**
+*** \brief Evaluation count.
+*** \details Number of Moon() evaluations of MoonPhaseEvent() so far.
+**/
+static unsigned long f_EvaluationCount;
+
+/**
+*** \brief Sink.
+*** \details Results are stored here so the operations are not optimized
+***   away.
+**/
+static double volatile f_Sink;
+
+/**
+*** \brief Samples.
+*** \details Time per operation of each sample (in nanoseconds).
+**/
+static double f_pSamples[SAMPLE_COUNT];
+
+/**
+*** \brief Legacy API data.
+*** \details Coordinates filled in by CalcEphem().
+**/
+static CTrans f_CTrans;
+
+/**
+*** \brief Recalculated moon data.
+*** \details Moon data advanced by the MoonData_Recalculate() benchmark.
+**/
+static MOONDATA_T f_RecalculateData;
+
+/**
+*** \brief Printed moon data.
+*** \details Moon data at BASE_UTC, printed by the Information_Print()
+***   benchmark.
+**/
+static MOONDATA_T f_PrintData;
+
+/**
+*** \brief Print options.
+*** \details Options of the print benchmarks (the application defaults).
+**/
+static MOONDATAPRINTOPTIONS_T f_PrintOptions;
+
+/**
+*** \brief Information count.
+*** \details Number of information items.
+**/
+static int f_InformationCount;
+
+/**
+*** \brief Printed time.
+*** \details Time printed by the DateTime_Print() benchmark.
+**/
+static struct tm f_Time;
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+#ifdef    COUNT_ALLOCATIONS
+extern void *__libc_malloc(size_t Size);
+extern void *__libc_calloc(size_t Count,size_t Size);
+extern void *__libc_realloc(void *pMemory,size_t Size);
+extern void __libc_free(void *pMemory);
+
+/**
+*** \brief Counting allocator.
+*** \details glibc lets a program replace malloc() and friends (the C
+***   library uses the replacements too), so these count every allocation
+***   and hand it to the glibc allocator.
+**/
+void *malloc(size_t Size)
+{
+  __atomic_fetch_add(&f_AllocationCount,1,__ATOMIC_RELAXED);
+  return(__libc_malloc(Size));
+}
+
+void *calloc(size_t Count,size_t Size)
+{
+  __atomic_fetch_add(&f_AllocationCount,1,__ATOMIC_RELAXED);
+  return(__libc_calloc(Count,Size));
+}
+
+void *realloc(void *pMemory,size_t Size)
+{
+  __atomic_fetch_add(&f_AllocationCount,1,__ATOMIC_RELAXED);
+  return(__libc_realloc(pMemory,Size));
+}
+
+void free(void *pMemory)
+{
+  __libc_free(pMemory);
+  return;
+}
+#endif    /* COUNT_ALLOCATIONS */
+
+/**
+*** \brief Prints the usage.
+*** \details Prints the command line syntax to stderr.
+*** \param pProgram Program name.
+**/
+static void Usage(char const *pProgram)
+{
+  int Index;
+
+
+  fprintf(stderr,
+      "Usage: %s [-t seconds] [-o file] [benchmark ...]\n"
+      "Options:\n"
+      "  -t seconds   time per benchmark (default %g)\n"
+      "  -o file      write the results as JSON to the file (- for stdout)\n"
+      "Benchmarks (default all):\n",
+      pProgram,DEFAULT_SECONDS);
+  for(Index=0;Index<BENCHMARK_COUNT;Index++)
+    fprintf(stderr,"  %s\n",f_pBenchmarks[Index].pName);
+  return;
+}
+
+/**
+*** \brief Monotonic clock.
+*** \details Returns a monotonic time (in nanoseconds).
+*** \returns Time (in nanoseconds).
+**/
+static double Nanoseconds(void)
+{
+#ifndef   _WIN32
+  struct timespec Time;
+
+
+  clock_gettime(CLOCK_MONOTONIC,&Time);
+  return(Time.tv_sec*1e9+Time.tv_nsec);
+#else     /* _WIN32 */
+  LARGE_INTEGER Count;
+  LARGE_INTEGER Frequency;
+
+
+  QueryPerformanceCounter(&Count);
+  QueryPerformanceFrequency(&Frequency);
+  return((double)Count.QuadPart*1e9/Frequency.QuadPart);
+#endif    /* _WIN32 */
+}
+
+/**
+*** \brief Returns the allocation count.
+*** \details Returns the number of allocations so far (0 if they are not
+***   counted).
+*** \returns Allocation count.
+**/
+static unsigned long GetAllocationCount(void)
+{
+#ifdef    COUNT_ALLOCATIONS
+  return(__atomic_load_n(&f_AllocationCount,__ATOMIC_RELAXED));
+#else     /* COUNT_ALLOCATIONS */
+  return(0);
+#endif    /* COUNT_ALLOCATIONS */
+}
+
+/**
+*** \brief Counts solver evaluations.
+*** \details Phase solver statistics hook. The benchmarks run on one
+***   thread, so a plain increment is enough.
+*** \param Evaluations Moon() evaluations of one MoonPhaseEvent() call.
+*** \param pData Evaluation count.
+**/
+static void CountEvaluations(int Evaluations,void *pData)
+{
+  *(unsigned long *)pData+=Evaluations;
+  return;
+}
+
+/**
+*** \brief Compares two doubles.
+*** \details qsort() comparison function.
+*** \param pA First double.
+*** \param pB Second double.
+*** \retval <0 First is smaller.
+*** \retval 0 Equal.
+*** \retval >0 First is larger.
+**/
+static int CompareDoubles(void const *pA,void const *pB)
+{
+  double A;
+  double B;
+
+
+  A=*(double const *)pA;
+  B=*(double const *)pB;
+  return( (A>B)-(A<B) );
+}
+
+/**
+*** \brief Runs a benchmark.
+*** \details Warms up while doubling the batch until it takes WARMUP_NS,
+***   sizes the batch so the samples take Seconds in all, then times
+***   SAMPLE_COUNT batches.
+*** \param pBenchmark Benchmark.
+*** \param Seconds Time to spend on the samples (in seconds).
+*** \param pResult Storage for the result.
+**/
+static void Run(BENCHMARK_T const *pBenchmark,double Seconds,
+    RESULT_T *pResult)
+{
+  long Iteration;
+  long Batch;
+  long Count;
+  int Sample;
+  double Start;
+  double Elapsed;
+  double Total;
+  unsigned long Allocations;
+  unsigned long Evaluations;
+
+
+  /* Warm up, and estimate the time per operation. */
+  Iteration=0;
+  Batch=1;
+  do
+  {
+    Start=Nanoseconds();
+    for(Count=0;Count<Batch;Count++)
+      pBenchmark->pOperation(Iteration++);
+    Elapsed=Nanoseconds()-Start;
+    Batch*=2;
+  } while(Elapsed<WARMUP_NS);
+  Batch=(long)(Seconds*1e9/SAMPLE_COUNT/(Elapsed/(Batch/2)));
+  if (Batch<1)
+    Batch=1;
+
+  /* Time the samples. */
+  Total=0.0;
+  Allocations=GetAllocationCount();
+  Evaluations=f_EvaluationCount;
+  for(Sample=0;Sample<SAMPLE_COUNT;Sample++)
+  {
+    Start=Nanoseconds();
+    for(Count=0;Count<Batch;Count++)
+      pBenchmark->pOperation(Iteration++);
+    Elapsed=Nanoseconds()-Start;
+    Total+=Elapsed;
+    f_pSamples[Sample]=Elapsed/Batch;
+  }
+  Allocations=GetAllocationCount()-Allocations;
+  Evaluations=f_EvaluationCount-Evaluations;
+
+  qsort(f_pSamples,SAMPLE_COUNT,sizeof(*f_pSamples),CompareDoubles);
+  pResult->OperationCount=Batch*SAMPLE_COUNT;
+  pResult->BatchSize=Batch;
+  pResult->Mean=Total/pResult->OperationCount;
+  pResult->Allocations=(double)Allocations/pResult->OperationCount;
+  pResult->Evaluations=(double)Evaluations/pResult->OperationCount;
+  pResult->Minimum=f_pSamples[0];
+  pResult->P50=f_pSamples[SAMPLE_COUNT/2];
+  pResult->P90=f_pSamples[SAMPLE_COUNT*90/100];
+  pResult->P99=f_pSamples[SAMPLE_COUNT*99/100];
+  pResult->Maximum=f_pSamples[SAMPLE_COUNT-1];
+  return;
+}
+
+/**
+*** \brief Sets up the inputs.
+*** \details Fixes the time zone, installs the phase solver hook, and sets
+***   up the moon data and options.
+*** \retval 0 Success.
+*** \retval 1 Failure (a message has been printed).
+**/
+static int Setup(void)
+{
+  char const *pLabel;
+  time_t UTC;
+
+
+  /* Same results whatever the local time zone. */
+  putenv("TZ=UTC");
+  tzset();
+
+  /* Count the phase solver work of every benchmark. */
+  SetPhaseSolverHook(CountEvaluations,&f_EvaluationCount);
+
+  if ( (MoonData_Initialize(&f_RecalculateData)<0) ||
+      (MoonData_Initialize(&f_PrintData)<0) )
+  {
+    fprintf(stderr,"MoonData_Initialize() failed.\n");
+    return(1);
+  }
+  f_RecalculateData.CTransData.Glat=LATITUDE;
+  f_RecalculateData.CTransData.Glon=LONGITUDE;
+  f_RecalculateData.AccuracyTier=EPHEMTIER_PRECISE;
+  f_PrintData.CTransData.Glat=LATITUDE;
+  f_PrintData.CTransData.Glon=LONGITUDE;
+  f_PrintData.AccuracyTier=EPHEMTIER_PRECISE;
+  MoonData_Recalculate(&f_PrintData,BASE_UTC);
+
+  f_CTrans.Glat=LATITUDE;
+
+  f_PrintOptions.DateTimeOptions.DateStyleIndex=0;
+  f_PrintOptions.DateTimeOptions.Flags=DATETIMEFLAG_4DIGITYEAR;
+  for(f_InformationCount=0;
+      Information_GetLabel(f_InformationCount,&pLabel)>0;
+      f_InformationCount++);
+
+  UTC=BASE_UTC;
+  f_Time=*gmtime(&UTC);
+
+  return(0);
+}
+
+/**
+*** \brief CalcEphem() benchmark.
+*** \details The moon every minute of a day (legacy API).
+*** \param Iteration Iteration.
+**/
+static void BenchCalcEphem(long Iteration)
+{
+  CalcEphem(20150615L,(Iteration%1440)/60.0,&f_CTrans);
+  f_Sink=f_CTrans.h_moon;
+  return;
+}
+
+/**
+*** \brief Moon() benchmark.
+*** \details The lunar theory every hour.
+*** \param Iteration Iteration.
+**/
+static void BenchMoon(long Iteration)
+{
+  double Lambda;
+  double Beta;
+  double R;
+  double Age;
+
+
+  f_Sink=Moon(BASE_T+(Iteration%INPUT_COUNT)*HOUR_T,
+      &Lambda,&Beta,&R,&Age);
+  return;
+}
+
+/**
+*** \brief MiniMoon() benchmark.
+*** \details The low precision position every hour.
+*** \param Iteration Iteration.
+**/
+static void BenchMiniMoon(long Iteration)
+{
+  double RA;
+  double Dec;
+
+
+  MiniMoon(BASE_T+(Iteration%INPUT_COUNT)*HOUR_T,&RA,&Dec);
+  f_Sink=RA+Dec;
+  return;
+}
+
+/**
+*** \brief MoonPhaseEvent() benchmark.
+*** \details The nearest principal phase (in turn) from every hour.
+*** \param Iteration Iteration.
+**/
+static void BenchMoonPhaseEvent(long Iteration)
+{
+  f_Sink=MoonPhaseEvent(BASE_T+(Iteration%INPUT_COUNT)*HOUR_T,
+      0.25*(Iteration%4),1e-9);
+  return;
+}
+
+/**
+*** \brief MoonRise() benchmark.
+*** \details Rise and set times of each day of four weeks (legacy API,
+***   after the latitude was set by the CalcEphem() benchmark).
+*** \param Iteration Iteration.
+**/
+static void BenchMoonRise(long Iteration)
+{
+  double Rise;
+  double Set;
+
+
+  MoonRise(2015,6,1+(int)(Iteration%28),0.0,&Rise,&Set);
+  f_Sink=Rise+Set;
+  return;
+}
+
+/**
+*** \brief MoonData_Recalculate() benchmark.
+*** \details The moon data every second, as updated by the application.
+*** \param Iteration Iteration.
+**/
+static void BenchMoonDataRecalculate(long Iteration)
+{
+  MoonData_Recalculate(&f_RecalculateData,(time_t)(BASE_UTC+Iteration));
+  f_Sink=f_RecalculateData.CTransData.h_moon;
+  return;
+}
+
+/**
+*** \brief Information_Print() benchmark.
+*** \details Prints each information item in turn (first unit/format).
+*** \param Iteration Iteration.
+**/
+static void BenchInformationPrint(long Iteration)
+{
+  char *pText;
+
+
+  pText=NULL;
+  Information_Print(&f_PrintData,(int)(Iteration%f_InformationCount),0,
+      &f_PrintOptions,&pText);
+  f_Sink=(pText!=NULL);
+  free(pText);
+  return;
+}
+
+/**
+*** \brief DateTime_Print() benchmark.
+*** \details Prints the date and time of every minute of an hour.
+*** \param Iteration Iteration.
+**/
+static void BenchDateTimePrint(long Iteration)
+{
+  char *pText;
+
+
+  pText=NULL;
+  f_Time.tm_min=(int)(Iteration%60);
+  DateTime_Print(1,&f_Time,DATE_FORMAT,&f_PrintOptions.DateTimeOptions,
+      &pText);
+  f_Sink=(pText!=NULL);
+  free(pText);
+  return;
+}
+
+/**
+*** \brief Writes the results as JSON.
+*** \details Writes the selected results as one JSON object.
+*** \param pFile File.
+*** \param Seconds Time per benchmark (in seconds).
+*** \param pSelected Selection flag of each benchmark.
+*** \param pResults Results of each benchmark.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int WriteJSON(FILE *pFile,double Seconds,int const *pSelected,
+    RESULT_T const *pResults)
+{
+  char pTimestamp[32];
+  time_t Now;
+  int Index;
+  int FirstFlag;
+
+
+  Now=time(NULL);
+  strftime(pTimestamp,sizeof(pTimestamp),"%Y-%m-%dT%H:%M:%SZ",gmtime(&Now));
+  fprintf(pFile,
+      "{\n"
+      "  \"program\": \"moonphase-bench\",\n"
+      "  \"timestamp\": \"%s\",\n"
+      "  \"seconds\": %g,\n"
+      "  \"samples\": %d,\n"
+      "  \"benchmarks\": [",
+      pTimestamp,Seconds,SAMPLE_COUNT);
+  FirstFlag=1;
+  for(Index=0;Index<BENCHMARK_COUNT;Index++)
+  {
+    if (pSelected[Index]==0)
+      continue;
+    fprintf(pFile,
+        "%s\n"
+        "    {\n"
+        "      \"name\": \"%s\",\n"
+        "      \"operations\": %ld,\n"
+        "      \"batch\": %ld,\n"
+        "      \"ns_per_op\": %.1f,\n",
+        (FirstFlag!=0) ? "" : ",",
+        f_pBenchmarks[Index].pName,pResults[Index].OperationCount,
+        pResults[Index].BatchSize,pResults[Index].Mean);
+#ifdef    COUNT_ALLOCATIONS
+    fprintf(pFile,"      \"allocs_per_op\": %.3f,\n",
+        pResults[Index].Allocations);
+#else     /* COUNT_ALLOCATIONS */
+    fprintf(pFile,"      \"allocs_per_op\": null,\n");
+#endif    /* COUNT_ALLOCATIONS */
+    fprintf(pFile,
+        "      \"evals_per_op\": %.3f,\n"
+        "      \"min_ns\": %.1f,\n"
+        "      \"p50_ns\": %.1f,\n"
+        "      \"p90_ns\": %.1f,\n"
+        "      \"p99_ns\": %.1f,\n"
+        "      \"max_ns\": %.1f\n"
+        "    }",
+        pResults[Index].Evaluations,pResults[Index].Minimum,
+        pResults[Index].P50,pResults[Index].P90,
+        pResults[Index].P99,pResults[Index].Maximum);
+    FirstFlag=0;
+  }
+  fprintf(pFile,"\n  ]\n}\n");
+  return(ferror(pFile)!=0);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the benchmarks.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  RESULT_T pResults[BENCHMARK_COUNT];
+  int pSelected[BENCHMARK_COUNT];
+  double Seconds;
+  char const *pJSONPathname;
+  int SelectedCount;
+  int Index;
+  int Benchmark;
+  FILE *pFile;
+  int Result;
+
+
+  /* Command line. */
+  Seconds=DEFAULT_SECONDS;
+  pJSONPathname=NULL;
+  SelectedCount=0;
+  memset(pSelected,0,sizeof(pSelected));
+  for(Index=1;Index<ArgC;Index++)
+  {
+    if ( (strcmp(ppArgV[Index],"-t")==0) && (Index+1<ArgC) )
+    {
+      Seconds=atof(ppArgV[++Index]);
+      if (Seconds<=0.0)
+        break;
+    }
+    else if ( (strcmp(ppArgV[Index],"-o")==0) && (Index+1<ArgC) )
+      pJSONPathname=ppArgV[++Index];
+    else
+    {
+      for(Benchmark=0;Benchmark<BENCHMARK_COUNT;Benchmark++)
+        if (strcmp(ppArgV[Index],f_pBenchmarks[Benchmark].pName)==0)
+          break;
+      if (Benchmark==BENCHMARK_COUNT)
+        break;
+      pSelected[Benchmark]=1;
+      SelectedCount++;
+    }
+  }
+  if (Index<ArgC)
+  {
+    Usage(ppArgV[0]);
+    return(1);
+  }
+  if (SelectedCount==0)
+    for(Benchmark=0;Benchmark<BENCHMARK_COUNT;Benchmark++)
+      pSelected[Benchmark]=1;
+
+  if (Setup()!=0)
+    return(1);
+
+  /* Run. */
+  memset(pResults,0,sizeof(pResults));
+  for(Benchmark=0;Benchmark<BENCHMARK_COUNT;Benchmark++)
+    if (pSelected[Benchmark]!=0)
+      Run(&f_pBenchmarks[Benchmark],Seconds,&pResults[Benchmark]);
+
+  /* Report. */
+  Result=0;
+  if ( (pJSONPathname!=NULL) && (strcmp(pJSONPathname,"-")==0) )
+    Result=WriteJSON(stdout,Seconds,pSelected,pResults);
+  else
+  {
+    printf("%-22s %12s %10s %10s %12s %12s %12s\n",
+        "benchmark","ns/op","allocs/op","evals/op","p50 ns","p90 ns",
+        "p99 ns");
+    for(Benchmark=0;Benchmark<BENCHMARK_COUNT;Benchmark++)
+      if (pSelected[Benchmark]!=0)
+      {
+        printf("%-22s %12.1f ",
+            f_pBenchmarks[Benchmark].pName,pResults[Benchmark].Mean);
+#ifdef    COUNT_ALLOCATIONS
+        printf("%10.3f ",pResults[Benchmark].Allocations);
+#else     /* COUNT_ALLOCATIONS */
+        printf("%10s ","n/a");
+#endif    /* COUNT_ALLOCATIONS */
+        printf("%10.3f ",pResults[Benchmark].Evaluations);
+        printf("%12.1f %12.1f %12.1f\n",pResults[Benchmark].P50,
+            pResults[Benchmark].P90,pResults[Benchmark].P99);
+      }
+    if (pJSONPathname!=NULL)
+    {
+      pFile=fopen(pJSONPathname,"w");
+      if ( (pFile==NULL) ||
+          (WriteJSON(pFile,Seconds,pSelected,pResults)!=0) ||
+          (fclose(pFile)!=0) )
+      {
+        fprintf(stderr,"Unable to write \"%s\".\n",pJSONPathname);
+        Result=1;
+      }
+    }
+  }
+
+  MoonData_Uninitialize(&f_PrintData);
+  MoonData_Uninitialize(&f_RecalculateData);
+
+  return(Result);
+}
+
+
+#undef    BENCHMARK_C
@@ -0,0 +1,177 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file gridbenchmark.c
+*** \brief Rise/set map benchmark.
+*** \details Computes global moon rise/set maps with MoonGrid_Calculate() and
+***   reports the throughput in cells per second.
+***   Usage: moonphase-gridbench [resolution (degrees)] [days]
+**/
+
+
+/** Identifier for gridbenchmark.c. **/
+#define   GRIDBENCHMARK_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moongrid.h"
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <time.h>
+#ifdef    _OPENMP
+#include  <omp.h>
+#endif    /* _OPENMP */
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Default resolution.
+*** \details Default grid step (in degrees).
+**/
+#define   DEFAULT_RESOLUTION  (0.25)
+
+/**
+*** \brief Default day count.
+*** \details Default number of days (maps) to compute.
+**/
+#define   DEFAULT_DAYCOUNT    (10)
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double Seconds(void);
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Wall clock.
+*** \details Returns a wall clock time (in seconds). Without OpenMP the
+***   benchmark runs on one core, so processor time serves.
+*** \returns Time (in seconds).
+**/
+static double Seconds(void)
+{
+#ifdef    _OPENMP
+  return(omp_get_wtime());
+#else     /* _OPENMP */
+  return((double)clock()/CLOCKS_PER_SEC);
+#endif    /* _OPENMP */
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the benchmark.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  MOONGRID_T Grid;
+  double Resolution;
+  int DayCount;
+  int Day;
+  long CellCount;
+  float *pRise;
+  float *pSet;
+  double Start;
+  double Elapsed;
+  int ThreadCount;
+
+
+  Resolution=(ArgC>1) ? atof(ppArgV[1]) : DEFAULT_RESOLUTION;
+  DayCount=(ArgC>2) ? atoi(ppArgV[2]) : DEFAULT_DAYCOUNT;
+  if ( (Resolution<=0.0) || (Resolution>90.0) || (DayCount<=0) )
+  {
+    fprintf(stderr,"Usage: %s [resolution (degrees)] [days]\n",ppArgV[0]);
+    return(1);
+  }
+
+  /* Cell centres covering the globe. */
+  Grid.LatitudeCount=(int)(180.0/Resolution+0.5);
+  Grid.LatitudeStep=180.0/Grid.LatitudeCount;
+  Grid.Latitude=-90.0+0.5*Grid.LatitudeStep;
+  Grid.LongitudeCount=(int)(360.0/Resolution+0.5);
+  Grid.LongitudeStep=360.0/Grid.LongitudeCount;
+  Grid.Longitude=-180.0+0.5*Grid.LongitudeStep;
+  CellCount=(long)Grid.LatitudeCount*Grid.LongitudeCount;
+
+  pRise=(float *)malloc(CellCount*sizeof(*pRise));
+  pSet=(float *)malloc(CellCount*sizeof(*pSet));
+  if ( (pRise==NULL) || (pSet==NULL) )
+  {
+    fprintf(stderr,"Out of memory.\n");
+    free(pRise);
+    free(pSet);
+    return(1);
+  }
+
+#ifdef    _OPENMP
+  ThreadCount=omp_get_max_threads();
+#else     /* _OPENMP */
+  ThreadCount=1;
+#endif    /* _OPENMP */
+
+  Start=Seconds();
+  for(Day=0;Day<DayCount;Day++)
+    if (MoonGrid_Calculate(&Grid,2015,1,1+Day%28,pRise,pSet)<0)
+    {
+      fprintf(stderr,"MoonGrid_Calculate() failed.\n");
+      free(pRise);
+      free(pSet);
+      return(1);
+    }
+  Elapsed=Seconds()-Start;
+
+  printf("grid:       %d x %d (%g degrees)\n",
+      Grid.LatitudeCount,Grid.LongitudeCount,Resolution);
+  printf("days:       %d\n",DayCount);
+  printf("threads:    %d\n",ThreadCount);
+  printf("seconds:    %.3f\n",Elapsed);
+  printf("cells/s:    %.0f\n",DayCount*CellCount/Elapsed);
+
+  free(pRise);
+  free(pSet);
+
+  return(0);
+}
+
+
+#undef    GRIDBENCHMARK_C
@@ -0,0 +1,428 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file querybenchmark.c
+*** \brief Query service client and benchmark.
+*** \details Sends a mixed workload of moon data queries in batches to
+***   moonphase-service, checks the replies against MoonQuery_Answer() called
+***   in-process, and reports the throughput of both in requests per second.
+***   Without a running service only the in-process figures are reported.
+***   Usage: moonphase-querybench [batch size] [requests] [socket]
+**/
+
+
+/** Identifier for querybenchmark.c. **/
+#define   QUERYBENCHMARK_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moonquery.h"
+
+#include  <errno.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+#include  <unistd.h>
+#include  <sys/socket.h>
+#include  <sys/un.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Default batch size.
+*** \details Default number of requests per batch.
+**/
+#define   DEFAULT_BATCHSIZE     (256)
+
+/**
+*** \brief Default request count.
+*** \details Default number of requests per pass.
+**/
+#define   DEFAULT_REQUESTCOUNT  (100000)
+
+/**
+*** \brief Observer count.
+*** \details Number of distinct observers in the workload.
+**/
+#define   OBSERVERCOUNT         (16)
+
+/**
+*** \brief Workload start.
+*** \details Time of the first request (2015-01-01 0h UTC).
+**/
+#define   WORKLOAD_START        (1420070400.0)
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double Seconds(void);
+static void MakeWorkload(MOONQUERYREQUEST_T *pRequests,long Count);
+static int Connect(char const *pPathname);
+static int WriteAll(int Socket,void const *pBuffer,size_t Size);
+static int ReadAll(int Socket,void *pBuffer,size_t Size);
+static int RunLocal(MOONQUERY_T *pQuery,MOONQUERYREQUEST_T const *pRequests,
+    long Count,int BatchSize,MOONQUERYREPLY_T *pReplies);
+static int RunService(int Socket,MOONQUERYREQUEST_T const *pRequests,
+    long Count,int BatchSize,MOONQUERYREPLY_T *pReplies);
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Wall clock.
+*** \details Returns a monotonic wall clock time (in seconds).
+*** \returns Time (in seconds).
+**/
+static double Seconds(void)
+{
+  struct timespec Time;
+
+
+  clock_gettime(CLOCK_MONOTONIC,&Time);
+  return(Time.tv_sec+1e-9*Time.tv_nsec);
+}
+
+/**
+*** \brief Builds the workload.
+*** \details Fills in a repeatable mix of ephemeris (half), rise/set and
+***   phase queries for a few observers over two months, much as a set of
+***   clocks and panels polling the service would send.
+*** \param pRequests Storage for the requests.
+*** \param Count Number of requests.
+**/
+static void MakeWorkload(MOONQUERYREQUEST_T *pRequests,long Count)
+{
+  long Index;
+  int Observer;
+
+
+  for(Index=0;Index<Count;Index++)
+  {
+    Observer=(int)(Index%OBSERVERCOUNT);
+    memset(&pRequests[Index],0,sizeof(pRequests[Index]));
+    switch(Index%4)
+    {
+      case 0:
+      case 1:
+        pRequests[Index].Type=MOONQUERYTYPE_EPHEMERIS;
+        break;
+      case 2:
+        pRequests[Index].Type=MOONQUERYTYPE_RISESET;
+        break;
+      default:
+        pRequests[Index].Type=MOONQUERYTYPE_PHASE;
+        break;
+    }
+    pRequests[Index].AccuracyTier=EPHEMTIER_DISPLAY;
+    pRequests[Index].UTC=WORKLOAD_START+(Index*7919L%(60L*86400L));
+    pRequests[Index].Latitude=-60.0+8.0*Observer;
+    pRequests[Index].Longitude=-170.0+22.5*Observer;
+    pRequests[Index].TimeZone=(double)((Observer*3)%25-12);
+  }
+  return;
+}
+
+/**
+*** \brief Connects to the service.
+*** \details Opens a stream socket to the service.
+*** \param pPathname Socket pathname.
+*** \returns Socket, or -1 if the service is not running.
+**/
+static int Connect(char const *pPathname)
+{
+  struct sockaddr_un Address;
+  int Socket;
+
+
+  if (strlen(pPathname)>=sizeof(Address.sun_path))
+    return(-1);
+  Socket=socket(AF_UNIX,SOCK_STREAM,0);
+  if (Socket<0)
+    return(-1);
+  memset(&Address,0,sizeof(Address));
+  Address.sun_family=AF_UNIX;
+  strcpy(Address.sun_path,pPathname);
+  if (connect(Socket,(struct sockaddr *)&Address,sizeof(Address))<0)
+  {
+    close(Socket);
+    return(-1);
+  }
+  return(Socket);
+}
+
+/**
+*** \brief Writes a buffer.
+*** \details Writes all of a buffer to a socket.
+*** \param Socket Socket.
+*** \param pBuffer Buffer.
+*** \param Size Size of the buffer (in bytes).
+*** \retval 0 Success.
+*** \retval -1 Failure.
+**/
+static int WriteAll(int Socket,void const *pBuffer,size_t Size)
+{
+  char const *pByte;
+  ssize_t Written;
+
+
+  pByte=(char const *)pBuffer;
+  while(Size>0)
+  {
+    Written=write(Socket,pByte,Size);
+    if (Written<0)
+    {
+      if (errno==EINTR)
+        continue;
+      return(-1);
+    }
+    pByte+=Written;
+    Size-=Written;
+  }
+  return(0);
+}
+
+/**
+*** \brief Reads a buffer.
+*** \details Reads exactly Size bytes from a socket.
+*** \param Socket Socket.
+*** \param pBuffer Storage for the bytes.
+*** \param Size Number of bytes.
+*** \retval 0 Success.
+*** \retval -1 Failure (or the service closed the connection).
+**/
+static int ReadAll(int Socket,void *pBuffer,size_t Size)
+{
+  char *pByte;
+  ssize_t Read;
+
+
+  pByte=(char *)pBuffer;
+  while(Size>0)
+  {
+    Read=read(Socket,pByte,Size);
+    if (Read<0)
+    {
+      if (errno==EINTR)
+        continue;
+      return(-1);
+    }
+    if (Read==0)
+      return(-1);
+    pByte+=Read;
+    Size-=Read;
+  }
+  return(0);
+}
+
+/**
+*** \brief Runs the workload in-process.
+*** \details Answers the workload batch by batch with MoonQuery_Answer().
+*** \param pQuery Query engine.
+*** \param pRequests Workload.
+*** \param Count Number of requests.
+*** \param BatchSize Requests per batch.
+*** \param pReplies Storage for Count replies.
+*** \retval 0 Success.
+*** \retval -1 Failure.
+**/
+static int RunLocal(MOONQUERY_T *pQuery,MOONQUERYREQUEST_T const *pRequests,
+    long Count,int BatchSize,MOONQUERYREPLY_T *pReplies)
+{
+  long Index;
+  int Size;
+
+
+  for(Index=0;Index<Count;Index+=Size)
+  {
+    Size=(Count-Index<BatchSize) ? (int)(Count-Index) : BatchSize;
+    if (MoonQuery_Answer(pQuery,&pRequests[Index],Size,&pReplies[Index])<0)
+      return(-1);
+  }
+  return(0);
+}
+
+/**
+*** \brief Runs the workload against the service.
+*** \details Sends the workload batch by batch and waits for each reply.
+*** \param Socket Connection to the service.
+*** \param pRequests Workload.
+*** \param Count Number of requests.
+*** \param BatchSize Requests per batch.
+*** \param pReplies Storage for Count replies.
+*** \retval 0 Success.
+*** \retval -1 Failure.
+**/
+static int RunService(int Socket,MOONQUERYREQUEST_T const *pRequests,
+    long Count,int BatchSize,MOONQUERYREPLY_T *pReplies)
+{
+  MOONQUERYHEADER_T Header;
+  long Index;
+  int Size;
+
+
+  for(Index=0;Index<Count;Index+=Size)
+  {
+    Size=(Count-Index<BatchSize) ? (int)(Count-Index) : BatchSize;
+    Header.Magic=MOONQUERY_MAGIC;
+    Header.Count=Size;
+    if ( (WriteAll(Socket,&Header,sizeof(Header))<0) ||
+        (WriteAll(Socket,&pRequests[Index],Size*sizeof(*pRequests))<0) ||
+        (ReadAll(Socket,&Header,sizeof(Header))<0) ||
+        (Header.Magic!=MOONQUERY_MAGIC) || ((int)Header.Count!=Size) ||
+        (ReadAll(Socket,&pReplies[Index],Size*sizeof(*pReplies))<0) )
+      return(-1);
+  }
+  return(0);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the benchmark.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure (or the service replies differ).
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  static MOONQUERY_T Query;
+  char const *pPathname;
+  int BatchSize;
+  long Count;
+  MOONQUERYREQUEST_T *pRequests;
+  MOONQUERYREPLY_T *pLocalReplies;
+  MOONQUERYREPLY_T *pServiceReplies;
+  int Socket;
+  int Pass;
+  double Start;
+  double pLocalTimes[2];
+  double pServiceTimes[2];
+  long MismatchCount;
+  long Index;
+
+
+  BatchSize=(ArgC>1) ? atoi(ppArgV[1]) : DEFAULT_BATCHSIZE;
+  Count=(ArgC>2) ? atol(ppArgV[2]) : DEFAULT_REQUESTCOUNT;
+  pPathname=(ArgC>3) ? ppArgV[3] : getenv("MOONPHASE_QUERYSOCKET");
+  if ( (pPathname==NULL) || (pPathname[0]==0) )
+    pPathname=MOONQUERY_SOCKETPATHNAME;
+  if ( (BatchSize<=0) || (BatchSize>MOONQUERY_MAXBATCH) || (Count<=0) )
+  {
+    fprintf(stderr,"Usage: %s [batch size (1-%d)] [requests] [socket]\n",
+        ppArgV[0],MOONQUERY_MAXBATCH);
+    return(1);
+  }
+
+  pRequests=(MOONQUERYREQUEST_T *)malloc(Count*sizeof(*pRequests));
+  pLocalReplies=(MOONQUERYREPLY_T *)malloc(Count*sizeof(*pLocalReplies));
+  pServiceReplies=(MOONQUERYREPLY_T *)malloc(Count*sizeof(*pServiceReplies));
+  if ( (pRequests==NULL) || (pLocalReplies==NULL) ||
+      (pServiceReplies==NULL) || (MoonQuery_Initialize(&Query)<0) )
+  {
+    fprintf(stderr,"Out of memory.\n");
+    free(pRequests);
+    free(pLocalReplies);
+    free(pServiceReplies);
+    return(1);
+  }
+  MakeWorkload(pRequests,Count);
+
+  /* Two passes: the first one warms the profiles and rise/set caches. */
+  for(Pass=0;Pass<2;Pass++)
+  {
+    Start=Seconds();
+    if (RunLocal(&Query,pRequests,Count,BatchSize,pLocalReplies)<0)
+    {
+      fprintf(stderr,"MoonQuery_Answer() failed.\n");
+      MoonQuery_Uninitialize(&Query);
+      free(pRequests);
+      free(pLocalReplies);
+      free(pServiceReplies);
+      return(1);
+    }
+    pLocalTimes[Pass]=Seconds()-Start;
+  }
+  MoonQuery_Uninitialize(&Query);
+
+  printf("requests:   %ld (batches of %d)\n",Count,BatchSize);
+  printf("in-process: %.0f requests/s cold, %.0f requests/s warm\n",
+      Count/pLocalTimes[0],Count/pLocalTimes[1]);
+
+  MismatchCount=0;
+  Socket=Connect(pPathname);
+  if (Socket<0)
+    printf("service:    not running (%s)\n",pPathname);
+  else
+  {
+    for(Pass=0;Pass<2;Pass++)
+    {
+      Start=Seconds();
+      if (RunService(Socket,pRequests,Count,BatchSize,pServiceReplies)<0)
+      {
+        fprintf(stderr,"Service connection failed.\n");
+        close(Socket);
+        free(pRequests);
+        free(pLocalReplies);
+        free(pServiceReplies);
+        return(1);
+      }
+      pServiceTimes[Pass]=Seconds()-Start;
+    }
+    close(Socket);
+
+    for(Index=0;Index<Count;Index++)
+      if (memcmp(&pLocalReplies[Index],&pServiceReplies[Index],
+          sizeof(*pLocalReplies))!=0)
+        MismatchCount++;
+
+    printf("service:    %.0f requests/s first pass, %.0f requests/s second\n",
+        Count/pServiceTimes[0],Count/pServiceTimes[1]);
+    printf("batches/s:  %.0f\n",
+        ((Count+BatchSize-1)/BatchSize)/pServiceTimes[1]);
+    printf("mismatches: %ld\n",MismatchCount);
+  }
+
+  free(pRequests);
+  free(pLocalReplies);
+  free(pServiceReplies);
+
+  return( (MismatchCount==0) ? 0 : 1 );
+}
+
+
+#undef    QUERYBENCHMARK_C
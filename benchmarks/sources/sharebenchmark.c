@@ -0,0 +1,387 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file sharebenchmark.c
+*** \brief Shared memory publication stress test.
+*** \details Publishes snapshots into a private segment (see moonshare.h) as
+***   fast as possible while several reader threads, each with a mapping of
+***   its own, read them. Every snapshot is built from one counter, so a
+***   reader can tell a torn snapshot from a consistent one. Reports the
+***   publication and read rates, the read retries and any torn snapshots.
+***   Usage: moonphase-sharebench [readers] [seconds]
+**/
+
+
+/** Identifier for sharebenchmark.c. **/
+#define   SHAREBENCHMARK_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moonshare.h"
+
+#include  <pthread.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <time.h>
+#include  <unistd.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Default reader count.
+*** \details Default number of reader threads.
+**/
+#define   DEFAULT_READERCOUNT   (4)
+
+/**
+*** \brief Default duration.
+*** \details Default length of the test (in seconds).
+**/
+#define   DEFAULT_SECONDS       (5)
+
+/**
+*** \brief Maximum reader count.
+*** \details Maximum number of reader threads.
+**/
+#define   MAXIMUM_READERCOUNT   (64)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Reader state.
+*** \details Results of one reader thread.
+**/
+typedef struct structREADER
+{
+  /**
+  *** \brief Thread.
+  *** \details Thread identifier.
+  **/
+  pthread_t Thread;
+  /**
+  *** \brief Read count.
+  *** \details Number of snapshots read.
+  **/
+  unsigned long ReadCount;
+  /**
+  *** \brief Retry count.
+  *** \details Number of reads retried (MOONSHARE_T.RetryCount).
+  **/
+  unsigned long RetryCount;
+  /**
+  *** \brief Torn count.
+  *** \details Number of inconsistent snapshots read (should be 0).
+  **/
+  unsigned long TornCount;
+  /**
+  *** \brief Backward count.
+  *** \details Number of snapshots older than the one read before (should
+  ***   be 0).
+  **/
+  unsigned long BackwardCount;
+  /**
+  *** \brief Error flag.
+  *** \details Non-zero if the segment could not be opened or read.
+  **/
+  int ErrorFlag;
+} READER_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double Seconds(void);
+static void MakeSnapshot(unsigned long Counter,MOONSHAREDATA_T *pData);
+static int CheckSnapshot(MOONSHAREDATA_T const *pData);
+static void *ReaderThread(void *pArgument);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+/**
+*** \brief Segment name.
+*** \details Name of the private segment of the test.
+**/
+static char f_pName[MOONSHARE_NAMESIZE];
+
+/**
+*** \brief Stop flag.
+*** \details Set when the readers should stop.
+**/
+static volatile int f_StopFlag;
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Wall clock.
+*** \details Returns a monotonic wall clock time (in seconds).
+*** \returns Time (in seconds).
+**/
+static double Seconds(void)
+{
+  struct timespec Time;
+
+
+  clock_gettime(CLOCK_MONOTONIC,&Time);
+  return(Time.tv_sec+1e-9*Time.tv_nsec);
+}
+
+/**
+*** \brief Builds a snapshot.
+*** \details Fills every field of a snapshot from a counter.
+*** \param Counter Counter.
+*** \param pData Storage for the snapshot.
+**/
+static void MakeSnapshot(unsigned long Counter,MOONSHAREDATA_T *pData)
+{
+  double Base;
+  int Index;
+
+
+  Base=(double)Counter;
+  pData->UTC=Base;
+  pData->Latitude=Base+1.0;
+  pData->Longitude=Base+2.0;
+  pData->TimeZone=Base+3.0;
+  pData->RightAscension=Base+4.0;
+  pData->Declination=Base+5.0;
+  pData->Altitude=Base+6.0;
+  pData->Azimuth=Base+7.0;
+  pData->Phase=Base+8.0;
+  pData->Age=Base+9.0;
+  pData->Distance=Base+10.0;
+  for(Index=0;Index<6;Index++)
+    pData->pRiseSet[Index]=Base+11.0+Index;
+  pData->VisibleFlag=(int)(Counter&0x7FFFFFFF);
+  pData->AccuracyTier=(int)(~Counter&0x7FFFFFFF);
+  return;
+}
+
+/**
+*** \brief Checks a snapshot.
+*** \details Checks that all fields of a snapshot come from one counter.
+*** \param pData Snapshot.
+*** \retval 1 Consistent.
+*** \retval 0 Torn.
+**/
+static int CheckSnapshot(MOONSHAREDATA_T const *pData)
+{
+  MOONSHAREDATA_T Expected;
+
+
+  MakeSnapshot((unsigned long)pData->UTC,&Expected);
+  return( (pData->Latitude==Expected.Latitude) &&
+      (pData->Longitude==Expected.Longitude) &&
+      (pData->TimeZone==Expected.TimeZone) &&
+      (pData->RightAscension==Expected.RightAscension) &&
+      (pData->Declination==Expected.Declination) &&
+      (pData->Altitude==Expected.Altitude) &&
+      (pData->Azimuth==Expected.Azimuth) &&
+      (pData->Phase==Expected.Phase) &&
+      (pData->Age==Expected.Age) &&
+      (pData->Distance==Expected.Distance) &&
+      (pData->pRiseSet[0]==Expected.pRiseSet[0]) &&
+      (pData->pRiseSet[5]==Expected.pRiseSet[5]) &&
+      (pData->VisibleFlag==Expected.VisibleFlag) &&
+      (pData->AccuracyTier==Expected.AccuracyTier) );
+}
+
+/**
+*** \brief Reader thread.
+*** \details Reads snapshots until told to stop.
+*** \param pArgument Reader state (READER_T).
+*** \returns NULL.
+**/
+static void *ReaderThread(void *pArgument)
+{
+  READER_T *pReader;
+  MOONSHARE_T Share;
+  MOONSHAREDATA_T Data;
+  double Last;
+
+
+  pReader=(READER_T *)pArgument;
+  if ( (MoonShare_Initialize(&Share)<0) ||
+      (MoonShare_Open(&Share,f_pName)<0) )
+  {
+    pReader->ErrorFlag=1;
+    return(NULL);
+  }
+
+  Last=-1.0;
+  while(f_StopFlag==0)
+  {
+    if (MoonShare_Read(&Share,&Data,NULL)<0)
+    {
+      pReader->ErrorFlag=1;
+      break;
+    }
+    pReader->ReadCount++;
+    if (CheckSnapshot(&Data)==0)
+      pReader->TornCount++;
+    if (Data.UTC<Last)
+      pReader->BackwardCount++;
+    Last=Data.UTC;
+  }
+  pReader->RetryCount=Share.RetryCount;
+
+  MoonShare_Uninitialize(&Share);
+  return(NULL);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure (or torn snapshots).
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  static READER_T pReaders[MAXIMUM_READERCOUNT];
+  MOONSHARE_T Share;
+  MOONSHAREDATA_T Data;
+  int ReaderCount;
+  double Duration;
+  int Index;
+  unsigned long Counter;
+  double Start;
+  double Elapsed;
+  unsigned long ReadCount;
+  unsigned long RetryCount;
+  unsigned long TornCount;
+  unsigned long BackwardCount;
+  int ErrorFlag;
+
+
+  ReaderCount=(ArgC>1) ? atoi(ppArgV[1]) : DEFAULT_READERCOUNT;
+  Duration=(ArgC>2) ? atof(ppArgV[2]) : DEFAULT_SECONDS;
+  if ( (ReaderCount<=0) || (ReaderCount>MAXIMUM_READERCOUNT) ||
+      (Duration<=0.0) )
+  {
+    fprintf(stderr,"Usage: %s [readers (1-%d)] [seconds]\n",
+        ppArgV[0],MAXIMUM_READERCOUNT);
+    return(1);
+  }
+
+  /* A private segment, so a running application is not disturbed. */
+  snprintf(f_pName,sizeof(f_pName),"%ssharebench-%ld",
+      MOONSHARE_NAMEPREFIX,(long)getpid());
+  if ( (MoonShare_Initialize(&Share)<0) ||
+      (MoonShare_Create(&Share,f_pName)<0) )
+  {
+    fprintf(stderr,"Unable to create %s.\n",f_pName);
+    return(1);
+  }
+  Counter=1;
+  MakeSnapshot(Counter,&Data);
+  MoonShare_Write(&Share,&Data);
+
+  f_StopFlag=0;
+  for(Index=0;Index<ReaderCount;Index++)
+    if (pthread_create(&pReaders[Index].Thread,NULL,
+        ReaderThread,&pReaders[Index])!=0)
+    {
+      fprintf(stderr,"Unable to start reader %d.\n",Index);
+      ReaderCount=Index;
+      f_StopFlag=1;
+    }
+
+  /* Publish as fast as possible. */
+  Start=Seconds();
+  do
+  {
+    for(Index=0;Index<1000;Index++)
+    {
+      Counter++;
+      MakeSnapshot(Counter,&Data);
+      MoonShare_Write(&Share,&Data);
+    }
+    Elapsed=Seconds()-Start;
+  }
+  while( (f_StopFlag==0) && (Elapsed<Duration) );
+  f_StopFlag=1;
+
+  ReadCount=0;
+  RetryCount=0;
+  TornCount=0;
+  BackwardCount=0;
+  ErrorFlag=0;
+  for(Index=0;Index<ReaderCount;Index++)
+  {
+    pthread_join(pReaders[Index].Thread,NULL);
+    ReadCount+=pReaders[Index].ReadCount;
+    RetryCount+=pReaders[Index].RetryCount;
+    TornCount+=pReaders[Index].TornCount;
+    BackwardCount+=pReaders[Index].BackwardCount;
+    ErrorFlag|=pReaders[Index].ErrorFlag;
+  }
+  MoonShare_Uninitialize(&Share);
+
+  printf("readers:      %d\n",ReaderCount);
+  printf("seconds:      %.3f\n",Elapsed);
+  printf("publications: %lu (%.0f/s)\n",Counter,Counter/Elapsed);
+  printf("reads:        %lu (%.0f/s per reader)\n",
+      ReadCount,ReadCount/Elapsed/(ReaderCount>0 ? ReaderCount : 1));
+  printf("retries:      %lu\n",RetryCount);
+  printf("torn:         %lu\n",TornCount);
+  printf("backward:     %lu\n",BackwardCount);
+  if (ErrorFlag!=0)
+    printf("errors:       reader failed\n");
+
+  return( (ErrorFlag==0) && (TornCount==0) && (BackwardCount==0) ? 0 : 1 );
+}
+
+
+#undef    SHAREBENCHMARK_C
@@ -21,12 +21,21 @@
 # Configuration
 #
 
+# OpenMP is optional; without it the grid and event searches run on one core.
+FIND_PACKAGE(OpenMP)
+IF(OPENMP_FOUND)
+  SET(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} ${OpenMP_C_FLAGS}")
+  SET(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS}")
+  SET(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} ${OpenMP_C_FLAGS}")
+ENDIF()
+
 
 #
 # Include paths
 #
 
 INCLUDE_DIRECTORIES(
+    "${CMAKE_CURRENT_BINARY_DIR}/"
     "${CMAKE_CURRENT_LIST_DIR}/sources/"
     "${CMAKE_SOURCE_DIR}/toolbox/generic/sources/")
 
@@ -38,16 +47,43 @@ INCLUDE_DIRECTORIES(
 SET(COMMON_SOURCES
     "${CMAKE_CURRENT_LIST_DIR}/sources/calcephem.c"
     "${CMAKE_CURRENT_LIST_DIR}/sources/datetime.c"
+    "${CMAKE_CURRENT_LIST_DIR}/sources/daynumber.c"
+    "${CMAKE_CURRENT_LIST_DIR}/sources/ephemfile.c"
     "${CMAKE_CURRENT_LIST_DIR}/sources/information.c"
+    "${CMAKE_CURRENT_LIST_DIR}/sources/lunation.c"
+    "${CMAKE_CURRENT_LIST_DIR}/sources/mooncache.c"
+    "${CMAKE_CURRENT_LIST_DIR}/sources/mooneclipse.c"
+    "${CMAKE_CURRENT_LIST_DIR}/sources/moonevent.c"
+    "${CMAKE_CURRENT_LIST_DIR}/sources/moongrid.c"
+    "${CMAKE_CURRENT_LIST_DIR}/sources/moonquery.c"
     "${CMAKE_CURRENT_LIST_DIR}/sources/moondata.c")
 SET(COMMON_FILES
-    ${COMMON_SOURCES})
+    ${COMMON_SOURCES}
+    "${CMAKE_CURRENT_BINARY_DIR}/lunationtable.h")
 
 
 #
 # Binaries
 #
 
+# The lunation table used by lunation.c is generated at build time from the
+#   lunar theory in calcephem.c.
+IF(NOT TARGET lunationtablegenerator)
+  ADD_EXECUTABLE(lunationtablegenerator
+      "${CMAKE_CURRENT_LIST_DIR}/tools/lunationtablegenerator.c"
+      "${CMAKE_CURRENT_LIST_DIR}/sources/calcephem.c"
+      "${CMAKE_CURRENT_LIST_DIR}/sources/daynumber.c")
+  SET_TARGET_PROPERTIES(lunationtablegenerator PROPERTIES
+      COMPILE_DEFINITIONS CALCEPHEM_NOLUNATIONTABLE)
+  IF(UNIX)
+    TARGET_LINK_LIBRARIES(lunationtablegenerator m)
+  ENDIF()
+ENDIF()
+ADD_CUSTOM_COMMAND(
+    OUTPUT "${CMAKE_CURRENT_BINARY_DIR}/lunationtable.h"
+    COMMAND lunationtablegenerator "${CMAKE_CURRENT_BINARY_DIR}/lunationtable.h"
+    DEPENDS lunationtablegenerator)
+
 
 #
 # Subdirectories
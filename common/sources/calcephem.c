@@ -1,28 +1,58 @@
 /** \todo This needs a lot of clean up. **/
 #include  "calcephem.h"
+#include  "daynumber.h"
+#ifndef CALCEPHEM_NOLUNATIONTABLE
+#include  "lunation.h"
+#endif
 #include  <string.h>
 #include  <time.h>
 #include  <math.h>
 
+/*
+ *  Moon4() uses AVX2/SSE2 for the series when built with GCC or Clang on
+ *  x86; other builds fall back to the scalar MoonSum().
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MOON4_X86
+#include  <immintrin.h>
+#endif
+
 
-static double Moon(double T, double *LAMBDA, double *BETA, double *R, double *AGE);
+static void MoonArgs(double T, double Limit, MoonSeries *ms);
+static void MoonAngles(double T, double Limit, MoonSeries *ms, double ARG[5], double FAC[5]);
+static void MoonHarmonics(MoonSeries *ms, int i, double C, double S, double FAC);
+static void MoonSum(MoonSeries *ms);
+static void MoonSum4(MoonSeries ms[4]);
+static double MoonFinish(MoonSeries *ms, double *LAMBDA, double *BETA, double *R, double *AGE);
+static void MoonStepper_Renormalize(MoonStepper *s);
+static double MoonStepper_Finish(MoonStepper *s, double *LAMBDA, double *BETA, double *R, double *AGE);
 static double sine(double phi);
 static double frac(double x);
-static void addsol(double, double, double, double, int, int, int, int);
-static void term(int, int, int, int, double*, double*);
+static void term(MoonSeries*, int, int, int, int, double*, double*);
 static void addthe(double, double, double, double, double*, double*);
-static void addn(double, int, int, int, int);
-static double NewMoon(double ax, double bx, double cx);
-static void MiniMoon(double T, double *RA, double *DEC);
+static double PhaseRate(double T);
+static double MoonAge(double TU, double AGE);
 /*static void MoonRise(int year, int month, int day, double LocalHour,
     double *UTRise, double *UTSet);*/
 /*static void UTTohhmm(double UT, int *h, int *m);*/
+static void RiseSetSamples(int year, int month, int day, EphemContext const *ctx,
+    double y[RISESET_SAMPLES]);
+static void RiseSetAppend(RiseSetRecord const *record, void *data);
+static void MoonVector(double JD, double v[3]);
+static void NextDay(int *year, int *month, int *day);
 static void Interp(double ym, double y0, double yp, double *xe, double *ye,
     double *z1, double *z2, int *nz);
-static double SinH(int year, int month, int day, double UT);
+static double SinH(int year, int month, int day, double UT,
+    EphemContext const *ctx);
 static double kepler(double M,double e);
-static int DayofYear(int year,int month,int day);
-static int DayofWeek(int year,int month,int day,char dowstr[]);
+static void CalcEphemCore(double JD0, double JDTDT, double UT, CTrans *c, EphemContext const *ctx, int tier);
+static void CalendarFromDayNumber(long DayNumber, double UT, CTrans *c);
+static double EphemGMST(double JD0, double UT);
+static double EphemObliquity(double TU);
+static void CalcEphemSun(double JDTDT, CTrans *c);
+static void EphemMoonGeocentric(double TU, double gmst, double epsilon, double Phase,
+    double LambdaMoon, double BetaMoon, double R, double AGE, EphemGeocentric *g);
+static void RecordToCTrans(EphemRecord const *r, CTrans *c);
 static double jd(int ny,int nm,int nd,double UT);
 static double hour24(double hour);
 static double angle2pi(double angle);
@@ -49,213 +79,372 @@ static double angle360(double angle);
 static const double TwoPi = 6.283185308;
 static const double ARC = 206264.81;
 /*double sine(), frac();*/
-static double  DLAM, DLAMS;
-static double  DS;
-static double  GAM1C;
-static double  SINPI;
-static double  N;
-static double  CO[14][5], SI[14][5];
+
+/*
+ *  Statistics hook for MoonPhaseEvent() (see SetPhaseSolverHook()). One
+ *  for the whole process, called from whichever thread runs the solver.
+ */
+static PhaseSolverHook PhaseSolverStats = NULL;
+static void *PhaseSolverStatsData = NULL;
+
+/*
+ *  Perturbation terms of Brown's series (Solar1, Solar2 and Solar3). Each
+ *  term adds COEFFL*sin, COEFFS*sin, COEFFG*cos and COEFFP*cos of the
+ *  argument P*L + Q*LS + R*F + S*D to DLAM, DS, GAM1C and SINPI.
+ */
+typedef struct MoonTerm {
+  double COEFFL, COEFFS, COEFFG, COEFFP;
+  int P, Q, R, S;
+} MoonTerm;
+
+static const MoonTerm SolarTerms[] = {
+  /* Solar1 */
+  {   13.902,   14.06,-0.001,   0.2607,0, 0, 0, 4},
+  {    0.403,   -4.01,+0.394,   0.0023,0, 0, 0, 3},
+  { 2369.912, 2373.36,+0.601,  28.2333,0, 0, 0, 2},
+  { -125.154, -112.79,-0.725,  -0.9781,0, 0, 0, 1},
+  {    1.979,    6.98,-0.445,   0.0433,1, 0, 0, 4},
+  {  191.953,  192.72,+0.029,   3.0861,1, 0, 0, 2},
+  {   -8.466,  -13.51,+0.455,  -0.1093,1, 0, 0, 1},
+  {22639.500,22609.07,+0.079, 186.5398,1, 0, 0, 0},
+  {   18.609,    3.59,-0.094,   0.0118,1, 0, 0,-1},
+  {-4586.465,-4578.13,-0.077,  34.3117,1, 0, 0,-2},
+  {   +3.215,    5.44,+0.192,  -0.0386,1, 0, 0,-3},
+  {  -38.428,  -38.64,+0.001,   0.6008,1, 0, 0,-4},
+  {   -0.393,   -1.43,-0.092,   0.0086,1, 0, 0,-6},
+  {   -0.289,   -1.59,+0.123,  -0.0053,0, 1, 0, 4},
+  {  -24.420,  -25.10,+0.040,  -0.3000,0, 1, 0, 2},
+  {   18.023,   17.93,+0.007,   0.1494,0, 1, 0, 1},
+  { -668.146, -126.98,-1.302,  -0.3997,0, 1, 0, 0},
+  {    0.560,    0.32,-0.001,  -0.0037,0, 1, 0,-1},
+  { -165.145, -165.06,+0.054,   1.9178,0, 1, 0,-2},
+  {   -1.877,   -6.46,-0.416,   0.0339,0, 1, 0,-4},
+  {    0.213,    1.02,-0.074,   0.0054,2, 0, 0, 4},
+  {   14.387,   14.78,-0.017,   0.2833,2, 0, 0, 2},
+  {   -0.586,   -1.20,+0.054,  -0.0100,2, 0, 0, 1},
+  {  769.016,  767.96,+0.107,  10.1657,2, 0, 0, 0},
+  {   +1.750,    2.01,-0.018,   0.0155,2, 0, 0,-1},
+  { -211.656, -152.53,+5.679,  -0.3039,2, 0, 0,-2},
+  {   +1.225,    0.91,-0.030,  -0.0088,2, 0, 0,-3},
+  {  -30.773,  -34.07,-0.308,   0.3722,2, 0, 0,-4},
+  {   -0.570,   -1.40,-0.074,   0.0109,2, 0, 0,-6},
+  {   -2.921,  -11.75,+0.787,  -0.0484,1, 1, 0, 2},
+  {   +1.267,    1.52,-0.022,   0.0164,1, 1, 0, 1},
+  { -109.673, -115.18,+0.461,  -0.9490,1, 1, 0, 0},
+  { -205.962, -182.36,+2.056,  +1.4437,1, 1, 0,-2},
+  {    0.233,    0.36, 0.012,  -0.0025,1, 1, 0,-3},
+  {   -4.391,   -9.66,-0.471,   0.0673,1, 1, 0,-4},
+  /* Solar2 */
+  {    0.283,    1.53,-0.111,  +0.0060,1,-1, 0,+4},
+  {   14.577,   31.70,-1.540,  +0.2302,1,-1, 0, 2},
+  {  147.687,  138.76,+0.679,  +1.1528,1,-1, 0, 0},
+  {   -1.089,    0.55,+0.021,   0.0   ,1,-1, 0,-1},
+  {   28.475,   23.59,-0.443,  -0.2257,1,-1, 0,-2},
+  {   -0.276,   -0.38,-0.006,  -0.0036,1,-1, 0,-3},
+  {    0.636,    2.27,+0.146,  -0.0102,1,-1, 0,-4},
+  {   -0.189,   -1.68,+0.131,  -0.0028,0, 2, 0, 2},
+  {   -7.486,   -0.66,-0.037,  -0.0086,0, 2, 0, 0},
+  {   -8.096,  -16.35,-0.740,   0.0918,0, 2, 0,-2},
+  {   -5.741,   -0.04, 0.0  ,  -0.0009,0, 0, 2, 2},
+  {    0.255,    0.0 , 0.0  ,   0.0   ,0, 0, 2, 1},
+  { -411.608,   -0.20, 0.0  ,  -0.0124,0, 0, 2, 0},
+  {    0.584,    0.84, 0.0  ,  +0.0071,0, 0, 2,-1},
+  {  -55.173,  -52.14, 0.0  ,  -0.1052,0, 0, 2,-2},
+  {    0.254,    0.25, 0.0  ,  -0.0017,0, 0, 2,-3},
+  {   +0.025,   -1.67, 0.0  ,  +0.0031,0, 0, 2,-4},
+  {    1.060,    2.96,-0.166,   0.0243,3, 0, 0,+2},
+  {   36.124,   50.64,-1.300,   0.6215,3, 0, 0, 0},
+  {  -13.193,  -16.40,+0.258,  -0.1187,3, 0, 0,-2},
+  {   -1.187,   -0.74,+0.042,   0.0074,3, 0, 0,-4},
+  {   -0.293,   -0.31,-0.002,   0.0046,3, 0, 0,-6},
+  {   -0.290,   -1.45,+0.116,  -0.0051,2, 1, 0, 2},
+  {   -7.649,  -10.56,+0.259,  -0.1038,2, 1, 0, 0},
+  {   -8.627,   -7.59,+0.078,  -0.0192,2, 1, 0,-2},
+  {   -2.740,   -2.54,+0.022,   0.0324,2, 1, 0,-4},
+  {    1.181,    3.32,-0.212,   0.0213,2,-1, 0,+2},
+  {    9.703,   11.67,-0.151,   0.1268,2,-1, 0, 0},
+  {   -0.352,   -0.37,+0.001,  -0.0028,2,-1, 0,-1},
+  {   -2.494,   -1.17,-0.003,  -0.0017,2,-1, 0,-2},
+  {    0.360,    0.20,-0.012,  -0.0043,2,-1, 0,-4},
+  {   -1.167,   -1.25,+0.008,  -0.0106,1, 2, 0, 0},
+  {   -7.412,   -6.12,+0.117,   0.0484,1, 2, 0,-2},
+  {   -0.311,   -0.65,-0.032,   0.0044,1, 2, 0,-4},
+  {   +0.757,    1.82,-0.105,   0.0112,1,-2, 0, 2},
+  {   +2.580,    2.32,+0.027,   0.0196,1,-2, 0, 0},
+  {   +2.533,    2.40,-0.014,  -0.0212,1,-2, 0,-2},
+  {   -0.344,   -0.57,-0.025,  +0.0036,0, 3, 0,-2},
+  {   -0.992,   -0.02, 0.0  ,   0.0   ,1, 0, 2, 2},
+  {  -45.099,   -0.02, 0.0  ,  -0.0010,1, 0, 2, 0},
+  {   -0.179,   -9.52, 0.0  ,  -0.0833,1, 0, 2,-2},
+  {   -0.301,   -0.33, 0.0  ,   0.0014,1, 0, 2,-4},
+  {   -6.382,   -3.37, 0.0  ,  -0.0481,1, 0,-2, 2},
+  {   39.528,   85.13, 0.0  ,  -0.7136,1, 0,-2, 0},
+  {    9.366,    0.71, 0.0  ,  -0.0112,1, 0,-2,-2},
+  {    0.202,    0.02, 0.0  ,   0.0   ,1, 0,-2,-4},
+  /* Solar3 */
+  {    0.415,    0.10, 0.0  ,  0.0013,0, 1, 2, 0},
+  {   -2.152,   -2.26, 0.0  , -0.0066,0, 1, 2,-2},
+  {   -1.440,   -1.30, 0.0  , +0.0014,0, 1,-2, 2},
+  {    0.384,   -0.04, 0.0  ,  0.0   ,0, 1,-2,-2},
+  {   +1.938,   +3.60,-0.145, +0.0401,4, 0, 0, 0},
+  {   -0.952,   -1.58,+0.052, -0.0130,4, 0, 0,-2},
+  {   -0.551,   -0.94,+0.032, -0.0097,3, 1, 0, 0},
+  {   -0.482,   -0.57,+0.005, -0.0045,3, 1, 0,-2},
+  {    0.681,    0.96,-0.026,  0.0115,3,-1, 0, 0},
+  {   -0.297,   -0.27, 0.002, -0.0009,2, 2, 0,-2},
+  {    0.254,   +0.21,-0.003,  0.0   ,2,-2, 0,-2},
+  {   -0.250,   -0.22, 0.004,  0.0014,1, 3, 0,-2},
+  {   -3.996,    0.0 , 0.0  , +0.0004,2, 0, 2, 0},
+  {    0.557,   -0.75, 0.0  , -0.0090,2, 0, 2,-2},
+  {   -0.459,   -0.38, 0.0  , -0.0053,2, 0,-2, 2},
+  {   -1.298,    0.74, 0.0  , +0.0004,2, 0,-2, 0},
+  {    0.538,    1.14, 0.0  , -0.0141,2, 0,-2,-2},
+  {    0.263,    0.02, 0.0  ,  0.0   ,1, 1, 2, 0},
+  {    0.426,   +0.07, 0.0  , -0.0006,1, 1,-2,-2},
+  {   -0.304,   +0.03, 0.0  , +0.0003,1,-1, 2, 0},
+  {   -0.372,   -0.19, 0.0  , -0.0027,1,-1,-2, 2},
+  {   +0.418,    0.0 , 0.0  ,  0.0   ,0, 0, 4, 0},
+  {   -0.330,   -0.04, 0.0  ,  0.0   ,3, 0, 2, 0}
+};
+
+/*
+ *  Latitude terms: each adds COEFFN*sin(P*L + Q*LS + R*F + S*D) to N.
+ */
+typedef struct MoonNTerm {
+  double COEFFN;
+  int P, Q, R, S;
+} MoonNTerm;
+
+static const MoonNTerm NTerms[] = {
+  {-526.069, 0, 0,1,-2},
+  {  -3.352, 0, 0,1,-4},
+  { +44.297,+1, 0,1,-2},
+  {  -6.000,+1, 0,1,-4},
+  { +20.599,-1, 0,1, 0},
+  { -30.598,-1, 0,1,-2},
+  { -24.649,-2, 0,1, 0},
+  {  -2.000,-2, 0,1,-2},
+  { -22.571, 0,+1,1,-2},
+  { +10.985, 0,-1,1,-2}
+};
+
+/*
+ *  Small additive longitude terms: each adds COEFF*sine(A + B*T) to DLAM.
+ */
+typedef struct MoonAddTerm {
+  double COEFF, A, B;
+} MoonAddTerm;
+
+static const MoonAddTerm AddTerms[MOONSTEPPER_ADDTERMS] = {
+  {0.82, 0.7736,  -62.5512},
+  {0.31, 0.0466, -125.1025},
+  {0.35, 0.5785,  -25.1042},
+  {0.66, 0.4591, 1335.8075},
+  {0.64, 0.3130,  -91.5680},
+  {1.14, 0.1480, 1331.2898},
+  {0.21, 0.5918, 1056.5859},
+  {0.44, 0.5784, 1322.8595},
+  {0.24, 0.2275,   -5.7374},
+  {0.28, 0.2965,    2.6929},
+  {0.33, 0.3132,    6.3368}
+};
+
+#define NSOLARTERMS ((int)(sizeof(SolarTerms)/sizeof(SolarTerms[0])))
+#define NNTERMS     ((int)(sizeof(NTerms)/sizeof(NTerms[0])))
+
+/* Highest harmonic filled in by MoonArgs() for L, LS, F and D. */
+static const int HarmonicMax[5] = { 0, 4, 3, 4, 6 };
+
+/*
+ *  Smallest term amplitude (in arcseconds) kept by each EPHEMTIER_*. A
+ *  term's amplitude is the largest of its coefficients; the long periodic
+ *  variations and the small additive terms of MoonFinish() are dropped as
+ *  a block once the limit exceeds their largest coefficient.
+ */
+static const double TierLimit[EPHEMTIER_COUNT] = { 30.0, 2.0, 0.0 };
+
+#define LONGPERIODIC_MAX    88.70   /* Largest long periodic coefficient */
+#define ADDITIVE_MAX         1.14   /* Largest additive DLAM coefficient */
+
 
 double Moon(double T, double *LAMBDA, double *BETA, double *R, double *AGE){
 
+  MoonSeries Series, *ms = &Series;
+
+  MoonArgs(T, 0.0, ms);
+  MoonSum(ms);
+  return( MoonFinish(ms, LAMBDA, BETA, R, AGE) );
+
+}
+
+
+double MoonTier(double T, int tier, double *LAMBDA, double *BETA, double *R, double *AGE){
+
+  MoonSeries Series, *ms = &Series;
+
+  if ((tier < 0) || (tier >= EPHEMTIER_COUNT)) tier = EPHEMTIER_PRECISE;
+  MoonArgs(T, TierLimit[tier], ms);
+  MoonSum(ms);
+  return( MoonFinish(ms, LAMBDA, BETA, R, AGE) );
+
+}
+
+
+/*
+ *  Fundamental arguments and CO/SI harmonic tables for Moon(). Limit is
+ *  kept in ms for MoonSum() and MoonFinish(); 0 keeps every term.
+ */
+void MoonArgs(double T, double Limit, MoonSeries *ms){
+
+  double ARG[5], FAC[5];
+  int i;
+
+  MoonAngles(T, Limit, ms, ARG, FAC);
+  for (i=1; i<=4; ++i) MoonHarmonics(ms, i, cos(ARG[i]), sin(ARG[i]), FAC[i]);
+
+}
+
+
+/*
+ *  Fundamental arguments of Moon(): fills in everything in ms but the
+ *  CO/SI tables, and returns L, LS, F and D (ARG[1-4]) with the scale
+ *  factors of their harmonics (FAC[1-4]).
+ */
+void MoonAngles(double T, double Limit, MoonSeries *ms, double ARG[5], double FAC[5]){
+
   double T2;
   double S1, S2, S3, S4, S5, S6, S7;
   double DL0, DL, DD, DGAM, DLS, DF;
-  double L0, L, LS, F, D;
-  double ARG = 0.0, FAC = 0.0;
-  int MAX = 0, i, j;
-  double S;
+  double L, LS, F, D;
 
 
   T2 = T*T;
-  DLAM = 0.0, DS = 0.0, GAM1C = 0.0; SINPI = 3422.7000;
+  ms->DLAM = 0.0, ms->DS = 0.0, ms->GAM1C = 0.0; ms->SINPI = 3422.7000;
+  ms->N = 0.0;
+  ms->Limit = Limit;
 
   /*
    * Long Periodic variations
    */
-  S1 = sine( 0.19833 + 0.05611*T );
-  S2 = sine( 0.27869 + 0.04508*T );
-  S3 = sine( 0.16827 - 0.36903*T );
-  S4 = sine( 0.34734 - 5.37261*T );
-  S5 = sine( 0.10498 - 5.37899*T );
-  S6 = sine( 0.42681 - 0.41855*T );
-  S7 = sine( 0.14943 - 5.37511*T );
-  DL0 = 0.84*S1 + 0.31*S2 + 14.27*S3 + 7.26*S4 + 0.28*S5 + 0.24*S6;
-  DL  = 2.94*S1 + 0.31*S2 + 14.27*S3 + 9.34*S4 + 1.12*S5 + 0.83*S6;
-  DLS = -6.40*S1 - 1.89*S6;
-  DF = 0.21*S1 + 0.31*S2 + 14.27*S3 - 88.70*S4 - 15.30*S5 + 0.24*S6 - 1.86*S7;
-  DD = DL0 - DLS;
-  DGAM = -3332e-9 * sine( 0.59734 - 5.37261*T)
-      -539e-9 * sine( 0.35498 - 5.37899*T)
-      -64e-9 * sine( 0.39943 - 5.37511*T);
-
-
-
-  L0  = TwoPi*frac( 0.60643382 + 1336.85522467*T - 0.00000313*T2 ) + DL0/ARC;
+  if (Limit > LONGPERIODIC_MAX){
+    DL0 = DL = DLS = DF = DD = DGAM = 0.0;
+  } else {
+    S1 = sine( 0.19833 + 0.05611*T );
+    S2 = sine( 0.27869 + 0.04508*T );
+    S3 = sine( 0.16827 - 0.36903*T );
+    S4 = sine( 0.34734 - 5.37261*T );
+    S5 = sine( 0.10498 - 5.37899*T );
+    S6 = sine( 0.42681 - 0.41855*T );
+    S7 = sine( 0.14943 - 5.37511*T );
+    DL0 = 0.84*S1 + 0.31*S2 + 14.27*S3 + 7.26*S4 + 0.28*S5 + 0.24*S6;
+    DL  = 2.94*S1 + 0.31*S2 + 14.27*S3 + 9.34*S4 + 1.12*S5 + 0.83*S6;
+    DLS = -6.40*S1 - 1.89*S6;
+    DF = 0.21*S1 + 0.31*S2 + 14.27*S3 - 88.70*S4 - 15.30*S5 + 0.24*S6 - 1.86*S7;
+    DD = DL0 - DLS;
+    DGAM = -3332e-9 * sine( 0.59734 - 5.37261*T)
+        -539e-9 * sine( 0.35498 - 5.37899*T)
+        -64e-9 * sine( 0.39943 - 5.37511*T);
+  }
+
+
+
+  ms->L0 = TwoPi*frac( 0.60643382 + 1336.85522467*T - 0.00000313*T2 ) + DL0/ARC;
   L   = TwoPi*frac( 0.37489701 + 1325.55240982*T + 0.00002565*T2 ) + DL/ARC;
   LS  = TwoPi*frac( 0.99312619 +   99.99735956*T - 0.00000044*T2 ) + DLS/ARC;
   F   = TwoPi*frac( 0.25909118 + 1342.22782980*T - 0.00000892*T2 ) + DF/ARC;
   D   = TwoPi*frac( 0.82736186 + 1236.85308708*T - 0.00000397*T2 ) + DD/ARC;
+  ms->T = T, ms->LS = LS, ms->F = F, ms->D = D, ms->DGAM = DGAM;
 
-  for (i=1; i<=4; ++i){
-    switch (i){
-      case 1:
-        ARG = L,  MAX = 4, FAC = 1.000002208;
-        break;
-      case 2:
-        ARG = LS, MAX = 3, FAC = 0.997504612 - 0.002495388*T;
-        break;
-      case 3:
-        ARG = F,  MAX = 4, FAC = 1.000002708 + 139.978*DGAM;
-        break;
-      case 4:
-        ARG = D,  MAX = 6, FAC = 1.0;
-        break;
-    }
+  ARG[1] = L,  FAC[1] = 1.000002208;
+  ARG[2] = LS, FAC[2] = 0.997504612 - 0.002495388*T;
+  ARG[3] = F,  FAC[3] = 1.000002708 + 139.978*DGAM;
+  ARG[4] = D,  FAC[4] = 1.0;
+
+}
 
-    CO[6+0][i] = 1.0, CO[6+1][i] = cos(ARG)*FAC;
-    SI[6+0][i] = 0.0, SI[6+1][i] = sin(ARG)*FAC;
-    for (j=2; j<=MAX; ++j) addthe(CO[6+j-1][i], SI[6+j-1][i], CO[6+1][i], SI[6+1][i], &CO[6+j][i], &SI[6+j][i]);
-    for (j=1; j<=MAX; ++j) {
-      CO[6-j][i] = CO[6+j][i];
-      SI[6-j][i] = -SI[6+j][i];
-    }
 
+/*
+ *  CO/SI harmonic table of argument i (1-4) from C and S, the cosine and
+ *  sine of the argument, and FAC, the scale factor.
+ */
+void MoonHarmonics(MoonSeries *ms, int i, double C, double S, double FAC){
 
+  int j, MAX = HarmonicMax[i];
+
+  ms->CO[6+0][i] = 1.0, ms->CO[6+1][i] = C*FAC;
+  ms->SI[6+0][i] = 0.0, ms->SI[6+1][i] = S*FAC;
+  for (j=2; j<=MAX; ++j) addthe(ms->CO[6+j-1][i], ms->SI[6+j-1][i], ms->CO[6+1][i], ms->SI[6+1][i], &ms->CO[6+j][i], &ms->SI[6+j][i]);
+  for (j=1; j<=MAX; ++j) {
+    ms->CO[6-j][i] = ms->CO[6+j][i];
+    ms->SI[6-j][i] = -ms->SI[6+j][i];
   }
 
+}
 
 
-  /*
-   *  Solar1
-   */
-  addsol(   13.902,   14.06,-0.001,   0.2607,0, 0, 0, 4);
-  addsol(    0.403,   -4.01,+0.394,   0.0023,0, 0, 0, 3);
-  addsol( 2369.912, 2373.36,+0.601,  28.2333,0, 0, 0, 2);
-  addsol( -125.154, -112.79,-0.725,  -0.9781,0, 0, 0, 1);
-  addsol(    1.979,    6.98,-0.445,   0.0433,1, 0, 0, 4);
-  addsol(  191.953,  192.72,+0.029,   3.0861,1, 0, 0, 2);
-  addsol(   -8.466,  -13.51,+0.455,  -0.1093,1, 0, 0, 1);
-  addsol(22639.500,22609.07,+0.079, 186.5398,1, 0, 0, 0);
-  addsol(   18.609,    3.59,-0.094,   0.0118,1, 0, 0,-1);
-  addsol(-4586.465,-4578.13,-0.077,  34.3117,1, 0, 0,-2);
-  addsol(   +3.215,    5.44,+0.192,  -0.0386,1, 0, 0,-3);
-  addsol(  -38.428,  -38.64,+0.001,   0.6008,1, 0, 0,-4);
-  addsol(   -0.393,   -1.43,-0.092,   0.0086,1, 0, 0,-6);
-  addsol(   -0.289,   -1.59,+0.123,  -0.0053,0, 1, 0, 4);
-  addsol(  -24.420,  -25.10,+0.040,  -0.3000,0, 1, 0, 2);
-  addsol(   18.023,   17.93,+0.007,   0.1494,0, 1, 0, 1);
-  addsol( -668.146, -126.98,-1.302,  -0.3997,0, 1, 0, 0);
-  addsol(    0.560,    0.32,-0.001,  -0.0037,0, 1, 0,-1);
-  addsol( -165.145, -165.06,+0.054,   1.9178,0, 1, 0,-2);
-  addsol(   -1.877,   -6.46,-0.416,   0.0339,0, 1, 0,-4);
-  addsol(    0.213,    1.02,-0.074,   0.0054,2, 0, 0, 4);
-  addsol(   14.387,   14.78,-0.017,   0.2833,2, 0, 0, 2);
-  addsol(   -0.586,   -1.20,+0.054,  -0.0100,2, 0, 0, 1);
-  addsol(  769.016,  767.96,+0.107,  10.1657,2, 0, 0, 0);
-  addsol(   +1.750,    2.01,-0.018,   0.0155,2, 0, 0,-1);
-  addsol( -211.656, -152.53,+5.679,  -0.3039,2, 0, 0,-2);
-  addsol(   +1.225,    0.91,-0.030,  -0.0088,2, 0, 0,-3);
-  addsol(  -30.773,  -34.07,-0.308,   0.3722,2, 0, 0,-4);
-  addsol(   -0.570,   -1.40,-0.074,   0.0109,2, 0, 0,-6);
-  addsol(   -2.921,  -11.75,+0.787,  -0.0484,1, 1, 0, 2);
-  addsol(   +1.267,    1.52,-0.022,   0.0164,1, 1, 0, 1);
-  addsol( -109.673, -115.18,+0.461,  -0.9490,1, 1, 0, 0);
-  addsol( -205.962, -182.36,+2.056,  +1.4437,1, 1, 0,-2);
-  addsol(    0.233,    0.36, 0.012,  -0.0025,1, 1, 0,-3);
-  addsol(   -4.391,   -9.66,-0.471,   0.0673,1, 1, 0,-4);
+/*
+ *  Accumulates the SolarTerms/NTerms series into DLAM, DS, GAM1C, SINPI, N.
+ */
+void MoonSum(MoonSeries *ms){
 
+  const MoonTerm *t;
+  const MoonNTerm *n;
+  double PX = 1.0, PY = 0.0, X, Y;
+  int i, P = 0, Q = 0, R = 0;
 
   /*
-   *  Solar2
+   *  Terms with the same P, Q and R are adjacent in the tables, so the
+   *  product of the L, LS and F harmonics is only formed when that prefix
+   *  changes. Each term then multiplies in its D harmonic. The products are
+   *  taken in the same order as term(), so the sums are unchanged.
    */
-  addsol(    0.283,    1.53,-0.111,  +0.0060,1,-1, 0,+4);
-  addsol(   14.577,   31.70,-1.540,  +0.2302,1,-1, 0, 2);
-  addsol(  147.687,  138.76,+0.679,  +1.1528,1,-1, 0, 0);
-  addsol(   -1.089,    0.55,+0.021,   0.0   ,1,-1, 0,-1);
-  addsol(   28.475,   23.59,-0.443,  -0.2257,1,-1, 0,-2);
-  addsol(   -0.276,   -0.38,-0.006,  -0.0036,1,-1, 0,-3);
-  addsol(    0.636,    2.27,+0.146,  -0.0102,1,-1, 0,-4);
-  addsol(   -0.189,   -1.68,+0.131,  -0.0028,0, 2, 0, 2);
-  addsol(   -7.486,   -0.66,-0.037,  -0.0086,0, 2, 0, 0);
-  addsol(   -8.096,  -16.35,-0.740,   0.0918,0, 2, 0,-2);
-  addsol(   -5.741,   -0.04, 0.0  ,  -0.0009,0, 0, 2, 2);
-  addsol(    0.255,    0.0 , 0.0  ,   0.0   ,0, 0, 2, 1);
-  addsol( -411.608,   -0.20, 0.0  ,  -0.0124,0, 0, 2, 0);
-  addsol(    0.584,    0.84, 0.0  ,  +0.0071,0, 0, 2,-1);
-  addsol(  -55.173,  -52.14, 0.0  ,  -0.1052,0, 0, 2,-2);
-  addsol(    0.254,    0.25, 0.0  ,  -0.0017,0, 0, 2,-3);
-  addsol(   +0.025,   -1.67, 0.0  ,  +0.0031,0, 0, 2,-4);
-  addsol(    1.060,    2.96,-0.166,   0.0243,3, 0, 0,+2);
-  addsol(   36.124,   50.64,-1.300,   0.6215,3, 0, 0, 0);
-  addsol(  -13.193,  -16.40,+0.258,  -0.1187,3, 0, 0,-2);
-  addsol(   -1.187,   -0.74,+0.042,   0.0074,3, 0, 0,-4);
-  addsol(   -0.293,   -0.31,-0.002,   0.0046,3, 0, 0,-6);
-  addsol(   -0.290,   -1.45,+0.116,  -0.0051,2, 1, 0, 2);
-  addsol(   -7.649,  -10.56,+0.259,  -0.1038,2, 1, 0, 0);
-  addsol(   -8.627,   -7.59,+0.078,  -0.0192,2, 1, 0,-2);
-  addsol(   -2.740,   -2.54,+0.022,   0.0324,2, 1, 0,-4);
-  addsol(    1.181,    3.32,-0.212,   0.0213,2,-1, 0,+2);
-  addsol(    9.703,   11.67,-0.151,   0.1268,2,-1, 0, 0);
-  addsol(   -0.352,   -0.37,+0.001,  -0.0028,2,-1, 0,-1);
-  addsol(   -2.494,   -1.17,-0.003,  -0.0017,2,-1, 0,-2);
-  addsol(    0.360,    0.20,-0.012,  -0.0043,2,-1, 0,-4);
-  addsol(   -1.167,   -1.25,+0.008,  -0.0106,1, 2, 0, 0);
-  addsol(   -7.412,   -6.12,+0.117,   0.0484,1, 2, 0,-2);
-  addsol(   -0.311,   -0.65,-0.032,   0.0044,1, 2, 0,-4);
-  addsol(   +0.757,    1.82,-0.105,   0.0112,1,-2, 0, 2);
-  addsol(   +2.580,    2.32,+0.027,   0.0196,1,-2, 0, 0);
-  addsol(   +2.533,    2.40,-0.014,  -0.0212,1,-2, 0,-2);
-  addsol(   -0.344,   -0.57,-0.025,  +0.0036,0, 3, 0,-2);
-  addsol(   -0.992,   -0.02, 0.0  ,   0.0   ,1, 0, 2, 2);
-  addsol(  -45.099,   -0.02, 0.0  ,  -0.0010,1, 0, 2, 0);
-  addsol(   -0.179,   -9.52, 0.0  ,  -0.0833,1, 0, 2,-2);
-  addsol(   -0.301,   -0.33, 0.0  ,   0.0014,1, 0, 2,-4);
-  addsol(   -6.382,   -3.37, 0.0  ,  -0.0481,1, 0,-2, 2);
-  addsol(   39.528,   85.13, 0.0  ,  -0.7136,1, 0,-2, 0);
-  addsol(    9.366,    0.71, 0.0  ,  -0.0112,1, 0,-2,-2);
-  addsol(    0.202,    0.02, 0.0  ,   0.0   ,1, 0,-2,-4);
+  for (i=0; i<NSOLARTERMS; ++i){
+    t = &SolarTerms[i];
+    if ((ms->Limit > 0.0) && (fabs(t->COEFFL) < ms->Limit) && (fabs(t->COEFFS) < ms->Limit)
+        && (fabs(t->COEFFG) < ms->Limit) && (fabs(t->COEFFP) < ms->Limit)) continue;
+    if ((i == 0) || (t->P != P) || (t->Q != Q) || (t->R != R)){
+      P = t->P, Q = t->Q, R = t->R;
+      term(ms, P, Q, R, 0, &PX, &PY);
+    }
+    if (t->S != 0) addthe(PX, PY, ms->CO[6+t->S][4], ms->SI[6+t->S][4], &X, &Y);
+    else X = PX, Y = PY;
+    ms->DLAM += t->COEFFL*Y;
+    ms->DS += t->COEFFS*Y;
+    ms->GAM1C += t->COEFFG*X;
+    ms->SINPI += t->COEFFP*X;
+  }
+
+  for (i=0; i<NNTERMS; ++i){
+    n = &NTerms[i];
+    if (fabs(n->COEFFN) < ms->Limit) continue;
+    if ((i == 0) || (n->P != P) || (n->Q != Q) || (n->R != R)){
+      P = n->P, Q = n->Q, R = n->R;
+      term(ms, P, Q, R, 0, &PX, &PY);
+    }
+    if (n->S != 0) addthe(PX, PY, ms->CO[6+n->S][4], ms->SI[6+n->S][4], &X, &Y);
+    else X = PX, Y = PY;
+    ms->N += n->COEFFN*Y;
+  }
+
+}
 
-  /*
-   *  Solar3
-   */
-  addsol(    0.415,    0.10, 0.0  ,  0.0013,0, 1, 2, 0);
-  addsol(   -2.152,   -2.26, 0.0  , -0.0066,0, 1, 2,-2);
-  addsol(   -1.440,   -1.30, 0.0  , +0.0014,0, 1,-2, 2);
-  addsol(    0.384,   -0.04, 0.0  ,  0.0   ,0, 1,-2,-2);
-  addsol(   +1.938,   +3.60,-0.145, +0.0401,4, 0, 0, 0);
-  addsol(   -0.952,   -1.58,+0.052, -0.0130,4, 0, 0,-2);
-  addsol(   -0.551,   -0.94,+0.032, -0.0097,3, 1, 0, 0);
-  addsol(   -0.482,   -0.57,+0.005, -0.0045,3, 1, 0,-2);
-  addsol(    0.681,    0.96,-0.026,  0.0115,3,-1, 0, 0);
-  addsol(   -0.297,   -0.27, 0.002, -0.0009,2, 2, 0,-2);
-  addsol(    0.254,   +0.21,-0.003,  0.0   ,2,-2, 0,-2);
-  addsol(   -0.250,   -0.22, 0.004,  0.0014,1, 3, 0,-2);
-  addsol(   -3.996,    0.0 , 0.0  , +0.0004,2, 0, 2, 0);
-  addsol(    0.557,   -0.75, 0.0  , -0.0090,2, 0, 2,-2);
-  addsol(   -0.459,   -0.38, 0.0  , -0.0053,2, 0,-2, 2);
-  addsol(   -1.298,    0.74, 0.0  , +0.0004,2, 0,-2, 0);
-  addsol(    0.538,    1.14, 0.0  , -0.0141,2, 0,-2,-2);
-  addsol(    0.263,    0.02, 0.0  ,  0.0   ,1, 1, 2, 0);
-  addsol(    0.426,   +0.07, 0.0  , -0.0006,1, 1,-2,-2);
-  addsol(   -0.304,   +0.03, 0.0  , +0.0003,1,-1, 2, 0);
-  addsol(   -0.372,   -0.19, 0.0  , -0.0027,1,-1,-2, 2);
-  addsol(   +0.418,    0.0 , 0.0  ,  0.0   ,0, 0, 4, 0);
-  addsol(   -0.330,   -0.04, 0.0  ,  0.0   ,3, 0, 2, 0);
 
-  N = 0.0;
-  addn(-526.069, 0, 0,1,-2); addn(  -3.352, 0, 0,1,-4);
-  addn( +44.297,+1, 0,1,-2); addn(  -6.000,+1, 0,1,-4);
-  addn( +20.599,-1, 0,1, 0); addn( -30.598,-1, 0,1,-2);
-  addn( -24.649,-2, 0,1, 0); addn(  -2.000,-2, 0,1,-2);
-  addn( -22.571, 0,+1,1,-2); addn( +10.985, 0,-1,1,-2);
+/*
+ *  Turns the accumulated series into LAMBDA, BETA, R and AGE. Returns the
+ *  phase.
+ */
+double MoonFinish(MoonSeries *ms, double *LAMBDA, double *BETA, double *R, double *AGE){
+
+  double T = ms->T;
+  double S, FAC, Sum;
+  int i;
+
 
-  DLAM += +0.82*sine( 0.7736   -62.5512*T ) + 0.31*sine( 0.0466  -125.1025*T )
-          +0.35*sine( 0.5785   -25.1042*T ) + 0.66*sine( 0.4591 +1335.8075*T )
-          +0.64*sine( 0.3130   -91.5680*T ) + 1.14*sine( 0.1480 +1331.2898*T )
-          +0.21*sine( 0.5918 +1056.5859*T ) + 0.44*sine( 0.5784 +1322.8595*T )
-          +0.24*sine( 0.2275    -5.7374*T ) + 0.28*sine( 0.2965    +2.6929*T )
-          +0.33*sine( 0.3132    +6.3368*T );
+  if (ms->Limit <= ADDITIVE_MAX){
+    for (i=0, Sum=0.0; i<MOONSTEPPER_ADDTERMS; ++i)
+      Sum += AddTerms[i].COEFF*sine( AddTerms[i].A + AddTerms[i].B*T );
+    ms->DLAM += Sum;
+  }
 
 
 
@@ -265,19 +454,19 @@ double Moon(double T, double *LAMBDA, double *BETA, double *R, double *AGE){
 
 
 
-  *LAMBDA = 360.0*frac( (L0+DLAM/ARC)/TwoPi );
+  *LAMBDA = 360.0*frac( (ms->L0+ms->DLAM/ARC)/TwoPi );
 
-  S = F + DS/ARC;
-  FAC = 1.000002708 + 139.978*DGAM;
-  *BETA = (FAC*(18518.511 + 1.189 + GAM1C)*sin(S) - 6.24*sin(3*S) + N)/3600.0;
+  S = ms->F + ms->DS/ARC;
+  FAC = 1.000002708 + 139.978*ms->DGAM;
+  *BETA = (FAC*(18518.511 + 1.189 + ms->GAM1C)*sin(S) - 6.24*sin(3*S) + ms->N)/3600.0;
 
-  SINPI *= 0.999953253;
-  *R = ARC/SINPI;
+  ms->SINPI *= 0.999953253;
+  *R = ARC/ms->SINPI;
 
 
-  DLAMS = 6893.0 * sin(LS) + 72.0 * sin(2.0*LS);
+  ms->DLAMS = 6893.0 * sin(ms->LS) + 72.0 * sin(2.0*ms->LS);
 
-  *AGE = 29.530589*frac((D+(DLAM-DLAMS)/ARC)/TwoPi);
+  *AGE = 29.530589*frac((ms->D+(ms->DLAM-ms->DLAMS)/ARC)/TwoPi);
 /*
 printf("Diff = %f\n", 360.0*frac((D+(DLAM-DLAMS)/ARC)/TwoPi));
 */
@@ -295,38 +484,374 @@ printf("Diff = %f\n", 360.0*frac((D+(DLAM-DLAMS)/ARC)/TwoPi));
 }
 
 
-double sine(double phi){
+void MoonStepper_Init(MoonStepper *s, double T0, double dT, int tier){
 
-  return( sin(TwoPi*frac(phi)) );
+  if ((tier < 0) || (tier >= EPHEMTIER_COUNT)) tier = EPHEMTIER_PRECISE;
+  s->T0 = T0, s->dT = dT, s->Step = 0, s->tier = tier;
 
 }
 
 
-double frac(double x){
+/*
+ *  Recomputes the state at the next sample exactly, and the rotations and
+ *  increments that carry it to the sample after. Over one renormalization
+ *  interval the arguments are taken as linear in time, which is good to
+ *  far better than the series itself for steps of up to a day.
+ */
+void MoonStepper_Renormalize(MoonStepper *s){
 
-  x -= (int)x;
-  return( (x<0) ? x+1.0 : x );
+  MoonSeries Next;
+  double T, Angle, ARG[5], FAC[5], ARG1[5], FAC1[5];
+  int i;
+
+  T = s->T0 + s->Step*s->dT;
+  MoonAngles(T, TierLimit[s->tier], &s->Series, ARG, FAC);
+  MoonAngles(T+s->dT, TierLimit[s->tier], &Next, ARG1, FAC1);
+
+  for (i=1; i<=4; ++i){
+    s->Arg[i][0] = cos(ARG[i]), s->Arg[i][1] = sin(ARG[i]);
+    s->ArgStep[i][0] = cos(ARG1[i]-ARG[i]), s->ArgStep[i][1] = sin(ARG1[i]-ARG[i]);
+    s->FAC[i] = FAC[i], s->FACStep[i] = FAC1[i]-FAC[i];
+  }
+
+  s->AngleStep[0] = Next.L0 - s->Series.L0;
+  s->AngleStep[1] = Next.LS - s->Series.LS;
+  s->AngleStep[2] = Next.F - s->Series.F;
+  s->AngleStep[3] = Next.D - s->Series.D;
+  for (i=0; i<4; ++i) s->AngleStep[i] -= TwoPi*floor(s->AngleStep[i]/TwoPi + 0.5);
+  s->AngleStep[4] = Next.DGAM - s->Series.DGAM;
+
+  for (i=0; i<MOONSTEPPER_ADDTERMS; ++i){
+    Angle = TwoPi*frac( AddTerms[i].A + AddTerms[i].B*T );
+    s->Add[i][0] = cos(Angle), s->Add[i][1] = sin(Angle);
+    Angle = TwoPi*AddTerms[i].B*s->dT;
+    s->AddStep[i][0] = cos(Angle), s->AddStep[i][1] = sin(Angle);
+  }
+
+}
+
+
+double MoonStepper_Next(MoonStepper *s, double *T, double *LAMBDA, double *BETA, double *R, double *AGE){
+
+  MoonSeries *ms = &s->Series;
+  double Phase;
+  int i;
+
+  if ((s->Step % MOONSTEPPER_RENORMALIZE) == 0) MoonStepper_Renormalize(s);
+
+  ms->DLAM = 0.0, ms->DS = 0.0, ms->GAM1C = 0.0; ms->SINPI = 3422.7000;
+  ms->N = 0.0;
+  for (i=1; i<=4; ++i) MoonHarmonics(ms, i, s->Arg[i][0], s->Arg[i][1], s->FAC[i]);
+  MoonSum(ms);
+  *T = ms->T;
+  Phase = MoonStepper_Finish(s, LAMBDA, BETA, R, AGE);
+
+  /*
+   *  Advance to the next sample.
+   */
+  for (i=1; i<=4; ++i){
+    addthe(s->Arg[i][0], s->Arg[i][1], s->ArgStep[i][0], s->ArgStep[i][1], &s->Arg[i][0], &s->Arg[i][1]);
+    s->FAC[i] += s->FACStep[i];
+  }
+  ms->L0 += s->AngleStep[0];
+  ms->LS += s->AngleStep[1];
+  ms->F += s->AngleStep[2];
+  ms->D += s->AngleStep[3];
+  ms->DGAM += s->AngleStep[4];
+  for (i=0; i<MOONSTEPPER_ADDTERMS; ++i)
+    addthe(s->Add[i][0], s->Add[i][1], s->AddStep[i][0], s->AddStep[i][1], &s->Add[i][0], &s->Add[i][1]);
+  ++s->Step;
+  ms->T = s->T0 + s->Step*s->dT;
+
+  return( Phase );
+
+}
+
+
+/*
+ *  MoonFinish() for a stepper: the sines of the additive terms and of LS
+ *  come from the stepped rotations, and sin(3S) from sin(S), which leaves
+ *  a single sin() per sample.
+ */
+double MoonStepper_Finish(MoonStepper *s, double *LAMBDA, double *BETA, double *R, double *AGE){
+
+  MoonSeries *ms = &s->Series;
+  double SinS, FAC, Sum;
+  int i;
+
+
+  if (ms->Limit <= ADDITIVE_MAX){
+    for (i=0, Sum=0.0; i<MOONSTEPPER_ADDTERMS; ++i)
+      Sum += AddTerms[i].COEFF*s->Add[i][1];
+    ms->DLAM += Sum;
+  }
+
+  *LAMBDA = 360.0*frac( (ms->L0+ms->DLAM/ARC)/TwoPi );
+
+  SinS = sin(ms->F + ms->DS/ARC);
+  FAC = 1.000002708 + 139.978*ms->DGAM;
+  *BETA = (FAC*(18518.511 + 1.189 + ms->GAM1C)*SinS - 6.24*SinS*(3.0 - 4.0*SinS*SinS) + ms->N)/3600.0;
+
+  ms->SINPI *= 0.999953253;
+  *R = ARC/ms->SINPI;
+
+  ms->DLAMS = 6893.0 * s->Arg[2][1] + 72.0 * 2.0*s->Arg[2][1]*s->Arg[2][0];
+
+  *AGE = 29.530589*frac((ms->D+(ms->DLAM-ms->DLAMS)/ARC)/TwoPi);
+
+  return( *AGE/29.530589 );
+
+}
+
+
+/*
+ *  Moon() for four time values at once. The fundamental arguments and the
+ *  final conversion are done lane by lane; the SolarTerms/NTerms series,
+ *  which is most of the work, runs on all four lanes together with AVX2 or
+ *  SSE2 when the CPU has them (checked at run time). Every lane does the
+ *  same operations in the same order as MoonSum(), so the results match
+ *  Moon() exactly.
+ */
+void Moon4(double const T[4], double LAMBDA[4], double BETA[4], double R[4], double AGE[4], double PHASE[4]){
+
+  MoonSeries ms[4];
+  int i;
+
+  for (i=0; i<4; ++i) MoonArgs(T[i], 0.0, &ms[i]);
+  MoonSum4(ms);
+  for (i=0; i<4; ++i) PHASE[i] = MoonFinish(&ms[i], &LAMBDA[i], &BETA[i], &R[i], &AGE[i]);
 
 }
 
 
+#ifdef MOON4_X86
 
-void addsol(double COEFFL, double COEFFS, double COEFFG, double COEFFP, int P, int Q, int R, int S){
+/*
+ *  CO/SI tables of four MoonSeries interleaved by lane, so that one
+ *  harmonic of all four lanes is a single aligned vector load.
+ */
+typedef struct MoonHarmonics4 {
+  double CO[14][5][4] __attribute__((aligned(32)));
+  double SI[14][5][4] __attribute__((aligned(32)));
+} MoonHarmonics4;
+
+static void Interleave4(MoonSeries const ms[4], MoonHarmonics4 *h){
+
+  int j, k, l;
+
+  for (k=1; k<=4; ++k)
+    for (j=6-HarmonicMax[k]; j<=6+HarmonicMax[k]; ++j)
+      for (l=0; l<4; ++l){
+        h->CO[j][k][l] = ms[l].CO[j][k];
+        h->SI[j][k][l] = ms[l].SI[j][k];
+      }
+
+}
+
+/*
+ *  P, Q, R, S of entry i of SolarTerms followed by NTerms.
+ */
+static void TermIndex(int i, int I[5]){
+
+  if (i < NSOLARTERMS)
+    I[1] = SolarTerms[i].P, I[2] = SolarTerms[i].Q, I[3] = SolarTerms[i].R, I[4] = SolarTerms[i].S;
+  else
+    I[1] = NTerms[i-NSOLARTERMS].P, I[2] = NTerms[i-NSOLARTERMS].Q, I[3] = NTerms[i-NSOLARTERMS].R, I[4] = NTerms[i-NSOLARTERMS].S;
+
+}
+
+__attribute__((target("avx2")))
+static void MoonSum4_AVX2(MoonSeries ms[4]){
+
+  MoonHarmonics4 h;
+  __m256d DLAM, DS, GAM1C, SINPI, N, PX, PY, X, Y, C, S, XX;
+  double out[4] __attribute__((aligned(32)));
+  int i, k, I[5], P[4] = { 0, 0, 0, 0 };
+
+  Interleave4(ms, &h);
+  DLAM  = _mm256_set_pd(ms[3].DLAM, ms[2].DLAM, ms[1].DLAM, ms[0].DLAM);
+  DS    = _mm256_set_pd(ms[3].DS, ms[2].DS, ms[1].DS, ms[0].DS);
+  GAM1C = _mm256_set_pd(ms[3].GAM1C, ms[2].GAM1C, ms[1].GAM1C, ms[0].GAM1C);
+  SINPI = _mm256_set_pd(ms[3].SINPI, ms[2].SINPI, ms[1].SINPI, ms[0].SINPI);
+  N     = _mm256_set_pd(ms[3].N, ms[2].N, ms[1].N, ms[0].N);
+  PX = _mm256_set1_pd(1.0), PY = _mm256_setzero_pd();
+
+  /* Same prefix reuse and product order as MoonSum(). */
+  for (i=0; i<NSOLARTERMS+NNTERMS; ++i){
+    TermIndex(i, I);
+    if ((i == 0) || (i == NSOLARTERMS) || (I[1] != P[1]) || (I[2] != P[2]) || (I[3] != P[3])){
+      P[1] = I[1], P[2] = I[2], P[3] = I[3];
+      PX = _mm256_set1_pd(1.0), PY = _mm256_setzero_pd();
+      for (k=1; k<=3; ++k){
+        if (I[k] != 0){
+          C = _mm256_load_pd(h.CO[6+I[k]][k]);
+          S = _mm256_load_pd(h.SI[6+I[k]][k]);
+          XX = _mm256_sub_pd(_mm256_mul_pd(PX, C), _mm256_mul_pd(PY, S));
+          PY = _mm256_add_pd(_mm256_mul_pd(PY, C), _mm256_mul_pd(PX, S));
+          PX = XX;
+        }
+      }
+    }
+    if (I[4] != 0){
+      C = _mm256_load_pd(h.CO[6+I[4]][4]);
+      S = _mm256_load_pd(h.SI[6+I[4]][4]);
+      X = _mm256_sub_pd(_mm256_mul_pd(PX, C), _mm256_mul_pd(PY, S));
+      Y = _mm256_add_pd(_mm256_mul_pd(PY, C), _mm256_mul_pd(PX, S));
+    } else {
+      X = PX, Y = PY;
+    }
+    if (i < NSOLARTERMS){
+      DLAM  = _mm256_add_pd(DLAM,  _mm256_mul_pd(_mm256_set1_pd(SolarTerms[i].COEFFL), Y));
+      DS    = _mm256_add_pd(DS,    _mm256_mul_pd(_mm256_set1_pd(SolarTerms[i].COEFFS), Y));
+      GAM1C = _mm256_add_pd(GAM1C, _mm256_mul_pd(_mm256_set1_pd(SolarTerms[i].COEFFG), X));
+      SINPI = _mm256_add_pd(SINPI, _mm256_mul_pd(_mm256_set1_pd(SolarTerms[i].COEFFP), X));
+    } else {
+      N = _mm256_add_pd(N, _mm256_mul_pd(_mm256_set1_pd(NTerms[i-NSOLARTERMS].COEFFN), Y));
+    }
+  }
+
+  _mm256_store_pd(out, DLAM);  for (k=0; k<4; ++k) ms[k].DLAM = out[k];
+  _mm256_store_pd(out, DS);    for (k=0; k<4; ++k) ms[k].DS = out[k];
+  _mm256_store_pd(out, GAM1C); for (k=0; k<4; ++k) ms[k].GAM1C = out[k];
+  _mm256_store_pd(out, SINPI); for (k=0; k<4; ++k) ms[k].SINPI = out[k];
+  _mm256_store_pd(out, N);     for (k=0; k<4; ++k) ms[k].N = out[k];
+
+}
+
+__attribute__((target("sse2")))
+static void MoonSum4_SSE2(MoonSeries ms[4]){
+
+  MoonHarmonics4 h;
+  __m128d DLAM[2], DS[2], GAM1C[2], SINPI[2], N[2], PX[2], PY[2], X, Y, C, S, XX;
+  double out[2] __attribute__((aligned(16)));
+  int i, k, l, I[5], P[4] = { 0, 0, 0, 0 };
+
+  Interleave4(ms, &h);
+  for (l=0; l<2; ++l){
+    DLAM[l]  = _mm_set_pd(ms[2*l+1].DLAM, ms[2*l].DLAM);
+    DS[l]    = _mm_set_pd(ms[2*l+1].DS, ms[2*l].DS);
+    GAM1C[l] = _mm_set_pd(ms[2*l+1].GAM1C, ms[2*l].GAM1C);
+    SINPI[l] = _mm_set_pd(ms[2*l+1].SINPI, ms[2*l].SINPI);
+    N[l]     = _mm_set_pd(ms[2*l+1].N, ms[2*l].N);
+    PX[l] = _mm_set1_pd(1.0), PY[l] = _mm_setzero_pd();
+  }
+
+  /* Same prefix reuse and product order as MoonSum(). */
+  for (i=0; i<NSOLARTERMS+NNTERMS; ++i){
+    TermIndex(i, I);
+    if ((i == 0) || (i == NSOLARTERMS) || (I[1] != P[1]) || (I[2] != P[2]) || (I[3] != P[3])){
+      P[1] = I[1], P[2] = I[2], P[3] = I[3];
+      for (l=0; l<2; ++l){
+        PX[l] = _mm_set1_pd(1.0), PY[l] = _mm_setzero_pd();
+        for (k=1; k<=3; ++k){
+          if (I[k] != 0){
+            C = _mm_load_pd(&h.CO[6+I[k]][k][2*l]);
+            S = _mm_load_pd(&h.SI[6+I[k]][k][2*l]);
+            XX    = _mm_sub_pd(_mm_mul_pd(PX[l], C), _mm_mul_pd(PY[l], S));
+            PY[l] = _mm_add_pd(_mm_mul_pd(PY[l], C), _mm_mul_pd(PX[l], S));
+            PX[l] = XX;
+          }
+        }
+      }
+    }
+    for (l=0; l<2; ++l){
+      if (I[4] != 0){
+        C = _mm_load_pd(&h.CO[6+I[4]][4][2*l]);
+        S = _mm_load_pd(&h.SI[6+I[4]][4][2*l]);
+        X = _mm_sub_pd(_mm_mul_pd(PX[l], C), _mm_mul_pd(PY[l], S));
+        Y = _mm_add_pd(_mm_mul_pd(PY[l], C), _mm_mul_pd(PX[l], S));
+      } else {
+        X = PX[l], Y = PY[l];
+      }
+      if (i < NSOLARTERMS){
+        DLAM[l]  = _mm_add_pd(DLAM[l],  _mm_mul_pd(_mm_set1_pd(SolarTerms[i].COEFFL), Y));
+        DS[l]    = _mm_add_pd(DS[l],    _mm_mul_pd(_mm_set1_pd(SolarTerms[i].COEFFS), Y));
+        GAM1C[l] = _mm_add_pd(GAM1C[l], _mm_mul_pd(_mm_set1_pd(SolarTerms[i].COEFFG), X));
+        SINPI[l] = _mm_add_pd(SINPI[l], _mm_mul_pd(_mm_set1_pd(SolarTerms[i].COEFFP), X));
+      } else {
+        N[l] = _mm_add_pd(N[l], _mm_mul_pd(_mm_set1_pd(NTerms[i-NSOLARTERMS].COEFFN), Y));
+      }
+    }
+  }
+
+  for (l=0; l<2; ++l){
+    _mm_store_pd(out, DLAM[l]);  ms[2*l].DLAM = out[0],  ms[2*l+1].DLAM = out[1];
+    _mm_store_pd(out, DS[l]);    ms[2*l].DS = out[0],    ms[2*l+1].DS = out[1];
+    _mm_store_pd(out, GAM1C[l]); ms[2*l].GAM1C = out[0], ms[2*l+1].GAM1C = out[1];
+    _mm_store_pd(out, SINPI[l]); ms[2*l].SINPI = out[0], ms[2*l+1].SINPI = out[1];
+    _mm_store_pd(out, N[l]);     ms[2*l].N = out[0],     ms[2*l+1].N = out[1];
+  }
+
+}
+
+#endif  /* MOON4_X86 */
+
+
+/*
+ *  Kernel chosen with SetMoonKernel().
+ */
+static int MoonKernel = MOONKERNEL_AUTO;
+
+int SetMoonKernel(int kernel){
+
+  switch (kernel){
+    case MOONKERNEL_AUTO:
+    case MOONKERNEL_SCALAR:
+      break;
+#ifdef MOON4_X86
+    case MOONKERNEL_SSE2:
+      if (!__builtin_cpu_supports("sse2")) return(0);
+      break;
+    case MOONKERNEL_AVX2:
+      if (!__builtin_cpu_supports("avx2")) return(0);
+      break;
+#endif  /* MOON4_X86 */
+    default:
+      return(0);
+  }
+  MoonKernel = kernel;
+  return(1);
+
+}
+
+void MoonSum4(MoonSeries ms[4]){
+
+  int i;
+
+#ifdef MOON4_X86
+  if ((MoonKernel == MOONKERNEL_AVX2) ||
+      ((MoonKernel == MOONKERNEL_AUTO) && __builtin_cpu_supports("avx2"))){
+    MoonSum4_AVX2(ms);
+    return;
+  }
+  if ((MoonKernel == MOONKERNEL_SSE2) ||
+      ((MoonKernel == MOONKERNEL_AUTO) && __builtin_cpu_supports("sse2"))){
+    MoonSum4_SSE2(ms);
+    return;
+  }
+#endif  /* MOON4_X86 */
+  for (i=0; i<4; ++i) MoonSum(&ms[i]);
+
+}
+
+
+double sine(double phi){
+
+  return( sin(TwoPi*frac(phi)) );
+
+}
 
-  double X, Y;
 
-  term(P, Q, R, S, &X, &Y);
-  DLAM += COEFFL*Y;
-  DS += COEFFS*Y;
-  GAM1C += COEFFG*X;
-  SINPI += COEFFP*X;
+double frac(double x){
 
+  x -= (int)x;
+  return( (x<0) ? x+1.0 : x );
 
 }
 
 
 
-void term(int P, int Q, int R, int S, double *X, double *Y){
+void term(MoonSeries *ms, int P, int Q, int R, int S, double *X, double *Y){
 
   double XX, YY;
   int k, I[5];
@@ -334,7 +859,7 @@ void term(int P, int Q, int R, int S, double *X, double *Y){
   I[1] = P, I[2] = Q, I[3] = R, I[4] = S, XX = 1.0, YY = 0.0;
   for (k=1; k<=4; ++k){
     if (I[k] != 0.0){
-      addthe(XX, YY, CO[6+I[k]][k], SI[6+I[k]][k], &XX, &YY);
+      addthe(XX, YY, ms->CO[6+I[k]][k], ms->SI[6+I[k]][k], &XX, &YY);
     }
   }
   *X = XX;
@@ -353,62 +878,104 @@ void addthe(double C1, double S1, double C2, double S2, double *C, double *S){
 }
 
 
-void addn(double COEFFN, int P, int Q, int R, int S){
+/*
+ *  Rate of the phase returned by Moon() (in revolutions per century): the
+ *  mean motion of D plus the derivatives of the longitude terms larger
+ *  than 100" and of the solar equation of centre. This is good to a
+ *  fraction of a percent, which is all the Newton step in MoonPhaseEvent()
+ *  needs.
+ */
+double PhaseRate(double T){
+
+  static const double n[5] = { 0.0, 1325.55240982, 99.99735956, 1342.22782980, 1236.85308708 };
+  const MoonTerm *t;
+  double L, LS, F, D, Rate = 0.0;
 
-  double X, Y;
 
-  term(P, Q, R, S, &X, &Y);
-  N += COEFFN*Y;
+  L  = TwoPi*frac( 0.37489701 + n[1]*T );
+  LS = TwoPi*frac( 0.99312619 + n[2]*T );
+  F  = TwoPi*frac( 0.25909118 + n[3]*T );
+  D  = TwoPi*frac( 0.82736186 + n[4]*T );
+
+  for (t=SolarTerms; t<SolarTerms+NSOLARTERMS; ++t){
+    if (fabs(t->COEFFL) < 100.0) continue;
+    Rate += t->COEFFL*(t->P*n[1] + t->Q*n[2] + t->R*n[3] + t->S*n[4])
+        *cos(t->P*L + t->Q*LS + t->R*F + t->S*D);
+  }
+  Rate -= (6893.0*cos(LS) + 144.0*cos(2.0*LS))*n[2];
 
+  return( n[4] + Rate/ARC );
 
 }
 
 
 
-#define Rdefine 0.61803399
-#define Cdefine 0.38196601
 
-double NewMoon(double ax, double bx, double cx){
+/*
+ *  Finds the instant nearest T (Julian centuries (TDT) since J2000) at
+ *  which the phase returned by Moon() equals Phase (0 new moon, 0.25 first
+ *  quarter, 0.5 full moon, 0.75 last quarter). Newton iteration with the
+ *  rate from PhaseRate(); stops once the step is below Tolerance (in Julian
+ *  centuries). A start within a few days of the event takes three or four
+ *  Moon() evaluations.
+ */
+#define PHASEEVENT_MAXSTEPS 20
 
-  double f1, f2, x0, x1, x2, x3/*, Moon()*/;
-  double L, B, Rad, AGE, tol=1e-7;
+double MoonPhaseEvent(double T, double Phase, double Tolerance){
+
+  double L, B, Rad, AGE, Offset, Step;
+  int Evaluations = 0;
+
+
+  do {
+    Offset = Moon(T, &L, &B, &Rad, &AGE) - Phase;
+    Offset -= floor(Offset + 0.5);
+    Step = -Offset/PhaseRate(T);
+    T += Step;
+  } while ((fabs(Step) > Tolerance) && (++Evaluations < PHASEEVENT_MAXSTEPS));
+  if (Evaluations < PHASEEVENT_MAXSTEPS) ++Evaluations;
+
+  if (PhaseSolverStats != NULL) PhaseSolverStats(Evaluations, PhaseSolverStatsData);
+  return(T);
+
+}
+
+
+
+
+void SetPhaseSolverHook(PhaseSolverHook hook, void *data){
+
+  PhaseSolverStats = hook;
+  PhaseSolverStatsData = data;
 
-  x0 = ax;
-  x3 = cx;
-  if (fabs(cx-bx) > fabs(bx-ax)){
-    x1 = bx;
-    x2 = bx + Cdefine*(cx-bx);
-  } else {
-    x2 = bx;
-    x1 = bx - Cdefine*(bx-ax);
-  }
-  f1 = Moon(x1, &L, &B, &Rad, &AGE);
-  f2 = Moon(x2, &L, &B, &Rad, &AGE);
-  while (fabs(x3-x0) > tol*(fabs(x1)+fabs(x2))){
-    if (f2 < f1){
-      x0 = x1;
-      x1 = x2;
-      x2 = Rdefine*x1+Cdefine*x3;
-      f1 = f2;
-      f2 = Moon(x2, &L, &B, &Rad, &AGE);
-    } else {
-      x3 = x2;
-      x2 = x1;
-      x1 = Rdefine*x2+Cdefine*x0;
-      f2 = f1;
-      f1 = Moon(x1, &L, &B, &Rad, &AGE);
-    }
-  }
-  if (f1 < f2){
-    return(x1);
-  } else {
-    return(x2);
-  }
 }
 
 
 
 
+#define NEWMOON_TOLERANCE 1e-9 /* Julian centuries (about 3 s) */
+
+/*
+ *  Time since the last new moon (in days). TU is in Julian centuries (TDT)
+ *  since J2000 and AGE is the approximate age from Moon(). Inside the range
+ *  of the precomputed lunation table (lunation.h) this is a lookup;
+ *  elsewhere MoonPhaseEvent() solves for the new moon near TU - AGE.
+ */
+double MoonAge(double TU, double AGE){
+
+#ifndef CALCEPHEM_NOLUNATIONTABLE
+  double Age;
+
+  if (Lunation_GetAge(TU, &Age) > 0)
+    return(Age);
+#endif
+
+  return((TU - MoonPhaseEvent(TU - AGE/36525.0, 0.0, NEWMOON_TOLERANCE))*36525.0);
+
+}
+
+
+
 /*
  * MINI_MOON: low precision lunar coordinates (approx. 5'/1')
  *            T  : time in Julian centuries since J2000
@@ -474,27 +1041,86 @@ void MiniMoon(double T, double *RA, double *DEC){
 /*#define DegPerRad       57.29577951308232087680*/
 /*#define RadPerDeg        0.01745329251994329576*/
 
+/*
+ *  Observer state used by the non-reentrant CalcEphem()/MoonRise() wrappers.
+ *  Callers that need thread safety should use CalcEphem_r()/MoonRise_r()
+ *  with their own EphemContext instead.
+ */
 /*extern static*/ double Glon, SinGlat, CosGlat, TimeZone;
 
+void EphemContext_Set(EphemContext *ctx, double lat, double lon, double tz){
+
+  ctx->Glon = lon;
+  ctx->SinGlat = sin(lat*RadPerDeg);
+  ctx->CosGlat = cos(lat*RadPerDeg);
+  ctx->TimeZone = tz;
+
+}
+
 void MoonRise(int year, int month, int day, double LocalHour, double *UTRise, double *UTSet){
 
-  double UT, ym, y0, yp, SinH0;
-  double xe, ye, z1, z2/*, SinH(), hour24()*/;
-  int Rise, Set, nz;
+  EphemContext ctx;
+
+  ctx.Glon = Glon;
+  ctx.SinGlat = SinGlat;
+  ctx.CosGlat = CosGlat;
+  ctx.TimeZone = TimeZone;
+  MoonRise_r(year, month, day, LocalHour, UTRise, UTSet, &ctx);
+
+}
+
+void MoonRise_r(int year, int month, int day, double LocalHour, double *UTRise, double *UTSet,
+    EphemContext const *ctx){
+
+  double y[RISESET_SAMPLES];
+
+  RiseSetSamples(year, month, day, ctx, y);
+  RiseSetScan(y, ctx->TimeZone, UTRise, UTSet);
+
+}
+
+/*
+ *  The hourly samples MoonRise_r() works from: SinH() - SinH0 at local
+ *  hours 0 to 24 of the given day.
+ */
+void RiseSetSamples(int year, int month, int day, EphemContext const *ctx, double y[RISESET_SAMPLES]){
+
+  double UT, SinH0;
+  int i;
 
   SinH0 = sin( 8.0/60.0 * RadPerDeg );
 
+  UT = 1.0+ctx->TimeZone;
+  y[0] = SinH(year, month, day, UT-1.0, ctx) - SinH0;
+  for (i=1; UT <= 24.0+ctx->TimeZone; i+=2, UT+=2.0){
+    y[i] = SinH(year, month, day, UT, ctx) - SinH0;
+    y[i+1] = SinH(year, month, day, UT+1.0, ctx) - SinH0;
+  }
+
+}
+
+/*
+ *  Finds the rise and set times (UT, or -999.0 if none) in a day of samples
+ *  from RiseSetSamples() or MoonTrack(), fitting a parabola through each
+ *  group of three.
+ */
+void RiseSetScan(double const y[RISESET_SAMPLES], double TimeZone, double *UTRise, double *UTSet){
+
+  double UT, ym, y0, yp;
+  double xe, ye, z1, z2;
+  int i, Rise, Set, nz;
+
 
   UT = 1.0+TimeZone;
   *UTRise = -999.0;
   *UTSet = -999.0;
   Rise = Set = 0;
-  ym = SinH(year, month, day, UT-1.0) - SinH0;
+  ym = y[0];
 
-  while ( (UT <= 24.0+TimeZone) ) {
+  for (i=1; UT <= 24.0+TimeZone; i+=2) {
 
-  y0 = SinH(year, month, day, UT) - SinH0;
-  yp = SinH(year, month, day, UT+1.0) - SinH0;
+  y0 = y[i];
+  yp = y[i+1];
 
   Interp(ym, y0, yp, &xe, &ye, &z1, &z2, &nz);
 
@@ -544,6 +1170,214 @@ void MoonRise(int year, int month, int day, double LocalHour, double *UTRise, do
 
 }
 
+/*
+ *  The observer independent part of RiseSetSamples(): the direction of the
+ *  moon (MiniMoon(), as a unit vector) and the Greenwich sidereal angle
+ *  (in radians) at local hours 0 to 24 of the given day. For an observer
+ *  at latitude phi and longitude lambda (west positive), the sample is
+ *  sin(phi)*v[2] + cos(phi)*(v[0]*cos(theta-lambda) + v[1]*sin(theta-lambda))
+ *  less the horizon term; the grid code relies on this to share one track
+ *  between any number of observers.
+ */
+void MoonTrack(int year, int month, int day, double TimeZone,
+    double v[RISESET_SAMPLES][3], double theta[RISESET_SAMPLES]){
+
+  double UT, TU, RA, DEC, gmst;
+  int k;
+
+
+  for (k=0; k<RISESET_SAMPLES; ++k){
+
+    UT = TimeZone + k;
+    TU = (jd(year, month, day, UT) - 2451545.0)/36525.0;
+
+    MiniMoon(TU, &RA, &DEC);
+    RA *= 15.0*RadPerDeg;
+    DEC *= RadPerDeg;
+    v[k][0] = cos(DEC)*cos(RA);
+    v[k][1] = cos(DEC)*sin(RA);
+    v[k][2] = sin(DEC);
+
+    UT = 24.0*frac( UT/24.0 );
+    gmst = UT + 6.697374558 + (8640184.812866+(0.093104-6.2e-6*TU)*TU)*TU/3600.0;
+    theta[k] = 15.0*24.0*frac( gmst/24.0 )*RadPerDeg;
+
+  }
+
+}
+
+void RiseSetCache_Init(RiseSetCache *cache){
+
+  memset(cache, 0, sizeof(*cache));
+
+}
+
+/*
+ *  MoonRise_r() through a RiseSetCache. A day already in the cache for the
+ *  same observer costs a lookup; a new day costs one day of samples and
+ *  replaces the oldest slot. Any change of observer (including the time
+ *  zone) empties the cache first.
+ */
+void MoonRiseCached(int year, int month, int day, double *UTRise, double *UTSet,
+    EphemContext const *ctx, RiseSetCache *cache){
+
+  RiseSetDay *d;
+  long date = 10000L*year + 100*month + day;
+  int i;
+
+
+  if ( (cache->ctx.Glon != ctx->Glon) || (cache->ctx.SinGlat != ctx->SinGlat) ||
+      (cache->ctx.CosGlat != ctx->CosGlat) || (cache->ctx.TimeZone != ctx->TimeZone) ){
+    for (i=0; i<RISESETCACHE_DAYS; ++i) cache->Day[i].date = 0;
+    cache->ctx = *ctx;
+  }
+
+  for (i=0; i<RISESETCACHE_DAYS; ++i){
+    d = &cache->Day[i];
+    if (d->date == date){
+      ++cache->Hits;
+      *UTRise = d->UTRise;
+      *UTSet = d->UTSet;
+      return;
+    }
+  }
+
+  ++cache->Misses;
+  d = &cache->Day[cache->Next];
+  cache->Next = (cache->Next+1) % RISESETCACHE_DAYS;
+  RiseSetSamples(year, month, day, ctx, d->SinH);
+  RiseSetScan(d->SinH, ctx->TimeZone, &d->UTRise, &d->UTSet);
+  d->date = date;
+  *UTRise = d->UTRise;
+  *UTSet = d->UTSet;
+
+}
+
+/*
+ *  Rise/set times for ndays consecutive days from year/month/day, passed
+ *  one record per day to callback. The times are those of MoonRise_r() to
+ *  within MOONRISERANGE_MAXERROR(_POLAR) seconds, but the samples are
+ *  built much more cheaply: MiniMoon() is evaluated once per day (at local
+ *  midnight) as a unit vector and interpolated to each hour with a cubic
+ *  through the four surrounding days, which is good to a few arc seconds;
+ *  the sidereal time is stepped hour to hour by a rotation; and the
+ *  midnight sample between two days is shared. The calendar is stepped by day number, with no
+ *  mktime()/gmtime().
+ */
+void MoonRiseRange(int year, int month, int day, int ndays, EphemContext const *ctx,
+    RiseSetCallback callback, void *data){
+
+  RiseSetRecord record;
+  double y[RISESET_SAMPLES], w[RISESET_SAMPLES-1][4], node[4][3];
+  double JD0, TU, UT0, lmst, SinH0, u, x, yy, z;
+  double c, s, cd, sd, t;
+  int i, j, k;
+
+
+  SinH0 = sin( 8.0/60.0 * RadPerDeg );
+
+  /* Cubic Lagrange weights for nodes at -1, 0, 1, 2 days. */
+  for (k=0; k<RISESET_SAMPLES-1; ++k){
+    u = k/24.0;
+    w[k][0] = -u*(u-1.0)*(u-2.0)/6.0;
+    w[k][1] = (u+1.0)*(u-1.0)*(u-2.0)/2.0;
+    w[k][2] = -(u+1.0)*u*(u-2.0)/2.0;
+    w[k][3] = (u+1.0)*u*(u-1.0)/6.0;
+  }
+
+  /* Hourly step of the sidereal angle. */
+  t = 15.0*RadPerDeg*(1.0 + 8640184.812866/(3600.0*24.0*36525.0));
+  cd = cos(t); sd = sin(t);
+
+  JD0 = jd(year, month, day, ctx->TimeZone);
+  UT0 = 24.0*frac( ctx->TimeZone/24.0 );
+  for (j=0; j<3; ++j) MoonVector(JD0 + j - 1.0, node[j+1]);
+
+  for (i=0; i<ndays; ++i){
+
+    for (j=0; j<3; ++j){
+      node[j][0] = node[j+1][0]; node[j][1] = node[j+1][1]; node[j][2] = node[j+1][2];
+    }
+    MoonVector(JD0 + i + 2.0, node[3]);
+
+    /* Sidereal angle at local midnight, as in SinH(). */
+    TU = (JD0 + i - 2451545.0)/36525.0;
+    lmst = UT0 + 6.697374558 + (8640184.812866+(0.093104-6.2e-6*TU)*TU)*TU/3600.0;
+    lmst = 24.0*frac( (lmst-ctx->Glon/15.0) / 24.0 );
+    c = cos(15.0*lmst*RadPerDeg); s = sin(15.0*lmst*RadPerDeg);
+
+    for (k=0; k<RISESET_SAMPLES; ++k){
+      if ( (k > 0) || (i == 0) ){
+        if (k < RISESET_SAMPLES-1){
+          x  = w[k][0]*node[0][0] + w[k][1]*node[1][0] + w[k][2]*node[2][0] + w[k][3]*node[3][0];
+          yy = w[k][0]*node[0][1] + w[k][1]*node[1][1] + w[k][2]*node[2][1] + w[k][3]*node[3][1];
+          z  = w[k][0]*node[0][2] + w[k][1]*node[1][2] + w[k][2]*node[2][2] + w[k][3]*node[3][2];
+        } else {
+          x = node[2][0]; yy = node[2][1]; z = node[2][2];
+        }
+        y[k] = ctx->SinGlat*z + ctx->CosGlat*(x*c + yy*s) - SinH0;
+      }
+      t = c*cd - s*sd;
+      s = s*cd + c*sd;
+      c = t;
+    }
+
+    RiseSetScan(y, ctx->TimeZone, &record.UTRise, &record.UTSet);
+    record.date = 10000L*year + 100*month + day;
+    callback(&record, data);
+
+    y[0] = y[RISESET_SAMPLES-1];
+    NextDay(&year, &month, &day);
+
+  }
+
+}
+
+/*
+ *  MoonRiseRange() into a caller-owned array of ndays records.
+ */
+void MoonRiseRangeBuffer(int year, int month, int day, int ndays, EphemContext const *ctx,
+    RiseSetRecord *records){
+
+  MoonRiseRange(year, month, day, ndays, ctx, RiseSetAppend, &records);
+
+}
+
+void RiseSetAppend(RiseSetRecord const *record, void *data){
+
+  RiseSetRecord **next = (RiseSetRecord **)data;
+
+  *(*next)++ = *record;
+
+}
+
+/*
+ *  Direction of the moon (MiniMoon()) at a Julian date, as a unit vector
+ *  in the equatorial system of date.
+ */
+void MoonVector(double JD, double v[3]){
+
+  double RA, DEC;
+
+  MiniMoon((JD - 2451545.0)/36525.0, &RA, &DEC);
+  RA *= 15.0*RadPerDeg;
+  DEC *= RadPerDeg;
+  v[0] = cos(DEC)*cos(RA);
+  v[1] = cos(DEC)*sin(RA);
+  v[2] = sin(DEC);
+
+}
+
+/*
+ *  Steps a date to the next day, in the calendar of DayNumber_ToDate()
+ *  (Julian before 1582-10-15, Gregorian from then on).
+ */
+void NextDay(int *year, int *month, int *day){
+
+  DayNumber_ToDate(DayNumber_FromDate(*year, *month, *day) + 1, year, month, day);
+
+}
+
 #if 0
 void UTTohhmm(double UT, int *h, int *m){
 
@@ -599,7 +1433,7 @@ void Interp(double ym, double y0, double yp, double *xe, double *ye, double *z1,
 
 
 
-double SinH(int year, int month, int day, double UT){
+double SinH(int year, int month, int day, double UT, EphemContext const *ctx){
 
   double TU/*, frac(), jd()*/;
   double RA_Moon, DEC_Moon, gmst, lmst, Tau/*, Moon()*/;
@@ -630,10 +1464,10 @@ double SinH(int year, int month, int day, double UT){
   gmst = 6.697374558 + 1.0027379093*UT + (8640184.812866+(0.093104-6.2e-6*TU)*TU)*TU/3600.0;
   */
   gmst = UT + 6.697374558 + (8640184.812866+(0.093104-6.2e-6*TU)*TU)*TU/3600.0;
-  lmst = 24.0*frac( (gmst-Glon/15.0) / 24.0 );
+  lmst = 24.0*frac( (gmst-ctx->Glon/15.0) / 24.0 );
 
   Tau = 15.0*lmst*RadPerDeg - RA_Moon;
-  return( SinGlat*sin(DEC_Moon) + CosGlat*cos(DEC_Moon)*cos(Tau) );
+  return( ctx->SinGlat*sin(DEC_Moon) + ctx->CosGlat*cos(DEC_Moon)*cos(Tau) );
 
 
 }
@@ -642,25 +1476,32 @@ double SinH(int year, int month, int day, double UT){
 /*#include "CalcEphem.h"*/
 
 
+/*
+ *  The observer is c->Glat/c->Glon, and its latitude is left in the
+ *  globals for MoonRise(), as before the reentrant versions.
+ */
 void CalcEphem(long int date,double UT,CTrans *c)
 {
-  int    year, month, day;
-  double TU, TU2, TU3, T0/*, gmst*/;
-  double varep, varpi;
-  double eccen, epsilon;
-  double days, M, E, nu, lambnew;
-  double r0, earth_sun_distance;
-  double RA, DEC, RA_Moon, DEC_Moon;
-  double TDT, AGE, LambdaMoon, BetaMoon, R;
-  /* double jd(), hour24(), angle2pi(), angle360(), kepler(), Moon(), NewMoon();*/
-  double Ta, Tb, Tc/*, frac()*/;
-  double /*SinGlat, CosGlat, SinGlon, CosGlon,*/ Tau, lmst, x, y, z;
-  double SinTau, CosTau, SinDec, CosDec;
+  EphemContext ctx;
 
+  EphemContext_Set(&ctx, c->Glat, c->Glon, TimeZone);
+  CalcEphem_r(date, UT, c, &ctx);
+  SinGlat = ctx.SinGlat;
+  CosGlat = ctx.CosGlat;
+}
 
 
+void CalcEphem_r(long int date,double UT,CTrans *c,EphemContext const *ctx)
+{
+  CalcEphemTier_r(date, UT, c, ctx, EPHEMTIER_PRECISE);
+}
 
 
+void CalcEphemTier_r(long int date,double UT,CTrans *c,EphemContext const *ctx,int tier)
+{
+  int    year, month, day;
+  long   DayNumber;
+
   c->UT = UT;
   year = (int)(date/10000);
   month = (int)( (date - year*10000)/100 );
@@ -669,34 +1510,125 @@ void CalcEphem(long int date,double UT,CTrans *c)
   c->month = month;
   c->day = day;
 
-  c->doy = DayofYear(year, month, day);
-  c->dow = DayofWeek(year, month, day, c->dowstr);
+  DayNumber = DayNumber_FromDate(year, month, day);
+  c->doy = DayNumber_GetDayOfYear(DayNumber, year);
+  c->dow = DayNumber_GetDayOfWeek(DayNumber);
+  strcpy(c->dowstr, DayNumber_GetDayOfWeekName(c->dow));
+
+  CalcEphemCore(jd(year, month, day, 0.0), jd(year, month, day, UT + 59.0/3600.0), UT, c, ctx, tier);
+}
 
 
+void CalcEphemJD(double jd_ut, CTrans *c, EphemContext const *ctx, int tier)
+{
+  long   DayNumber;
+  double JD0, UT;
 
   /*
-   *  Compute Greenwich Mean Sidereal Time (gmst)
-   *  The TU here is number of Julian centuries
-   *  since 2000 January 1.5
-   *  From the 1996 astronomical almanac
+   *  Day numbers start at noon, dates at midnight.
    */
-  TU = (jd(year, month, day, 0.0) - 2451545.0)/36525.0;
+  DayNumber = (long)floor(jd_ut + 0.5);
+  JD0 = DayNumber - 0.5;
+  UT = (jd_ut - JD0)*24.0;
+
+  CalendarFromDayNumber(DayNumber, UT, c);
+  CalcEphemCore(JD0, jd_ut + 59.0/86400.0, UT, c, ctx, tier);
+}
+
+
+/*
+ *  Calendar fields of CTrans from a day number, with dowstr left empty.
+ */
+void CalendarFromDayNumber(long DayNumber, double UT, CTrans *c)
+{
+  c->UT = UT;
+  DayNumber_ToDate(DayNumber, &c->year, &c->month, &c->day);
+  c->doy = DayNumber_GetDayOfYear(DayNumber, c->year);
+  c->dow = DayNumber_GetDayOfWeek(DayNumber);
+  c->dowstr[0] = '\0';
+}
+
+
+char const *CTrans_GetDayOfWeekString(CTrans *c)
+{
+  if (c->dowstr[0] == '\0') strcpy(c->dowstr, DayNumber_GetDayOfWeekName(c->dow));
+  return(c->dowstr);
+}
+
+
+/*
+ *  Everything but the calendar fields. JD0 is the Julian date at 0h UT of
+ *  the day and JDTDT the Julian date of the instant in TDT.
+ */
+void CalcEphemCore(double JD0, double JDTDT, double UT, CTrans *c, EphemContext const *ctx, int tier)
+{
+  double TU, AGE, LambdaMoon, BetaMoon, R, Phase;
+  EphemGeocentric Geocentric;
+  EphemRecord Record;
+
+
+  c->gmst = EphemGMST(JD0, UT);
+  CalcEphemSun(JDTDT, c);
+
+
+  /*
+   * Compute Moon Phase and AGE Stuff. The AGE that comes out of Moon()
+   * is actually the Phase converted to days. Since AGE is actually defined
+   * to be time since last NewMoon, we need to figure out what the JD of the
+   * last new moon was. Thats done in EphemMoonGeocentric()....
+   */
+  TU = (JDTDT - 2451545.0)/36525.0;
+  Phase = MoonTier(TU, tier, &LambdaMoon, &BetaMoon, &R, &AGE);
+
+  EphemMoonGeocentric(TU, c->gmst, c->epsilon, Phase, LambdaMoon, BetaMoon, R, AGE, &Geocentric);
+  Geocentric.JD = JDTDT - 59.0/86400.0;
+  EphemTopocentric(&Geocentric, ctx, &Record);
+  RecordToCTrans(&Record, c);
+
+}
+
+
+/*
+ *  Greenwich Mean Sidereal Time (in hours) at UT hours after JD0 (0h UT).
+ *  The TU here is number of Julian centuries since 2000 January 1.5.
+ *  From the 1996 astronomical almanac.
+ */
+double EphemGMST(double JD0, double UT)
+{
+  double TU, TU2, TU3, T0;
+
+  TU = (JD0 - 2451545.0)/36525.0;
   TU2 = TU*TU;
   TU3 = TU2*TU;
   T0 = (6.0 + 41.0/60.0 + 50.54841/3600.0) + 8640184.812866/3600.0*TU
           + 0.093104/3600.0*TU2 - 6.2e-6/3600.0*TU3;
   T0 = hour24(T0);
-  c->gmst = hour24(T0 + UT*1.002737909);
-
-
-  /* convert to radians for ease later on */
-  /* gmst = c->gmst*15.0*M_PI/180.0;*/
-
-  lmst = 24.0*frac( (c->gmst - c->Glon/15.0) / 24.0 );
+  return( hour24(T0 + UT*1.002737909) );
+}
 
 
+/*
+ * Obliquity of the Ecliptic (in radians) at epoch TU. The TU in this
+ * formula is the number of Julian centuries since epoch 2000 January 1.5
+ */
+double EphemObliquity(double TU)
+{
+  return( (23.43929167 - 0.013004166*TU - 1.6666667e-7*TU*TU
+              - 5.0277777778e-7*TU*TU*TU)*RadPerDeg );
+}
 
 
+/*
+ *  The sun fields of CTrans (eccentricity to DEC_sun) at JDTDT (TDT).
+ */
+void CalcEphemSun(double JDTDT, CTrans *c)
+{
+  double TU;
+  double varep, varpi;
+  double eccen, epsilon;
+  double days, M, E, nu, lambnew;
+  double r0, earth_sun_distance;
+  double RA, DEC;
 
 
   /*
@@ -712,8 +1644,7 @@ void CalcEphem(long int date,double UT,CTrans *c)
    *   The TU here is the number of Julian centuries since
    *   1900 January 0.0 (= 2415020.0)
    */
-  TDT = UT + 59.0/3600.0;
-  TU = (jd(year, month, day, TDT) - 2415020.0)/36525.0;
+  TU = (JDTDT - 2415020.0)/36525.0;
   varep = (279.6966778 + 36000.76892*TU + 0.0003025*TU*TU)*RadPerDeg;
   varpi = (281.2208444 + 1.719175*TU + 0.000452778*TU*TU)*RadPerDeg;
   eccen = 0.01675104 - 0.0000418*TU - 0.000000126*TU*TU;
@@ -723,12 +1654,9 @@ void CalcEphem(long int date,double UT,CTrans *c)
 
   /*
    * Compute the Obliquity of the Ecliptic at epoch TU
-   * The TU in this formula is the number of Julian
-   * centuries since epoch 2000 January 1.5
    */
-  TU  = (jd(year, month, day, TDT) - jd(2000, 1, 1, 12.0))/36525.0;
-  epsilon = (23.43929167 - 0.013004166*TU - 1.6666667e-7*TU*TU
-              - 5.0277777778e-7*TU*TU*TU)*RadPerDeg;
+  TU  = (JDTDT - 2451545.0)/36525.0;
+  epsilon = EphemObliquity(TU);
   c->epsilon = epsilon;
 
 
@@ -741,7 +1669,7 @@ void CalcEphem(long int date,double UT,CTrans *c)
    *
    *
    */
-  days  = jd(year, month, day, TDT) - jd(year, month, day, TDT);
+  days  = JDTDT - JDTDT;
   M = angle2pi(2.0*M_PI/365.242191*days + varep - varpi);
   E = kepler(M, eccen);
   nu = 2.0*atan( sqrt((1.0+eccen)/(1.0-eccen))*tan(E/2.0) );
@@ -757,9 +1685,6 @@ void CalcEphem(long int date,double UT,CTrans *c)
   c->earth_sun_dist = earth_sun_distance;
 
 
-
-
-
   /*
    * Compute Right Ascension and Declination of the Sun
    */
@@ -768,152 +1693,306 @@ void CalcEphem(long int date,double UT,CTrans *c)
   c->RA_sun = RA;
   c->DEC_sun = DEC;
 
+}
 
 
+/*
+ *  The observer independent moon fields from the output of Moon() at TU.
+ *  gmst is in hours and epsilon in radians.
+ */
+void EphemMoonGeocentric(double TU, double gmst, double epsilon, double Phase,
+    double LambdaMoon, double BetaMoon, double R, double AGE, EphemGeocentric *g)
+{
+  double RA_Moon, DEC_Moon;
 
 
-
-  /*
-   * Compute Moon Phase and AGE Stuff. The AGE that comes out of Moon()
-   * is actually the Phase converted to days. Since AGE is actually defined
-   * to be time since last NewMoon, we need to figure out what the JD of the
-   * last new moon was. Thats done below....
-   */
-  TU = (jd(year, month, day, TDT) - 2451545.0)/36525.0;
-  c->MoonPhase = Moon(TU, &LambdaMoon, &BetaMoon, &R, &AGE);
+  g->gmst = gmst;
+  g->MoonPhase = Phase;
   LambdaMoon *= RadPerDeg;
   BetaMoon *= RadPerDeg;
 
 
   RA_Moon  = angle360(atan2(sin(LambdaMoon)*cos(epsilon)-tan(BetaMoon)*sin(epsilon), cos(LambdaMoon))*DegPerRad);
   DEC_Moon = asin( sin(BetaMoon)*cos(epsilon) + cos(BetaMoon)*sin(epsilon)*sin(LambdaMoon))*DegPerRad;
-  c->RA_moon = RA_Moon;
-  c->DEC_moon = DEC_Moon;
+  g->RA_moon = RA_Moon;
+  g->DEC_moon = DEC_Moon;
+  g->SinDec = sin(DEC_Moon*RadPerDeg);
+  g->CosDec = cos(DEC_Moon*RadPerDeg);
 
 
   /*
-   *  Compute Alt/Az coords
+   * Compute accurate AGE of the Moon
    */
-  Tau = (15.0*lmst - RA_Moon)*RadPerDeg;
-  CosGlat = cos(c->Glat*RadPerDeg); SinGlat = sin(c->Glat*RadPerDeg);
-  /* CosGlon = cos(c->Glon*RadPerDeg); SinGlon = sin(c->Glon*RadPerDeg);*/
-  CosTau = cos(Tau); SinTau = sin(Tau);
-  SinDec = sin(DEC_Moon*RadPerDeg); CosDec = cos(DEC_Moon*RadPerDeg);
-  x = CosDec*CosTau*SinGlat - SinDec*CosGlat;
-  y = CosDec*SinTau;
-  z = CosDec*CosTau*CosGlat + SinDec*SinGlat;
-  c->A_moon = DegPerRad*atan2(y, x);
-  c->h_moon = DegPerRad*asin(z);
-  c->Visible = (c->h_moon < 0.0) ? 0 : 1;
-
+  g->MoonAge = MoonAge(TU, AGE);
 
 
   /*
-   * Compute accurate AGE of the Moon
+   * Compute Earth-Moon distance
    */
-  Tb = TU - AGE/36525.0; /* should be very close to minimum */
-  Ta = Tb - 0.4/36525.0;
-  Tc = Tb + 0.4/36525.0;
-  c->MoonAge = (TU - NewMoon(Ta, Tb, Tc))*36525.0;
+  g->EarthMoonDistance = R;
+
+}
 
 
+void EphemTopocentric(EphemGeocentric const *g, EphemContext const *ctx, EphemRecord *r)
+{
+  double Tau, lmst, x, y, z;
+  double SinTau, CosTau;
+
+
+  lmst = 24.0*frac( (g->gmst - ctx->Glon/15.0) / 24.0 );
+
+  r->JD = g->JD;
+  r->RA_moon = g->RA_moon;
+  r->DEC_moon = g->DEC_moon;
+  r->MoonPhase = g->MoonPhase;
+  r->MoonAge = g->MoonAge;
+  r->EarthMoonDistance = g->EarthMoonDistance;
+
 
   /*
-   * Compute Earth-Moon distance
+   *  Compute Alt/Az coords
    */
-  c->EarthMoonDistance = R;
+  Tau = (15.0*lmst - g->RA_moon)*RadPerDeg;
+  CosTau = cos(Tau); SinTau = sin(Tau);
+  x = g->CosDec*CosTau*ctx->SinGlat - g->SinDec*ctx->CosGlat;
+  y = g->CosDec*SinTau;
+  z = g->CosDec*CosTau*ctx->CosGlat + g->SinDec*ctx->SinGlat;
+  r->A_moon = DegPerRad*atan2(y, x);
+  r->h_moon = DegPerRad*asin(z);
 
+}
 
 
+/*
+ *  Copies the moon fields of a record into CTrans.
+ */
+void RecordToCTrans(EphemRecord const *r, CTrans *c)
+{
+  c->RA_moon = r->RA_moon;
+  c->DEC_moon = r->DEC_moon;
+  c->h_moon = r->h_moon;
+  c->A_moon = r->A_moon;
+  c->Visible = (c->h_moon < 0.0) ? 0 : 1;
+  c->MoonPhase = r->MoonPhase;
+  c->MoonAge = r->MoonAge;
+  c->EarthMoonDistance = r->EarthMoonDistance;
 }
 
 
+void CalcEphemRecord(double jd_ut, EphemContext const *ctx, int tier, EphemRecord *r, CTrans *cold)
+{
+  long   DayNumber;
+  double JD0, JDTDT, UT, TU, gmst, epsilon;
+  double AGE, LambdaMoon, BetaMoon, R, Phase;
+  EphemGeocentric Geocentric;
+
+  DayNumber = (long)floor(jd_ut + 0.5);
+  JD0 = DayNumber - 0.5;
+  UT = (jd_ut - JD0)*24.0;
+  JDTDT = jd_ut + 59.0/86400.0;
+
+  TU = (JDTDT - 2451545.0)/36525.0;
+  gmst = EphemGMST(JD0, UT);
+  epsilon = EphemObliquity(TU);
+  Phase = MoonTier(TU, tier, &LambdaMoon, &BetaMoon, &R, &AGE);
+  EphemMoonGeocentric(TU, gmst, epsilon, Phase, LambdaMoon, BetaMoon, R, AGE, &Geocentric);
+  Geocentric.JD = jd_ut;
+  EphemTopocentric(&Geocentric, ctx, r);
 
+  /*
+   *  The rest only if asked for.
+   */
+  if (cold != NULL){
+    CalendarFromDayNumber(DayNumber, UT, cold);
+    cold->gmst = gmst;
+    CalcEphemSun(JDTDT, cold);
+    RecordToCTrans(r, cold);
+  }
+}
 
 
-double kepler(double M,double e)
+void CalcEphemRecords(double const *jd_ut, int n, EphemContext const *ctx, int tier, EphemRecord *out)
 {
-  int n=0;
-  double E, Eold, eps = 1.0e-8;
+  int    i0, l, m;
+  long   DayNumber;
+  double JD0, UT, T[4], gmst[4];
+  double LambdaMoon[4], BetaMoon[4], R[4], AGE[4], Phase[4];
+  EphemGeocentric Geocentric;
+
+  for (i0=0; i0<n; i0+=4){
+
+    m = (n-i0 < 4) ? n-i0 : 4;
+    for (l=0; l<m; ++l){
+      DayNumber = (long)floor(jd_ut[i0+l] + 0.5);
+      JD0 = DayNumber - 0.5;
+      UT = (jd_ut[i0+l] - JD0)*24.0;
+      gmst[l] = EphemGMST(JD0, UT);
+      T[l] = (jd_ut[i0+l] + 59.0/86400.0 - 2451545.0)/36525.0;
+    }
 
+    /*
+     *  Full precision goes four samples at a time (same results as Moon()).
+     */
+    if ((m == 4) && (tier == EPHEMTIER_PRECISE))
+      Moon4(T, LambdaMoon, BetaMoon, R, AGE, Phase);
+    else
+      for (l=0; l<m; ++l) Phase[l] = MoonTier(T[l], tier, &LambdaMoon[l], &BetaMoon[l], &R[l], &AGE[l]);
+
+    for (l=0; l<m; ++l){
+      EphemMoonGeocentric(T[l], gmst[l], EphemObliquity(T[l]), Phase[l], LambdaMoon[l], BetaMoon[l], R[l], AGE[l], &Geocentric);
+      Geocentric.JD = jd_ut[i0+l];
+      EphemTopocentric(&Geocentric, ctx, &out[i0+l]);
+    }
 
+  }
 
-  E = M + e*sin(M);
-  do{
-    Eold = E;
-    E = Eold + (M-Eold+e*sin(Eold))
-            /(1.0-e*cos(Eold));
-    ++n;
-  }while((fabs(E-Eold) > eps) && (n < 100));
-  return(E);
 }
 
 
 
+void CalcEphemGeocentric(double jd_ut, int tier, EphemGeocentric *g)
+{
+  double JD0, UT, TU;
+  double AGE, LambdaMoon, BetaMoon, R, Phase;
+
+  JD0 = floor(jd_ut + 0.5) - 0.5;
+  UT = (jd_ut - JD0)*24.0;
+  TU = (jd_ut + 59.0/86400.0 - 2451545.0)/36525.0;
+
+  Phase = MoonTier(TU, tier, &LambdaMoon, &BetaMoon, &R, &AGE);
+  EphemMoonGeocentric(TU, EphemGMST(JD0, UT), EphemObliquity(TU), Phase, LambdaMoon, BetaMoon, R, AGE, g);
+  g->JD = jd_ut;
+}
 
-int DayofYear(int year,int month,int day)
-/*int year, month, day;*/
+
+void CalcEphemObservers(double jd_ut, int tier, EphemContext const *ctx, int n, EphemRecord *out)
 {
-  /*double jd();*/
-  return((int)(jd(year, month, day, 0.0) - jd(year, 1, 0, 0.0)));
+  int    i;
+  EphemGeocentric Geocentric;
+
+  CalcEphemGeocentric(jd_ut, tier, &Geocentric);
+  for (i=0; i<n; ++i) EphemTopocentric(&Geocentric, &ctx[i], &out[i]);
 }
 
 
 
 
-int DayofWeek(int year,int month,int day,char dowstr[])
-/*int year, month, day;*/
-/*char dowstr[];*/
+/*
+ *  Batch version of CalcEphem_r(). Only the moon fields selected in
+ *  "fields" (EPHEMFIELD_*) are computed, and each is written to its own
+ *  caller-owned array in "out" (the other pointers may be NULL). The sun,
+ *  calendar and dipole parts of CTrans are never computed. The observer
+ *  is taken from ctx (see EphemContext_Set()).
+ */
+void CalcEphemBatch(long int const *date, double const *UT, int n,
+    EphemContext const *ctx, int fields, EphemBatch *out)
 {
-  double JD, A, Afrac/*, jd()*/;
-  int n, iA;
-
-  JD = jd(year, month, day, 0.0);
-  A = (JD + 1.5)/7.0;
-  iA = (int)A;
-  Afrac = A - (double)iA;
-  n = (int)(Afrac*7.0 + 0.5);
-  switch(n){
-    case 0:
-      strcpy(dowstr, "Sunday");
-      break;
-    case 1:
-      strcpy(dowstr, "Monday");
-      break;
-    case 2:
-      strcpy(dowstr, "Tuesday");
-      break;
-    case 3:
-      strcpy(dowstr, "Wednesday");
-      break;
-    case 4:
-      strcpy(dowstr, "Thursday");
-      break;
-    case 5:
-      strcpy(dowstr, "Friday");
-      break;
-    case 6:
-      strcpy(dowstr, "Saturday");
-      break;
+  int    i, i0, l, m, year[4], month[4], day[4];
+  double TU, TDT, gmst, lmst, epsilon;
+  double T[4], LambdaMoon[4], BetaMoon[4], R[4], AGE[4], Phase[4];
+  double RA_Moon, DEC_Moon, Tau, SinTau, CosTau, SinDec, CosDec, x, y, z;
+
+  for (i0=0; i0<n; i0+=4){
+
+    m = (n-i0 < 4) ? n-i0 : 4;
+    for (l=0; l<m; ++l){
+      i = i0+l;
+      year[l] = (int)(date[i]/10000);
+      month[l] = (int)( (date[i] - year[l]*10000)/100 );
+      day[l] = (int)( date[i] - year[l]*10000 - month[l]*100 );
+      TDT = UT[i] + 59.0/3600.0;
+      T[l] = (jd(year[l], month[l], day[l], TDT) - 2451545.0)/36525.0;
+    }
+
+    /*
+     *  Evaluate the lunar theory four samples at a time.
+     */
+    if (m == 4)
+      Moon4(T, LambdaMoon, BetaMoon, R, AGE, Phase);
+    else
+      for (l=0; l<m; ++l) Phase[l] = Moon(T[l], &LambdaMoon[l], &BetaMoon[l], &R[l], &AGE[l]);
+
+    for (l=0; l<m; ++l){
+
+      i = i0+l;
+      TU = T[l];
+      if (fields & EPHEMFIELD_PHASE) out->MoonPhase[i] = Phase[l];
+      if (fields & EPHEMFIELD_DISTANCE) out->EarthMoonDistance[i] = R[l];
+
+      if (fields & (EPHEMFIELD_RADEC|EPHEMFIELD_ALTAZ)){
+        epsilon = EphemObliquity(TU);
+        LambdaMoon[l] *= RadPerDeg;
+        BetaMoon[l] *= RadPerDeg;
+        RA_Moon  = angle360(atan2(sin(LambdaMoon[l])*cos(epsilon)-tan(BetaMoon[l])*sin(epsilon), cos(LambdaMoon[l]))*DegPerRad);
+        DEC_Moon = asin( sin(BetaMoon[l])*cos(epsilon) + cos(BetaMoon[l])*sin(epsilon)*sin(LambdaMoon[l]))*DegPerRad;
+        if (fields & EPHEMFIELD_RADEC){
+          out->RA_moon[i] = RA_Moon;
+          out->DEC_moon[i] = DEC_Moon;
+        }
+
+        if (fields & EPHEMFIELD_ALTAZ){
+          gmst = EphemGMST(jd(year[l], month[l], day[l], 0.0), UT[i]);
+          lmst = 24.0*frac( (gmst - ctx->Glon/15.0) / 24.0 );
+          Tau = (15.0*lmst - RA_Moon)*RadPerDeg;
+          CosTau = cos(Tau); SinTau = sin(Tau);
+          SinDec = sin(DEC_Moon*RadPerDeg); CosDec = cos(DEC_Moon*RadPerDeg);
+          x = CosDec*CosTau*ctx->SinGlat - SinDec*ctx->CosGlat;
+          y = CosDec*SinTau;
+          z = CosDec*CosTau*ctx->CosGlat + SinDec*ctx->SinGlat;
+          out->A_moon[i] = DegPerRad*atan2(y, x);
+          out->h_moon[i] = DegPerRad*asin(z);
+        }
+      }
+
+      if (fields & EPHEMFIELD_AGE)
+        out->MoonAge[i] = MoonAge(T[l], AGE[l]);
+
+    }
+
   }
-  return(n);
+
 }
 
 
 
 
 
+double kepler(double M,double e)
+{
+  int n=0;
+  double E, Eold, eps = 1.0e-8;
+
+
+
+  E = M + e*sin(M);
+  do{
+    Eold = E;
+    E = Eold + (M-Eold+e*sin(Eold))
+            /(1.0-e*cos(Eold));
+    ++n;
+  }while((fabs(E-Eold) > eps) && (n < 100));
+  return(E);
+}
+
+
+
+
 /*
  *  Compute the Julian Day number for the given date.
  *  Julian Date is the number of days since noon of Jan 1 4713 B.C.
+ *  The calendar (Julian before 1582-10-15) is chosen from the date alone,
+ *  so that UT outside 0-24 hours does not move the date across the reform.
  */
 double jd(int ny,int nm,int nd,double UT)
 /*int ny, nm, nd;*/
 /*double UT;*/
 {
   double A, B, C, D, JD, day;
+  int Gregorian;
 
   day = nd + UT/24.0;
+  Gregorian = (10000L*ny + 100*nm + nd >= 15821015L);
 
 
   if ((nm == 1) || (nm == 2)){
@@ -921,7 +2000,7 @@ double jd(int ny,int nm,int nd,double UT)
     nm = nm + 12;
   }
 
-  if (((double)ny+nm/12.0+day/365.25)>=(1582.0+10.0/12.0+15.0/365.25)){
+  if (Gregorian){
     A = ((int)(ny / 100.0));
     B = 2.0 - A + (int)(A/4.0);
   }
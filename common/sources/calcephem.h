@@ -1,3 +1,6 @@
+#ifndef   CALCEPHEM_H
+#define   CALCEPHEM_H
+
 
 typedef struct Vector {
   double x;
@@ -38,16 +41,309 @@ typedef struct CTrans {
   int    Visible;           /* Wether or not moon is above horizon */
 } CTrans;
 
+/*
+ *  Observer state for the reentrant CalcEphem_r()/MoonRise_r() entry points.
+ *  They only read it, so threads may share one without locking.
+ */
+typedef struct EphemContext {
+  double Glon;              /* Geographic Longitude of Observer (west positive) */
+  double SinGlat;           /* Sine of Geographic Latitude of Observer */
+  double CosGlat;           /* Cosine of Geographic Latitude of Observer */
+  double TimeZone;          /* Hours to add to local time to get UT */
+} EphemContext;
+
+/*
+ *  Compact moon output for large result arrays: the CTrans fields most
+ *  callers read, in one 64 byte cache line (allocate arrays with 64 byte
+ *  alignment, e.g. posix_memalign(), to keep it so). The calendar and sun
+ *  fields of CTrans are optional outputs of CalcEphemRecord(); the moon is
+ *  above the horizon when h_moon >= 0.
+ */
+#if defined(_MSC_VER)
+#define EPHEMRECORD_ALIGN   __declspec(align(64))
+#else
+#define EPHEMRECORD_ALIGN   __attribute__((aligned(64)))
+#endif
+
+typedef struct EPHEMRECORD_ALIGN EphemRecord {
+  double JD;                /* Julian Date (UT) */
+  double RA_moon;           /* Right Ascention of Moon (in degrees) */
+  double DEC_moon;          /* Declination of Moon (in degrees) */
+  double h_moon;            /* Altitude of Moon (in degrees) */
+  double A_moon;            /* Azimuth of Moon (in degrees) */
+  double MoonPhase;         /* The Phase of the Moon (0-1) */
+  double MoonAge;           /* Age of Moon in Days */
+  double EarthMoonDistance; /* Distance between the Earth and Moon (in earth-radii) */
+} EphemRecord;
+
+/*
+ *  The observer independent part of an EphemRecord: everything up to the
+ *  equatorial position depends only on the time. EphemTopocentric() turns
+ *  it into a record for one observer.
+ */
+typedef struct EphemGeocentric {
+  double JD;                /* Julian Date (UT) */
+  double gmst;              /* Greenwich Mean Sidereal Time (in hours) */
+  double RA_moon;           /* Right Ascention of Moon (in degrees) */
+  double DEC_moon;          /* Declination of Moon (in degrees) */
+  double SinDec, CosDec;    /* Sine and cosine of DEC_moon */
+  double MoonPhase;         /* The Phase of the Moon (0-1) */
+  double MoonAge;           /* Age of Moon in Days */
+  double EarthMoonDistance; /* Distance between the Earth and Moon (in earth-radii) */
+} EphemGeocentric;
+
+/*
+ *  Rolling per-observer cache for MoonRiseCached(). Each slot holds one day:
+ *  the hourly samples MoonRise_r() works from (SinH() - SinH0 at local
+ *  hours 0 to 24) and the rise/set times found in them. Slots are reused
+ *  oldest first, so yesterday/today/tomorrow plus one spare fit. Clear with
+ *  RiseSetCache_Init() before first use; one cache per thread.
+ */
+#define RISESET_SAMPLES     25
+#define RISESETCACHE_DAYS   4
+
+typedef struct RiseSetDay {
+  long   date;                      /* YYYYMMDD, or 0 if the slot is empty */
+  double SinH[RISESET_SAMPLES];     /* Hourly samples */
+  double UTRise, UTSet;             /* As returned by MoonRise_r() */
+} RiseSetDay;
+
+typedef struct RiseSetCache {
+  EphemContext ctx;                 /* Observer of the cached days */
+  RiseSetDay Day[RISESETCACHE_DAYS];
+  int Next;                         /* Slot to replace next */
+  unsigned long Hits, Misses;       /* Days served from / added to the cache */
+} RiseSetCache;
+
+/*
+ *  One day of MoonRiseRange() output. Times are as from MoonRise_r(), to
+ *  within MOONRISERANGE_MAXERROR seconds up to 60 degrees of latitude and
+ *  MOONRISERANGE_MAXERROR_POLAR beyond, where the moon can graze the
+ *  horizon; the days have the same events (checked by
+ *  moonphase-riserangetest).
+ */
+#define MOONRISERANGE_MAXERROR        3.0
+#define MOONRISERANGE_MAXERROR_POLAR  60.0
+
+typedef struct RiseSetRecord {
+  long   date;                      /* YYYYMMDD */
+  double UTRise, UTSet;
+} RiseSetRecord;
+
+typedef void (*RiseSetCallback)(RiseSetRecord const *record, void *data);
+
+/*
+ *  Working state of the Brown series evaluation. Kept on the stack of
+ *  Moon() so that concurrent evaluations do not share anything; only
+ *  public so that a MoonStepper can hold one.
+ */
+typedef struct MoonSeries {
+  double T, L0, LS, F, D, DGAM;
+  double DLAM, DLAMS;
+  double DS;
+  double GAM1C;
+  double SINPI;
+  double N;
+  double CO[14][5], SI[14][5];
+  double Limit;     /* Terms smaller than this (in arcseconds) are dropped */
+} MoonSeries;
+
+/*
+ *  Fixed step generator of MoonTier() samples at T0, T0+dT, T0+2dT, ...
+ *  The harmonics of L, LS, F and D and the small longitude terms advance
+ *  by a constant rotation per step (addthe()) instead of fresh sin()/cos()
+ *  calls, and are recomputed exactly every MOONSTEPPER_RENORMALIZE steps
+ *  to bound the drift. The samples agree with MoonTier() at the same tier
+ *  to MOONSTEPPER_MAXERROR_HOURLY in longitude and latitude for steps of
+ *  up to an hour, and MOONSTEPPER_MAXERROR_DAILY for daily steps, over at
+ *  least 10^6 steps (checked by moonphase-steppertest); distance and age
+ *  to 1e-6 (earth radii, days). One stepper per thread.
+ */
+#define MOONSTEPPER_RENORMALIZE  64
+#define MOONSTEPPER_ADDTERMS     11
+#define MOONSTEPPER_MAXERROR_HOURLY  0.002  /* arc seconds */
+#define MOONSTEPPER_MAXERROR_DAILY   0.02   /* arc seconds */
+
+typedef struct MoonStepper {
+  MoonSeries Series;                /* Series state at the next sample */
+  double T0, dT;                    /* First sample and step (Julian centuries) */
+  long   Step;                      /* Index of the next sample */
+  int    tier;                      /* EPHEMTIER_* */
+  double Arg[5][2], ArgStep[5][2];  /* cos/sin of L, LS, F, D (1-4), and their rotation per step */
+  double FAC[5], FACStep[5];        /* Scale factors of the harmonics, and their change per step */
+  double AngleStep[5];              /* Change per step of L0, LS, F, D and DGAM */
+  double Add[MOONSTEPPER_ADDTERMS][2], AddStep[MOONSTEPPER_ADDTERMS][2];
+} MoonStepper;
+
+/*
+ *  Statistics hook for the phase event solver. Called after every
+ *  MoonPhaseEvent() with the number of Moon() evaluations it took.
+ */
+typedef void (*PhaseSolverHook)(int evaluations, void *data);
+
+/*
+ *  Accuracy tiers for MoonTier() and CalcEphemTier_r(). The lower tiers
+ *  drop the perturbation terms of Brown's series whose amplitude is below
+ *  a limit. Largest errors against the full series, 1900-2100 (checked
+ *  by moonphase-tiertest):
+ *    ICON     terms >= 30": 2.7' longitude, 1.5' latitude, 0.033 earth
+ *             radii, 0.004 days of age; about half the cost of Moon()
+ *    DISPLAY  terms >= 2": 16" longitude, 2" latitude, 0.002 earth radii,
+ *             0.0004 days of age; about 55% of the cost of Moon()
+ *    PRECISE  every term (same as Moon())
+ */
+#define EPHEMTIER_ICON        0
+#define EPHEMTIER_DISPLAY     1
+#define EPHEMTIER_PRECISE     2
+#define EPHEMTIER_COUNT       3
+
+/*
+ *  Series kernels of Moon4(). AUTO uses the fastest one the CPU has; the
+ *  others force one (for testing).
+ */
+#define MOONKERNEL_AUTO       0
+#define MOONKERNEL_SCALAR     1
+#define MOONKERNEL_SSE2       2
+#define MOONKERNEL_AVX2       3
+
+/*
+ *  Field selection flags for CalcEphemBatch().
+ */
+#define EPHEMFIELD_RADEC      0x01  /* RA_moon, DEC_moon */
+#define EPHEMFIELD_ALTAZ      0x02  /* h_moon, A_moon */
+#define EPHEMFIELD_PHASE      0x04  /* MoonPhase */
+#define EPHEMFIELD_AGE        0x08  /* MoonAge */
+#define EPHEMFIELD_DISTANCE   0x10  /* EarthMoonDistance */
+
+/*
+ *  Caller-owned structure-of-arrays output for CalcEphemBatch(). Only the
+ *  arrays selected by the field flags need to be allocated.
+ */
+typedef struct EphemBatch {
+  double *RA_moon;            /* Right Ascention of Moon (in degrees) */
+  double *DEC_moon;           /* Declination of Moon (in degrees) */
+  double *h_moon;             /* Altitude of Moon (in degrees) */
+  double *A_moon;             /* Azimuth of Moon (in degrees) */
+  double *MoonPhase;          /* The Phase of the Moon (0-1) */
+  double *MoonAge;            /* Age of Moon in Days */
+  double *EarthMoonDistance;  /* Distance between the Earth and Moon (in earth-radii) */
+} EphemBatch;
+
 #ifdef  __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
 
+/*
+ *  Brown's lunar theory. T is in Julian centuries (TDT) since J2000.
+ *  LAMBDA/BETA are ecliptic longitude/latitude (degrees), R is the distance
+ *  (earth radii) and AGE the phase in days. Returns the phase (0-1).
+ */
+double Moon(double T, double *LAMBDA, double *BETA, double *R, double *AGE);
+/* Moon() at a chosen accuracy (EPHEMTIER_*). */
+double MoonTier(double T, int tier, double *LAMBDA, double *BETA, double *R, double *AGE);
+/*
+ *  Low precision (about 5' in RA, 1' in DEC) lunar coordinates, as used
+ *  for rise/set times. RA is in hours and DEC in degrees (equinox of date).
+ */
+void MiniMoon(double T, double *RA, double *DEC);
+/*
+ *  Starts a stepper at T0 with step dT (Julian centuries). Each
+ *  MoonStepper_Next() returns the next sample as MoonTier() would, along
+ *  with its time T.
+ */
+void MoonStepper_Init(MoonStepper *s, double T0, double dT, int tier);
+double MoonStepper_Next(MoonStepper *s, double *T, double *LAMBDA, double *BETA, double *R, double *AGE);
+/*
+ *  Instant nearest T at which the phase from Moon() equals Phase (0 new
+ *  moon, 0.25 first quarter, 0.5 full moon, 0.75 last quarter). T and
+ *  Tolerance are in Julian centuries.
+ */
+double MoonPhaseEvent(double T, double Phase, double Tolerance);
+/*
+ *  Installs (or, with NULL, removes) the solver statistics hook. The hook
+ *  is a single process wide global, not per thread; set it before starting
+ *  any threads that use it. MoonEvent_Find() and MoonEclipse_Find() call
+ *  MoonPhaseEvent() from their OpenMP loops, so the hook may be called
+ *  from several threads at once and must update its data atomically.
+ */
+void SetPhaseSolverHook(PhaseSolverHook hook, void *data);
+/*
+ *  Moon() for four times at once (the batch paths use it). The results
+ *  match Moon() whatever the kernel.
+ */
+void Moon4(double const T[4], double LAMBDA[4], double BETA[4], double R[4], double AGE[4], double PHASE[4]);
+/*
+ *  Selects the series kernel of Moon4() (MOONKERNEL_*). Returns 0, and
+ *  keeps the current kernel, if this build or CPU does not have it. The
+ *  selection is process wide; make it before starting any threads.
+ */
+int SetMoonKernel(int kernel);
+
 void CalcEphem(long int, double, CTrans*);
 void MoonRise(int year, int month, int day, double LocalHour,
     double *UTRise, double *UTSet);
 
+void EphemContext_Set(EphemContext *ctx, double lat, double lon, double tz);
+/*
+ *  CalcEphem() for the observer in ctx, which is only read (c->Glat and
+ *  c->Glon are neither read nor written).
+ */
+void CalcEphem_r(long int, double, CTrans*, EphemContext const *ctx);
+/* CalcEphem_r() with the moon computed at a chosen accuracy (EPHEMTIER_*). */
+void CalcEphemTier_r(long int, double, CTrans*, EphemContext const *ctx, int tier);
+/*
+ *  CalcEphemTier_r() for a Julian date (UT). The date is converted once
+ *  with integer day numbers (daynumber.h), and dowstr is left empty until
+ *  CTrans_GetDayOfWeekString() is called.
+ */
+void CalcEphemJD(double jd_ut, CTrans *c, EphemContext const *ctx, int tier);
+/* Fills in c->dowstr if it is empty, and returns it. */
+char const *CTrans_GetDayOfWeekString(CTrans *c);
+/*
+ *  The moon at a Julian date (UT) for the observer in ctx, as a compact
+ *  record. If cold is not NULL it is filled in as by CalcEphemJD() as
+ *  well, except for Glat and Glon (the observer is ctx).
+ */
+void CalcEphemRecord(double jd_ut, EphemContext const *ctx, int tier, EphemRecord *r, CTrans *cold);
+/* CalcEphemRecord() for n Julian dates, without the cold fields. */
+void CalcEphemRecords(double const *jd_ut, int n, EphemContext const *ctx, int tier, EphemRecord *out);
+/* The geocentric stage of CalcEphemRecord(), once per instant. */
+void CalcEphemGeocentric(double jd_ut, int tier, EphemGeocentric *g);
+/* The topocentric stage: altitude and azimuth for one observer. */
+void EphemTopocentric(EphemGeocentric const *g, EphemContext const *ctx, EphemRecord *r);
+/*
+ *  One instant for n observers (ctx[0..n-1], see EphemContext_Set()). The
+ *  moon is computed once; each observer only costs the alt/az rotation.
+ */
+void CalcEphemObservers(double jd_ut, int tier, EphemContext const *ctx, int n, EphemRecord *out);
+void MoonRise_r(int year, int month, int day, double LocalHour,
+    double *UTRise, double *UTSet, EphemContext const *ctx);
+void CalcEphemBatch(long int const *date, double const *UT, int n,
+    EphemContext const *ctx, int fields, EphemBatch *out);
+
+void RiseSetCache_Init(RiseSetCache *cache);
+void MoonRiseCached(int year, int month, int day, double *UTRise, double *UTSet,
+    EphemContext const *ctx, RiseSetCache *cache);
+void MoonRiseRange(int year, int month, int day, int ndays, EphemContext const *ctx,
+    RiseSetCallback callback, void *data);
+void MoonRiseRangeBuffer(int year, int month, int day, int ndays, EphemContext const *ctx,
+    RiseSetRecord *records);
+
+/*
+ *  Building blocks for computing rise/set for many observers at once (see
+ *  moongrid.h): the shared moon track of a day, and the scan of one
+ *  observer's samples (SinH() less sin(8') at local hours 0 to 24).
+ */
+void MoonTrack(int year, int month, int day, double TimeZone,
+    double v[RISESET_SAMPLES][3], double theta[RISESET_SAMPLES]);
+void RiseSetScan(double const y[RISESET_SAMPLES], double TimeZone,
+    double *UTRise, double *UTSet);
+
 #ifdef  __cplusplus
 }
 
 
 #endif  /* __cplusplus */
+
+
+#endif    /* CALCEPHEM_H */
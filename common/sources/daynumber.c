@@ -0,0 +1,207 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file daynumber.c
+*** \brief daynumber.h implementation.
+*** \details Implementation file for daynumber.h.
+**/
+
+
+/** Identifier for daynumber.c. **/
+#define   DAYNUMBER_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "daynumber.h"
+#ifdef    DEBUG_DAYNUMBER_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_DAYNUMBER_C */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Day of the week names.
+*** \details Names of the days of the week, Sunday first.
+**/
+static char const *f_ppDayOfWeekNames[7]=
+{
+  "Sunday","Monday","Tuesday","Wednesday","Thursday","Friday","Saturday"
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+long DayNumber_FromDate(int Year,int Month,int Day)
+{
+  long A;
+  long Y;
+  long M;
+  long DayNumber;
+
+
+  DEBUGLOG_Printf3("DayNumber_FromDate(%d,%d,%d)",Year,Month,Day);
+  DEBUGLOG_LogIn();
+
+  /* Count from March 4801 BC so the leap day ends the year. */
+  A=(14-Month)/12;
+  Y=Year+4800L-A;
+  M=Month+12*A-3;
+  DayNumber=Day+(153*M+2)/5+365*Y+Y/4;
+  if ( (Year>1582) || ((Year==1582) && ((Month>10) ||
+      ((Month==10) && (Day>=15)))) )
+    DayNumber+=-Y/100+Y/400-32045;
+  else
+    DayNumber+=-32083;
+
+  DEBUGLOG_LogOut();
+  return(DayNumber);
+}
+
+void DayNumber_ToDate(long DayNumber,int *pYear,int *pMonth,int *pDay)
+{
+  long B;
+  long C;
+  long D;
+  long E;
+  long M;
+
+
+  DEBUGLOG_Printf4("DayNumber_ToDate(%ld,%p,%p,%p)",
+      DayNumber,pYear,pMonth,pDay);
+  DEBUGLOG_LogIn();
+
+  /* Centuries (Gregorian only), then years and months from March 1. */
+  if (DayNumber>=DAYNUMBER_GREGORIAN)
+  {
+    B=(4*(DayNumber+32044)+3)/146097;
+    C=DayNumber+32044-146097*B/4;
+  }
+  else
+  {
+    B=0;
+    C=DayNumber+32082;
+  }
+  D=(4*C+3)/1461;
+  E=C-1461*D/4;
+  M=(5*E+2)/153;
+
+  *pDay=(int)(E-(153*M+2)/5+1);
+  *pMonth=(int)(M+3-12*(M/10));
+  *pYear=(int)(100*B+D-4800+M/10);
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+int DayNumber_GetDayOfYear(long DayNumber,int Year)
+{
+  int DayOfYear;
+
+
+  DEBUGLOG_Printf2("DayNumber_GetDayOfYear(%ld,%d)",DayNumber,Year);
+  DEBUGLOG_LogIn();
+
+  DayOfYear=(int)(DayNumber-DayNumber_FromDate(Year,1,1)+1);
+
+  DEBUGLOG_LogOut();
+  return(DayOfYear);
+}
+
+int DayNumber_GetDayOfWeek(long DayNumber)
+{
+  int DayOfWeek;
+
+
+  DEBUGLOG_Printf1("DayNumber_GetDayOfWeek(%ld)",DayNumber);
+  DEBUGLOG_LogIn();
+
+  /* Day number 0 was a Monday. */
+  DayOfWeek=(int)((DayNumber+1)%7);
+  if (DayOfWeek<0)
+    DayOfWeek+=7;
+
+  DEBUGLOG_LogOut();
+  return(DayOfWeek);
+}
+
+char const *DayNumber_GetDayOfWeekName(int DayOfWeek)
+{
+  char const *pName;
+
+
+  DEBUGLOG_Printf1("DayNumber_GetDayOfWeekName(%d)",DayOfWeek);
+  DEBUGLOG_LogIn();
+
+  if ( (DayOfWeek<0) || (DayOfWeek>=7) )
+    pName="";
+  else
+    pName=f_ppDayOfWeekNames[DayOfWeek];
+
+  DEBUGLOG_LogOut();
+  return(pName);
+}
+
+
+#undef    DAYNUMBER_C
@@ -0,0 +1,142 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file daynumber.h
+*** \brief Integer day numbers.
+*** \details Converts between calendar dates and Julian day numbers (the
+***   Julian date at noon of a day) with integer arithmetic only, and
+***   derives the day of the year and the day of the week from them. Dates
+***   from 1582-10-15 on are Gregorian, earlier dates Julian (as in jd() in
+***   calcephem.c). Valid from 4801 BC on.
+**/
+
+
+#ifndef   DAYNUMBER_H
+#define   DAYNUMBER_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "sysdefs.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Gregorian reform.
+*** \details Day number of 1582-10-15, the first Gregorian date.
+**/
+#define   DAYNUMBER_GREGORIAN   (2299161L)
+
+/**
+*** \brief Day number range.
+*** \details Range of day numbers the conversions handle: from 4713-01-01
+***   BC (Julian) up to where the intermediate products still fit in 32
+***   bits (year 1364999 or so).
+**/
+#define   DAYNUMBER_MINIMUM     (0L)
+#define   DAYNUMBER_MAXIMUM     (500000000L)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+*** \brief Date to day number.
+*** \details Returns the day number of a calendar date.
+*** \param Year Year (astronomical, so 1 BC is 0).
+*** \param Month Month (1-12).
+*** \param Day Day of the month (1-31).
+*** \returns Day number.
+**/
+long DayNumber_FromDate(int Year,int Month,int Day);
+/**
+*** \brief Day number to date.
+*** \details Returns the calendar date of a day number.
+*** \param DayNumber Day number.
+*** \param pYear Storage for the year.
+*** \param pMonth Storage for the month (1-12).
+*** \param pDay Storage for the day of the month (1-31).
+**/
+void DayNumber_ToDate(long DayNumber,int *pYear,int *pMonth,int *pDay);
+/**
+*** \brief Day of the year.
+*** \details Returns the day of the year of a day number.
+*** \param DayNumber Day number.
+*** \param Year Year of the day number (from DayNumber_ToDate()).
+*** \returns Day of the year (1-366).
+**/
+int DayNumber_GetDayOfYear(long DayNumber,int Year);
+/**
+*** \brief Day of the week.
+*** \details Returns the day of the week of a day number.
+*** \param DayNumber Day number.
+*** \returns Day of the week (0 Sunday - 6 Saturday).
+**/
+int DayNumber_GetDayOfWeek(long DayNumber);
+/**
+*** \brief Day of the week name.
+*** \details Returns the English name of a day of the week.
+*** \param DayOfWeek Day of the week (0 Sunday - 6 Saturday).
+*** \returns Name (e.g. "Sunday"), or "" if DayOfWeek is out of range.
+**/
+char const *DayNumber_GetDayOfWeekName(int DayOfWeek);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* DAYNUMBER_H */
@@ -0,0 +1,517 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file ephemfile.c
+*** \brief ephemfile.h implementation.
+*** \details Implementation file for ephemfile.h.
+**/
+
+
+/** Identifier for ephemfile.c. **/
+#define   EPHEMFILE_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "ephemfile.h"
+#ifdef    DEBUG_EPHEMFILE_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_EPHEMFILE_C */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#ifndef   _WIN32
+#include  <fcntl.h>
+#include  <unistd.h>
+#include  <sys/mman.h>
+#include  <sys/stat.h>
+#endif    /* _WIN32 */
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Largest file.
+*** \details Offsets are 32 bit, so files are limited to 4 GB.
+**/
+#define   MAXIMUM_FILESIZE      (0xFFFFFFFFULL)
+
+/**
+*** \brief Segment states.
+*** \details Values of EPHEMFILE_T.pStates.
+**/
+#define   STATE_UNCHECKED       (0)
+#define   STATE_VALID           (1)
+#define   STATE_INVALID         (2)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(EphemFile,EPHEMFILE_T);
+static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(EphemFile,EPHEMFILE_T);
+static unsigned int CRC32(void const *pBuffer,size_t Size);
+static int CheckHeader(EPHEMFILEHEADER_T const *pHeader,size_t Size);
+static int CheckSegment(EPHEMFILE_T *pFile,unsigned long Segment);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+STRUCTURE_FUNCTION_INITIALIZE(EphemFile,EPHEMFILE_T)
+
+static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(EphemFile,EPHEMFILE_T)
+{
+  DEBUGLOG_Printf1("EphemFile_InitializeMembers(%p)",pStructure);
+  DEBUGLOG_LogIn();
+
+  pStructure->pMapping=NULL;
+  pStructure->pStates=NULL;
+
+  DEBUGLOG_LogOut();
+  return(ERRORCODE_SUCCESS);
+}
+
+STRUCTURE_FUNCTION_UNINITIALIZE(EphemFile,EPHEMFILE_T)
+
+static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(EphemFile,EPHEMFILE_T)
+{
+  DEBUGLOG_Printf1("EphemFile_UninitializeMembers(%p)",pStructure);
+  DEBUGLOG_LogIn();
+
+  EphemFile_Close(pStructure);
+
+  DEBUGLOG_LogOut();
+  return(ERRORCODE_SUCCESS);
+}
+
+/**
+*** \brief Computes a CRC-32.
+*** \details CRC-32 (IEEE 802.3, as used by zip) of a buffer. Bitwise, as
+***   each block is only checked once.
+*** \param pBuffer Buffer.
+*** \param Size Size of the buffer (in bytes).
+*** \returns CRC-32.
+**/
+static unsigned int CRC32(void const *pBuffer,size_t Size)
+{
+  unsigned char const *pByte;
+  unsigned int CRC;
+  int Bit;
+
+
+  pByte=(unsigned char const *)pBuffer;
+  CRC=0xFFFFFFFFU;
+  while(Size-->0)
+  {
+    CRC^=*pByte++;
+    for(Bit=0;Bit<8;Bit++)
+      CRC=(CRC>>1)^(0xEDB88320U&(0U-(CRC&1U)));
+  }
+  return(~CRC);
+}
+
+/**
+*** \brief Checks a header.
+*** \details Checks the magic, version, byte order and checksum of a
+***   header, and that the sizes in it add up to the size of the file.
+*** \param pHeader Header.
+*** \param Size Size of the file (in bytes).
+*** \retval 1 Valid.
+*** \retval 0 Invalid.
+**/
+static int CheckHeader(EPHEMFILEHEADER_T const *pHeader,size_t Size)
+{
+  unsigned long long Expected;
+
+
+  if ( (Size<sizeof(*pHeader)) ||
+      (memcmp(pHeader->pMagic,EPHEMFILE_MAGIC,sizeof(pHeader->pMagic))!=0) ||
+      (pHeader->ByteOrder!=EPHEMFILE_BYTEORDER) ||
+      (pHeader->Version!=EPHEMFILE_VERSION) ||
+      (pHeader->HeaderSize!=sizeof(*pHeader)) ||
+      (pHeader->HeaderChecksum!=CRC32(pHeader,
+          offsetof(EPHEMFILEHEADER_T,HeaderChecksum))) )
+    return(0);
+
+  Expected=(unsigned long long)pHeader->SegmentCount*
+      (sizeof(EPHEMFILEINDEX_T)+pHeader->BlockSize)+pHeader->IndexOffset;
+  return( (pHeader->SegmentCount>0) &&
+      (pHeader->IndexOffset==sizeof(*pHeader)) &&
+      (pHeader->BlockSize==
+          pHeader->QuantityCount*pHeader->CoefficientCount*sizeof(double)) &&
+      (pHeader->BlockSize>0) &&
+      (Expected==pHeader->FileSize) && (Expected==Size) );
+}
+
+/**
+*** \brief Checks a segment.
+*** \details Checks that the index entry of a segment points where it
+***   should and that the block matches its checksum, and records the
+***   result.
+*** \param pFile Pointer to the file.
+*** \param Segment Segment number (from 0).
+*** \retval 1 Valid.
+*** \retval 0 Invalid.
+**/
+static int CheckSegment(EPHEMFILE_T *pFile,unsigned long Segment)
+{
+  EPHEMFILEHEADER_T const *pHeader;
+  EPHEMFILEINDEX_T const *pEntry;
+  unsigned long long Offset;
+  int ValidFlag;
+
+
+  pHeader=pFile->pHeader;
+  pEntry=&pFile->pIndex[Segment];
+  Offset=pHeader->IndexOffset+
+      (unsigned long long)pHeader->SegmentCount*sizeof(EPHEMFILEINDEX_T)+
+      (unsigned long long)Segment*pHeader->BlockSize;
+  ValidFlag=(pEntry->Offset==Offset) &&
+      (CRC32(pFile->pMapping+Offset,pHeader->BlockSize)==pEntry->Checksum);
+
+  pFile->pStates[Segment]=ValidFlag ? STATE_VALID : STATE_INVALID;
+  pFile->CheckCount++;
+  if (ValidFlag==0)
+  {
+    pFile->InvalidCount++;
+    MESSAGELOG_Error("Corrupt ephemeris segment.");
+  }
+  return(ValidFlag);
+}
+
+ERRORCODE_T EphemFile_Open(EPHEMFILE_T *pFile,char const *pPathname)
+{
+  ERRORCODE_T ErrorCode;
+  unsigned char *pMapping;
+  size_t Size;
+#ifndef   _WIN32
+  int Descriptor;
+  struct stat Status;
+  void *pAddress;
+#else     /* _WIN32 */
+  FILE *pHandle;
+  long Length;
+#endif    /* _WIN32 */
+
+
+  DEBUGLOG_Printf3("EphemFile_Open(%p,%p(%s))",pFile,pPathname,pPathname);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pFile==NULL) || (pPathname==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if (pFile->pMapping!=NULL)
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    ErrorCode=ERRORCODE_SYSTEMFAILURE;
+    pMapping=NULL;
+    Size=0;
+#ifndef   _WIN32
+    Descriptor=open(pPathname,O_RDONLY);
+    if (Descriptor>=0)
+    {
+      if ( (fstat(Descriptor,&Status)==0) && (Status.st_size>0) )
+      {
+        Size=(size_t)Status.st_size;
+        pAddress=mmap(NULL,Size,PROT_READ,MAP_SHARED,Descriptor,0);
+        if (pAddress!=MAP_FAILED)
+          pMapping=(unsigned char *)pAddress;
+      }
+      close(Descriptor);
+    }
+#else     /* _WIN32 */
+    /* No mmap(), read the file instead. */
+    pHandle=fopen(pPathname,"rb");
+    if (pHandle!=NULL)
+    {
+      if ( (fseek(pHandle,0,SEEK_END)==0) && ((Length=ftell(pHandle))>0) &&
+          (fseek(pHandle,0,SEEK_SET)==0) )
+      {
+        Size=(size_t)Length;
+        pMapping=(unsigned char *)malloc(Size);
+        if ( (pMapping!=NULL) && (fread(pMapping,Size,1,pHandle)!=1) )
+        {
+          free(pMapping);
+          pMapping=NULL;
+        }
+      }
+      fclose(pHandle);
+    }
+#endif    /* _WIN32 */
+
+    if (pMapping!=NULL)
+    {
+      pFile->pMapping=pMapping;
+      pFile->Size=Size;
+      pFile->pHeader=(EPHEMFILEHEADER_T const *)pMapping;
+      if (CheckHeader(pFile->pHeader,Size)==0)
+        ErrorCode=ERRORCODE_INVALIDDATA;
+      else
+      {
+        pFile->pIndex=(EPHEMFILEINDEX_T const *)
+            (pMapping+pFile->pHeader->IndexOffset);
+        /* Large allocations come as untouched zero pages, so this costs
+            the same for any number of segments. */
+        pFile->pStates=(unsigned char *)
+            calloc(pFile->pHeader->SegmentCount,sizeof(*pFile->pStates));
+        if (pFile->pStates==NULL)
+          ErrorCode=ERRORCODE_OUTOFMEMORY;
+        else
+        {
+          pFile->CheckCount=0;
+          pFile->InvalidCount=0;
+          ErrorCode=ERRORCODE_SUCCESS;
+        }
+      }
+      if (ErrorCode<0)
+        EphemFile_Close(pFile);
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+void EphemFile_Close(EPHEMFILE_T *pFile)
+{
+  DEBUGLOG_Printf1("EphemFile_Close(%p)",pFile);
+  DEBUGLOG_LogIn();
+
+  if ( (pFile!=NULL) && (pFile->pMapping!=NULL) )
+  {
+#ifndef   _WIN32
+    munmap((void *)pFile->pMapping,pFile->Size);
+#else     /* _WIN32 */
+    free((void *)pFile->pMapping);
+#endif    /* _WIN32 */
+    free(pFile->pStates);
+    pFile->pMapping=NULL;
+    pFile->pHeader=NULL;
+    pFile->pIndex=NULL;
+    pFile->pStates=NULL;
+  }
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+ERRORCODE_T EphemFile_GetSegment(EPHEMFILE_T *pFile,long Index,
+    double const **ppCoefficients)
+{
+  ERRORCODE_T ErrorCode;
+  unsigned long Segment;
+
+
+  DEBUGLOG_Printf3("EphemFile_GetSegment(%p,%ld,%p)",
+      pFile,Index,ppCoefficients);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pFile==NULL) || (ppCoefficients==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if (pFile->pMapping==NULL)
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else if ( (Index<pFile->pHeader->FirstSegment) ||
+      (Index-pFile->pHeader->FirstSegment>=
+          (long)pFile->pHeader->SegmentCount) )
+    ErrorCode=ERRORCODE_FALSE;
+  else
+  {
+    Segment=(unsigned long)(Index-pFile->pHeader->FirstSegment);
+    if ( (pFile->pStates[Segment]==STATE_VALID) ||
+        ( (pFile->pStates[Segment]==STATE_UNCHECKED) &&
+        (CheckSegment(pFile,Segment)!=0) ) )
+    {
+      *ppCoefficients=(double const *)
+          (pFile->pMapping+pFile->pIndex[Segment].Offset);
+      ErrorCode=ERRORCODE_SUCCESS;
+    }
+    else
+      ErrorCode=ERRORCODE_INVALIDDATA;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+ERRORCODE_T EphemFile_Verify(EPHEMFILE_T *pFile)
+{
+  ERRORCODE_T ErrorCode;
+  unsigned long Segment;
+
+
+  DEBUGLOG_Printf1("EphemFile_Verify(%p)",pFile);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if (pFile==NULL)
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if (pFile->pMapping==NULL)
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    for(Segment=0;Segment<pFile->pHeader->SegmentCount;Segment++)
+      if (pFile->pStates[Segment]==STATE_UNCHECKED)
+        CheckSegment(pFile,Segment);
+    ErrorCode=(pFile->InvalidCount==0) ?
+        ERRORCODE_SUCCESS : ERRORCODE_INVALIDDATA;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+ERRORCODE_T EphemFile_Write(char const *pPathname,
+    int QuantityCount,int CoefficientCount,double SegmentDays,
+    long FirstSegment,long SegmentCount,EPHEMFILEFIT_F pFit,void *pData)
+{
+  ERRORCODE_T ErrorCode;
+  EPHEMFILEHEADER_T Header;
+  EPHEMFILEINDEX_T *pIndex;
+  double *pBlock;
+  unsigned long long FileSize;
+  FILE *pHandle;
+  long Segment;
+
+
+  DEBUGLOG_Printf8("EphemFile_Write(%p(%s),%d,%d,%f,%ld,%ld,%p)",
+      pPathname,pPathname,QuantityCount,CoefficientCount,SegmentDays,
+      FirstSegment,SegmentCount,pFit);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  FileSize=sizeof(Header)+(unsigned long long)SegmentCount*
+      (sizeof(*pIndex)+(unsigned long long)QuantityCount*CoefficientCount*
+      sizeof(double));
+  if ( (pPathname==NULL) || (pFit==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (QuantityCount<=0) || (CoefficientCount<=0) ||
+      (SegmentDays<=0.0) || (SegmentCount<=0) ||
+      (FirstSegment<-2147483647L) ||
+      (FirstSegment>2147483647L-SegmentCount) ||
+      (FileSize>MAXIMUM_FILESIZE) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    memset(&Header,0,sizeof(Header));
+    memcpy(Header.pMagic,EPHEMFILE_MAGIC,sizeof(Header.pMagic));
+    Header.Version=EPHEMFILE_VERSION;
+    Header.ByteOrder=EPHEMFILE_BYTEORDER;
+    Header.HeaderSize=sizeof(Header);
+    Header.QuantityCount=QuantityCount;
+    Header.CoefficientCount=CoefficientCount;
+    Header.SegmentDays=SegmentDays;
+    Header.FirstSegment=(int)FirstSegment;
+    Header.SegmentCount=(unsigned int)SegmentCount;
+    Header.FirstJD=2451545.0+FirstSegment*SegmentDays;
+    Header.LastJD=2451545.0+(FirstSegment+SegmentCount)*SegmentDays;
+    Header.IndexOffset=sizeof(Header);
+    Header.BlockSize=QuantityCount*CoefficientCount*sizeof(double);
+    Header.FileSize=(unsigned int)FileSize;
+    Header.HeaderChecksum=
+        CRC32(&Header,offsetof(EPHEMFILEHEADER_T,HeaderChecksum));
+
+    pIndex=(EPHEMFILEINDEX_T *)calloc(SegmentCount,sizeof(*pIndex));
+    pBlock=(double *)malloc(Header.BlockSize);
+    if ( (pIndex==NULL) || (pBlock==NULL) )
+      ErrorCode=ERRORCODE_OUTOFMEMORY;
+    else
+    {
+      ErrorCode=ERRORCODE_SYSTEMFAILURE;
+      pHandle=fopen(pPathname,"wb");
+      if (pHandle!=NULL)
+      {
+        /* Blocks first (after room for the index), then the index. */
+        if (fseek(pHandle,Header.IndexOffset+SegmentCount*sizeof(*pIndex),
+            SEEK_SET)==0)
+        {
+          for(Segment=0;Segment<SegmentCount;Segment++)
+          {
+            pFit(FirstSegment+Segment,pBlock,pData);
+            pIndex[Segment].Offset=Header.IndexOffset+
+                SegmentCount*sizeof(*pIndex)+Segment*Header.BlockSize;
+            pIndex[Segment].Checksum=CRC32(pBlock,Header.BlockSize);
+            if (fwrite(pBlock,Header.BlockSize,1,pHandle)!=1)
+              break;
+          }
+          if ( (Segment==SegmentCount) &&
+              (fseek(pHandle,0,SEEK_SET)==0) &&
+              (fwrite(&Header,sizeof(Header),1,pHandle)==1) &&
+              (fwrite(pIndex,sizeof(*pIndex),SegmentCount,pHandle)==
+                  (size_t)SegmentCount) )
+            ErrorCode=ERRORCODE_SUCCESS;
+        }
+        if (fclose(pHandle)!=0)
+          ErrorCode=ERRORCODE_SYSTEMFAILURE;
+        if (ErrorCode<0)
+          remove(pPathname);
+      }
+    }
+    free(pIndex);
+    free(pBlock);
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+
+#undef    EPHEMFILE_C
@@ -0,0 +1,330 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file ephemfile.h
+*** \brief Precomputed ephemeris files.
+*** \details Reads and writes ephemeris files: Chebyshev coefficient blocks
+***   for consecutive fixed length time spans, as fitted by mooncache.c, so
+***   that a process can map them instead of fitting them again. The file is
+***   an EPHEMFILEHEADER_T, an index of EPHEMFILEINDEX_T (one per segment)
+***   and the coefficient blocks, in the byte order of the machine that
+***   wrote it.
+***
+***   A file is mapped read-only, so all processes using it share one copy
+***   in the page cache. Opening it only checks the header; each segment is
+***   checked against its checksum the first time it is used, so opening
+***   and the first lookup cost the same whatever the time range.
+**/
+
+
+#ifndef   EPHEMFILE_H
+#define   EPHEMFILE_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "structure.h"
+#include  "sysdefs.h"
+
+#include  <stddef.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Magic.
+*** \details First bytes of an ephemeris file.
+**/
+#define   EPHEMFILE_MAGIC       "MPEF"
+
+/**
+*** \brief Version.
+*** \details Version of the file layout.
+**/
+#define   EPHEMFILE_VERSION     (1)
+
+/**
+*** \brief Byte order mark.
+*** \details Written as a native integer, to detect files from machines of
+***   the other byte order.
+**/
+#define   EPHEMFILE_BYTEORDER   (0x01020304UL)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief File header.
+*** \details Start of an ephemeris file.
+**/
+typedef struct structEPHEMFILEHEADER
+{
+  /**
+  *** \brief Magic.
+  *** \details EPHEMFILE_MAGIC (not terminated).
+  **/
+  char pMagic[4];
+  /**
+  *** \brief Version.
+  *** \details EPHEMFILE_VERSION.
+  **/
+  unsigned int Version;
+  /**
+  *** \brief Byte order.
+  *** \details EPHEMFILE_BYTEORDER.
+  **/
+  unsigned int ByteOrder;
+  /**
+  *** \brief Header size.
+  *** \details Size of the header (in bytes).
+  **/
+  unsigned int HeaderSize;
+  /**
+  *** \brief Quantity count.
+  *** \details Number of fitted quantities in a block.
+  **/
+  unsigned int QuantityCount;
+  /**
+  *** \brief Coefficient count.
+  *** \details Number of Chebyshev coefficients per quantity.
+  **/
+  unsigned int CoefficientCount;
+  /**
+  *** \brief Segment span.
+  *** \details Length of a segment (in days).
+  **/
+  double SegmentDays;
+  /**
+  *** \brief First segment.
+  *** \details Index (T/span, T in Julian centuries (TDT) since J2000) of
+  ***   the first segment.
+  **/
+  int FirstSegment;
+  /**
+  *** \brief Segment count.
+  *** \details Number of segments.
+  **/
+  unsigned int SegmentCount;
+  /**
+  *** \brief First date.
+  *** \details Start of the first segment (Julian date, TDT).
+  **/
+  double FirstJD;
+  /**
+  *** \brief Last date.
+  *** \details End of the last segment (Julian date, TDT).
+  **/
+  double LastJD;
+  /**
+  *** \brief Index offset.
+  *** \details Offset of the index (in bytes from the start of the file).
+  **/
+  unsigned int IndexOffset;
+  /**
+  *** \brief Block size.
+  *** \details Size of a coefficient block (in bytes).
+  **/
+  unsigned int BlockSize;
+  /**
+  *** \brief File size.
+  *** \details Size of the whole file (in bytes).
+  **/
+  unsigned int FileSize;
+  /**
+  *** \brief Header checksum.
+  *** \details CRC-32 of the header before this field.
+  **/
+  unsigned int HeaderChecksum;
+} EPHEMFILEHEADER_T;
+
+/**
+*** \brief Index entry.
+*** \details Where one segment is, and its checksum.
+**/
+typedef struct structEPHEMFILEINDEX
+{
+  /**
+  *** \brief Offset.
+  *** \details Offset of the block (in bytes from the start of the file).
+  **/
+  unsigned int Offset;
+  /**
+  *** \brief Checksum.
+  *** \details CRC-32 of the block.
+  **/
+  unsigned int Checksum;
+} EPHEMFILEINDEX_T;
+
+/**
+*** \brief Segment fitter.
+*** \details Fills in the coefficient block of a segment for
+***   EphemFile_Write(), as QuantityCount rows of CoefficientCount doubles.
+*** \param Index Segment index.
+*** \param pCoefficients Storage for the block.
+*** \param pData Data passed to EphemFile_Write().
+**/
+typedef void (*EPHEMFILEFIT_F)(long Index,double *pCoefficients,void *pData);
+
+/**
+*** \brief Open ephemeris file.
+*** \details A mapped file and the checks done on it so far. Use one per
+***   thread (mapping the same file again is cheap, the pages are shared).
+**/
+typedef struct structEPHEMFILE
+{
+  /**
+  *** \brief Mapping.
+  *** \details Start of the file in memory, NULL if none is open.
+  **/
+  unsigned char const *pMapping;
+  /**
+  *** \brief Size.
+  *** \details Size of the mapping (in bytes).
+  **/
+  size_t Size;
+  /**
+  *** \brief Header.
+  *** \details Header of the file (points into the mapping).
+  **/
+  EPHEMFILEHEADER_T const *pHeader;
+  /**
+  *** \brief Index.
+  *** \details Index of the file (points into the mapping).
+  **/
+  EPHEMFILEINDEX_T const *pIndex;
+  /**
+  *** \brief Segment states.
+  *** \details Per segment: 0 not checked yet, 1 valid, 2 invalid.
+  **/
+  unsigned char *pStates;
+  /**
+  *** \brief Check count.
+  *** \details Number of segments checked so far.
+  **/
+  unsigned long CheckCount;
+  /**
+  *** \brief Invalid count.
+  *** \details Number of segments that failed their check.
+  **/
+  unsigned long InvalidCount;
+} EPHEMFILE_T;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+STRUCTURE_PROTOTYPE_INITIALIZE(EphemFile,EPHEMFILE_T);
+STRUCTURE_PROTOTYPE_UNINITIALIZE(EphemFile,EPHEMFILE_T);
+/**
+*** \brief Opens a file.
+*** \details Maps a file read-only and checks its header. The segments are
+***   checked as they are used.
+*** \param pFile Pointer to the file.
+*** \param pPathname Pathname of the file.
+*** \retval >0 Success.
+*** \retval <0 Failure (ERRORCODE_INVALIDDATA if it is not a valid file of
+***   this version and byte order).
+**/
+ERRORCODE_T EphemFile_Open(EPHEMFILE_T *pFile,char const *pPathname);
+/**
+*** \brief Closes a file.
+*** \details Unmaps the file.
+*** \param pFile Pointer to the file.
+**/
+void EphemFile_Close(EPHEMFILE_T *pFile);
+/**
+*** \brief Returns a segment.
+*** \details Returns the coefficient block of a segment, checking it first
+***   if it has not been checked yet.
+*** \param pFile Pointer to the file.
+*** \param Index Segment index (see EPHEMFILEHEADER_T.FirstSegment).
+*** \param ppCoefficients Storage for a pointer to the block (in the
+***   mapping, valid until the file is closed).
+*** \retval >0 Success.
+*** \retval ERRORCODE_FALSE The file does not cover the segment.
+*** \retval <0 Failure (ERRORCODE_INVALIDDATA if the block is corrupt).
+**/
+ERRORCODE_T EphemFile_GetSegment(EPHEMFILE_T *pFile,long Index,
+    double const **ppCoefficients);
+/**
+*** \brief Checks all segments.
+*** \details Checks every segment not checked yet.
+*** \param pFile Pointer to the file.
+*** \retval >0 All segments are valid.
+*** \retval <0 Failure (ERRORCODE_INVALIDDATA if any segment is corrupt).
+**/
+ERRORCODE_T EphemFile_Verify(EPHEMFILE_T *pFile);
+/**
+*** \brief Writes a file.
+*** \details Writes a file of SegmentCount segments starting at
+***   FirstSegment, calling pFit for each block.
+*** \param pPathname Pathname of the file.
+*** \param QuantityCount Number of quantities per block.
+*** \param CoefficientCount Number of coefficients per quantity.
+*** \param SegmentDays Length of a segment (in days).
+*** \param FirstSegment Index of the first segment.
+*** \param SegmentCount Number of segments.
+*** \param pFit Segment fitter.
+*** \param pData Data passed to pFit.
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T EphemFile_Write(char const *pPathname,
+    int QuantityCount,int CoefficientCount,double SegmentDays,
+    long FirstSegment,long SegmentCount,EPHEMFILEFIT_F pFit,void *pData);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* EPHEMFILE_H */
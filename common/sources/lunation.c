@@ -0,0 +1,243 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file lunation.c
+*** \brief lunation.h implementation.
+*** \details Implementation file for lunation.h.
+**/
+
+
+/** Identifier for lunation.c. **/
+#define   LUNATION_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "lunation.h"
+#ifdef    DEBUG_LUNATION_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_LUNATION_C */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  "lunationtable.h"   /* Generated by lunationtablegenerator. */
+
+#include  <math.h>
+#include  <stdlib.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Mean synodic month.
+*** \details Mean length of a lunation (in Julian centuries).
+**/
+#define   SYNODICMONTH_CENTURIES  (LUNATION_SYNODICMONTH/36525.0)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static long FindPrevious(double T,int Phase);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Finds the previous phase event.
+*** \details Estimates the lunation from the mean synodic month, then steps
+***   to the right one. The true phases never stray more than a day from
+***   the mean, so this takes at most a step or two.
+*** \param T Time (in Julian centuries (TDT) since J2000).
+*** \param Phase Phase (LUNATIONPHASE_E).
+*** \returns Lunation index of the last event at or before T, or -1 if it
+***   is before the table.
+**/
+static long FindPrevious(double T,int Phase)
+{
+  long Index;
+
+
+  Index=(long)floor((T-f_pLunationTable[0][Phase])/SYNODICMONTH_CENTURIES);
+  if (Index<0)
+    Index=0;
+  else if (Index>=LUNATIONTABLE_LUNATIONCOUNT)
+    Index=LUNATIONTABLE_LUNATIONCOUNT-1;
+  while( (Index+1<LUNATIONTABLE_LUNATIONCOUNT) &&
+      (f_pLunationTable[Index+1][Phase]<=T) )
+    Index++;
+  while( (Index>=0) && (f_pLunationTable[Index][Phase]>T) )
+    Index--;
+
+  return(Index);
+}
+
+ERRORCODE_T Lunation_GetRange(double *pFirst,double *pLast)
+{
+  ERRORCODE_T ErrorCode;
+
+
+  DEBUGLOG_Printf2("Lunation_GetRange(%p,%p)",pFirst,pLast);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pFirst==NULL) || (pLast==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else
+  {
+    *pFirst=f_pLunationTable[0][LUNATIONPHASE_NEWMOON];
+    *pLast=f_pLunationTable[
+        LUNATIONTABLE_LUNATIONCOUNT-1][LUNATIONPHASE_LASTQUARTER];
+    ErrorCode=ERRORCODE_SUCCESS;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+ERRORCODE_T Lunation_GetAge(double T,double *pAge)
+{
+  ERRORCODE_T ErrorCode;
+  long Index;
+
+
+  DEBUGLOG_Printf2("Lunation_GetAge(%f,%p)",T,pAge);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if (pAge==NULL)
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (T<f_pLunationTable[0][LUNATIONPHASE_NEWMOON]) ||
+      (T>f_pLunationTable[
+      LUNATIONTABLE_LUNATIONCOUNT-1][LUNATIONPHASE_LASTQUARTER]) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    Index=FindPrevious(T,LUNATIONPHASE_NEWMOON);
+    *pAge=(T-f_pLunationTable[Index][LUNATIONPHASE_NEWMOON])*36525.0;
+    ErrorCode=ERRORCODE_SUCCESS;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+ERRORCODE_T Lunation_GetPreviousPhase(double T,int Phase,double *pT)
+{
+  ERRORCODE_T ErrorCode;
+  long Index;
+
+
+  DEBUGLOG_Printf3("Lunation_GetPreviousPhase(%f,%d,%p)",T,Phase,pT);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if (pT==NULL)
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (Phase<0) || (Phase>=LUNATIONPHASE_COUNT) ||
+      (T>f_pLunationTable[
+      LUNATIONTABLE_LUNATIONCOUNT-1][LUNATIONPHASE_LASTQUARTER]) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    Index=FindPrevious(T,Phase);
+    if (Index<0)
+      ErrorCode=ERRORCODE_INVALIDPARAMETER;
+    else
+    {
+      *pT=f_pLunationTable[Index][Phase];
+      ErrorCode=ERRORCODE_SUCCESS;
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+ERRORCODE_T Lunation_GetNextPhase(double T,int Phase,double *pT)
+{
+  ERRORCODE_T ErrorCode;
+  long Index;
+
+
+  DEBUGLOG_Printf3("Lunation_GetNextPhase(%f,%d,%p)",T,Phase,pT);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if (pT==NULL)
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (Phase<0) || (Phase>=LUNATIONPHASE_COUNT) ||
+      (T<f_pLunationTable[0][LUNATIONPHASE_NEWMOON]) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    Index=FindPrevious(T,Phase)+1;
+    if (Index>=LUNATIONTABLE_LUNATIONCOUNT)
+      ErrorCode=ERRORCODE_INVALIDPARAMETER;
+    else
+    {
+      *pT=f_pLunationTable[Index][Phase];
+      ErrorCode=ERRORCODE_SUCCESS;
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+
+#undef    LUNATION_C
@@ -0,0 +1,168 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file lunation.h
+*** \brief Precomputed lunation table.
+*** \details Looks up the new moon, first quarter, full moon and last quarter
+***   instants from a table generated at build time (see
+***   lunationtablegenerator.c), so the moon age and the phase events do not
+***   need a search through the lunar theory.
+**/
+
+
+#ifndef   LUNATION_H
+#define   LUNATION_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "errorcode.h"
+#include  "sysdefs.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Mean synodic month.
+*** \details Mean length of a lunation (in days).
+**/
+#define   LUNATION_SYNODICMONTH   (29.530589)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Lunation phases.
+*** \details Phase events held in the table, in the order they occur.
+**/
+typedef enum enumLUNATIONPHASE
+{
+  /**
+  *** \brief New moon.
+  *** \details New moon.
+  **/
+  LUNATIONPHASE_NEWMOON=0,
+  /**
+  *** \brief First quarter.
+  *** \details First quarter.
+  **/
+  LUNATIONPHASE_FIRSTQUARTER,
+  /**
+  *** \brief Full moon.
+  *** \details Full moon.
+  **/
+  LUNATIONPHASE_FULLMOON,
+  /**
+  *** \brief Last quarter.
+  *** \details Last quarter.
+  **/
+  LUNATIONPHASE_LASTQUARTER,
+  /**
+  *** \brief Phase count.
+  *** \details Number of phase events per lunation.
+  **/
+  LUNATIONPHASE_COUNT
+} LUNATIONPHASE_E;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+*** \brief Returns the table range.
+*** \details Returns the first and last instants held in the table.
+*** \param pFirst Storage for the first instant (in Julian centuries (TDT)
+***   since J2000).
+*** \param pLast Storage for the last instant (in Julian centuries (TDT)
+***   since J2000).
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T Lunation_GetRange(double *pFirst,double *pLast);
+/**
+*** \brief Returns the moon age.
+*** \details Returns the time since the previous new moon.
+*** \param T Time (in Julian centuries (TDT) since J2000).
+*** \param pAge Storage for the age (in days).
+*** \retval >0 Success.
+*** \retval <0 Failure (T is outside the table).
+**/
+ERRORCODE_T Lunation_GetAge(double T,double *pAge);
+/**
+*** \brief Returns the previous phase event.
+*** \details Returns the last instant of a phase at or before T.
+*** \param T Time (in Julian centuries (TDT) since J2000).
+*** \param Phase Phase (LUNATIONPHASE_E).
+*** \param pT Storage for the instant (in Julian centuries (TDT) since
+***   J2000).
+*** \retval >0 Success.
+*** \retval <0 Failure (T is outside the table).
+**/
+ERRORCODE_T Lunation_GetPreviousPhase(double T,int Phase,double *pT);
+/**
+*** \brief Returns the next phase event.
+*** \details Returns the first instant of a phase after T.
+*** \param T Time (in Julian centuries (TDT) since J2000).
+*** \param Phase Phase (LUNATIONPHASE_E).
+*** \param pT Storage for the instant (in Julian centuries (TDT) since
+***   J2000).
+*** \retval >0 Success.
+*** \retval <0 Failure (T is outside the table).
+**/
+ERRORCODE_T Lunation_GetNextPhase(double T,int Phase,double *pT);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* LUNATION_H */
@@ -0,0 +1,424 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file mooncache.c
+*** \brief mooncache.h implementation.
+*** \details Implementation file for mooncache.h.
+**/
+
+
+/** Identifier for mooncache.c. **/
+#define   MOONCACHE_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "mooncache.h"
+#ifdef    DEBUG_MOONCACHE_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_MOONCACHE_C */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  <math.h>
+#include  <string.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Segment span.
+*** \details Length of a cache segment (in Julian centuries).
+**/
+#define   SEGMENT_CENTURIES   (MOONCACHE_SEGMENTDAYS/36525.0)
+
+/**
+*** \brief Node count.
+*** \details Number of Chebyshev nodes (one per coefficient).
+**/
+#define   NODE_COUNT          (MOONCACHE_COEFFICIENTCOUNT)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(MoonCache,MOONCACHE_T);
+static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(MoonCache,MOONCACHE_T);
+static void BuildSegment(MOONCACHE_T *pCache,
+    MOONCACHESEGMENT_T *pSegment,long Index);
+static double Chebyshev(double const *pCoefficients,double X);
+static void EvaluateMoon(double T,double pValues[MOONCACHEQUANTITY_COUNT]);
+static double WrapDifference(int Quantity,double Difference);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Wrap periods.
+*** \details Period of each quantity, or 0 if it does not wrap.
+**/
+static double const f_pWrapPeriod[MOONCACHEQUANTITY_COUNT]=
+    { 360.0, 0.0, 0.0, 1.0 };
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+STRUCTURE_FUNCTION_INITIALIZE(MoonCache,MOONCACHE_T)
+
+static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(MoonCache,MOONCACHE_T)
+{
+  ERRORCODE_T ErrorCode;
+  int Index;
+
+
+  DEBUGLOG_Printf1("MoonCache_InitializeMembers(%p)",pStructure);
+  DEBUGLOG_LogIn();
+
+  /* Mark all slots empty. */
+  for(Index=0;Index<MOONCACHE_SLOTCOUNT;Index++)
+    pStructure->pSegments[Index].Index=-1;
+  pStructure->pFile=NULL;
+
+  ErrorCode=ERRORCODE_SUCCESS;
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+STRUCTURE_FUNCTION_UNINITIALIZE(MoonCache,MOONCACHE_T)
+
+static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(MoonCache,MOONCACHE_T)
+{
+  ERRORCODE_T ErrorCode;
+  UNUSED(pStructure);
+
+
+  DEBUGLOG_Printf1("MoonCache_UninitializeMembers(%p)",pStructure);
+  DEBUGLOG_LogIn();
+
+  ErrorCode=ERRORCODE_SUCCESS;
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+/**
+*** \brief Builds a segment.
+*** \details Fits a segment and updates the cache error bounds.
+*** \param pCache Pointer to the cache.
+*** \param pSegment Segment to fill.
+*** \param Index Span index (T/span).
+**/
+static void BuildSegment(MOONCACHE_T *pCache,
+    MOONCACHESEGMENT_T *pSegment,long Index)
+{
+  double pError[MOONCACHEQUANTITY_COUNT];
+  int Quantity;
+
+
+  DEBUGLOG_Printf3("BuildSegment(%p,%p,%ld)",pCache,pSegment,Index);
+  DEBUGLOG_LogIn();
+
+  MoonCache_FitSegment(Index,pSegment->pCoefficients,pError);
+  pSegment->Index=Index;
+  for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+    if (pError[Quantity]>pCache->pMaximumError[Quantity])
+      pCache->pMaximumError[Quantity]=pError[Quantity];
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+/**
+*** \brief Evaluates a Chebyshev series.
+*** \details Clenshaw recurrence for one quantity of a segment.
+*** \param pCoefficients Coefficients (the first one halved).
+*** \param X Position in the segment (-1 to 1).
+*** \returns Value of the series.
+**/
+static double Chebyshev(double const *pCoefficients,double X)
+{
+  double B0;
+  double B1;
+  double B2;
+  int Index;
+
+
+  B1=0.0;
+  B2=0.0;
+  for(Index=MOONCACHE_COEFFICIENTCOUNT-1;Index>=1;Index--)
+  {
+    B0=2.0*X*B1-B2+pCoefficients[Index];
+    B2=B1;
+    B1=B0;
+  }
+  return(X*B1-B2+pCoefficients[0]);
+}
+
+/**
+*** \brief Evaluates the lunar theory.
+*** \details Calls Moon() and stores the cached quantities.
+*** \param T Time (in Julian centuries (TDT) since J2000).
+*** \param pValues Storage for the quantities.
+**/
+static void EvaluateMoon(double T,double pValues[MOONCACHEQUANTITY_COUNT])
+{
+  double Age;
+
+
+  pValues[MOONCACHEQUANTITY_PHASE]=Moon(T,&pValues[MOONCACHEQUANTITY_LAMBDA],
+      &pValues[MOONCACHEQUANTITY_BETA],&pValues[MOONCACHEQUANTITY_DISTANCE],
+      &Age);
+  return;
+}
+
+ERRORCODE_T MoonCache_Evaluate(MOONCACHE_T *pCache,double T,
+    double *pLambda,double *pBeta,double *pDistance,double *pPhase)
+{
+  ERRORCODE_T ErrorCode;
+  MOONCACHESEGMENT_T *pSegment;
+  double const *pCoefficients;
+  long Index;
+  double X;
+  double Value;
+
+
+  DEBUGLOG_Printf6("MoonCache_Evaluate(%p,%f,%p,%p,%p,%p)",
+      pCache,T,pLambda,pBeta,pDistance,pPhase);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pCache==NULL) || (pLambda==NULL) || (pBeta==NULL) ||
+      (pDistance==NULL) || (pPhase==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else
+  {
+    /* Find (or build) the segment. */
+    Index=(long)floor(T/SEGMENT_CENTURIES);
+    pSegment=&pCache->pSegments[
+        ((Index%MOONCACHE_SLOTCOUNT)+MOONCACHE_SLOTCOUNT)%MOONCACHE_SLOTCOUNT];
+    if (pSegment->Index==Index)
+      pCache->HitCount++;
+    else
+    {
+      pCache->MissCount++;
+      if ( (pCache->pFile!=NULL) &&
+          (EphemFile_GetSegment(pCache->pFile,Index,&pCoefficients)>0) )
+      {
+        memcpy(pSegment->pCoefficients,pCoefficients,
+            sizeof(pSegment->pCoefficients));
+        pSegment->Index=Index;
+        pCache->FileCount++;
+      }
+      else
+        BuildSegment(pCache,pSegment,Index);
+    }
+
+    /* Evaluate. */
+    X=2.0*(T/SEGMENT_CENTURIES-Index)-1.0;
+    Value=Chebyshev(pSegment->pCoefficients[MOONCACHEQUANTITY_LAMBDA],X);
+    *pLambda=Value-360.0*floor(Value/360.0);
+    *pBeta=Chebyshev(pSegment->pCoefficients[MOONCACHEQUANTITY_BETA],X);
+    *pDistance=
+        Chebyshev(pSegment->pCoefficients[MOONCACHEQUANTITY_DISTANCE],X);
+    Value=Chebyshev(pSegment->pCoefficients[MOONCACHEQUANTITY_PHASE],X);
+    *pPhase=Value-floor(Value);
+
+    ErrorCode=ERRORCODE_SUCCESS;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+ERRORCODE_T MoonCache_GetMaximumError(
+    MOONCACHE_T const *pCache,int Quantity,double *pError)
+{
+  ERRORCODE_T ErrorCode;
+
+
+  DEBUGLOG_Printf3("MoonCache_GetMaximumError(%p,%d,%p)",
+      pCache,Quantity,pError);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pCache==NULL) || (pError==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (Quantity<0) || (Quantity>=MOONCACHEQUANTITY_COUNT) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    *pError=pCache->pMaximumError[Quantity];
+    ErrorCode=ERRORCODE_SUCCESS;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+void MoonCache_FitSegment(long Index,
+    double pCoefficients[MOONCACHEQUANTITY_COUNT][MOONCACHE_COEFFICIENTCOUNT],
+    double pError[MOONCACHEQUANTITY_COUNT])
+{
+  double pNodes[NODE_COUNT][MOONCACHEQUANTITY_COUNT];
+  double pValues[MOONCACHEQUANTITY_COUNT];
+  double Middle;
+  double HalfSpan;
+  double Sum;
+  double Error;
+  double X;
+  int Node;
+  int Quantity;
+  int Coefficient;
+
+
+  DEBUGLOG_Printf3("MoonCache_FitSegment(%ld,%p,%p)",
+      Index,pCoefficients,pError);
+  DEBUGLOG_LogIn();
+
+  HalfSpan=0.5*SEGMENT_CENTURIES;
+  Middle=(Index+0.5)*SEGMENT_CENTURIES;
+
+  /* Sample in increasing time (x=-1 first) so the wrapping quantities
+      can be unwrapped against the previous node. */
+  for(Node=NODE_COUNT-1;Node>=0;Node--)
+  {
+    X=cos(M_PI*(Node+0.5)/NODE_COUNT);
+    EvaluateMoon(Middle+HalfSpan*X,pNodes[Node]);
+    if (Node<NODE_COUNT-1)
+      for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+        pNodes[Node][Quantity]=pNodes[Node+1][Quantity]+WrapDifference(
+            Quantity,pNodes[Node][Quantity]-pNodes[Node+1][Quantity]);
+  }
+
+  /* Chebyshev coefficients (the first one is stored halved). */
+  for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+    for(Coefficient=0;Coefficient<MOONCACHE_COEFFICIENTCOUNT;Coefficient++)
+    {
+      Sum=0.0;
+      for(Node=0;Node<NODE_COUNT;Node++)
+        Sum+=pNodes[Node][Quantity]*
+            cos(M_PI*Coefficient*(Node+0.5)/NODE_COUNT);
+      pCoefficients[Quantity][Coefficient]=
+          (Coefficient==0 ? 1.0 : 2.0)*Sum/NODE_COUNT;
+    }
+
+  /* Check the fit between the nodes and at both ends of the span. */
+  for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+    pError[Quantity]=0.0;
+  for(Node=0;Node<=NODE_COUNT;Node++)
+  {
+    X=cos(M_PI*Node/NODE_COUNT);
+    EvaluateMoon(Middle+HalfSpan*X,pValues);
+    for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+    {
+      Error=fabs(WrapDifference(Quantity,
+          Chebyshev(pCoefficients[Quantity],X)-pValues[Quantity]));
+      if (Error>pError[Quantity])
+        pError[Quantity]=Error;
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+ERRORCODE_T MoonCache_SetFile(MOONCACHE_T *pCache,EPHEMFILE_T *pFile)
+{
+  ERRORCODE_T ErrorCode;
+
+
+  DEBUGLOG_Printf2("MoonCache_SetFile(%p,%p)",pCache,pFile);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if (pCache==NULL)
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (pFile!=NULL) && ( (pFile->pHeader==NULL) ||
+      (pFile->pHeader->QuantityCount!=
+          (unsigned int)MOONCACHEQUANTITY_COUNT) ||
+      (pFile->pHeader->CoefficientCount!=MOONCACHE_COEFFICIENTCOUNT) ||
+      (pFile->pHeader->SegmentDays!=MOONCACHE_SEGMENTDAYS) ) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    pCache->pFile=pFile;
+    ErrorCode=ERRORCODE_SUCCESS;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+/**
+*** \brief Wraps a difference.
+*** \details Reduces the difference of a wrapping quantity to half a period
+***   either side of zero.
+*** \param Quantity Quantity (MOONCACHEQUANTITY_E).
+*** \param Difference Difference.
+*** \returns Wrapped difference.
+**/
+static double WrapDifference(int Quantity,double Difference)
+{
+  double Period;
+
+
+  Period=f_pWrapPeriod[Quantity];
+  if (Period!=0.0)
+    Difference-=Period*floor(Difference/Period+0.5);
+  return(Difference);
+}
+
+
+#undef    MOONCACHE_C
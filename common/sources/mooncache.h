@@ -0,0 +1,262 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file mooncache.h
+*** \brief Chebyshev segment cache for the lunar theory.
+*** \details Fits Chebyshev polynomials to the output of Moon() over fixed
+***   time spans, building the segments as they are needed. Dense time
+***   sweeps then evaluate a short polynomial instead of the full series.
+**/
+
+
+#ifndef   MOONCACHE_H
+#define   MOONCACHE_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "ephemfile.h"
+#include  "structure.h"
+#include  "sysdefs.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Segment span.
+*** \details Length of a cache segment (in days).
+**/
+#define   MOONCACHE_SEGMENTDAYS       (2.0)
+/**
+*** \brief Coefficient count.
+*** \details Number of Chebyshev coefficients per quantity per segment.
+**/
+#define   MOONCACHE_COEFFICIENTCOUNT  (16)
+/**
+*** \brief Segment slot count.
+*** \details Number of segments held by the cache (direct mapped).
+**/
+#define   MOONCACHE_SLOTCOUNT         (64)
+/**
+*** \brief Error bounds.
+*** \details Largest difference from Moon() of each quantity over
+***   1900-2100 (in degrees, degrees, earth radii and phase), checked by
+***   moonphase-mooncachetest. MoonCache_GetMaximumError() stays within
+***   them as well.
+**/
+#define   MOONCACHE_MAXERROR_LAMBDA   (1e-8)
+#define   MOONCACHE_MAXERROR_BETA     (1e-8)
+#define   MOONCACHE_MAXERROR_DISTANCE (2e-9)
+#define   MOONCACHE_MAXERROR_PHASE    (1e-10)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Cached quantities.
+*** \details Index of each quantity in a segment.
+**/
+typedef enum enumMOONCACHEQUANTITY
+{
+  /**
+  *** \brief Longitude.
+  *** \details Ecliptic longitude (in degrees).
+  **/
+  MOONCACHEQUANTITY_LAMBDA=0,
+  /**
+  *** \brief Latitude.
+  *** \details Ecliptic latitude (in degrees).
+  **/
+  MOONCACHEQUANTITY_BETA,
+  /**
+  *** \brief Distance.
+  *** \details Earth-moon distance (in earth radii).
+  **/
+  MOONCACHEQUANTITY_DISTANCE,
+  /**
+  *** \brief Phase.
+  *** \details Phase as returned by Moon() (0-1).
+  **/
+  MOONCACHEQUANTITY_PHASE,
+  /**
+  *** \brief Quantity count.
+  *** \details Number of cached quantities.
+  **/
+  MOONCACHEQUANTITY_COUNT
+} MOONCACHEQUANTITY_E;
+
+/**
+*** \brief Cache segment.
+*** \details Chebyshev coefficients for one time span.
+**/
+typedef struct structMOONCACHESEGMENT
+{
+  /**
+  *** \brief Segment index.
+  *** \details Index of the span held in this slot (T/span), or -1 if the
+  ***   slot is empty.
+  **/
+  long Index;
+  /**
+  *** \brief Coefficients.
+  *** \details Chebyshev coefficients of each quantity. Longitude and phase
+  ***   are fitted unwrapped.
+  **/
+  double pCoefficients[MOONCACHEQUANTITY_COUNT][MOONCACHE_COEFFICIENTCOUNT];
+} MOONCACHESEGMENT_T;
+
+/**
+*** \brief Moon cache.
+*** \details Segment storage and statistics. A cache is not thread safe; use
+***   one per thread.
+**/
+typedef struct structMOONCACHE
+{
+  /**
+  *** \brief Segments.
+  *** \details Direct mapped segment slots.
+  **/
+  MOONCACHESEGMENT_T pSegments[MOONCACHE_SLOTCOUNT];
+  /**
+  *** \brief Fit error.
+  *** \details Largest difference between the fit and Moon() seen at the
+  ***   check points of all segments built so far, per quantity.
+  **/
+  double pMaximumError[MOONCACHEQUANTITY_COUNT];
+  /**
+  *** \brief Hit count.
+  *** \details Number of evaluations served by an existing segment.
+  **/
+  unsigned long HitCount;
+  /**
+  *** \brief Miss count.
+  *** \details Number of evaluations that had to build a segment.
+  **/
+  unsigned long MissCount;
+  /**
+  *** \brief Ephemeris file.
+  *** \details Precomputed segments (see MoonCache_SetFile()), or NULL.
+  **/
+  EPHEMFILE_T *pFile;
+  /**
+  *** \brief File count.
+  *** \details Number of misses served from the ephemeris file.
+  **/
+  unsigned long FileCount;
+} MOONCACHE_T;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+STRUCTURE_PROTOTYPE_INITIALIZE(MoonCache,MOONCACHE_T);
+STRUCTURE_PROTOTYPE_UNINITIALIZE(MoonCache,MOONCACHE_T);
+/**
+*** \brief Evaluates the moon position.
+*** \details Same outputs as Moon(), served from the segment covering T.
+***   The segment is fitted first if it is not in the cache.
+*** \param pCache Pointer to the cache.
+*** \param T Time (in Julian centuries (TDT) since J2000).
+*** \param pLambda Ecliptic longitude (in degrees, 0-360).
+*** \param pBeta Ecliptic latitude (in degrees).
+*** \param pDistance Earth-moon distance (in earth radii).
+*** \param pPhase Phase (0-1).
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T MoonCache_Evaluate(MOONCACHE_T *pCache,double T,
+    double *pLambda,double *pBeta,double *pDistance,double *pPhase);
+/**
+*** \brief Returns the fit error bound.
+*** \details Returns the largest fit error seen so far for a quantity. It is
+***   measured against Moon() halfway between the fit nodes and at the ends
+***   of every segment built, so it is an estimate rather than a strict bound.
+*** \param pCache Pointer to the cache.
+*** \param Quantity Quantity (MOONCACHEQUANTITY_E).
+*** \param pError Largest error (in the units of the quantity).
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T MoonCache_GetMaximumError(
+    MOONCACHE_T const *pCache,int Quantity,double *pError);
+/**
+*** \brief Fits a segment.
+*** \details Computes the coefficients of a span as the cache does on a
+***   miss, for writing ephemeris files.
+*** \param Index Span index (T/span).
+*** \param pCoefficients Storage for the coefficients.
+*** \param pError Storage for the fit error of each quantity (as in
+***   MoonCache_GetMaximumError()).
+**/
+void MoonCache_FitSegment(long Index,
+    double pCoefficients[MOONCACHEQUANTITY_COUNT][MOONCACHE_COEFFICIENTCOUNT],
+    double pError[MOONCACHEQUANTITY_COUNT]);
+/**
+*** \brief Sets the ephemeris file.
+*** \details Serves misses in the span of an ephemeris file from it instead
+***   of fitting them. The file holds the same fits, so the results do not
+***   change. A segment that fails its checksum is fitted as usual. The file
+***   must stay open while it is set.
+*** \param pCache Pointer to the cache.
+*** \param pFile Pointer to an open file, or NULL to stop using one.
+*** \retval >0 Success.
+*** \retval <0 Failure (the file does not hold moon cache segments).
+**/
+ERRORCODE_T MoonCache_SetFile(MOONCACHE_T *pCache,EPHEMFILE_T *pFile);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* MOONCACHE_H */
@@ -42,6 +42,11 @@
 #include  "debuglog.h"
 #include  "messagelog.h"
 
+#include  "daynumber.h"
+
+#include  <stdlib.h>
+#include  <string.h>
+
 
 /****
 *****
@@ -49,6 +54,24 @@
 *****
 ****/
 
+/**
+*** \brief Unix epoch.
+*** \details Julian date of 1970-01-01 0h UT (time_t 0).
+**/
+#define   MOONDATA_UNIXEPOCH_JD   (2440587.5)
+
+/**
+*** \brief Unix epoch day.
+*** \details Day number of 1970-01-01.
+**/
+#define   MOONDATA_UNIXEPOCH_DAY  (2440588L)
+
+/**
+*** \brief Seconds per day.
+*** \details Seconds per day.
+**/
+#define   MOONDATA_DAYSECONDS     (86400L)
+
 
 /****
 *****
@@ -56,9 +79,6 @@
 *****
 ****/
 
-extern double Glon;
-extern double TimeZone;
-
 
 /****
 *****
@@ -68,6 +88,13 @@ extern double TimeZone;
 
 static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(MoonData,MOONDATA_T);
 static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(MoonData,MOONDATA_T);
+static long DayFromTime(time_t Time);
+static long SystemOffset(time_t UTC);
+static void ZoneFill(MOONDATAZONE_T *pZone,int Year);
+static int InputsEqual(MOONDATAINPUTS_T const *pA,MOONDATAINPUTS_T const *pB);
+static MOONDATAMEMOENTRY_T *MemoLookup(MOONDATA_T *pMoonData,
+    MOONDATAINPUTS_T const *pInputs);
+static void Calculate(MOONDATA_T *pMoonData,MOONDATAINPUTS_T const *pInputs);
 
 
 /****
@@ -95,12 +122,16 @@ STRUCTURE_FUNCTION_INITIALIZE(MoonData,MOONDATA_T)
 static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(MoonData,MOONDATA_T)
 {
   ERRORCODE_T ErrorCode;
-  UNUSED(pStructure);
 
 
   DEBUGLOG_Printf1("MoonData_InitializeMembers(%p)",pStructure);
   DEBUGLOG_LogIn();
 
+  pStructure->AccuracyTier=EPHEMTIER_PRECISE;
+  RiseSetCache_Init(&pStructure->RiseSetCache);
+  MoonData_ClearMemo(pStructure);
+  pStructure->Memo.Quantum=1;
+
   ErrorCode=ERRORCODE_SUCCESS;
 
   DEBUGLOG_LogOut();
@@ -137,66 +168,478 @@ float MoonData_GetMoonPhasePercent(MOONDATA_T const *pMoon)
   DEBUGLOG_LogOut();
   return(Percent);
 }
+/**
+*** \brief Day of a time.
+*** \details Returns the day number a time falls in.
+*** \param Time Time (seconds since 1970-01-01).
+*** \returns Day number.
+**/
+static long DayFromTime(time_t Time)
+{
+  long Days;
+
+
+  Days=(long)(Time/MOONDATA_DAYSECONDS);
+  if (Time%MOONDATA_DAYSECONDS<0)
+    Days--;
+  return(Days+MOONDATA_UNIXEPOCH_DAY);
+}
+
+/**
+*** \brief Asks the system for an offset.
+*** \details Returns the UTC offset of the local time zone at a time, using
+***   the reentrant C library conversion.
+*** \param UTC Time.
+*** \returns UTC minus local time (in seconds).
+**/
+static long SystemOffset(time_t UTC)
+{
+  struct tm LocalTime;
+  long Local;
+
+
+#ifdef    _WIN32
+  localtime_s(&LocalTime,&UTC);
+#else     /* _WIN32 */
+  localtime_r(&UTC,&LocalTime);
+#endif    /* _WIN32 */
+  /* tm_gmtoff is not supported in Windows. */
+  Local=(DayNumber_FromDate(LocalTime.tm_year+1900,LocalTime.tm_mon+1,
+      LocalTime.tm_mday)-MOONDATA_UNIXEPOCH_DAY)*MOONDATA_DAYSECONDS+LocalTime.tm_hour*3600L+
+      LocalTime.tm_min*60L+LocalTime.tm_sec;
+  return((long)(UTC-Local));
+}
+
+/**
+*** \brief Fills the zone cache.
+*** \details Finds the UTC offset changes of the local time zone in a year
+***   (and two days on either side). The offset is sampled every 6 hours
+***   and each change is narrowed down to the second. This is the only
+***   place the C library is asked about the time zone.
+*** \param pZone Pointer to the zone cache.
+*** \param Year Year.
+**/
+static void ZoneFill(MOONDATAZONE_T *pZone,int Year)
+{
+  time_t Time;
+  time_t Low;
+  time_t High;
+  time_t Middle;
+  long Offset;
+  long NextOffset;
+
+
+  /* localtime_r() need not pick up a new TZ by itself. */
+#ifdef    _WIN32
+  _tzset();
+#else     /* _WIN32 */
+  tzset();
+#endif    /* _WIN32 */
+
+  pZone->Start=(time_t)(DayNumber_FromDate(Year,1,1)-2-
+      MOONDATA_UNIXEPOCH_DAY)*MOONDATA_DAYSECONDS;
+  pZone->End=(time_t)(DayNumber_FromDate(Year+1,1,1)+2-
+      MOONDATA_UNIXEPOCH_DAY)*MOONDATA_DAYSECONDS;
+  pZone->YearEnd=pZone->End;
+  pZone->TransitionCount=0;
+  pZone->pOffsets[0]=SystemOffset(pZone->Start);
+
+  Offset=pZone->pOffsets[0];
+  for(Time=pZone->Start;Time<pZone->End;Time+=6*3600)
+  {
+    NextOffset=SystemOffset(Time+6*3600);
+    if (NextOffset==Offset)
+      continue;
+
+    if (pZone->TransitionCount==MOONDATA_ZONETRANSITIONS)
+    {
+      /* More changes than we can keep, the rest is not cached. */
+      pZone->End=Time;
+      break;
+    }
+
+    /* The offset is Offset at Low and NextOffset at High. */
+    Low=Time;
+    High=Time+6*3600;
+    while(High-Low>1)
+    {
+      Middle=Low+(High-Low)/2;
+      if (SystemOffset(Middle)==Offset)
+        Low=Middle;
+      else
+        High=Middle;
+    }
+    pZone->pTransitions[pZone->TransitionCount]=High;
+    pZone->pOffsets[++pZone->TransitionCount]=NextOffset;
+    Offset=NextOffset;
+  }
+  pZone->ValidFlag=1;
+  pZone->FillCount++;
+
+  return;
+}
+
+/**
+*** \brief Compares inputs.
+*** \details Checks whether two sets of inputs give the same fields.
+*** \param pA First inputs.
+*** \param pB Second inputs.
+*** \returns Non-zero if they are equal.
+**/
+static int InputsEqual(MOONDATAINPUTS_T const *pA,MOONDATAINPUTS_T const *pB)
+{
+  return( (pA->ValidFlag!=0) && (pB->ValidFlag!=0) && (pA->UTC==pB->UTC) &&
+      (pA->Glat==pB->Glat) && (pA->Glon==pB->Glon) &&
+      (pA->TimeZone==pB->TimeZone) && (pA->AccuracyTier==pB->AccuracyTier) );
+}
+
+/**
+*** \brief Finds a memo entry.
+*** \details Returns the entry computed from the same inputs, or the least
+***   recently used entry (with LastUse set to 0) to be overwritten.
+*** \param pMoonData Pointer to the moon data.
+*** \param pInputs Inputs.
+*** \returns Memo entry.
+**/
+static MOONDATAMEMOENTRY_T *MemoLookup(MOONDATA_T *pMoonData,
+    MOONDATAINPUTS_T const *pInputs)
+{
+  MOONDATAMEMO_T *pMemo;
+  MOONDATAMEMOENTRY_T *pEntry;
+  MOONDATAMEMOENTRY_T *pOldest;
+  int Index;
+
+
+  pMemo=&pMoonData->Memo;
+  pMemo->UseCount++;
+  pOldest=&pMemo->pEntries[0];
+  for(Index=0;Index<MOONDATA_MEMOSIZE;Index++)
+  {
+    pEntry=&pMemo->pEntries[Index];
+    if ( (pEntry->LastUse!=0) && (InputsEqual(&pEntry->Inputs,pInputs)!=0) )
+    {
+      pEntry->LastUse=pMemo->UseCount;
+      return(pEntry);
+    }
+    if (pEntry->LastUse<pOldest->LastUse)
+      pOldest=pEntry;
+  }
+
+  pOldest->LastUse=0;
+  return(pOldest);
+}
+
+/**
+*** \brief Computes the moon data.
+*** \details Recomputes the field groups whose inputs differ from those of
+***   the current fields. The ephemeris depends on the time, location and
+***   accuracy tier; the rise/set times on the date, location and time
+***   zone, so they are only redone when the date changes.
+*** \param pMoonData Pointer to the moon data.
+*** \param pInputs Inputs.
+**/
+static void Calculate(MOONDATA_T *pMoonData,MOONDATAINPUTS_T const *pInputs)
+{
+  MOONDATAINPUTS_T const *pCurrent;
+  EphemContext Context;
+  int Groups;
+  long DayNumber;
+  int Year;
+  int Month;
+  int Day;
+
+
+  pCurrent=&pMoonData->Inputs;
+  Groups=0;
+  if ( (pCurrent->ValidFlag==0) || (pCurrent->Glat!=pInputs->Glat) ||
+      (pCurrent->Glon!=pInputs->Glon) )
+    Groups=MOONDATAGROUP_MASK(MOONDATAGROUP_EPHEMERIS)|
+        MOONDATAGROUP_MASK(MOONDATAGROUP_RISESET);
+  if ( (pCurrent->UTC!=pInputs->UTC) ||
+      (pCurrent->AccuracyTier!=pInputs->AccuracyTier) )
+    Groups|=MOONDATAGROUP_MASK(MOONDATAGROUP_EPHEMERIS);
+  if (pCurrent->TimeZone!=pInputs->TimeZone)
+    Groups|=MOONDATAGROUP_MASK(MOONDATAGROUP_RISESET);
+
+  EphemContext_Set(&Context,pInputs->Glat,pInputs->Glon,pInputs->TimeZone);
+
+  if ((Groups&MOONDATAGROUP_MASK(MOONDATAGROUP_EPHEMERIS))!=0)
+  {
+    Year=pMoonData->CTransData.year;
+    Month=pMoonData->CTransData.month;
+    Day=pMoonData->CTransData.day;
+    CalcEphemJD(MOONDATA_UNIXEPOCH_JD+pInputs->UTC/86400.0,
+        &pMoonData->CTransData,&Context,pInputs->AccuracyTier);
+    if ( (pMoonData->CTransData.year!=Year) ||
+        (pMoonData->CTransData.month!=Month) ||
+        (pMoonData->CTransData.day!=Day) )
+      Groups|=MOONDATAGROUP_MASK(MOONDATAGROUP_RISESET);
+  }
+
+  if ((Groups&MOONDATAGROUP_MASK(MOONDATAGROUP_RISESET))!=0)
+  {
+    /* The local days starting at local midnight of the day before, the day
+        of and the day after the ephemeris date. */
+    DayNumber=DayNumber_FromDate(pMoonData->CTransData.year,
+        pMoonData->CTransData.month,pMoonData->CTransData.day);
+
+    /* Update yesterdays rise/set times. */
+    MoonDataZone_GetLocalDate(&pMoonData->Zone,DayNumber-1,&Year,&Month,&Day);
+    MoonRiseCached(Year,Month,Day,
+      &pMoonData->YesterdaysRise,&pMoonData->YesterdaysSet,&Context,
+      &pMoonData->RiseSetCache);
+
+    /* Update todays rise/set times. */
+    MoonDataZone_GetLocalDate(&pMoonData->Zone,DayNumber,&Year,&Month,&Day);
+    MoonRiseCached(Year,Month,Day,
+      &pMoonData->TodaysRise,&pMoonData->TodaysSet,&Context,
+      &pMoonData->RiseSetCache);
+
+    /* Update tomorrows rise/set times. */
+    MoonDataZone_GetLocalDate(&pMoonData->Zone,DayNumber+1,&Year,&Month,&Day);
+    MoonRiseCached(Year,Month,Day,
+      &pMoonData->TomorrowsRise,&pMoonData->TomorrowsSet,&Context,
+      &pMoonData->RiseSetCache);
+  }
+
+  pMoonData->Inputs=*pInputs;
+  if ((Groups&MOONDATAGROUP_MASK(MOONDATAGROUP_EPHEMERIS))!=0)
+    pMoonData->Counters.pGroupCounts[MOONDATAGROUP_EPHEMERIS]++;
+  if ((Groups&MOONDATAGROUP_MASK(MOONDATAGROUP_RISESET))!=0)
+    pMoonData->Counters.pGroupCounts[MOONDATAGROUP_RISESET]++;
+  pMoonData->Counters.LastGroups=Groups;
+
+  return;
+}
+
 void MoonData_Recalculate(MOONDATA_T *pMoonData,time_t UTC)
 {
-  struct tm *pUTC;
-  int UTCHour;
-  struct tm *pLocalTime;
-  double Time;
-  long Date;
-  struct tm AdjustedTime;
-  time_t NormalizedTime;
+  char const *pName;
+  MOONDATAINPUTS_T Inputs;
+  MOONDATAMEMOENTRY_T *pEntry;
+  time_t Remainder;
 
 
   DEBUGLOG_Printf1("MoonData_Recalculate(%p)",pMoonData);
   DEBUGLOG_LogIn();
 
-  /* Get the UTC time. */
-  pUTC=gmtime(&UTC);
-
-  /* Convert time to hours. */
-  Time=pUTC->tm_hour+pUTC->tm_min/60.0+pUTC->tm_sec/3600.0;
-
-  /* Covert date to CalcEphem format (YYYYMMDD).*/
-  Date=10000*(pUTC->tm_year+1900)+100*(pUTC->tm_mon+1)+pUTC->tm_mday;
-
-  /* Get the local time. */
-  UTCHour=pUTC->tm_hour;    // pUTC and pLocalTime use same buffer.
-  pLocalTime=localtime(&UTC);
-
-  /* Update moon data. */
-  Glon=pMoonData->CTransData.Glon;
-  TimeZone=UTCHour-pLocalTime->tm_hour; /* tm_gmtoff not supported in Windows */
-  CalcEphem(Date,Time,&pMoonData->CTransData);
-
-  /* Update yesterdays rise/set times. */
-  memset(&AdjustedTime,0,sizeof(AdjustedTime));
-  AdjustedTime.tm_year=pMoonData->CTransData.year-1900;
-  AdjustedTime.tm_mon=pMoonData->CTransData.month-1;
-  AdjustedTime.tm_mday=pMoonData->CTransData.day-1;   // Yesterday.
-  AdjustedTime.tm_isdst=-1;   // Figure it out.
-  NormalizedTime=mktime(&AdjustedTime);
-  pUTC=gmtime(&NormalizedTime);
-  MoonRise(pUTC->tm_year+1900,pUTC->tm_mon+1,pUTC->tm_mday,0,
-    &pMoonData->YesterdaysRise,&pMoonData->YesterdaysSet);
-
-  /* Update todays rise/set times. */
-  AdjustedTime.tm_mday++;
-  NormalizedTime=mktime(&AdjustedTime);
-  pUTC=gmtime(&NormalizedTime);
-  MoonRise(pUTC->tm_year+1900,pUTC->tm_mon+1,pUTC->tm_mday,0,
-    &pMoonData->TodaysRise,&pMoonData->TodaysSet);
-
-  /* Update tomorrows rise/set times. */
-  AdjustedTime.tm_mday++;
-  NormalizedTime=mktime(&AdjustedTime);
-  pUTC=gmtime(&NormalizedTime);
-  MoonRise(pUTC->tm_year+1900,pUTC->tm_mon+1,pUTC->tm_mday,0,
-    &pMoonData->TomorrowsRise,&pMoonData->TomorrowsSet);
+  /* Quantize the time. */
+  if (pMoonData->Memo.Quantum>1)
+  {
+    Remainder=UTC%pMoonData->Memo.Quantum;
+    if (Remainder<0)
+      Remainder+=pMoonData->Memo.Quantum;
+    UTC-=Remainder;
+  }
+
+  /* Drop the zone cache if TZ was changed. */
+  pName=getenv("TZ");
+  if (pName==NULL)
+    pName="";
+  if (strncmp(pName,pMoonData->Zone.pName,MOONDATA_ZONENAMESIZE-1)!=0)
+  {
+    strncpy(pMoonData->Zone.pName,pName,MOONDATA_ZONENAMESIZE-1);
+    pMoonData->Zone.pName[MOONDATA_ZONENAMESIZE-1]=0;
+    pMoonData->Zone.ValidFlag=0;
+  }
+
+  Inputs.ValidFlag=1;
+  Inputs.UTC=UTC;
+  Inputs.Glat=pMoonData->CTransData.Glat;
+  Inputs.Glon=pMoonData->CTransData.Glon;
+  Inputs.TimeZone=MoonDataZone_GetOffset(&pMoonData->Zone,UTC)/3600.0;
+  Inputs.AccuracyTier=pMoonData->AccuracyTier;
+
+  pMoonData->Counters.CallCount++;
+  if (pMoonData->Memo.Quantum<=0)
+    Calculate(pMoonData,&Inputs);
+  else
+  {
+    pEntry=MemoLookup(pMoonData,&Inputs);
+    if (pEntry->LastUse!=0)
+    {
+      /* Same time and place as a recent call. */
+      pMoonData->Memo.HitCount++;
+      pMoonData->Counters.LastGroups=0;
+      pMoonData->Inputs=pEntry->Inputs;
+      pMoonData->CTransData=pEntry->CTransData;
+      pMoonData->YesterdaysRise=pEntry->pRiseSet[0];
+      pMoonData->YesterdaysSet=pEntry->pRiseSet[1];
+      pMoonData->TodaysRise=pEntry->pRiseSet[2];
+      pMoonData->TodaysSet=pEntry->pRiseSet[3];
+      pMoonData->TomorrowsRise=pEntry->pRiseSet[4];
+      pMoonData->TomorrowsSet=pEntry->pRiseSet[5];
+    }
+    else
+    {
+      pMoonData->Memo.MissCount++;
+      Calculate(pMoonData,&Inputs);
+
+      pEntry->Inputs=Inputs;
+      pEntry->LastUse=pMoonData->Memo.UseCount;
+      pEntry->CTransData=pMoonData->CTransData;
+      pEntry->pRiseSet[0]=pMoonData->YesterdaysRise;
+      pEntry->pRiseSet[1]=pMoonData->YesterdaysSet;
+      pEntry->pRiseSet[2]=pMoonData->TodaysRise;
+      pEntry->pRiseSet[3]=pMoonData->TodaysSet;
+      pEntry->pRiseSet[4]=pMoonData->TomorrowsRise;
+      pEntry->pRiseSet[5]=pMoonData->TomorrowsSet;
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void MoonData_GetMemoStatistics(MOONDATA_T const *pMoonData,
+    unsigned long *pHitCount,unsigned long *pMissCount)
+{
+  DEBUGLOG_Printf3("MoonData_GetMemoStatistics(%p,%p,%p)",
+      pMoonData,pHitCount,pMissCount);
+  DEBUGLOG_LogIn();
+
+  if (pHitCount!=NULL)
+    *pHitCount=pMoonData->Memo.HitCount;
+  if (pMissCount!=NULL)
+    *pMissCount=pMoonData->Memo.MissCount;
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void MoonData_ClearMemo(MOONDATA_T *pMoonData)
+{
+  int Index;
+
+
+  DEBUGLOG_Printf1("MoonData_ClearMemo(%p)",pMoonData);
+  DEBUGLOG_LogIn();
+
+  pMoonData->Memo.UseCount=0;
+  pMoonData->Memo.HitCount=0;
+  pMoonData->Memo.MissCount=0;
+  for(Index=0;Index<MOONDATA_MEMOSIZE;Index++)
+    pMoonData->Memo.pEntries[Index].LastUse=0;
+  pMoonData->Zone.ValidFlag=0;
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void MoonData_GetCounters(MOONDATA_T const *pMoonData,
+    MOONDATACOUNTERS_T *pCounters)
+{
+  DEBUGLOG_Printf2("MoonData_GetCounters(%p,%p)",pMoonData,pCounters);
+  DEBUGLOG_LogIn();
+
+  *pCounters=pMoonData->Counters;
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void MoonData_ResetCounters(MOONDATA_T *pMoonData)
+{
+  DEBUGLOG_Printf1("MoonData_ResetCounters(%p)",pMoonData);
+  DEBUGLOG_LogIn();
+
+  memset(&pMoonData->Counters,0,sizeof(pMoonData->Counters));
 
   DEBUGLOG_LogOut();
   return;
 }
 
+void MoonData_GetShareData(MOONDATA_T const *pMoonData,
+    MOONSHAREDATA_T *pData)
+{
+  CTrans const *pCTrans;
+
+
+  DEBUGLOG_Printf2("MoonData_GetShareData(%p,%p)",pMoonData,pData);
+  DEBUGLOG_LogIn();
+
+  pCTrans=&pMoonData->CTransData;
+  memset(pData,0,sizeof(*pData));
+  pData->UTC=(double)pMoonData->Inputs.UTC;
+  pData->Latitude=pCTrans->Glat;
+  pData->Longitude=pCTrans->Glon;
+  pData->TimeZone=pMoonData->Inputs.TimeZone;
+  pData->RightAscension=pCTrans->RA_moon;
+  pData->Declination=pCTrans->DEC_moon;
+  pData->Altitude=pCTrans->h_moon;
+  pData->Azimuth=pCTrans->A_moon;
+  pData->Phase=pCTrans->MoonPhase;
+  pData->Age=pCTrans->MoonAge;
+  pData->Distance=pCTrans->EarthMoonDistance;
+  pData->pRiseSet[0]=pMoonData->YesterdaysRise;
+  pData->pRiseSet[1]=pMoonData->YesterdaysSet;
+  pData->pRiseSet[2]=pMoonData->TodaysRise;
+  pData->pRiseSet[3]=pMoonData->TodaysSet;
+  pData->pRiseSet[4]=pMoonData->TomorrowsRise;
+  pData->pRiseSet[5]=pMoonData->TomorrowsSet;
+  pData->VisibleFlag=pCTrans->Visible;
+  pData->AccuracyTier=pMoonData->Inputs.AccuracyTier;
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+long MoonDataZone_GetOffset(MOONDATAZONE_T *pZone,time_t UTC)
+{
+  int Year;
+  int Month;
+  int Day;
+  int Index;
+  long Offset;
+
+
+  DEBUGLOG_Printf2("MoonDataZone_GetOffset(%p,%ld)",pZone,(long)UTC);
+  DEBUGLOG_LogIn();
+
+  /* Part of the cached year that did not fit, the C library answers. */
+  if ( (pZone->ValidFlag!=0) && (UTC>=pZone->End) && (UTC<pZone->YearEnd) )
+    Offset=SystemOffset(UTC);
+  else
+  {
+    if ( (pZone->ValidFlag==0) || (UTC<pZone->Start) || (UTC>=pZone->End) )
+    {
+      DayNumber_ToDate(DayFromTime(UTC),&Year,&Month,&Day);
+      ZoneFill(pZone,Year);
+    }
+    if (UTC>=pZone->End)
+      Offset=SystemOffset(UTC);
+    else
+    {
+      for(Index=0;Index<pZone->TransitionCount;Index++)
+        if (UTC<pZone->pTransitions[Index])
+          break;
+      Offset=pZone->pOffsets[Index];
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(Offset);
+}
+
+void MoonDataZone_GetLocalDate(MOONDATAZONE_T *pZone,long DayNumber,
+    int *pYear,int *pMonth,int *pDay)
+{
+  time_t Local;
+  time_t UTC;
+
+
+  DEBUGLOG_Printf5("MoonDataZone_GetLocalDate(%p,%ld,%p,%p,%p)",
+      pZone,DayNumber,pYear,pMonth,pDay);
+  DEBUGLOG_LogIn();
+
+  /* The offset at the local time, then at the UTC time it gives. */
+  Local=(time_t)(DayNumber-MOONDATA_UNIXEPOCH_DAY)*MOONDATA_DAYSECONDS;
+  UTC=Local+MoonDataZone_GetOffset(pZone,Local);
+  UTC=Local+MoonDataZone_GetOffset(pZone,UTC);
+  DayNumber_ToDate(DayFromTime(UTC),pYear,pMonth,pDay);
+
+  DEBUGLOG_LogOut();
+  return;
+}
 
 #undef    MOONDATA_C
@@ -37,6 +37,7 @@
 #include  "calcephem.h"
 #include  "structure.h"
 #include  "datetime.h"
+#include  "moonshare.h"
 
 #include  <time.h>
 
@@ -47,6 +48,34 @@
 *****
 ****/
 
+/**
+*** \brief Memo size.
+*** \details Number of results kept by the recalculation memo.
+**/
+#define   MOONDATA_MEMOSIZE       (8)
+
+/**
+*** \brief Field group mask.
+*** \details Mask bit of a field group (MOONDATAGROUP_E).
+**/
+#define   MOONDATAGROUP_MASK(g)   (1<<(g))
+
+/**
+*** \brief Zone name size.
+*** \details Size of the time zone name kept by the zone cache.
+**/
+#define   MOONDATA_ZONENAMESIZE   (64)
+
+/**
+*** \brief Zone transitions.
+*** \details Maximum number of UTC offset changes the zone cache keeps for
+***   a year. Can be overridden at build time (the zone test builds with a
+***   limit of 1 to cover years that do not fit).
+**/
+#ifndef   MOONDATA_ZONETRANSITIONS
+#define   MOONDATA_ZONETRANSITIONS  (8)
+#endif    /* MOONDATA_ZONETRANSITIONS */
+
 
 /****
 *****
@@ -54,6 +83,244 @@
 *****
 ****/
 
+/**
+*** \brief Field groups.
+*** \details Parts of MOONDATA_T that MoonData_Recalculate() updates
+***   separately.
+**/
+typedef enum enumMOONDATAGROUP
+{
+  /**
+  *** \brief Ephemeris.
+  *** \details CTransData. Depends on the time, the location and the
+  ***   accuracy tier.
+  **/
+  MOONDATAGROUP_EPHEMERIS=0,
+  /**
+  *** \brief Rise/set times.
+  *** \details Yesterdays, todays and tomorrows rise/set times. Depend on
+  ***   the date, the location and the time zone.
+  **/
+  MOONDATAGROUP_RISESET,
+  /**
+  *** \brief Group count.
+  *** \details Number of field groups.
+  **/
+  MOONDATAGROUP_COUNT
+} MOONDATAGROUP_E;
+
+/**
+*** \brief Inputs.
+*** \details The inputs the current fields were computed from.
+**/
+typedef struct structMOONDATAINPUTS
+{
+  /**
+  *** \brief Valid flag.
+  *** \details Set once the fields have been computed.
+  **/
+  int ValidFlag;
+
+  /**
+  *** \brief Time.
+  *** \details Time (quantized, in UTC).
+  **/
+  time_t UTC;
+
+  /**
+  *** \brief Latitude.
+  *** \details Observer latitude.
+  **/
+  double Glat;
+
+  /**
+  *** \brief Longitude.
+  *** \details Observer longitude.
+  **/
+  double Glon;
+
+  /**
+  *** \brief Time zone.
+  *** \details Time zone offset (in hours).
+  **/
+  double TimeZone;
+
+  /**
+  *** \brief Accuracy tier.
+  *** \details Accuracy tier (EPHEMTIER_*).
+  **/
+  int AccuracyTier;
+} MOONDATAINPUTS_T;
+
+/**
+*** \brief Work counters.
+*** \details How much work MoonData_Recalculate() has done.
+**/
+typedef struct structMOONDATACOUNTERS
+{
+  /**
+  *** \brief Call count.
+  *** \details Number of calls to MoonData_Recalculate().
+  **/
+  unsigned long CallCount;
+
+  /**
+  *** \brief Group counts.
+  *** \details Number of times each field group was recomputed (indexed by
+  ***   MOONDATAGROUP_E).
+  **/
+  unsigned long pGroupCounts[MOONDATAGROUP_COUNT];
+
+  /**
+  *** \brief Last groups.
+  *** \details Groups recomputed by the last call (MOONDATAGROUP_MASK()
+  ***   bits). 0 if nothing changed or the result came from the memo.
+  **/
+  int LastGroups;
+} MOONDATACOUNTERS_T;
+
+/**
+*** \brief Time zone cache.
+*** \details UTC offsets of the local time zone over one year (plus a few
+***   days on either side), so local/UTC conversions are plain arithmetic
+***   instead of calls into the C library.
+**/
+typedef struct structMOONDATAZONE
+{
+  /**
+  *** \brief Valid flag.
+  *** \details Non-zero if the cache holds a year. A cache set to all
+  ***   zeros is empty.
+  **/
+  int ValidFlag;
+
+  /**
+  *** \brief Fill count.
+  *** \details Number of times the cache was filled.
+  **/
+  unsigned long FillCount;
+
+  /**
+  *** \brief Zone name.
+  *** \details Value of the TZ environment variable the cache was filled
+  ***   for ("" if not set).
+  **/
+  char pName[MOONDATA_ZONENAMESIZE];
+
+  /**
+  *** \brief Start.
+  *** \details First time covered by the cache.
+  **/
+  time_t Start;
+
+  /**
+  *** \brief End.
+  *** \details First time after the cache.
+  **/
+  time_t End;
+
+  /**
+  *** \brief Year end.
+  *** \details First time after the span the cache was filled for. Past
+  ***   End if the span had more changes than fit.
+  **/
+  time_t YearEnd;
+
+  /**
+  *** \brief Transition count.
+  *** \details Number of offset changes between Start and End.
+  **/
+  int TransitionCount;
+
+  /**
+  *** \brief Transitions.
+  *** \details Times at which the offset changes, in increasing order.
+  **/
+  time_t pTransitions[MOONDATA_ZONETRANSITIONS];
+
+  /**
+  *** \brief Offsets.
+  *** \details UTC minus local time (in seconds) from Start, then from each
+  ***   transition.
+  **/
+  long pOffsets[MOONDATA_ZONETRANSITIONS+1];
+} MOONDATAZONE_T;
+
+/**
+*** \brief Memo entry.
+*** \details One result of MoonData_Recalculate() and the inputs it was
+***   computed from.
+**/
+typedef struct structMOONDATAMEMOENTRY
+{
+  /**
+  *** \brief Inputs.
+  *** \details Inputs the entry was computed from.
+  **/
+  MOONDATAINPUTS_T Inputs;
+
+  /**
+  *** \brief Last use.
+  *** \details Memo use count at the last hit, 0 if the entry is empty.
+  **/
+  unsigned long LastUse;
+
+  /**
+  *** \brief Ephemeris.
+  *** \details Computed ephemeris.
+  **/
+  CTrans CTransData;
+
+  /**
+  *** \brief Rise/set times.
+  *** \details Yesterdays, todays and tomorrows rise and set times, in
+  ***   that order.
+  **/
+  double pRiseSet[6];
+} MOONDATAMEMOENTRY_T;
+
+/**
+*** \brief Recalculation memo.
+*** \details Keeps the last few results of MoonData_Recalculate(), so
+***   several callers asking for the same time and place in quick
+***   succession only pay for the first one. The least recently used entry
+***   is replaced on a miss.
+**/
+typedef struct structMOONDATAMEMO
+{
+  /**
+  *** \brief Time quantum.
+  *** \details Times are rounded down to a multiple of this (in seconds)
+  ***   before being computed, so all times in a quantum share an entry.
+  ***   Defaults to 1; 0 disables the memo.
+  **/
+  int Quantum;
+
+  /**
+  *** \brief Use count.
+  *** \details Number of lookups so far, used to order the entries.
+  **/
+  unsigned long UseCount;
+
+  /**
+  *** \brief Hit count.
+  *** \details Number of recalculations answered from the memo.
+  **/
+  unsigned long HitCount;
+
+  /**
+  *** \brief Miss count.
+  *** \details Number of recalculations that had to be computed.
+  **/
+  unsigned long MissCount;
+
+  /**
+  *** \brief Entries.
+  *** \details Entries.
+  **/
+  MOONDATAMEMOENTRY_T pEntries[MOONDATA_MEMOSIZE];
+} MOONDATAMEMO_T;
+
 /**
 *** \brief
 *** \details
@@ -101,6 +368,47 @@ typedef struct structMOONDATA
   *** \details The time the moon set/will set tomorrow.
   **/
   double TomorrowsSet;
+
+  /**
+  *** \brief Accuracy tier.
+  *** \details Accuracy of the moon position (EPHEMTIER_*, see calcephem.h).
+  ***   Defaults to EPHEMTIER_PRECISE; EPHEMTIER_ICON is enough for the
+  ***   phase shown in an icon.
+  **/
+  int AccuracyTier;
+
+  /**
+  *** \brief Rise/set cache.
+  *** \details Hourly samples and rise/set times of the last few days, so
+  ***   recalculating within a day costs nothing and moving to the next day
+  ***   costs one new day.
+  **/
+  RiseSetCache RiseSetCache;
+
+  /**
+  *** \brief Recalculation memo.
+  *** \details Recent results of MoonData_Recalculate().
+  **/
+  MOONDATAMEMO_T Memo;
+
+  /**
+  *** \brief Inputs.
+  *** \details Inputs of the current fields, to find which groups a new
+  ***   call has to recompute.
+  **/
+  MOONDATAINPUTS_T Inputs;
+
+  /**
+  *** \brief Work counters.
+  *** \details Work counters.
+  **/
+  MOONDATACOUNTERS_T Counters;
+
+  /**
+  *** \brief Time zone cache.
+  *** \details UTC offsets of the local time zone for the current year.
+  **/
+  MOONDATAZONE_T Zone;
 } MOONDATA_T;
 
 
@@ -132,12 +440,76 @@ STRUCTURE_PROTOTYPE_INITIALIZE(MoonData,MOONDATA_T);
 STRUCTURE_PROTOTYPE_UNINITIALIZE(MoonData,MOONDATA_T);
 float MoonData_GetMoonPhasePercent(MOONDATA_T const *pMoon);
 /**
-*** \brief
-*** \details
+*** \brief Recalculates the moon data.
+*** \details Brings the fields up to date for a time and the location and
+***   accuracy tier in pMoonData. Only the field groups whose inputs
+***   changed since the last call are recomputed.
 *** \param pMoonData Pointer to the moon data.
 *** \param UTC Current time in UTC.
 **/
 void MoonData_Recalculate(MOONDATA_T *pMoonData,time_t UTC);
+/**
+*** \brief Returns the memo counters.
+*** \details Returns how many recalculations were answered from the memo
+***   and how many had to be computed.
+*** \param pMoonData Pointer to the moon data.
+*** \param pHitCount Storage for the hit count, or NULL.
+*** \param pMissCount Storage for the miss count, or NULL.
+**/
+void MoonData_GetMemoStatistics(MOONDATA_T const *pMoonData,
+    unsigned long *pHitCount,unsigned long *pMissCount);
+/**
+*** \brief Empties the memo.
+*** \details Discards all memo entries and resets the counters. The time
+***   zone cache is discarded too, so call this after the system time zone
+***   changes.
+*** \param pMoonData Pointer to the moon data.
+**/
+void MoonData_ClearMemo(MOONDATA_T *pMoonData);
+/**
+*** \brief Returns the work counters.
+*** \details Returns how often each field group was recomputed.
+*** \param pMoonData Pointer to the moon data.
+*** \param pCounters Storage for the counters.
+**/
+void MoonData_GetCounters(MOONDATA_T const *pMoonData,
+    MOONDATACOUNTERS_T *pCounters);
+/**
+*** \brief Resets the work counters.
+*** \details Sets all work counters to 0.
+*** \param pMoonData Pointer to the moon data.
+**/
+void MoonData_ResetCounters(MOONDATA_T *pMoonData);
+/**
+*** \brief Returns the published view.
+*** \details Fills in the view of the moon data that is published in
+***   shared memory (see moonshare.h) from the last recalculation.
+*** \param pMoonData Pointer to the moon data.
+*** \param pData Storage for the view.
+**/
+void MoonData_GetShareData(MOONDATA_T const *pMoonData,
+    MOONSHAREDATA_T *pData);
+/**
+*** \brief Returns a UTC offset.
+*** \details Returns the UTC offset of the local time zone (TZ) at a time,
+***   filling the zone cache for its year if needed.
+*** \param pZone Pointer to the zone cache.
+*** \param UTC Time.
+*** \returns UTC minus local time (in seconds).
+**/
+long MoonDataZone_GetOffset(MOONDATAZONE_T *pZone,time_t UTC);
+/**
+*** \brief Returns the UTC date of a local midnight.
+*** \details Returns the UTC date at the start of a local day, as
+***   gmtime(mktime()) of that midnight would.
+*** \param pZone Pointer to the zone cache.
+*** \param DayNumber Local day (see daynumber.h).
+*** \param pYear Storage for the year.
+*** \param pMonth Storage for the month (1-12).
+*** \param pDay Storage for the day (1-31).
+**/
+void MoonDataZone_GetLocalDate(MOONDATAZONE_T *pZone,long DayNumber,
+    int *pYear,int *pMonth,int *pDay);
 
 #ifdef  __cplusplus
 }
@@ -0,0 +1,374 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file mooneclipse.c
+*** \brief mooneclipse.h implementation.
+*** \details Implementation file for mooneclipse.h.
+**/
+
+
+/** Identifier for mooneclipse.c. **/
+#define   MOONECLIPSE_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "mooneclipse.h"
+#ifdef    DEBUG_MOONECLIPSE_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_MOONECLIPSE_C */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  "calcephem.h"
+#include  "lunation.h"
+
+#include  <math.h>
+#include  <stdlib.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Degrees to radians.
+*** \details Converts degrees to radians.
+**/
+#define   RADIANS(d)            ((d)*M_PI/180.0)
+
+/**
+*** \brief Radians to degrees.
+*** \details Converts radians to degrees.
+**/
+#define   DEGREES(r)            ((r)*180.0/M_PI)
+
+/**
+*** \brief Mean synodic month.
+*** \details Mean length of a lunation (in Julian centuries).
+**/
+#define   SYNODICMONTH_CENTURIES  (LUNATION_SYNODICMONTH/36525.0)
+
+/**
+*** \brief Search window.
+*** \details A true syzygy is within this of its mean estimate (three days,
+***   in Julian centuries).
+**/
+#define   SYZYGY_WINDOW         (3.0/36525.0)
+
+/**
+*** \brief Solver tolerance.
+*** \details Convergence limit of MoonPhaseEvent() outside the lunation
+***   table (in Julian centuries, about 3 s).
+**/
+#define   SOLVER_TOLERANCE      (1e-9)
+
+/**
+*** \brief Orbit inclination.
+*** \details Mean inclination of the moon orbit to the ecliptic (in degrees).
+**/
+#define   ORBIT_INCLINATION     (5.145)
+
+/**
+*** \brief Path inclination.
+*** \details Mean inclination of the moon path relative to the sun (or the
+***   earth shadow) near a node (in degrees). The least separation is the
+***   latitude at syzygy times its cosine.
+**/
+#define   PATH_INCLINATION      (5.56)
+
+/**
+*** \brief Moon radius.
+*** \details Moon radius (in earth radii).
+**/
+#define   MOON_RADIUS           (0.272481)
+
+/**
+*** \brief Sun semidiameter.
+*** \details Sun semidiameter at 1 AU (in degrees).
+**/
+#define   SUN_SEMIDIAMETER      (959.63/3600.0)
+
+/**
+*** \brief Sun parallax.
+*** \details Sun horizontal parallax at 1 AU (in degrees).
+**/
+#define   SUN_PARALLAX          (8.794/3600.0)
+
+/**
+*** \brief Shadow enlargement.
+*** \details The earth atmosphere widens the shadow by about 2%.
+**/
+#define   SHADOW_ENLARGEMENT    (1.02)
+
+/**
+*** \brief No eclipse.
+*** \details Slot value of a syzygy without an eclipse.
+**/
+#define   TYPE_NONE             (-1)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double FindSyzygy(double Guess,int Phase);
+static void Classify(double T,int Phase,MOONECLIPSE_T *pEclipse);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Finds a syzygy.
+*** \details Returns the new or full moon nearest a mean estimate, from the
+***   lunation table if it covers it, or else from MoonPhaseEvent().
+*** \param Guess Estimate (in Julian centuries (TDT) since J2000).
+*** \param Phase LUNATIONPHASE_NEWMOON or LUNATIONPHASE_FULLMOON.
+*** \returns Time of the syzygy.
+**/
+static double FindSyzygy(double Guess,int Phase)
+{
+  double T;
+
+
+  if ( (Lunation_GetNextPhase(Guess-SYZYGY_WINDOW,Phase,&T)>0) &&
+      (T<Guess+SYZYGY_WINDOW) )
+    return(T);
+  return(MoonPhaseEvent(Guess,0.25*Phase,SOLVER_TOLERANCE));
+}
+
+/**
+*** \brief Classifies a syzygy.
+*** \details Compares the least separation of the moon from the sun (new
+***   moon) or the shadow axis (full moon) with the disc and shadow radii.
+*** \param T Time of the syzygy.
+*** \param Phase LUNATIONPHASE_NEWMOON or LUNATIONPHASE_FULLMOON.
+*** \param pEclipse Storage for the eclipse. Type is TYPE_NONE if there is
+***   none.
+**/
+static void Classify(double T,int Phase,MOONECLIPSE_T *pEclipse)
+{
+  double Lambda;
+  double Beta;
+  double Distance;
+  double Age;
+  double Anomaly;
+  double SunDistance;
+  double Separation;
+  double MoonParallax;
+  double MoonRadius;
+  double SunParallax;
+  double SunRadius;
+  double Umbra;
+  double Penumbra;
+  double Axis;
+  double Gamma;
+  double MoonRadiusNear;
+  double MoonRadiusFar;
+
+
+  Moon(T,&Lambda,&Beta,&Distance,&Age);
+  pEclipse->T=T;
+  pEclipse->Type=TYPE_NONE;
+  pEclipse->Beta=Beta;
+  pEclipse->NodeDistance=
+      sin(RADIANS(fabs(Beta)))/sin(RADIANS(ORBIT_INCLINATION));
+  pEclipse->NodeDistance=(pEclipse->NodeDistance>=1.0) ?
+      90.0 : DEGREES(asin(pEclipse->NodeDistance));
+  pEclipse->Magnitude=0.0;
+
+  /* Disc sizes (in degrees). The sun distance is from its mean anomaly. */
+  Anomaly=RADIANS(357.52911+35999.05029*T);
+  SunDistance=1.000140-0.016708*cos(Anomaly)-0.000141*cos(2.0*Anomaly);
+  MoonParallax=DEGREES(asin(1.0/Distance));
+  MoonRadius=DEGREES(asin(MOON_RADIUS/Distance));
+  SunParallax=SUN_PARALLAX/SunDistance;
+  SunRadius=SUN_SEMIDIAMETER/SunDistance;
+  Separation=fabs(Beta)*cos(RADIANS(PATH_INCLINATION));
+
+  if (Phase==LUNATIONPHASE_FULLMOON)
+  {
+    Umbra=SHADOW_ENLARGEMENT*(MoonParallax+SunParallax-SunRadius);
+    Penumbra=SHADOW_ENLARGEMENT*(MoonParallax+SunParallax+SunRadius);
+    if (Separation<Umbra+MoonRadius)
+    {
+      pEclipse->Type=(Separation<Umbra-MoonRadius) ?
+          MOONECLIPSETYPE_LUNARTOTAL : MOONECLIPSETYPE_LUNARPARTIAL;
+      pEclipse->Magnitude=(Umbra+MoonRadius-Separation)/(2.0*MoonRadius);
+    }
+    else if (Separation<Penumbra+MoonRadius)
+    {
+      pEclipse->Type=MOONECLIPSETYPE_LUNARPENUMBRAL;
+      pEclipse->Magnitude=
+          (Penumbra+MoonRadius-Separation)/(2.0*MoonRadius);
+    }
+  }
+  else
+  {
+    /* The shadow axis passes Gamma earth radii from the earth center. */
+    Axis=MoonParallax-SunParallax;
+    Gamma=Separation/Axis;
+    if (Separation<Axis)
+    {
+      /* Central; the moon looks largest where the axis meets the earth. */
+      MoonRadiusNear=DEGREES(asin(MOON_RADIUS/
+          (Distance-sqrt(1.0-Gamma*Gamma))));
+      MoonRadiusFar=MoonRadius;
+      if (MoonRadiusFar>=SunRadius)
+        pEclipse->Type=MOONECLIPSETYPE_SOLARTOTAL;
+      else if (MoonRadiusNear>SunRadius)
+        pEclipse->Type=MOONECLIPSETYPE_SOLARHYBRID;
+      else
+        pEclipse->Type=MOONECLIPSETYPE_SOLARANNULAR;
+      pEclipse->Magnitude=MoonRadiusNear/SunRadius;
+    }
+    else if (Separation<Axis+fabs(MoonRadius-SunRadius))
+    {
+      /* Non-central; the edge of the shadow cone still reaches the earth. */
+      pEclipse->Type=(MoonRadius>=SunRadius) ?
+          MOONECLIPSETYPE_SOLARTOTAL : MOONECLIPSETYPE_SOLARANNULAR;
+      pEclipse->Magnitude=MoonRadius/SunRadius;
+    }
+    else if (Separation<Axis+MoonRadius+SunRadius)
+    {
+      /* Seen from the point of the earth nearest the axis. */
+      pEclipse->Type=MOONECLIPSETYPE_SOLARPARTIAL;
+      pEclipse->Magnitude=
+          (MoonRadius+SunRadius-(Separation-Axis))/(2.0*SunRadius);
+    }
+  }
+
+  return;
+}
+
+ERRORCODE_T MoonEclipse_Find(double First,double Last,
+    MOONECLIPSE_T **ppEclipses,long *pCount)
+{
+  ERRORCODE_T ErrorCode;
+  MOONECLIPSE_T *pSlots;
+  MOONECLIPSE_T *pEclipses;
+  double Lambda;
+  double Beta;
+  double Distance;
+  double Age;
+  double NewMoon;
+  double T;
+  long Count;
+  long Index;
+  int LunationCount;
+  int Lunation;
+
+
+  DEBUGLOG_Printf4("MoonEclipse_Find(%f,%f,%p,%p)",
+      First,Last,ppEclipses,pCount);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (ppEclipses==NULL) || (pCount==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if (Last<First)
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    *ppEclipses=NULL;
+    *pCount=0;
+
+    /* Mean new moon before the range, then one slot per syzygy. */
+    Moon(First,&Lambda,&Beta,&Distance,&Age);
+    NewMoon=First-Age/36525.0;
+    LunationCount=(int)((Last-NewMoon)/SYNODICMONTH_CENTURIES)+2;
+    pSlots=(MOONECLIPSE_T *)malloc(2*LunationCount*sizeof(*pSlots));
+    if (pSlots==NULL)
+      ErrorCode=ERRORCODE_OUTOFMEMORY;
+    else
+    {
+      /* Lunations are independent, so they can be shared out freely. */
+#ifdef    _OPENMP
+#pragma omp parallel for schedule(dynamic,64) private(T)
+#endif    /* _OPENMP */
+      for(Lunation=0;Lunation<LunationCount;Lunation++)
+      {
+        T=FindSyzygy(NewMoon+Lunation*SYNODICMONTH_CENTURIES,
+            LUNATIONPHASE_NEWMOON);
+        Classify(T,LUNATIONPHASE_NEWMOON,&pSlots[2*Lunation]);
+        T=FindSyzygy(NewMoon+(Lunation+0.5)*SYNODICMONTH_CENTURIES,
+            LUNATIONPHASE_FULLMOON);
+        Classify(T,LUNATIONPHASE_FULLMOON,&pSlots[2*Lunation+1]);
+      }
+
+      /* The slots are in time order; keep the eclipses in the range. */
+      Count=0;
+      for(Index=0;Index<2*LunationCount;Index++)
+        if ( (pSlots[Index].Type!=TYPE_NONE) &&
+            (pSlots[Index].T>=First) && (pSlots[Index].T<Last) )
+          pSlots[Count++]=pSlots[Index];
+
+      ErrorCode=ERRORCODE_SUCCESS;
+      if (Count==0)
+        free(pSlots);
+      else
+      {
+        pEclipses=(MOONECLIPSE_T *)realloc(pSlots,Count*sizeof(*pSlots));
+        *ppEclipses=(pEclipses==NULL) ? pSlots : pEclipses;
+        *pCount=Count;
+      }
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+
+#undef    MOONECLIPSE_C
@@ -0,0 +1,187 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file mooneclipse.h
+*** \brief Eclipse candidates.
+*** \details Screens every new and full moon in a time range for a solar or
+***   lunar eclipse. Only the syzygies are visited (from the lunation table
+***   where it reaches); the moon latitude there against the shadow and disc
+***   sizes gives the eclipse type. The geometry is geocentric and the
+***   shadow sizes use mean values where they change little, so the types
+***   of borderline eclipses may differ from a full computation.
+**/
+
+
+#ifndef   MOONECLIPSE_H
+#define   MOONECLIPSE_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "errorcode.h"
+#include  "sysdefs.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Eclipse types.
+*** \details Eclipse types.
+**/
+typedef enum enumMOONECLIPSETYPE
+{
+  /**
+  *** \brief Partial solar eclipse.
+  *** \details The moon shadow axis misses the earth.
+  **/
+  MOONECLIPSETYPE_SOLARPARTIAL=0,
+  /**
+  *** \brief Annular solar eclipse.
+  *** \details Central, the moon is too small to cover the sun.
+  **/
+  MOONECLIPSETYPE_SOLARANNULAR,
+  /**
+  *** \brief Hybrid solar eclipse.
+  *** \details Central, annular or total depending on where it is seen.
+  **/
+  MOONECLIPSETYPE_SOLARHYBRID,
+  /**
+  *** \brief Total solar eclipse.
+  *** \details Central, the moon covers the sun.
+  **/
+  MOONECLIPSETYPE_SOLARTOTAL,
+  /**
+  *** \brief Penumbral lunar eclipse.
+  *** \details The moon only enters the penumbra.
+  **/
+  MOONECLIPSETYPE_LUNARPENUMBRAL,
+  /**
+  *** \brief Partial lunar eclipse.
+  *** \details The moon partly enters the umbra.
+  **/
+  MOONECLIPSETYPE_LUNARPARTIAL,
+  /**
+  *** \brief Total lunar eclipse.
+  *** \details The moon is wholly inside the umbra.
+  **/
+  MOONECLIPSETYPE_LUNARTOTAL,
+  /**
+  *** \brief Type count.
+  *** \details Number of eclipse types.
+  **/
+  MOONECLIPSETYPE_COUNT
+} MOONECLIPSETYPE_E;
+
+/**
+*** \brief Eclipse candidate.
+*** \details One eclipse found by MoonEclipse_Find().
+**/
+typedef struct structMOONECLIPSE
+{
+  /**
+  *** \brief Time.
+  *** \details Time of the syzygy (in Julian centuries (TDT) since J2000).
+  **/
+  double T;
+  /**
+  *** \brief Type.
+  *** \details Eclipse type (MOONECLIPSETYPE_E).
+  **/
+  int Type;
+  /**
+  *** \brief Latitude.
+  *** \details Ecliptic latitude of the moon at the syzygy (in degrees).
+  **/
+  double Beta;
+  /**
+  *** \brief Node distance.
+  *** \details Angle from the moon to the nearest node along its orbit (in
+  ***   degrees).
+  **/
+  double NodeDistance;
+  /**
+  *** \brief Magnitude.
+  *** \details Fraction of the moon diameter inside the umbra (penumbra for
+  ***   penumbral eclipses), or of the sun diameter covered by the moon,
+  ***   at greatest eclipse.
+  **/
+  double Magnitude;
+} MOONECLIPSE_T;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+*** \brief Finds eclipse candidates.
+*** \details Returns the eclipses from First (included) to Last (excluded),
+***   sorted by time.
+*** \param First Start of the range (in Julian centuries (TDT) since J2000).
+*** \param Last End of the range (in Julian centuries (TDT) since J2000).
+*** \param ppEclipses Storage for a pointer to the eclipses. The caller must
+***   free() it. Set to NULL if there are none.
+*** \param pCount Storage for the number of eclipses.
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T MoonEclipse_Find(double First,double Last,
+    MOONECLIPSE_T **ppEclipses,long *pCount);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* MOONECLIPSE_H */
@@ -0,0 +1,656 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moonevent.c
+*** \brief moonevent.h implementation.
+*** \details Implementation file for moonevent.h.
+**/
+
+
+/** Identifier for moonevent.c. **/
+#define   MOONEVENT_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moonevent.h"
+#ifdef    DEBUG_MOONEVENT_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_MOONEVENT_C */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  "calcephem.h"
+#include  "lunation.h"
+
+#include  <math.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Degrees to radians.
+*** \details Converts degrees to radians.
+**/
+#define   RADIANS(d)        ((d)*M_PI/180.0)
+
+/**
+*** \brief Radians to degrees.
+*** \details Converts radians to degrees.
+**/
+#define   DEGREES(r)        ((r)*180.0/M_PI)
+
+/**
+*** \brief Scan step.
+*** \details Time between scan samples (one day, in Julian centuries).
+***   Events of one type are at least about a week apart, so no two fall
+***   between neighbouring samples.
+**/
+#define   SCAN_STEP         (1.0/36525.0)
+
+/**
+*** \brief Chunk size.
+*** \details Number of scan steps per unit of work (about a year).
+**/
+#define   CHUNK_STEPS       (366)
+
+/**
+*** \brief Solver tolerance.
+*** \details Convergence limit of the refinement (in Julian centuries,
+***   about 3 s).
+**/
+#define   SOLVER_TOLERANCE  (1e-9)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Quantities.
+*** \details Quantities searched for roots or extremes.
+**/
+typedef enum enumQUANTITY
+{
+  /**
+  *** \brief Latitude.
+  *** \details Ecliptic latitude (in degrees).
+  **/
+  QUANTITY_BETA=0,
+  /**
+  *** \brief Distance.
+  *** \details Earth-moon distance (in earth radii).
+  **/
+  QUANTITY_DISTANCE,
+  /**
+  *** \brief Declination.
+  *** \details Sine of the declination.
+  **/
+  QUANTITY_SINDECLINATION
+} QUANTITY_E;
+
+/**
+*** \brief Scan sample.
+*** \details The moon at one scan step.
+**/
+typedef struct structSAMPLE
+{
+  /**
+  *** \brief Time.
+  *** \details Time (in Julian centuries (TDT) since J2000).
+  **/
+  double T;
+  /**
+  *** \brief Phase.
+  *** \details Phase as returned by Moon() (0-1).
+  **/
+  double Phase;
+  /**
+  *** \brief Longitude.
+  *** \details Ecliptic longitude (in degrees).
+  **/
+  double Lambda;
+  /**
+  *** \brief Latitude, distance and declination.
+  *** \details Indexed by QUANTITY_E.
+  **/
+  double pQuantities[3];
+} SAMPLE_T;
+
+/**
+*** \brief Chunk.
+*** \details One unit of work and the events found in it.
+**/
+typedef struct structCHUNK
+{
+  /**
+  *** \brief First step.
+  *** \details Index of the first scan step of the chunk.
+  **/
+  long FirstStep;
+  /**
+  *** \brief Range start.
+  *** \details Events before this belong to another chunk.
+  **/
+  double First;
+  /**
+  *** \brief Range end.
+  *** \details Events at or after this belong to another chunk.
+  **/
+  double Last;
+  /**
+  *** \brief Events.
+  *** \details Events found, sorted by time once the chunk is done.
+  **/
+  MOONEVENT_T *pEvents;
+  /**
+  *** \brief Event count.
+  *** \details Number of events found.
+  **/
+  long Count;
+  /**
+  *** \brief Allocated count.
+  *** \details Number of events pEvents has room for.
+  **/
+  long Allocated;
+  /**
+  *** \brief Error code.
+  *** \details Result of the search.
+  **/
+  ERRORCODE_T ErrorCode;
+} CHUNK_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static void Evaluate(double T,SAMPLE_T *pSample);
+static void FindRoot(int Quantity,SAMPLE_T const *pBefore,
+    SAMPLE_T const *pAfter,SAMPLE_T *pSample);
+static void FindExtreme(int Quantity,double Sign,SAMPLE_T const *pSamples,
+    SAMPLE_T *pSample);
+static void AddEvent(CHUNK_T *pChunk,double T,int Type,double Value);
+static void SearchChunk(CHUNK_T *pChunk,double Origin,long StepCount,
+    int Mask);
+static int CompareEvents(void const *pA,void const *pB);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Evaluates the moon.
+*** \details Fills a sample from Moon().
+*** \param T Time (in Julian centuries (TDT) since J2000).
+*** \param pSample Storage for the sample.
+**/
+static void Evaluate(double T,SAMPLE_T *pSample)
+{
+  double Beta;
+  double Age;
+  double Epsilon;
+
+
+  pSample->Phase=Moon(T,&pSample->Lambda,&Beta,
+      &pSample->pQuantities[QUANTITY_DISTANCE],&Age);
+  pSample->T=T;
+  pSample->pQuantities[QUANTITY_BETA]=Beta;
+
+  /* Mean obliquity, as in CalcEphem(). */
+  Epsilon=RADIANS(23.43929167-0.013004166*T-1.6666667e-7*T*T-
+      5.0277777778e-7*T*T*T);
+  pSample->pQuantities[QUANTITY_SINDECLINATION]=
+      sin(RADIANS(Beta))*cos(Epsilon)+
+      cos(RADIANS(Beta))*sin(Epsilon)*sin(RADIANS(pSample->Lambda));
+
+  return;
+}
+
+/**
+*** \brief Finds a root.
+*** \details Finds the zero of a quantity between two samples of opposite
+***   sign by false position (Illinois variant). Takes about five
+***   evaluations from a one day bracket.
+*** \param Quantity Quantity (QUANTITY_E).
+*** \param pBefore Sample before the root.
+*** \param pAfter Sample after the root.
+*** \param pSample Storage for the sample at the root.
+**/
+static void FindRoot(int Quantity,SAMPLE_T const *pBefore,
+    SAMPLE_T const *pAfter,SAMPLE_T *pSample)
+{
+  double A,FA;
+  double B,FB;
+  double T;
+  int Side;
+
+
+  A=pBefore->T;
+  FA=pBefore->pQuantities[Quantity];
+  B=pAfter->T;
+  FB=pAfter->pQuantities[Quantity];
+  *pSample=*pBefore;
+  Side=0;
+  while(B-A>SOLVER_TOLERANCE)
+  {
+    T=(A*FB-B*FA)/(FB-FA);
+    Evaluate(T,pSample);
+    if (pSample->pQuantities[Quantity]==0.0)
+      break;
+    if ((pSample->pQuantities[Quantity]<0.0)==(FA<0.0))
+    {
+      /* Converged from this side. */
+      if (T-A<0.5*SOLVER_TOLERANCE)
+        break;
+      A=T;
+      FA=pSample->pQuantities[Quantity];
+      if (Side==-1)
+        FB*=0.5;
+      Side=-1;
+    }
+    else
+    {
+      if (B-T<0.5*SOLVER_TOLERANCE)
+        break;
+      B=T;
+      FB=pSample->pQuantities[Quantity];
+      if (Side==1)
+        FA*=0.5;
+      Side=1;
+    }
+  }
+
+  return;
+}
+
+/**
+*** \brief Finds an extreme.
+*** \details Finds the maximum of Sign times a quantity inside three scan
+***   samples whose middle one is the largest, by successive parabolic
+***   interpolation. The triple always brackets the extreme; when the
+***   parabola lands too close to the best point, a golden section step
+***   into the larger side is taken instead.
+*** \param Quantity Quantity (QUANTITY_E).
+*** \param Sign 1 for a maximum, -1 for a minimum.
+*** \param pSamples The three samples.
+*** \param pSample Storage for the sample at the extreme.
+**/
+static void FindExtreme(int Quantity,double Sign,SAMPLE_T const *pSamples,
+    SAMPLE_T *pSample)
+{
+  SAMPLE_T Sample;
+  double A,FA;
+  double B,FB;
+  double C,FC;
+  double U,FU;
+  double P,Q;
+  int Iteration;
+
+
+  A=pSamples[0].T;
+  FA=Sign*pSamples[0].pQuantities[Quantity];
+  B=pSamples[1].T;
+  FB=Sign*pSamples[1].pQuantities[Quantity];
+  C=pSamples[2].T;
+  FC=Sign*pSamples[2].pQuantities[Quantity];
+  *pSample=pSamples[1];
+  for(Iteration=0;(Iteration<50)&&(C-A>2.0*SOLVER_TOLERANCE);Iteration++)
+  {
+    /* Vertex of the parabola through the triple. */
+    P=(B-A)*(B-A)*(FB-FC)-(B-C)*(B-C)*(FB-FA);
+    Q=(B-A)*(FB-FC)-(B-C)*(FB-FA);
+    U=(Q!=0.0) ? B-0.5*P/Q : B;
+    if ( (U<=A) || (U>=C) )
+      U=B;
+    if (fabs(U-B)<0.5*SOLVER_TOLERANCE)
+    {
+      /* Converged, unless the bracket is still wide. */
+      if (C-A<4.0*SOLVER_TOLERANCE)
+        break;
+      U=(C-B>B-A) ? B+SOLVER_TOLERANCE : B-SOLVER_TOLERANCE;
+    }
+    Evaluate(U,&Sample);
+    FU=Sign*Sample.pQuantities[Quantity];
+
+    /* Keep the best point in the middle. */
+    if (FU>=FB)
+    {
+      if (U<B)
+      {
+        C=B;
+        FC=FB;
+      }
+      else
+      {
+        A=B;
+        FA=FB;
+      }
+      B=U;
+      FB=FU;
+      *pSample=Sample;
+    }
+    else if (U<B)
+    {
+      A=U;
+      FA=FU;
+    }
+    else
+    {
+      C=U;
+      FC=FU;
+    }
+  }
+
+  return;
+}
+
+/**
+*** \brief Adds an event.
+*** \details Appends an event to a chunk if it is inside the chunk range.
+*** \param pChunk Chunk.
+*** \param T Time (in Julian centuries (TDT) since J2000).
+*** \param Type Event type (MOONEVENTTYPE_E).
+*** \param Value Event value.
+**/
+static void AddEvent(CHUNK_T *pChunk,double T,int Type,double Value)
+{
+  MOONEVENT_T *pEvents;
+  long Allocated;
+
+
+  if ( (pChunk->ErrorCode<0) || (T<pChunk->First) || (T>=pChunk->Last) )
+    return;
+
+  if (pChunk->Count==pChunk->Allocated)
+  {
+    Allocated=(pChunk->Allocated==0) ? 128 : 2*pChunk->Allocated;
+    pEvents=(MOONEVENT_T *)realloc(pChunk->pEvents,
+        Allocated*sizeof(*pEvents));
+    if (pEvents==NULL)
+    {
+      pChunk->ErrorCode=ERRORCODE_OUTOFMEMORY;
+      return;
+    }
+    pChunk->pEvents=pEvents;
+    pChunk->Allocated=Allocated;
+  }
+  pChunk->pEvents[pChunk->Count].T=T;
+  pChunk->pEvents[pChunk->Count].Type=Type;
+  pChunk->pEvents[pChunk->Count].Value=Value;
+  pChunk->Count++;
+
+  return;
+}
+
+/**
+*** \brief Searches one chunk.
+*** \details Scans the chunk (plus a step either side, so extremes at the
+***   edges are bracketed) and refines every event found. All chunks scan
+***   the same steps, so an event near a chunk edge is found the same way
+***   by both chunks and kept by one.
+*** \param pChunk Chunk.
+*** \param Origin Time of scan step 0.
+*** \param StepCount Number of scan steps in the chunk.
+*** \param Mask Event types wanted.
+**/
+static void SearchChunk(CHUNK_T *pChunk,double Origin,long StepCount,
+    int Mask)
+{
+  SAMPLE_T pSamples[3];
+  SAMPLE_T Sample;
+  double T;
+  double Sign;
+  long Step;
+  int Quarter;
+  int Previous;
+  int Quantity;
+  int Type;
+
+
+  /* pSamples[0..2] are the steps before, at and after Step. */
+  Step=pChunk->FirstStep-1;
+  Evaluate(Origin+(Step-1)*SCAN_STEP,&pSamples[1]);
+  Evaluate(Origin+Step*SCAN_STEP,&pSamples[2]);
+  for(;Step<=pChunk->FirstStep+StepCount;Step++)
+  {
+    pSamples[0]=pSamples[1];
+    pSamples[1]=pSamples[2];
+    Evaluate(Origin+(Step+1)*SCAN_STEP,&pSamples[2]);
+
+    /* Quarter crossings, from the lunation table where it reaches. */
+    if ((Mask&(MOONEVENT_MASK(MOONEVENTTYPE_NEWMOON)|
+        MOONEVENT_MASK(MOONEVENTTYPE_FIRSTQUARTER)|
+        MOONEVENT_MASK(MOONEVENTTYPE_FULLMOON)|
+        MOONEVENT_MASK(MOONEVENTTYPE_LASTQUARTER)))!=0)
+    {
+      Previous=(int)floor(4.0*pSamples[1].Phase)&3;
+      Quarter=(int)floor(4.0*pSamples[2].Phase)&3;
+      if ( (Quarter!=Previous) && ((Mask&MOONEVENT_MASK(Quarter))!=0) )
+      {
+        if ( (Lunation_GetNextPhase(pSamples[1].T-SCAN_STEP,Quarter,&T)<0) ||
+            (T>pSamples[2].T+SCAN_STEP) )
+          T=MoonPhaseEvent(0.5*(pSamples[1].T+pSamples[2].T),0.25*Quarter,
+              SOLVER_TOLERANCE);
+        AddEvent(pChunk,T,Quarter,0.25*Quarter);
+      }
+    }
+
+    /* Nodes. */
+    if ( ((pSamples[1].pQuantities[QUANTITY_BETA]<0.0)!=
+        (pSamples[2].pQuantities[QUANTITY_BETA]<0.0)) &&
+        ((Mask&(MOONEVENT_MASK(MOONEVENTTYPE_ASCENDINGNODE)|
+        MOONEVENT_MASK(MOONEVENTTYPE_DESCENDINGNODE)))!=0) )
+    {
+      Type=(pSamples[1].pQuantities[QUANTITY_BETA]<0.0) ?
+          MOONEVENTTYPE_ASCENDINGNODE : MOONEVENTTYPE_DESCENDINGNODE;
+      if ((Mask&MOONEVENT_MASK(Type))!=0)
+      {
+        FindRoot(QUANTITY_BETA,&pSamples[1],&pSamples[2],&Sample);
+        AddEvent(pChunk,Sample.T,Type,Sample.Lambda);
+      }
+    }
+
+    /* Apsides and declination extremes. */
+    for(Quantity=QUANTITY_DISTANCE;Quantity<=QUANTITY_SINDECLINATION;
+        Quantity++)
+    {
+      if ( (pSamples[1].pQuantities[Quantity]>
+          pSamples[0].pQuantities[Quantity]) &&
+          (pSamples[1].pQuantities[Quantity]>=
+          pSamples[2].pQuantities[Quantity]) )
+        Sign=1.0;
+      else if ( (pSamples[1].pQuantities[Quantity]<
+          pSamples[0].pQuantities[Quantity]) &&
+          (pSamples[1].pQuantities[Quantity]<=
+          pSamples[2].pQuantities[Quantity]) )
+        Sign=-1.0;
+      else
+        continue;
+
+      if (Quantity==QUANTITY_DISTANCE)
+        Type=(Sign>0.0) ? MOONEVENTTYPE_APOGEE : MOONEVENTTYPE_PERIGEE;
+      else
+        Type=(Sign>0.0) ?
+            MOONEVENTTYPE_NORTHDECLINATION : MOONEVENTTYPE_SOUTHDECLINATION;
+      if ((Mask&MOONEVENT_MASK(Type))==0)
+        continue;
+
+      FindExtreme(Quantity,Sign,pSamples,&Sample);
+      if (Quantity==QUANTITY_DISTANCE)
+        AddEvent(pChunk,Sample.T,Type,Sample.pQuantities[QUANTITY_DISTANCE]);
+      else
+        AddEvent(pChunk,Sample.T,Type,
+            DEGREES(asin(Sample.pQuantities[QUANTITY_SINDECLINATION])));
+    }
+  }
+
+  if ( (pChunk->ErrorCode>0) && (pChunk->Count>1) )
+    qsort(pChunk->pEvents,pChunk->Count,sizeof(*pChunk->pEvents),
+        CompareEvents);
+
+  return;
+}
+
+/**
+*** \brief Compares events.
+*** \details qsort() comparison by time, then type.
+*** \param pA First event.
+*** \param pB Second event.
+*** \returns <0, 0 or >0 as A is before, with or after B.
+**/
+static int CompareEvents(void const *pA,void const *pB)
+{
+  MOONEVENT_T const *pEventA;
+  MOONEVENT_T const *pEventB;
+
+
+  pEventA=(MOONEVENT_T const *)pA;
+  pEventB=(MOONEVENT_T const *)pB;
+  if (pEventA->T<pEventB->T)
+    return(-1);
+  if (pEventA->T>pEventB->T)
+    return(1);
+  return(pEventA->Type-pEventB->Type);
+}
+
+ERRORCODE_T MoonEvent_Find(double First,double Last,int Mask,
+    MOONEVENT_T **ppEvents,long *pCount)
+{
+  ERRORCODE_T ErrorCode;
+  CHUNK_T *pChunks;
+  MOONEVENT_T *pEvents;
+  long StepCount;
+  long Count;
+  int ChunkCount;
+  int Chunk;
+
+
+  DEBUGLOG_Printf5("MoonEvent_Find(%f,%f,%d,%p,%p)",
+      First,Last,Mask,ppEvents,pCount);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (ppEvents==NULL) || (pCount==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (Last<First) || ((Mask&~MOONEVENT_ALL)!=0) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    *ppEvents=NULL;
+    *pCount=0;
+
+    StepCount=(long)ceil((Last-First)/SCAN_STEP);
+    ChunkCount=(int)((StepCount+CHUNK_STEPS-1)/CHUNK_STEPS);
+    pChunks=(CHUNK_T *)calloc(ChunkCount+1,sizeof(*pChunks));
+    if (pChunks==NULL)
+      ErrorCode=ERRORCODE_OUTOFMEMORY;
+    else
+    {
+      for(Chunk=0;Chunk<ChunkCount;Chunk++)
+      {
+        pChunks[Chunk].FirstStep=(long)Chunk*CHUNK_STEPS;
+        pChunks[Chunk].First=First+pChunks[Chunk].FirstStep*SCAN_STEP;
+        pChunks[Chunk].Last=(Chunk==ChunkCount-1) ?
+            Last : pChunks[Chunk].First+CHUNK_STEPS*SCAN_STEP;
+        pChunks[Chunk].ErrorCode=ERRORCODE_SUCCESS;
+      }
+
+      /* Chunks are independent, so they can be shared out freely. */
+#ifdef    _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif    /* _OPENMP */
+      for(Chunk=0;Chunk<ChunkCount;Chunk++)
+        SearchChunk(&pChunks[Chunk],First,
+            (Chunk==ChunkCount-1) ?
+            StepCount-pChunks[Chunk].FirstStep : CHUNK_STEPS,Mask);
+
+      /* Chunks are in time order, so joining them keeps the events sorted. */
+      ErrorCode=ERRORCODE_SUCCESS;
+      Count=0;
+      for(Chunk=0;Chunk<ChunkCount;Chunk++)
+      {
+        if (pChunks[Chunk].ErrorCode<0)
+          ErrorCode=pChunks[Chunk].ErrorCode;
+        Count+=pChunks[Chunk].Count;
+      }
+      if ( (ErrorCode>0) && (Count>0) )
+      {
+        pEvents=(MOONEVENT_T *)malloc(Count*sizeof(*pEvents));
+        if (pEvents==NULL)
+          ErrorCode=ERRORCODE_OUTOFMEMORY;
+        else
+        {
+          Count=0;
+          for(Chunk=0;Chunk<ChunkCount;Chunk++)
+          {
+            memcpy(pEvents+Count,pChunks[Chunk].pEvents,
+                pChunks[Chunk].Count*sizeof(*pEvents));
+            Count+=pChunks[Chunk].Count;
+          }
+          *ppEvents=pEvents;
+          *pCount=Count;
+        }
+      }
+
+      for(Chunk=0;Chunk<ChunkCount;Chunk++)
+        free(pChunks[Chunk].pEvents);
+      free(pChunks);
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+
+#undef    MOONEVENT_C
@@ -0,0 +1,203 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moonevent.h
+*** \brief Lunar event search.
+*** \details Finds the phases, apsides, nodes and declination extremes of
+***   the moon in a time range. Events are bracketed by a daily scan of the
+***   lunar theory and refined by root finding (phases come from the
+***   lunation table where it reaches); the range is cut into yearly chunks
+***   which are searched in parallel when built with OpenMP.
+**/
+
+
+#ifndef   MOONEVENT_H
+#define   MOONEVENT_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "errorcode.h"
+#include  "sysdefs.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Event mask.
+*** \details Mask bit of an event type (MOONEVENTTYPE_E).
+**/
+#define   MOONEVENT_MASK(t)     (1<<(t))
+
+/**
+*** \brief All events.
+*** \details Mask of all event types.
+**/
+#define   MOONEVENT_ALL         (MOONEVENT_MASK(MOONEVENTTYPE_COUNT)-1)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Event types.
+*** \details Event types.
+**/
+typedef enum enumMOONEVENTTYPE
+{
+  /**
+  *** \brief New moon.
+  *** \details New moon.
+  **/
+  MOONEVENTTYPE_NEWMOON=0,
+  /**
+  *** \brief First quarter.
+  *** \details First quarter.
+  **/
+  MOONEVENTTYPE_FIRSTQUARTER,
+  /**
+  *** \brief Full moon.
+  *** \details Full moon.
+  **/
+  MOONEVENTTYPE_FULLMOON,
+  /**
+  *** \brief Last quarter.
+  *** \details Last quarter.
+  **/
+  MOONEVENTTYPE_LASTQUARTER,
+  /**
+  *** \brief Perigee.
+  *** \details Minimum earth-moon distance.
+  **/
+  MOONEVENTTYPE_PERIGEE,
+  /**
+  *** \brief Apogee.
+  *** \details Maximum earth-moon distance.
+  **/
+  MOONEVENTTYPE_APOGEE,
+  /**
+  *** \brief Ascending node.
+  *** \details Moon crosses the ecliptic northwards.
+  **/
+  MOONEVENTTYPE_ASCENDINGNODE,
+  /**
+  *** \brief Descending node.
+  *** \details Moon crosses the ecliptic southwards.
+  **/
+  MOONEVENTTYPE_DESCENDINGNODE,
+  /**
+  *** \brief Northern declination extreme.
+  *** \details Maximum declination.
+  **/
+  MOONEVENTTYPE_NORTHDECLINATION,
+  /**
+  *** \brief Southern declination extreme.
+  *** \details Minimum declination.
+  **/
+  MOONEVENTTYPE_SOUTHDECLINATION,
+  /**
+  *** \brief Type count.
+  *** \details Number of event types.
+  **/
+  MOONEVENTTYPE_COUNT
+} MOONEVENTTYPE_E;
+
+/**
+*** \brief Event.
+*** \details One event found by MoonEvent_Find().
+**/
+typedef struct structMOONEVENT
+{
+  /**
+  *** \brief Time.
+  *** \details Time of the event (in Julian centuries (TDT) since J2000).
+  **/
+  double T;
+  /**
+  *** \brief Type.
+  *** \details Event type (MOONEVENTTYPE_E).
+  **/
+  int Type;
+  /**
+  *** \brief Value.
+  *** \details Distance for apsides (in earth radii), ecliptic longitude
+  ***   for nodes and declination for declination extremes (in degrees),
+  ***   phase (0-1) for phases.
+  **/
+  double Value;
+} MOONEVENT_T;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+*** \brief Finds events.
+*** \details Returns the events of the requested types from First (included)
+***   to Last (excluded), sorted by time.
+*** \param First Start of the range (in Julian centuries (TDT) since J2000).
+*** \param Last End of the range (in Julian centuries (TDT) since J2000).
+*** \param Mask Event types wanted (MOONEVENT_MASK() bits or MOONEVENT_ALL).
+*** \param ppEvents Storage for a pointer to the events. The caller must
+***   free() it. Set to NULL if there are no events.
+*** \param pCount Storage for the number of events.
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T MoonEvent_Find(double First,double Last,int Mask,
+    MOONEVENT_T **ppEvents,long *pCount);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* MOONEVENT_H */
@@ -0,0 +1,267 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moongrid.c
+*** \brief moongrid.h implementation.
+*** \details Implementation file for moongrid.h.
+**/
+
+
+/** Identifier for moongrid.c. **/
+#define   MOONGRID_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moongrid.h"
+#ifdef    DEBUG_MOONGRID_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_MOONGRID_C */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  "calcephem.h"
+
+#include  <math.h>
+#include  <stdlib.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Degrees to radians.
+*** \details Converts degrees to radians.
+**/
+#define   RADIANS(d)      ((d)*M_PI/180.0)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Moon track.
+*** \details The observer independent part of a day, shared by all tiles.
+**/
+typedef struct structTRACK
+{
+  /**
+  *** \brief Moon direction.
+  *** \details Unit vector of the moon at each sample (from MoonTrack()).
+  **/
+  double pDirection[RISESET_SAMPLES][3];
+  /**
+  *** \brief Sidereal angle cosine.
+  *** \details Cosine of the Greenwich sidereal angle at each sample.
+  **/
+  double pCosTheta[RISESET_SAMPLES];
+  /**
+  *** \brief Sidereal angle sine.
+  *** \details Sine of the Greenwich sidereal angle at each sample.
+  **/
+  double pSinTheta[RISESET_SAMPLES];
+  /**
+  *** \brief Horizon.
+  *** \details Sine of the rise/set altitude (8 arc minutes).
+  **/
+  double SinH0;
+} TRACK_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static void CalculateTile(MOONGRID_T const *pGrid,TRACK_T const *pTrack,
+    double const *pSinLatitude,double const *pCosLatitude,int Tile,
+    float *pRise,float *pSet);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Computes one tile.
+*** \details Reduces the track to one horizontal term per sample for each
+***   column of the tile, then scans every row of those columns. A cell
+***   costs two multiply-adds per sample plus the scan.
+*** \param pGrid Grid description.
+*** \param pTrack Moon track of the day.
+*** \param pSinLatitude Sine of the latitude of each row.
+*** \param pCosLatitude Cosine of the latitude of each row.
+*** \param Tile Tile index.
+*** \param pRise Rise time raster, or NULL.
+*** \param pSet Set time raster, or NULL.
+**/
+static void CalculateTile(MOONGRID_T const *pGrid,TRACK_T const *pTrack,
+    double const *pSinLatitude,double const *pCosLatitude,int Tile,
+    float *pRise,float *pSet)
+{
+  double pHorizontal[MOONGRID_TILECOLUMNS][RISESET_SAMPLES];
+  double pSamples[RISESET_SAMPLES];
+  double CosLongitude;
+  double SinLongitude;
+  double Rise;
+  double Set;
+  int FirstColumn;
+  int ColumnCount;
+  int Column;
+  int Row;
+  int Sample;
+  long Index;
+
+
+  FirstColumn=Tile*MOONGRID_TILECOLUMNS;
+  ColumnCount=pGrid->LongitudeCount-FirstColumn;
+  if (ColumnCount>MOONGRID_TILECOLUMNS)
+    ColumnCount=MOONGRID_TILECOLUMNS;
+
+  /* v[0]*cos(theta-lambda)+v[1]*sin(theta-lambda) for each column. */
+  for(Column=0;Column<ColumnCount;Column++)
+  {
+    CosLongitude=cos(RADIANS(
+        pGrid->Longitude+(FirstColumn+Column)*pGrid->LongitudeStep));
+    SinLongitude=sin(RADIANS(
+        pGrid->Longitude+(FirstColumn+Column)*pGrid->LongitudeStep));
+    for(Sample=0;Sample<RISESET_SAMPLES;Sample++)
+      pHorizontal[Column][Sample]=
+          pTrack->pDirection[Sample][0]*(pTrack->pCosTheta[Sample]*CosLongitude+
+          pTrack->pSinTheta[Sample]*SinLongitude)+
+          pTrack->pDirection[Sample][1]*(pTrack->pSinTheta[Sample]*CosLongitude-
+          pTrack->pCosTheta[Sample]*SinLongitude);
+  }
+
+  for(Row=0;Row<pGrid->LatitudeCount;Row++)
+    for(Column=0;Column<ColumnCount;Column++)
+    {
+      for(Sample=0;Sample<RISESET_SAMPLES;Sample++)
+        pSamples[Sample]=pSinLatitude[Row]*pTrack->pDirection[Sample][2]+
+            pCosLatitude[Row]*pHorizontal[Column][Sample]-pTrack->SinH0;
+      RiseSetScan(pSamples,0.0,&Rise,&Set);
+
+      Index=(long)Row*pGrid->LongitudeCount+FirstColumn+Column;
+      if (pRise!=NULL)
+        pRise[Index]=(Rise<0.0) ? MOONGRID_NOEVENT : (float)Rise;
+      if (pSet!=NULL)
+        pSet[Index]=(Set<0.0) ? MOONGRID_NOEVENT : (float)Set;
+    }
+
+  return;
+}
+
+ERRORCODE_T MoonGrid_Calculate(MOONGRID_T const *pGrid,
+    int Year,int Month,int Day,float *pRise,float *pSet)
+{
+  ERRORCODE_T ErrorCode;
+  TRACK_T Track;
+  double pTheta[RISESET_SAMPLES];
+  double *pSinLatitude;
+  double *pCosLatitude;
+  int TileCount;
+  int Tile;
+  int Row;
+  int Sample;
+
+
+  DEBUGLOG_Printf6("MoonGrid_Calculate(%p,%d,%d,%d,%p,%p)",
+      pGrid,Year,Month,Day,pRise,pSet);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pGrid==NULL) || ((pRise==NULL) && (pSet==NULL)) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (pGrid->LatitudeCount<=0) || (pGrid->LongitudeCount<=0) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    pSinLatitude=(double *)malloc(2*pGrid->LatitudeCount*sizeof(double));
+    if (pSinLatitude==NULL)
+      ErrorCode=ERRORCODE_OUTOFMEMORY;
+    else
+    {
+      pCosLatitude=pSinLatitude+pGrid->LatitudeCount;
+
+      /* The moon track, once for the whole grid. */
+      MoonTrack(Year,Month,Day,0.0,Track.pDirection,pTheta);
+      for(Sample=0;Sample<RISESET_SAMPLES;Sample++)
+      {
+        Track.pCosTheta[Sample]=cos(pTheta[Sample]);
+        Track.pSinTheta[Sample]=sin(pTheta[Sample]);
+      }
+      Track.SinH0=sin(RADIANS(8.0/60.0));
+
+      for(Row=0;Row<pGrid->LatitudeCount;Row++)
+      {
+        pSinLatitude[Row]=
+            sin(RADIANS(pGrid->Latitude+Row*pGrid->LatitudeStep));
+        pCosLatitude[Row]=
+            cos(RADIANS(pGrid->Latitude+Row*pGrid->LatitudeStep));
+      }
+
+      /* Tiles are independent, so they can be shared out freely. */
+      TileCount=(pGrid->LongitudeCount+MOONGRID_TILECOLUMNS-1)/
+          MOONGRID_TILECOLUMNS;
+#ifdef    _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif    /* _OPENMP */
+      for(Tile=0;Tile<TileCount;Tile++)
+        CalculateTile(pGrid,&Track,pSinLatitude,pCosLatitude,Tile,pRise,pSet);
+
+      free(pSinLatitude);
+      ErrorCode=ERRORCODE_SUCCESS;
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+
+#undef    MOONGRID_C
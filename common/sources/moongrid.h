@@ -0,0 +1,159 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moongrid.h
+*** \brief Moon rise/set maps.
+*** \details Computes the moon rise and set times of one day over a regular
+***   latitude/longitude grid. The moon track is computed once for the day
+***   and shared by every cell; the grid is split into column tiles which
+***   are spread over all cores when built with OpenMP.
+**/
+
+
+#ifndef   MOONGRID_H
+#define   MOONGRID_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "errorcode.h"
+#include  "sysdefs.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Tile width.
+*** \details Number of grid columns per unit of work.
+**/
+#define   MOONGRID_TILECOLUMNS  (32)
+
+/**
+*** \brief No event.
+*** \details Raster value of a cell in which the moon does not rise (or
+***   set) that day.
+**/
+#define   MOONGRID_NOEVENT      (-999.0f)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Grid description.
+*** \details Position and size of a grid. Cell (Row,Column) is at
+***   Latitude+Row*LatitudeStep, Longitude+Column*LongitudeStep, and is
+***   stored at index Row*LongitudeCount+Column of a raster.
+**/
+typedef struct structMOONGRID
+{
+  /**
+  *** \brief First latitude.
+  *** \details Latitude of row 0 (in degrees, north positive).
+  **/
+  double Latitude;
+  /**
+  *** \brief Latitude step.
+  *** \details Latitude step between rows (in degrees).
+  **/
+  double LatitudeStep;
+  /**
+  *** \brief Row count.
+  *** \details Number of rows.
+  **/
+  int LatitudeCount;
+  /**
+  *** \brief First longitude.
+  *** \details Longitude of column 0 (in degrees, west positive as in
+  ***   CTrans).
+  **/
+  double Longitude;
+  /**
+  *** \brief Longitude step.
+  *** \details Longitude step between columns (in degrees).
+  **/
+  double LongitudeStep;
+  /**
+  *** \brief Column count.
+  *** \details Number of columns.
+  **/
+  int LongitudeCount;
+} MOONGRID_T;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+*** \brief Computes rise/set maps.
+*** \details Fills dense rasters with the moon rise and set times of a UT
+***   day for every cell of a grid. The times are as returned by
+***   MoonRise_r() with a time zone of zero (UT hours), or MOONGRID_NOEVENT.
+*** \param pGrid Grid description.
+*** \param Year Year.
+*** \param Month Month (1-12).
+*** \param Day Day (1-31).
+*** \param pRise Rise time raster (LatitudeCount*LongitudeCount values), or
+***   NULL if not wanted.
+*** \param pSet Set time raster (LatitudeCount*LongitudeCount values), or
+***   NULL if not wanted.
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T MoonGrid_Calculate(MOONGRID_T const *pGrid,
+    int Year,int Month,int Day,float *pRise,float *pSet);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* MOONGRID_H */
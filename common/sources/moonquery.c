@@ -0,0 +1,387 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moonquery.c
+*** \brief moonquery.h implementation.
+*** \details Implementation file for moonquery.h.
+**/
+
+
+/** Identifier for moonquery.c. **/
+#define   MOONQUERY_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moonquery.h"
+#ifdef    DEBUG_MOONQUERY_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_MOONQUERY_C */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  "daynumber.h"
+#include  "lunation.h"
+
+#include  <math.h>
+#include  <string.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Unix epoch.
+*** \details Julian date of 1970-01-01 0h UT.
+**/
+#define   UNIXEPOCH_JD          (2440587.5)
+
+/**
+*** \brief Unix epoch day.
+*** \details Day number of 1970-01-01.
+**/
+#define   UNIXEPOCH_DAY         (2440588L)
+
+/**
+*** \brief Delta T.
+*** \details TDT minus UT (in days), as used by calcephem.c.
+**/
+#define   DELTAT                (59.0/86400.0)
+
+/**
+*** \brief Solver tolerance.
+*** \details Convergence limit of MoonPhaseEvent() outside the lunation
+***   table (in Julian centuries, about 3 s).
+**/
+#define   SOLVER_TOLERANCE      (1e-9)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(MoonQuery,MOONQUERY_T);
+static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(MoonQuery,MOONQUERY_T);
+static int CheckRequest(MOONQUERYREQUEST_T const *pRequest);
+static MOONQUERYPROFILE_T *GetProfile(MOONQUERY_T *pQuery,
+    MOONQUERYREQUEST_T const *pRequest);
+static void AnswerEphemeris(MOONQUERYPROFILE_T const *pProfile,
+    MOONQUERYREQUEST_T const *pRequest,MOONQUERYREPLY_T *pReply);
+static void AnswerRiseSet(MOONQUERYPROFILE_T *pProfile,
+    MOONQUERYREQUEST_T const *pRequest,MOONQUERYREPLY_T *pReply);
+static void AnswerPhase(MOONQUERYREQUEST_T const *pRequest,
+    MOONQUERYREPLY_T *pReply);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+STRUCTURE_FUNCTION_INITIALIZE(MoonQuery,MOONQUERY_T)
+
+static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(MoonQuery,MOONQUERY_T)
+{
+  DEBUGLOG_Printf1("MoonQuery_InitializeMembers(%p)",pStructure);
+  DEBUGLOG_LogIn();
+
+  /* All profiles start empty (LastUse 0). */
+
+  DEBUGLOG_LogOut();
+  return(ERRORCODE_SUCCESS);
+}
+
+STRUCTURE_FUNCTION_UNINITIALIZE(MoonQuery,MOONQUERY_T)
+
+static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(MoonQuery,MOONQUERY_T)
+{
+  UNUSED(pStructure);
+
+
+  DEBUGLOG_Printf1("MoonQuery_UninitializeMembers(%p)",pStructure);
+  DEBUGLOG_LogIn();
+
+  DEBUGLOG_LogOut();
+  return(ERRORCODE_SUCCESS);
+}
+
+/**
+*** \brief Checks a request.
+*** \details Checks that the time and observer of a request are finite and
+***   in range, and that the local day and the days either side have day
+***   numbers. Requests come from any client, so nothing else can be
+***   assumed of them.
+*** \param pRequest Request.
+*** \retval 1 Valid.
+*** \retval 0 Invalid.
+**/
+static int CheckRequest(MOONQUERYREQUEST_T const *pRequest)
+{
+  double Day;
+
+
+  if ( (isfinite(pRequest->UTC)==0) || (isfinite(pRequest->Latitude)==0) ||
+      (isfinite(pRequest->Longitude)==0) ||
+      (isfinite(pRequest->TimeZone)==0) ||
+      (fabs(pRequest->Latitude)>90.0) || (fabs(pRequest->TimeZone)>24.0) )
+    return(0);
+
+  Day=floor((pRequest->UTC-pRequest->TimeZone*3600.0)/86400.0)+
+      UNIXEPOCH_DAY;
+  return( (Day>DAYNUMBER_MINIMUM) && (Day<DAYNUMBER_MAXIMUM) );
+}
+
+/**
+*** \brief Finds a profile.
+*** \details Returns the profile of the observer of a request, setting up
+***   the least recently used one if the observer has none.
+*** \param pQuery Pointer to the query engine.
+*** \param pRequest Request.
+*** \returns Profile.
+**/
+static MOONQUERYPROFILE_T *GetProfile(MOONQUERY_T *pQuery,
+    MOONQUERYREQUEST_T const *pRequest)
+{
+  MOONQUERYPROFILE_T *pProfile;
+  MOONQUERYPROFILE_T *pOldest;
+  int Index;
+
+
+  pQuery->LookupCount++;
+  pOldest=&pQuery->pProfiles[0];
+  for(Index=0;Index<MOONQUERY_PROFILECOUNT;Index++)
+  {
+    pProfile=&pQuery->pProfiles[Index];
+    if ( (pProfile->LastUse!=0) &&
+        (pProfile->Latitude==pRequest->Latitude) &&
+        (pProfile->Longitude==pRequest->Longitude) &&
+        (pProfile->TimeZone==pRequest->TimeZone) )
+    {
+      pProfile->LastUse=pQuery->LookupCount;
+      return(pProfile);
+    }
+    if (pProfile->LastUse<pOldest->LastUse)
+      pOldest=pProfile;
+  }
+
+  pQuery->ProfileMissCount++;
+  pOldest->LastUse=pQuery->LookupCount;
+  pOldest->Latitude=pRequest->Latitude;
+  pOldest->Longitude=pRequest->Longitude;
+  pOldest->TimeZone=pRequest->TimeZone;
+  EphemContext_Set(&pOldest->Context,
+      pRequest->Latitude,pRequest->Longitude,pRequest->TimeZone);
+  RiseSetCache_Init(&pOldest->RiseSetCache);
+  return(pOldest);
+}
+
+/**
+*** \brief Answers an ephemeris request.
+*** \details Computes the moon for the observer of the profile.
+*** \param pProfile Observer profile.
+*** \param pRequest Request.
+*** \param pReply Storage for the reply.
+**/
+static void AnswerEphemeris(MOONQUERYPROFILE_T const *pProfile,
+    MOONQUERYREQUEST_T const *pRequest,MOONQUERYREPLY_T *pReply)
+{
+  EphemRecord Record;
+
+
+  if ( (pRequest->AccuracyTier<0) ||
+      (pRequest->AccuracyTier>=EPHEMTIER_COUNT) )
+  {
+    pReply->Status=ERRORCODE_INVALIDPARAMETER;
+    return;
+  }
+
+  CalcEphemRecord(UNIXEPOCH_JD+pRequest->UTC/86400.0,&pProfile->Context,
+      pRequest->AccuracyTier,&Record,NULL);
+  pReply->pValues[0]=Record.RA_moon;
+  pReply->pValues[1]=Record.DEC_moon;
+  pReply->pValues[2]=Record.h_moon;
+  pReply->pValues[3]=Record.A_moon;
+  pReply->pValues[4]=Record.MoonPhase;
+  pReply->pValues[5]=Record.MoonAge;
+  pReply->pValues[6]=Record.EarthMoonDistance;
+  return;
+}
+
+/**
+*** \brief Answers a rise/set request.
+*** \details Looks up the rise/set times of the local day of the request
+***   and the days either side, in the rise/set cache of the profile.
+*** \param pProfile Observer profile.
+*** \param pRequest Request.
+*** \param pReply Storage for the reply.
+**/
+static void AnswerRiseSet(MOONQUERYPROFILE_T *pProfile,
+    MOONQUERYREQUEST_T const *pRequest,MOONQUERYREPLY_T *pReply)
+{
+  long DayNumber;
+  int Day;
+  int Year;
+  int Month;
+  int MonthDay;
+
+
+  DayNumber=(long)floor(
+      (pRequest->UTC-pRequest->TimeZone*3600.0)/86400.0)+UNIXEPOCH_DAY;
+  for(Day=0;Day<3;Day++)
+  {
+    DayNumber_ToDate(DayNumber+Day-1,&Year,&Month,&MonthDay);
+    MoonRiseCached(Year,Month,MonthDay,
+        &pReply->pValues[2*Day],&pReply->pValues[2*Day+1],
+        &pProfile->Context,&pProfile->RiseSetCache);
+  }
+  return;
+}
+
+/**
+*** \brief Answers a phase request.
+*** \details Finds the moon age and the next phase events, from the
+***   lunation table if it covers the time, or else from MoonPhaseEvent().
+*** \param pRequest Request.
+*** \param pReply Storage for the reply.
+**/
+static void AnswerPhase(MOONQUERYREQUEST_T const *pRequest,
+    MOONQUERYREPLY_T *pReply)
+{
+  double T;
+  double Age;
+  double Event;
+  double Guess;
+  double Lambda;
+  double Beta;
+  double R;
+  int Phase;
+
+
+  T=(UNIXEPOCH_JD+pRequest->UTC/86400.0+DELTAT-2451545.0)/36525.0;
+  if (Lunation_GetAge(T,&Age)<0)
+    Moon(T,&Lambda,&Beta,&R,&Age);
+  pReply->pValues[0]=Age;
+
+  for(Phase=LUNATIONPHASE_NEWMOON;Phase<=LUNATIONPHASE_LASTQUARTER;Phase++)
+  {
+    if (Lunation_GetNextPhase(T,Phase,&Event)<0)
+    {
+      /* Mean time of the next such phase from the age. */
+      Guess=fmod(0.25*Phase*LUNATION_SYNODICMONTH-Age+
+          2.0*LUNATION_SYNODICMONTH,LUNATION_SYNODICMONTH);
+      Event=MoonPhaseEvent(T+Guess/36525.0,0.25*Phase,SOLVER_TOLERANCE);
+    }
+    pReply->pValues[1+Phase]=
+        (Event*36525.0+2451545.0-DELTAT-UNIXEPOCH_JD)*86400.0;
+  }
+  return;
+}
+
+ERRORCODE_T MoonQuery_Answer(MOONQUERY_T *pQuery,
+    MOONQUERYREQUEST_T const *pRequests,int Count,
+    MOONQUERYREPLY_T *pReplies)
+{
+  ERRORCODE_T ErrorCode;
+  MOONQUERYREQUEST_T const *pRequest;
+  MOONQUERYREPLY_T *pReply;
+  int Index;
+
+
+  DEBUGLOG_Printf4("MoonQuery_Answer(%p,%p,%d,%p)",
+      pQuery,pRequests,Count,pReplies);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pQuery==NULL) || (pRequests==NULL) || (pReplies==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (Count<0) || (Count>MOONQUERY_MAXBATCH) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    for(Index=0;Index<Count;Index++)
+    {
+      pRequest=&pRequests[Index];
+      pReply=&pReplies[Index];
+      memset(pReply,0,sizeof(*pReply));
+      pReply->Type=pRequest->Type;
+      pReply->Status=ERRORCODE_SUCCESS;
+
+      if (CheckRequest(pRequest)==0)
+        pReply->Status=ERRORCODE_INVALIDPARAMETER;
+      else
+        switch(pRequest->Type)
+        {
+          case MOONQUERYTYPE_EPHEMERIS:
+            AnswerEphemeris(GetProfile(pQuery,pRequest),pRequest,pReply);
+            break;
+          case MOONQUERYTYPE_RISESET:
+            AnswerRiseSet(GetProfile(pQuery,pRequest),pRequest,pReply);
+            break;
+          case MOONQUERYTYPE_PHASE:
+            AnswerPhase(pRequest,pReply);
+            break;
+          default:
+            pReply->Status=ERRORCODE_UNSUPPORTED;
+            break;
+        }
+    }
+    pQuery->BatchCount++;
+    pQuery->RequestCount+=Count;
+    ErrorCode=ERRORCODE_SUCCESS;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+
+#undef    MOONQUERY_C
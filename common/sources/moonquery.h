@@ -0,0 +1,321 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moonquery.h
+*** \brief Batched moon data queries.
+*** \details Answers batches of fixed size query records (ephemeris,
+***   rise/set times, phases) against a set of warm observer profiles, each
+***   with its own rise/set cache. This is the engine of the moon data
+***   daemon (moonphase-service); the records are also its wire format: a
+***   request is a MOONQUERYHEADER_T followed by Count MOONQUERYREQUEST_T,
+***   the reply a MOONQUERYHEADER_T followed by Count MOONQUERYREPLY_T, in
+***   the byte order of the machine.
+**/
+
+
+#ifndef   MOONQUERY_H
+#define   MOONQUERY_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "structure.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Magic.
+*** \details Magic of a request or reply header ("MPQ1").
+**/
+#define   MOONQUERY_MAGIC         (0x3151504DUL)
+
+/**
+*** \brief Socket pathname.
+*** \details Default pathname of the daemon socket. The MOONPHASE_QUERYSOCKET
+***   environment variable overrides it.
+**/
+#define   MOONQUERY_SOCKETPATHNAME  "/tmp/moonphase-query"
+
+/**
+*** \brief Maximum batch.
+*** \details Maximum number of requests in one batch.
+**/
+#define   MOONQUERY_MAXBATCH      (4096)
+
+/**
+*** \brief Value count.
+*** \details Number of values in a reply.
+**/
+#define   MOONQUERY_VALUECOUNT    (7)
+
+/**
+*** \brief Profile count.
+*** \details Number of observer profiles kept warm.
+**/
+#define   MOONQUERY_PROFILECOUNT  (64)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Query types.
+*** \details Query types.
+**/
+typedef enum enumMOONQUERYTYPE
+{
+  /**
+  *** \brief Ephemeris.
+  *** \details Values: right ascension, declination, altitude, azimuth (in
+  ***   degrees), phase (0-1), age (in days) and earth-moon distance (in
+  ***   earth radii), as in EphemRecord.
+  **/
+  MOONQUERYTYPE_EPHEMERIS=0,
+  /**
+  *** \brief Rise/set times.
+  *** \details Values: yesterdays, todays and tomorrows rise and set times
+  ***   (in local hours, -999 if none) of the local day of the time, as in
+  ***   MOONDATA_T.
+  **/
+  MOONQUERYTYPE_RISESET,
+  /**
+  *** \brief Phases.
+  *** \details Values: age (in days), then the next new moon, first
+  ***   quarter, full moon and last quarter (in seconds since 1970-01-01
+  ***   UTC).
+  **/
+  MOONQUERYTYPE_PHASE,
+  /**
+  *** \brief Type count.
+  *** \details Number of query types.
+  **/
+  MOONQUERYTYPE_COUNT
+} MOONQUERYTYPE_E;
+
+/**
+*** \brief Batch header.
+*** \details Start of a request or reply batch.
+**/
+typedef struct structMOONQUERYHEADER
+{
+  /**
+  *** \brief Magic.
+  *** \details MOONQUERY_MAGIC.
+  **/
+  unsigned int Magic;
+  /**
+  *** \brief Count.
+  *** \details Number of records that follow (at most MOONQUERY_MAXBATCH).
+  **/
+  unsigned int Count;
+} MOONQUERYHEADER_T;
+
+/**
+*** \brief Request.
+*** \details One query.
+**/
+typedef struct structMOONQUERYREQUEST
+{
+  /**
+  *** \brief Type.
+  *** \details Query type (MOONQUERYTYPE_E).
+  **/
+  int Type;
+  /**
+  *** \brief Accuracy tier.
+  *** \details Accuracy tier of ephemeris queries (EPHEMTIER_*).
+  **/
+  int AccuracyTier;
+  /**
+  *** \brief Time.
+  *** \details Time (in seconds since 1970-01-01 UTC).
+  **/
+  double UTC;
+  /**
+  *** \brief Latitude.
+  *** \details Observer latitude (in degrees, north positive).
+  **/
+  double Latitude;
+  /**
+  *** \brief Longitude.
+  *** \details Observer longitude (in degrees, west positive as in CTrans).
+  **/
+  double Longitude;
+  /**
+  *** \brief Time zone.
+  *** \details Hours to add to local time to get UT (as in EphemContext).
+  **/
+  double TimeZone;
+} MOONQUERYREQUEST_T;
+
+/**
+*** \brief Reply.
+*** \details Answer to one query.
+**/
+typedef struct structMOONQUERYREPLY
+{
+  /**
+  *** \brief Type.
+  *** \details Query type of the request.
+  **/
+  int Type;
+  /**
+  *** \brief Status.
+  *** \details ERRORCODE_SUCCESS, or the reason the request failed.
+  **/
+  int Status;
+  /**
+  *** \brief Values.
+  *** \details Answer (see MOONQUERYTYPE_E), unused values are 0.
+  **/
+  double pValues[MOONQUERY_VALUECOUNT];
+} MOONQUERYREPLY_T;
+
+/**
+*** \brief Observer profile.
+*** \details Warm state of one observer.
+**/
+typedef struct structMOONQUERYPROFILE
+{
+  /**
+  *** \brief Last use.
+  *** \details Lookup count at the last use, 0 if the profile is empty.
+  **/
+  unsigned long LastUse;
+  /**
+  *** \brief Latitude.
+  *** \details Observer latitude.
+  **/
+  double Latitude;
+  /**
+  *** \brief Longitude.
+  *** \details Observer longitude.
+  **/
+  double Longitude;
+  /**
+  *** \brief Time zone.
+  *** \details Observer time zone.
+  **/
+  double TimeZone;
+  /**
+  *** \brief Observer.
+  *** \details Observer context.
+  **/
+  EphemContext Context;
+  /**
+  *** \brief Rise/set cache.
+  *** \details Rise/set days of the observer.
+  **/
+  RiseSetCache RiseSetCache;
+} MOONQUERYPROFILE_T;
+
+/**
+*** \brief Query engine.
+*** \details Observer profiles and counters. Not shared between threads.
+**/
+typedef struct structMOONQUERY
+{
+  /**
+  *** \brief Lookup count.
+  *** \details Number of profile lookups, used to order the profiles.
+  **/
+  unsigned long LookupCount;
+  /**
+  *** \brief Profile misses.
+  *** \details Number of lookups that had to set up a profile.
+  **/
+  unsigned long ProfileMissCount;
+  /**
+  *** \brief Batch count.
+  *** \details Number of batches answered.
+  **/
+  unsigned long BatchCount;
+  /**
+  *** \brief Request count.
+  *** \details Number of requests answered.
+  **/
+  unsigned long RequestCount;
+  /**
+  *** \brief Profiles.
+  *** \details Profiles, the least recently used one is replaced.
+  **/
+  MOONQUERYPROFILE_T pProfiles[MOONQUERY_PROFILECOUNT];
+} MOONQUERY_T;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+STRUCTURE_PROTOTYPE_INITIALIZE(MoonQuery,MOONQUERY_T);
+STRUCTURE_PROTOTYPE_UNINITIALIZE(MoonQuery,MOONQUERY_T);
+/**
+*** \brief Answers a batch.
+*** \details Answers Count requests. A request that cannot be answered
+***   gets a negative Status; the others are not affected.
+*** \param pQuery Pointer to the query engine.
+*** \param pRequests Requests.
+*** \param Count Number of requests (at most MOONQUERY_MAXBATCH).
+*** \param pReplies Storage for Count replies.
+*** \retval >0 Success.
+*** \retval <0 Failure (invalid parameters).
+**/
+ERRORCODE_T MoonQuery_Answer(MOONQUERY_T *pQuery,
+    MOONQUERYREQUEST_T const *pRequests,int Count,
+    MOONQUERYREPLY_T *pReplies);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* MOONQUERY_H */
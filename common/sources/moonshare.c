@@ -0,0 +1,531 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moonshare.c
+*** \brief moonshare.h implementation.
+*** \details Implementation file for moonshare.h.
+**/
+
+
+/** Identifier for moonshare.c. **/
+#define   MOONSHARE_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moonshare.h"
+#ifdef    DEBUG_MOONSHARE_C
+#ifndef   USE_DEBUGLOG
+#define   USE_DEBUGLOG
+#endif    /* USE_DEBUGLOG */
+#endif    /* DEBUG_MOONSHARE_C */
+#include  "debuglog.h"
+
+#include  "sysdefs.h"
+
+#include  <stdio.h>
+#include  <string.h>
+#ifndef   _WIN32
+#include  <errno.h>
+#include  <fcntl.h>
+#include  <sched.h>
+#include  <unistd.h>
+#include  <sys/mman.h>
+#include  <sys/stat.h>
+#endif    /* _WIN32 */
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Data words.
+*** \details Size of MOONSHAREDATA_T in 32 bit words. The snapshot is
+***   copied a word at a time with atomic accesses, so that the copy is
+***   well defined while the other side is writing.
+**/
+#define   DATAWORDCOUNT   (sizeof(MOONSHAREDATA_T)/sizeof(unsigned int))
+
+/**
+*** \brief Spin limit.
+*** \details Number of times to look at an odd sequence before giving up (a
+***   reader) or deciding the writer died in the middle of a publication (a
+***   writer), several milliseconds.
+**/
+#define   SPINLIMIT       (1UL<<24)
+
+/**
+*** \brief Yield interval.
+*** \details Number of times to look at an odd sequence before giving the
+***   processor to the writer (which may have been preempted mid-write).
+**/
+#define   YIELDINTERVAL   (1024UL)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(MoonShare,MOONSHARE_T);
+static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(MoonShare,MOONSHARE_T);
+#ifndef   _WIN32
+static void SetName(MOONSHARE_T *pShare,char const *pName);
+static int CreateExclusive(char const *pName);
+static int IsOwnSegment(MOONSHARE_T const *pShare);
+#endif    /* _WIN32 */
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+STRUCTURE_FUNCTION_INITIALIZE(MoonShare,MOONSHARE_T)
+
+static STRUCTURE_PROTOTYPE_INITIALIZEMEMBERS(MoonShare,MOONSHARE_T)
+{
+  DEBUGLOG_Printf1("MoonShare_InitializeMembers(%p)",pStructure);
+  DEBUGLOG_LogIn();
+
+  pStructure->pSegment=NULL;
+
+  DEBUGLOG_LogOut();
+  return(ERRORCODE_SUCCESS);
+}
+
+STRUCTURE_FUNCTION_UNINITIALIZE(MoonShare,MOONSHARE_T)
+
+static STRUCTURE_PROTOTYPE_UNINITIALIZEMEMBERS(MoonShare,MOONSHARE_T)
+{
+  DEBUGLOG_Printf1("MoonShare_UninitializeMembers(%p)",pStructure);
+  DEBUGLOG_LogIn();
+
+  MoonShare_Close(pStructure);
+
+  DEBUGLOG_LogOut();
+  return(ERRORCODE_SUCCESS);
+}
+
+#ifndef   _WIN32
+
+/**
+*** \brief Sets the segment name.
+*** \details Copies the segment name into the handle, or the default name
+***   of the user if there is none.
+*** \param pShare Pointer to the handle.
+*** \param pName Segment name, or NULL.
+**/
+static void SetName(MOONSHARE_T *pShare,char const *pName)
+{
+  if (pName==NULL)
+    snprintf(pShare->pName,sizeof(pShare->pName),"%s%u",
+        MOONSHARE_NAMEPREFIX,(unsigned int)getuid());
+  else
+    snprintf(pShare->pName,sizeof(pShare->pName),"%s",pName);
+  return;
+}
+
+/**
+*** \brief Creates a segment exclusively.
+*** \details Creates a new segment. If the name is taken by a segment of
+***   the same user (left by a run that died, or in use by another
+***   instance), it is removed and created again; the name is predictable,
+***   so a segment of another user is never taken over.
+*** \param pName Segment name.
+*** \returns Descriptor, or -1 on failure.
+**/
+static int CreateExclusive(char const *pName)
+{
+  int Descriptor;
+  int Existing;
+  struct stat Status;
+  int OwnFlag;
+
+
+  Descriptor=shm_open(pName,O_RDWR|O_CREAT|O_EXCL,0644);
+  if ( (Descriptor<0) && (errno==EEXIST) )
+  {
+    Existing=shm_open(pName,O_RDONLY,0);
+    if (Existing>=0)
+    {
+      OwnFlag=(fstat(Existing,&Status)==0) && (Status.st_uid==getuid());
+      close(Existing);
+      if ( (OwnFlag!=0) && (shm_unlink(pName)==0) )
+        Descriptor=shm_open(pName,O_RDWR|O_CREAT|O_EXCL,0644);
+    }
+  }
+  return(Descriptor);
+}
+
+/**
+*** \brief Checks the segment name.
+*** \details Checks that the name of a created segment still refers to it.
+*** \param pShare Pointer to the handle.
+*** \retval 1 Same segment.
+*** \retval 0 Another segment, or none.
+**/
+static int IsOwnSegment(MOONSHARE_T const *pShare)
+{
+  int Descriptor;
+  struct stat Status;
+  int SameFlag;
+
+
+  SameFlag=0;
+  Descriptor=shm_open(pShare->pName,O_RDONLY,0);
+  if (Descriptor>=0)
+  {
+    SameFlag=(fstat(Descriptor,&Status)==0) &&
+        ((unsigned long)Status.st_dev==pShare->Device) &&
+        ((unsigned long)Status.st_ino==pShare->Inode);
+    close(Descriptor);
+  }
+  return(SameFlag);
+}
+
+ERRORCODE_T MoonShare_Create(MOONSHARE_T *pShare,char const *pName)
+{
+  ERRORCODE_T ErrorCode;
+  int Descriptor;
+  struct stat Status;
+  void *pMapping;
+
+
+  DEBUGLOG_Printf2("MoonShare_Create(%p,%p)",pShare,pName);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if (pShare==NULL)
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if (pShare->pSegment!=NULL)
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    SetName(pShare,pName);
+    ErrorCode=ERRORCODE_SYSTEMFAILURE;
+    Descriptor=CreateExclusive(pShare->pName);
+    if (Descriptor>=0)
+    {
+      /* Readable by others (monitoring agents), despite the umask. */
+      fchmod(Descriptor,0644);
+      if ( (fstat(Descriptor,&Status)==0) &&
+          (ftruncate(Descriptor,sizeof(MOONSHARESEGMENT_T))==0) )
+      {
+        pMapping=mmap(NULL,sizeof(MOONSHARESEGMENT_T),
+            PROT_READ|PROT_WRITE,MAP_SHARED,Descriptor,0);
+        if (pMapping!=MAP_FAILED)
+        {
+          pShare->pSegment=(MOONSHARESEGMENT_T *)pMapping;
+          pShare->WriterFlag=1;
+          pShare->Device=(unsigned long)Status.st_dev;
+          pShare->Inode=(unsigned long)Status.st_ino;
+          pShare->pSegment->Version=MOONSHARE_VERSION;
+          pShare->pSegment->DataSize=sizeof(MOONSHAREDATA_T);
+          /* Readers check the magic last, after the rest is set up. */
+          __atomic_store_n(&pShare->pSegment->Magic,
+              (unsigned int)MOONSHARE_MAGIC,__ATOMIC_RELEASE);
+          ErrorCode=ERRORCODE_SUCCESS;
+        }
+      }
+      close(Descriptor);
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+ERRORCODE_T MoonShare_Open(MOONSHARE_T *pShare,char const *pName)
+{
+  ERRORCODE_T ErrorCode;
+  int Descriptor;
+  struct stat Status;
+  void *pMapping;
+  MOONSHARESEGMENT_T const *pSegment;
+
+
+  DEBUGLOG_Printf2("MoonShare_Open(%p,%p)",pShare,pName);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if (pShare==NULL)
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if (pShare->pSegment!=NULL)
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    SetName(pShare,pName);
+    ErrorCode=ERRORCODE_SYSTEMFAILURE;
+    Descriptor=shm_open(pShare->pName,O_RDONLY,0);
+    if (Descriptor>=0)
+    {
+      if ( (fstat(Descriptor,&Status)==0) &&
+          (Status.st_size>=(off_t)sizeof(MOONSHARESEGMENT_T)) )
+      {
+        pMapping=mmap(NULL,sizeof(MOONSHARESEGMENT_T),
+            PROT_READ,MAP_SHARED,Descriptor,0);
+        if (pMapping!=MAP_FAILED)
+        {
+          pSegment=(MOONSHARESEGMENT_T const *)pMapping;
+          /* Newer writers only add fields, so any data that is at least
+              as large as ours will do. */
+          if ( (__atomic_load_n(&pSegment->Magic,__ATOMIC_ACQUIRE)!=
+              MOONSHARE_MAGIC) || (pSegment->Version<MOONSHARE_VERSION) ||
+              (pSegment->DataSize<sizeof(MOONSHAREDATA_T)) )
+          {
+            munmap(pMapping,sizeof(MOONSHARESEGMENT_T));
+            ErrorCode=ERRORCODE_INVALIDDATA;
+          }
+          else
+          {
+            pShare->pSegment=(MOONSHARESEGMENT_T *)pMapping;
+            pShare->WriterFlag=0;
+            pShare->RetryCount=0;
+            ErrorCode=ERRORCODE_SUCCESS;
+          }
+        }
+      }
+      else
+        ErrorCode=ERRORCODE_INVALIDDATA;
+      close(Descriptor);
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+void MoonShare_Close(MOONSHARE_T *pShare)
+{
+  DEBUGLOG_Printf1("MoonShare_Close(%p)",pShare);
+  DEBUGLOG_LogIn();
+
+  if ( (pShare!=NULL) && (pShare->pSegment!=NULL) )
+  {
+    if (pShare->WriterFlag!=0)
+    {
+      __atomic_store_n(&pShare->pSegment->Magic,0,__ATOMIC_RELEASE);
+      if (IsOwnSegment(pShare)!=0)
+        shm_unlink(pShare->pName);
+    }
+    munmap(pShare->pSegment,sizeof(MOONSHARESEGMENT_T));
+    pShare->pSegment=NULL;
+  }
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+ERRORCODE_T MoonShare_Write(MOONSHARE_T *pShare,MOONSHAREDATA_T const *pData)
+{
+  ERRORCODE_T ErrorCode;
+  MOONSHARESEGMENT_T *pSegment;
+  unsigned int const *pSource;
+  unsigned int *pTarget;
+  unsigned int Sequence;
+  unsigned int Next;
+  unsigned long Spin;
+  unsigned int Index;
+
+
+  DEBUGLOG_Printf2("MoonShare_Write(%p,%p)",pShare,pData);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pShare==NULL) || (pData==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if ( (pShare->pSegment==NULL) || (pShare->WriterFlag==0) )
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else
+  {
+    pSegment=pShare->pSegment;
+
+    /* Make the sequence odd. A new instance of the application replaces
+        the segment rather than sharing it, so there is one writer; the
+        compare and swap only takes over from a writer that died while
+        publishing and left the sequence odd. */
+    Sequence=__atomic_load_n(&pSegment->Sequence,__ATOMIC_RELAXED);
+    for(Spin=0;;Spin++)
+    {
+      if ((Sequence&1)==0)
+        Next=Sequence+1;
+      else if (Spin>=SPINLIMIT)
+        Next=Sequence+2;    // Left odd by a writer that died, take over.
+      else
+      {
+        if ((Spin+1)%YIELDINTERVAL==0)
+          sched_yield();
+        Sequence=__atomic_load_n(&pSegment->Sequence,__ATOMIC_RELAXED);
+        continue;
+      }
+      if (__atomic_compare_exchange_n(&pSegment->Sequence,&Sequence,Next,
+          0,__ATOMIC_RELAXED,__ATOMIC_RELAXED)!=0)
+        break;
+    }
+    /* The odd sequence must be visible before any data changes. */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    pSource=(unsigned int const *)pData;
+    pTarget=(unsigned int *)&pSegment->Data;
+    for(Index=0;Index<DATAWORDCOUNT;Index++)
+      __atomic_store_n(&pTarget[Index],pSource[Index],__ATOMIC_RELAXED);
+
+    /* Even again, after the data. */
+    __atomic_store_n(&pSegment->Sequence,Next+1,__ATOMIC_RELEASE);
+    ErrorCode=ERRORCODE_SUCCESS;
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+ERRORCODE_T MoonShare_Read(MOONSHARE_T *pShare,MOONSHAREDATA_T *pData,
+    unsigned int *pSequence)
+{
+  ERRORCODE_T ErrorCode;
+  MOONSHARESEGMENT_T const *pSegment;
+  unsigned int const *pSource;
+  unsigned int *pTarget;
+  unsigned int Sequence;
+  unsigned long Spin;
+  unsigned int Index;
+
+
+  DEBUGLOG_Printf3("MoonShare_Read(%p,%p,%p)",pShare,pData,pSequence);
+  DEBUGLOG_LogIn();
+
+  /* Parameter checking. */
+  if ( (pShare==NULL) || (pData==NULL) )
+    ErrorCode=ERRORCODE_NULLPARAMETER;
+  else if (pShare->pSegment==NULL)
+    ErrorCode=ERRORCODE_INVALIDPARAMETER;
+  else if (__atomic_load_n(&pShare->pSegment->Magic,__ATOMIC_ACQUIRE)!=
+      MOONSHARE_MAGIC)
+    ErrorCode=ERRORCODE_INVALIDDATA;
+  else
+  {
+    pSegment=pShare->pSegment;
+    pSource=(unsigned int const *)&pSegment->Data;
+    pTarget=(unsigned int *)pData;
+    for(Spin=0;Spin<SPINLIMIT;Spin++)
+    {
+      Sequence=__atomic_load_n(&pSegment->Sequence,__ATOMIC_ACQUIRE);
+      if ((Sequence&1)==0)
+      {
+        for(Index=0;Index<DATAWORDCOUNT;Index++)
+          pTarget[Index]=__atomic_load_n(&pSource[Index],__ATOMIC_RELAXED);
+        /* The data must be read before the sequence is checked again. */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&pSegment->Sequence,__ATOMIC_RELAXED)==Sequence)
+          break;
+      }
+      pShare->RetryCount++;
+      if ((Spin+1)%YIELDINTERVAL==0)
+        sched_yield();
+    }
+
+    if (Spin>=SPINLIMIT)
+      ErrorCode=ERRORCODE_SYSTEMFAILURE;
+    else if (Sequence==0)
+      ErrorCode=ERRORCODE_INVALIDDATA;
+    else
+    {
+      if (pSequence!=NULL)
+        *pSequence=Sequence;
+      ErrorCode=ERRORCODE_SUCCESS;
+    }
+  }
+
+  DEBUGLOG_LogOut();
+  return(ErrorCode);
+}
+
+#else     /* _WIN32 */
+
+ERRORCODE_T MoonShare_Create(MOONSHARE_T *pShare,char const *pName)
+{
+  UNUSED(pShare);
+  UNUSED(pName);
+  return(ERRORCODE_UNSUPPORTED);
+}
+
+ERRORCODE_T MoonShare_Open(MOONSHARE_T *pShare,char const *pName)
+{
+  UNUSED(pShare);
+  UNUSED(pName);
+  return(ERRORCODE_UNSUPPORTED);
+}
+
+void MoonShare_Close(MOONSHARE_T *pShare)
+{
+  UNUSED(pShare);
+  return;
+}
+
+ERRORCODE_T MoonShare_Write(MOONSHARE_T *pShare,MOONSHAREDATA_T const *pData)
+{
+  UNUSED(pShare);
+  UNUSED(pData);
+  return(ERRORCODE_UNSUPPORTED);
+}
+
+ERRORCODE_T MoonShare_Read(MOONSHARE_T *pShare,MOONSHAREDATA_T *pData,
+    unsigned int *pSequence)
+{
+  UNUSED(pShare);
+  UNUSED(pData);
+  UNUSED(pSequence);
+  return(ERRORCODE_UNSUPPORTED);
+}
+
+#endif    /* _WIN32 */
+
+
+#undef    MOONSHARE_C
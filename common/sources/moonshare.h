@@ -0,0 +1,333 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moonshare.h
+*** \brief Shared memory publication of the moon data.
+*** \details Publishes a snapshot of the moon data (MOONSHAREDATA_T, a
+***   stable and versioned view of MOONDATA_T) in a POSIX shared memory
+***   segment, so that other processes (panel applets, scripts, monitoring
+***   agents) can read it without computing it. The segment is protected by
+***   a sequence lock: the writer makes the sequence odd while it copies a
+***   snapshot in, and even again once it is done; a reader copies the
+***   snapshot out and retries if the sequence was odd or changed meanwhile.
+***   Reading takes no locks and no system calls (unless the writer is
+***   preempted in the middle of a publication, then the reader yields).
+***
+***   This module depends only on the C library (and -lrt with older C
+***   libraries), it is built as the moonphaseshare library for readers.
+**/
+
+
+#ifndef   MOONSHARE_H
+#define   MOONSHARE_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "errorcode.h"
+#include  "structure.h"
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Magic.
+*** \details Magic of a valid segment ("MPSH").
+**/
+#define   MOONSHARE_MAGIC         (0x4853504DUL)
+
+/**
+*** \brief Version.
+*** \details Version of MOONSHAREDATA_T. Fields are only ever added to the
+***   end, with a new version.
+**/
+#define   MOONSHARE_VERSION       (1)
+
+/**
+*** \brief Segment name.
+*** \details Prefix of the default segment name; the user id is appended
+***   ("/moonphase-1000"), so each user has a segment of their own.
+**/
+#define   MOONSHARE_NAMEPREFIX    "/moonphase-"
+
+/**
+*** \brief Name size.
+*** \details Maximum size of a segment name (including the terminator).
+**/
+#define   MOONSHARE_NAMESIZE      (64)
+
+/**
+*** \brief No event.
+*** \details Rise or set time of a day on which the moon does not rise (or
+***   set).
+**/
+#define   MOONSHARE_NOEVENT       (-999.0)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Published data.
+*** \details The moon data as published. All times are in the local time
+***   of the publisher.
+**/
+typedef struct structMOONSHAREDATA
+{
+  /**
+  *** \brief Time.
+  *** \details Time of the data (in seconds since 1970-01-01 UTC).
+  **/
+  double UTC;
+  /**
+  *** \brief Latitude.
+  *** \details Observer latitude (in degrees, north positive).
+  **/
+  double Latitude;
+  /**
+  *** \brief Longitude.
+  *** \details Observer longitude (in degrees, west positive as in CTrans).
+  **/
+  double Longitude;
+  /**
+  *** \brief Time zone.
+  *** \details Hours to add to local time to get UT.
+  **/
+  double TimeZone;
+  /**
+  *** \brief Right ascension.
+  *** \details Right ascension (in degrees).
+  **/
+  double RightAscension;
+  /**
+  *** \brief Declination.
+  *** \details Declination (in degrees).
+  **/
+  double Declination;
+  /**
+  *** \brief Altitude.
+  *** \details Altitude (in degrees).
+  **/
+  double Altitude;
+  /**
+  *** \brief Azimuth.
+  *** \details Azimuth (in degrees, as in CTrans).
+  **/
+  double Azimuth;
+  /**
+  *** \brief Phase.
+  *** \details Phase (0 new, 0.5 full, 1 new).
+  **/
+  double Phase;
+  /**
+  *** \brief Age.
+  *** \details Age (in days).
+  **/
+  double Age;
+  /**
+  *** \brief Distance.
+  *** \details Earth-moon distance (in earth radii).
+  **/
+  double Distance;
+  /**
+  *** \brief Rise/set times.
+  *** \details Yesterdays, todays and tomorrows rise and set times (in local
+  ***   hours), or MOONSHARE_NOEVENT.
+  **/
+  double pRiseSet[6];
+  /**
+  *** \brief Visible flag.
+  *** \details Non-zero if the moon is above the horizon.
+  **/
+  int VisibleFlag;
+  /**
+  *** \brief Accuracy tier.
+  *** \details Accuracy tier of the ephemeris (EPHEMTIER_*). The
+  ***   application publishes EPHEMTIER_ICON data while its dialogs are
+  ***   hidden; readers that need more than the phase should check it.
+  **/
+  int AccuracyTier;
+} MOONSHAREDATA_T;
+
+/**
+*** \brief Segment.
+*** \details Layout of the shared memory segment.
+**/
+typedef struct structMOONSHARESEGMENT
+{
+  /**
+  *** \brief Magic.
+  *** \details MOONSHARE_MAGIC, 0 once the writer has closed the segment.
+  **/
+  unsigned int Magic;
+  /**
+  *** \brief Version.
+  *** \details MOONSHARE_VERSION of the writer.
+  **/
+  unsigned int Version;
+  /**
+  *** \brief Data size.
+  *** \details Size of the data of the writer (in bytes).
+  **/
+  unsigned int DataSize;
+  /**
+  *** \brief Sequence.
+  *** \details Odd while a snapshot is being written, incremented twice by
+  ***   each publication (0 if nothing has been published yet).
+  **/
+  unsigned int Sequence;
+  /**
+  *** \brief Data.
+  *** \details Snapshot.
+  **/
+  MOONSHAREDATA_T Data;
+} MOONSHARESEGMENT_T;
+
+/**
+*** \brief Shared data handle.
+*** \details A mapping of the segment, for writing or for reading.
+**/
+typedef struct structMOONSHARE
+{
+  /**
+  *** \brief Segment.
+  *** \details Mapped segment, NULL if closed.
+  **/
+  MOONSHARESEGMENT_T *pSegment;
+  /**
+  *** \brief Writer flag.
+  *** \details Non-zero if the segment was created for writing.
+  **/
+  int WriterFlag;
+  /**
+  *** \brief Segment identity.
+  *** \details Device and inode of a created segment, so that closing only
+  ***   removes the name while it still refers to that segment.
+  **/
+  unsigned long Device;
+  unsigned long Inode;
+  /**
+  *** \brief Retry count.
+  *** \details Number of times a read had to be retried (reader only).
+  **/
+  unsigned long RetryCount;
+  /**
+  *** \brief Name.
+  *** \details Segment name.
+  **/
+  char pName[MOONSHARE_NAMESIZE];
+} MOONSHARE_T;
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+#ifdef  __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+STRUCTURE_PROTOTYPE_INITIALIZE(MoonShare,MOONSHARE_T);
+STRUCTURE_PROTOTYPE_UNINITIALIZE(MoonShare,MOONSHARE_T);
+/**
+*** \brief Creates the segment.
+*** \details Creates the segment and maps it for writing. A segment of the
+***   same name left by an earlier run (or another instance) of the same
+***   user is replaced; one that belongs to another user is never used.
+*** \param pShare Pointer to the handle.
+*** \param pName Segment name, NULL for the default name of the user.
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T MoonShare_Create(MOONSHARE_T *pShare,char const *pName);
+/**
+*** \brief Opens the segment.
+*** \details Maps an existing segment for reading.
+*** \param pShare Pointer to the handle.
+*** \param pName Segment name, NULL for the default name of the user.
+*** \retval >0 Success.
+*** \retval <0 Failure (ERRORCODE_SYSTEMFAILURE if there is no segment,
+***   ERRORCODE_INVALIDDATA if its version is unknown).
+**/
+ERRORCODE_T MoonShare_Open(MOONSHARE_T *pShare,char const *pName);
+/**
+*** \brief Closes the segment.
+*** \details Unmaps the segment. A writer also marks it closed and removes
+***   its name, unless the name has since been taken by another segment;
+***   readers that still have it mapped then get ERRORCODE_INVALIDDATA.
+*** \param pShare Pointer to the handle.
+**/
+void MoonShare_Close(MOONSHARE_T *pShare);
+/**
+*** \brief Publishes a snapshot.
+*** \details Copies a snapshot into the segment.
+*** \param pShare Pointer to a handle created with MoonShare_Create().
+*** \param pData Snapshot.
+*** \retval >0 Success.
+*** \retval <0 Failure.
+**/
+ERRORCODE_T MoonShare_Write(MOONSHARE_T *pShare,MOONSHAREDATA_T const *pData);
+/**
+*** \brief Reads the snapshot.
+*** \details Copies a consistent snapshot out of the segment.
+*** \param pShare Pointer to a handle opened with MoonShare_Open().
+*** \param pData Storage for the snapshot.
+*** \param pSequence Storage for the sequence of the snapshot (to tell a
+***   new one from the last one read), or NULL.
+*** \retval >0 Success.
+*** \retval <0 Failure (ERRORCODE_INVALIDDATA if nothing has been
+***   published yet or the writer closed the segment,
+***   ERRORCODE_SYSTEMFAILURE if a publication never completed).
+**/
+ERRORCODE_T MoonShare_Read(MOONSHARE_T *pShare,MOONSHAREDATA_T *pData,
+    unsigned int *pSequence);
+
+#ifdef  __cplusplus
+}
+#endif  /* __cplusplus */
+
+
+#endif    /* MOONSHARE_H */
@@ -0,0 +1,154 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file lunationtablegenerator.c
+*** \brief Lunation table generator.
+*** \details Build time tool that solves Moon() for every new moon, first
+***   quarter, full moon and last quarter from 1900 to 2100 and writes them
+***   as a C header (lunationtable.h) for lunation.c. Linked with a copy of
+***   calcephem.c built with CALCEPHEM_NOLUNATIONTABLE.
+**/
+
+
+/** Identifier for lunationtablegenerator.c. **/
+#define   LUNATIONTABLEGENERATOR_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "lunation.h"
+
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief First instant.
+*** \details 1900-01-01 0h (in Julian centuries (TDT) since J2000).
+**/
+#define   TABLE_FIRST           ((2415020.5-2451545.0)/36525.0)
+
+/**
+*** \brief Last instant.
+*** \details 2100-01-01 0h (in Julian centuries (TDT) since J2000).
+**/
+#define   TABLE_LAST            ((2488069.5-2451545.0)/36525.0)
+
+/**
+*** \brief Solver tolerance.
+*** \details Convergence limit of MoonPhaseEvent() (in Julian centuries,
+***   about 3 ms).
+**/
+#define   SOLVER_TOLERANCE      (1e-12)
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Program entry.
+*** \details Writes the table to the file named on the command line.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  FILE *pFile;
+  double Lambda;
+  double Beta;
+  double Distance;
+  double Age;
+  double T;
+  double pEvents[LUNATIONPHASE_COUNT];
+  long Count;
+  int Phase;
+
+
+  if (ArgC!=2)
+  {
+    fprintf(stderr,"Usage: %s <output pathname>\n",ppArgV[0]);
+    return(1);
+  }
+  pFile=fopen(ppArgV[1],"w");
+  if (pFile==NULL)
+  {
+    perror(ppArgV[1]);
+    return(1);
+  }
+
+  /* First new moon on or after the start. */
+  Moon(TABLE_FIRST,&Lambda,&Beta,&Distance,&Age);
+  T=MoonPhaseEvent(TABLE_FIRST+(LUNATION_SYNODICMONTH-Age)/36525.0,
+      0.0,SOLVER_TOLERANCE);
+  if (T<TABLE_FIRST)
+    T=MoonPhaseEvent(T+LUNATION_SYNODICMONTH/36525.0,0.0,SOLVER_TOLERANCE);
+
+  fprintf(pFile,
+      "/*\n"
+      "** Generated by lunationtablegenerator. Do not edit.\n"
+      "** One row per lunation: new moon, first quarter, full moon and last\n"
+      "** quarter (in Julian centuries (TDT) since J2000).\n"
+      "*/\n\n");
+  fprintf(pFile,"static double const f_pLunationTable[][%d]=\n{\n",
+      LUNATIONPHASE_COUNT);
+  for(Count=0;;Count++)
+  {
+    /* Each event starts from the previous one plus a mean quarter. */
+    pEvents[LUNATIONPHASE_NEWMOON]=T;
+    for(Phase=1;Phase<LUNATIONPHASE_COUNT;Phase++)
+      pEvents[Phase]=MoonPhaseEvent(
+          pEvents[Phase-1]+0.25*LUNATION_SYNODICMONTH/36525.0,
+          0.25*Phase,SOLVER_TOLERANCE);
+    if (pEvents[LUNATIONPHASE_LASTQUARTER]>TABLE_LAST)
+      break;
+    fprintf(pFile,"  { %.17g, %.17g, %.17g, %.17g },\n",
+        pEvents[0],pEvents[1],pEvents[2],pEvents[3]);
+    T=MoonPhaseEvent(
+        pEvents[LUNATIONPHASE_LASTQUARTER]+0.25*LUNATION_SYNODICMONTH/36525.0,
+        0.0,SOLVER_TOLERANCE);
+  }
+  fprintf(pFile,"};\n\n");
+  fprintf(pFile,"#define   LUNATIONTABLE_LUNATIONCOUNT   (%ld)\n",Count);
+
+  if (fclose(pFile)!=0)
+  {
+    perror(ppArgV[1]);
+    return(1);
+  }
+
+  return(0);
+}
+
+
+#undef    LUNATIONTABLEGENERATOR_C
@@ -0,0 +1,411 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file ephemeris.c
+*** \brief Ephemeris file generator.
+*** \details Writes the moon cache segments (see mooncache.h) covering a
+***   range of years to an ephemeris file (see ephemfile.h), or verifies an
+***   existing file. When built with mhash, an MD5 of the whole file is also
+***   written to (and checked against) pathname.md5.
+***   Usage: moonphase-ephemeris first-year last-year file
+***          moonphase-ephemeris -v file
+**/
+
+
+/** Identifier for ephemeris.c. **/
+#define   EPHEMERIS_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "mooncache.h"
+#include  "daynumber.h"
+#include  "errorcode.h"
+#ifdef    USE_MHASH
+#include  "checksum.h"
+#endif    /* USE_MHASH */
+
+#include  <math.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Margin.
+*** \details Segments added at both ends of the range, so that times near
+***   the ends are covered whatever the time scale.
+**/
+#define   MARGIN_SEGMENTS     (1)
+
+/**
+*** \brief Checksum suffix.
+*** \details Suffix of the MD5 file.
+**/
+#define   CHECKSUM_SUFFIX     ".md5"
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Fit statistics.
+*** \details Data passed to Fit().
+**/
+typedef struct structFITDATA
+{
+  /**
+  *** \brief Fit error.
+  *** \details Largest fit error of each quantity.
+  **/
+  double pMaximumError[MOONCACHEQUANTITY_COUNT];
+} FITDATA_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static void Usage(char const *pProgram);
+static void Fit(long Index,double *pCoefficients,void *pData);
+static int WriteChecksum(char const *pPathname);
+static int CheckChecksum(char const *pPathname);
+static int Generate(int FirstYear,int LastYear,char const *pPathname);
+static int Verify(char const *pPathname);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Quantity names.
+*** \details Names of the quantities (MOONCACHEQUANTITY_E) and their units.
+**/
+static char const *f_ppQuantityNames[MOONCACHEQUANTITY_COUNT]=
+{
+  "longitude (degrees)",
+  "latitude (degrees)",
+  "distance (earth radii)",
+  "phase"
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Prints the usage.
+*** \details Prints the command line syntax to stderr.
+*** \param pProgram Program name.
+**/
+static void Usage(char const *pProgram)
+{
+  fprintf(stderr,
+      "Usage: %s first-year last-year file\n"
+      "       %s -v file\n"
+      "Writes the moon ephemeris of the years (both included) to the file,\n"
+      "or with -v verifies the checksums of an existing file.\n",
+      pProgram,pProgram);
+  return;
+}
+
+/**
+*** \brief Fits a segment.
+*** \details EPHEMFILEFIT_F callback, fits a segment and keeps track of
+***   the fit error.
+*** \param Index Segment index.
+*** \param pCoefficients Storage for the coefficients.
+*** \param pData Pointer to the fit statistics (FITDATA_T).
+**/
+static void Fit(long Index,double *pCoefficients,void *pData)
+{
+  FITDATA_T *pFitData;
+  double pError[MOONCACHEQUANTITY_COUNT];
+  int Quantity;
+
+
+  pFitData=(FITDATA_T *)pData;
+  MoonCache_FitSegment(Index,
+      (double (*)[MOONCACHE_COEFFICIENTCOUNT])pCoefficients,pError);
+  for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+    if (pError[Quantity]>pFitData->pMaximumError[Quantity])
+      pFitData->pMaximumError[Quantity]=pError[Quantity];
+  return;
+}
+
+/**
+*** \brief Writes the MD5 file.
+*** \details Writes the MD5 of a file to pathname.md5, in md5sum format.
+***   Does nothing without mhash.
+*** \param pPathname Pathname of the file.
+*** \retval 0 Success.
+*** \retval 1 Failure (a message has been printed).
+**/
+static int WriteChecksum(char const *pPathname)
+{
+#ifdef    USE_MHASH
+  char *pChecksum;
+  char *pChecksumPathname;
+  char const *pName;
+  FILE *pFile;
+  int Result;
+
+
+  Result=1;
+  pChecksumPathname=(char *)malloc(strlen(pPathname)+sizeof(CHECKSUM_SUFFIX));
+  if (pChecksumPathname==NULL)
+    fprintf(stderr,"Out of memory.\n");
+  else if (Checksum_Calculate(pPathname,CHECKSUMTYPE_MD5,&pChecksum)<0)
+    fprintf(stderr,"Unable to checksum \"%s\".\n",pPathname);
+  else
+  {
+    sprintf(pChecksumPathname,"%s%s",pPathname,CHECKSUM_SUFFIX);
+    pName=strrchr(pPathname,'/');
+    pName=(pName==NULL) ? pPathname : pName+1;
+    pFile=fopen(pChecksumPathname,"w");
+    if ( (pFile!=NULL) &&
+        (fprintf(pFile,"%s  %s\n",pChecksum,pName)>0) &&
+        (fclose(pFile)==0) )
+      Result=0;
+    else
+      fprintf(stderr,"Unable to write \"%s\".\n",pChecksumPathname);
+    free(pChecksum);
+  }
+  free(pChecksumPathname);
+  return(Result);
+#else     /* USE_MHASH */
+  UNUSED(pPathname);
+
+
+  return(0);
+#endif    /* USE_MHASH */
+}
+
+/**
+*** \brief Checks the MD5 file.
+*** \details Compares the MD5 of a file with pathname.md5, if there is one.
+***   Does nothing without mhash.
+*** \param pPathname Pathname of the file.
+*** \retval 0 Success (or no MD5 file).
+*** \retval 1 Mismatch (a message has been printed).
+**/
+static int CheckChecksum(char const *pPathname)
+{
+#ifdef    USE_MHASH
+  char pExpected[64];
+  char *pChecksum;
+  char *pChecksumPathname;
+  FILE *pFile;
+  int Result;
+
+
+  Result=0;
+  pChecksumPathname=(char *)malloc(strlen(pPathname)+sizeof(CHECKSUM_SUFFIX));
+  if (pChecksumPathname==NULL)
+  {
+    fprintf(stderr,"Out of memory.\n");
+    return(1);
+  }
+  sprintf(pChecksumPathname,"%s%s",pPathname,CHECKSUM_SUFFIX);
+  pFile=fopen(pChecksumPathname,"r");
+  if (pFile!=NULL)
+  {
+    if ( (fscanf(pFile,"%63s",pExpected)!=1) ||
+        (Checksum_Calculate(pPathname,CHECKSUMTYPE_MD5,&pChecksum)<0) )
+      Result=1;
+    else
+    {
+      Result=(strcmp(pChecksum,pExpected)!=0);
+      free(pChecksum);
+    }
+    fclose(pFile);
+    if (Result!=0)
+      fprintf(stderr,"\"%s\" does not match \"%s\".\n",
+          pPathname,pChecksumPathname);
+    else
+      fprintf(stderr,"MD5 matches \"%s\".\n",pChecksumPathname);
+  }
+  free(pChecksumPathname);
+  return(Result);
+#else     /* USE_MHASH */
+  UNUSED(pPathname);
+
+
+  return(0);
+#endif    /* USE_MHASH */
+}
+
+/**
+*** \brief Generates a file.
+*** \details Writes the segments covering the years to a file.
+*** \param FirstYear First year.
+*** \param LastYear Last year (included).
+*** \param pPathname Pathname of the file.
+*** \retval 0 Success.
+*** \retval 1 Failure (a message has been printed).
+**/
+static int Generate(int FirstYear,int LastYear,char const *pPathname)
+{
+  FITDATA_T FitData;
+  ERRORCODE_T ErrorCode;
+  double FirstJD;
+  double LastJD;
+  long FirstSegment;
+  long SegmentCount;
+  clock_t Start;
+  int Quantity;
+
+
+  /* Day numbers are Julian day numbers, so 0h is half a day earlier. */
+  FirstJD=DayNumber_FromDate(FirstYear,1,1)-0.5;
+  LastJD=DayNumber_FromDate(LastYear+1,1,1)-0.5;
+  FirstSegment=(long)floor((FirstJD-2451545.0)/MOONCACHE_SEGMENTDAYS)-
+      MARGIN_SEGMENTS;
+  SegmentCount=(long)floor((LastJD-2451545.0)/MOONCACHE_SEGMENTDAYS)+
+      MARGIN_SEGMENTS-FirstSegment+1;
+
+  memset(&FitData,0,sizeof(FitData));
+  Start=clock();
+  ErrorCode=EphemFile_Write(pPathname,MOONCACHEQUANTITY_COUNT,
+      MOONCACHE_COEFFICIENTCOUNT,MOONCACHE_SEGMENTDAYS,
+      FirstSegment,SegmentCount,Fit,&FitData);
+  if (ErrorCode==ERRORCODE_INVALIDPARAMETER)
+  {
+    fprintf(stderr,"The range is too large.\n");
+    return(1);
+  }
+  else if (ErrorCode<0)
+  {
+    fprintf(stderr,"Unable to write \"%s\".\n",pPathname);
+    return(1);
+  }
+
+  fprintf(stderr,"%ld segments in %.3f seconds.\n",
+      SegmentCount,(double)(clock()-Start)/CLOCKS_PER_SEC);
+  for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+    fprintf(stderr,"Largest %s error: %.3g\n",
+        f_ppQuantityNames[Quantity],FitData.pMaximumError[Quantity]);
+  return(WriteChecksum(pPathname));
+}
+
+/**
+*** \brief Verifies a file.
+*** \details Checks the header and every segment of a file.
+*** \param pPathname Pathname of the file.
+*** \retval 0 Success.
+*** \retval 1 Failure (a message has been printed).
+**/
+static int Verify(char const *pPathname)
+{
+  EPHEMFILE_T File;
+  MOONCACHE_T Cache;
+  ERRORCODE_T ErrorCode;
+  int Result;
+
+
+  Result=1;
+  if ( (EphemFile_Initialize(&File)<0) || (MoonCache_Initialize(&Cache)<0) )
+    fprintf(stderr,"Unable to initialize.\n");
+  else
+  {
+    ErrorCode=EphemFile_Open(&File,pPathname);
+    if (ErrorCode==ERRORCODE_INVALIDDATA)
+      fprintf(stderr,"\"%s\" is not a valid ephemeris file.\n",pPathname);
+    else if (ErrorCode<0)
+      fprintf(stderr,"Unable to read \"%s\".\n",pPathname);
+    else if (MoonCache_SetFile(&Cache,&File)<0)
+      fprintf(stderr,"\"%s\" does not hold moon cache segments.\n",
+          pPathname);
+    else
+    {
+      fprintf(stderr,"JD %.1f to %.1f, %u segments of %g days.\n",
+          File.pHeader->FirstJD,File.pHeader->LastJD,
+          File.pHeader->SegmentCount,File.pHeader->SegmentDays);
+      if (EphemFile_Verify(&File)<0)
+        fprintf(stderr,"%lu of %lu segments are corrupt.\n",
+            File.InvalidCount,File.CheckCount);
+      else
+      {
+        fprintf(stderr,"All segments are valid.\n");
+        Result=CheckChecksum(pPathname);
+      }
+    }
+    MoonCache_Uninitialize(&Cache);
+    EphemFile_Uninitialize(&File);
+  }
+  return(Result);
+}
+
+/**
+*** \brief Program entry.
+*** \details Generates or verifies an ephemeris file.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  int FirstYear;
+  int LastYear;
+
+
+  if ( (ArgC==3) && (strcmp(ppArgV[1],"-v")==0) )
+    return(Verify(ppArgV[2]));
+
+  if ( (ArgC!=4) || (sscanf(ppArgV[1],"%d",&FirstYear)!=1) ||
+      (sscanf(ppArgV[2],"%d",&LastYear)!=1) || (LastYear<FirstYear) )
+  {
+    Usage(ppArgV[0]);
+    return(1);
+  }
+  return(Generate(FirstYear,LastYear,ppArgV[3]));
+}
+
+
+#undef    EPHEMERIS_C
@@ -452,6 +452,15 @@ CONTROLPANELDIALOG_C::CONTROLPANELDIALOG_C(QWidget *pParent) : QDialog(pParent)
   if (ErrorCode<0)
     throw(ErrorCode);
 
+  /* Publish the moon data for other processes. Not fatal if it fails. */
+  ErrorCode=MoonShare_Initialize(&m_MoonShare);
+  MESSAGELOG_LogError(ErrorCode);
+  if (ErrorCode>0)
+  {
+    ErrorCode=MoonShare_Create(&m_MoonShare,NULL);
+    MESSAGELOG_LogError(ErrorCode);
+  }
+
   /* Read configuration. */
   m_pSettings->Load();
 
@@ -583,6 +592,8 @@ CONTROLPANELDIALOG_C::~CONTROLPANELDIALOG_C(void)
   MESSAGELOG_LogError(ErrorCode);
   ErrorCode=MoonAnimation_Uninitialize(&m_MoonTrayImages);
   MESSAGELOG_LogError(ErrorCode);
+  ErrorCode=MoonShare_Uninitialize(&m_MoonShare);
+  MESSAGELOG_LogError(ErrorCode);
 
   DEBUGLOG_LogOut();
   return;
@@ -900,9 +911,18 @@ void CONTROLPANELDIALOG_C::ReadPreferences(SETTINGS_C *pSettings)
 
 void CONTROLPANELDIALOG_C::RecalculateMoonData(time_t Time)
 {
+  MOONSHAREDATA_T ShareData;
+
+
   DEBUGLOG_Printf1("CONTROLPANELDIALOG_C::RecalculateMoonData(%1)",time);
   DEBUGLOG_LogIn();
 
+  /* Only the full data is shown in the dialogs, the icon needs the phase. */
+  if ( (isVisible()==true) || (m_pInformationPanelDialog->isVisible()==true) )
+    m_MoonData.AccuracyTier=EPHEMTIER_PRECISE;
+  else
+    m_MoonData.AccuracyTier=EPHEMTIER_ICON;
+
   /* Recalculate the astronomical data. */
 #ifdef    DEBUG
   if (m_DateTimeOverrideFlag==true)
@@ -911,6 +931,11 @@ void CONTROLPANELDIALOG_C::RecalculateMoonData(time_t Time)
 #endif    /* DEBUG */
     MoonData_Recalculate(&m_MoonData,Time);
 
+  /* Publish it (ignored if the shared memory could not be created). The
+      snapshot carries the tier it was computed at. */
+  MoonData_GetShareData(&m_MoonData,&ShareData);
+  MoonShare_Write(&m_MoonShare,&ShareData);
+
   DEBUGLOG_LogOut();
   return;
 }
@@ -1362,7 +1387,7 @@ void CONTROLPANELDIALOG_C::LatitudeChangedSlot(double Latitude)
   DEBUGLOG_LogIn();
 
   m_MoonData.CTransData.Glat=Latitude;
-  MoonData_Recalculate(&m_MoonData,time(NULL));
+  RecalculateMoonData(time(NULL));
   PreferencesChangedSlot();
 
   DEBUGLOG_LogOut();
@@ -1375,7 +1400,7 @@ void CONTROLPANELDIALOG_C::LongitudeChangedSlot(double Longitude)
   DEBUGLOG_LogIn();
 
   m_MoonData.CTransData.Glon=-Longitude;
-  MoonData_Recalculate(&m_MoonData,time(NULL));
+  RecalculateMoonData(time(NULL));
   PreferencesChangedSlot();
 
   DEBUGLOG_LogOut();
@@ -196,7 +196,8 @@ class CONTROLPANELDIALOG_C : public QDialog, public Ui::CONTROLPANELDIALOGUI_C
 
     /**
     *** \brief Recalculates moon data.
-    *** \details Recalculates the moon data for a specific time.
+    *** \details Recalculates the moon data for a specific time and
+    ***   publishes it.
     *** \param Time Time to use for calculations.
     **/
     void RecalculateMoonData(time_t Time);
@@ -415,6 +416,13 @@ class CONTROLPANELDIALOG_C : public QDialog, public Ui::CONTROLPANELDIALOGUI_C
     **/
     MOONDATA_T m_MoonData;
 
+    /**
+    *** \brief Published moon data.
+    *** \details Shared memory the moon data is published in after each
+    ***   recalculation, for other processes to read.
+    **/
+    MOONSHARE_T m_MoonShare;
+
     /**
     *** \brief Tray icon.
     *** \details The images displayed in the tray icon.
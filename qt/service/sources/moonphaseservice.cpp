@@ -0,0 +1,305 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moonphaseservice.cpp
+*** \brief moonphase-service operating system entry point.
+*** \details Operating system entry point for moonphase-service. Runs the
+***   query server (see queryserver.h) as a daemon (or Windows service),
+***   answering moon data queries on a local socket.
+**/
+
+
+/** Identifier for moonphaseservice.cpp. **/
+#define   MOONPHASESERVICE_CPP
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "config.h"
+#if       defined(DEBUG_MOONPHASESERVICE_CPP)
+#if       !defined(USE_DEBUGLOG)
+#define   USE_DEBUGLOG
+#endif    /* !defined(USE_DEBUGLOG) */
+#endif    /* defined(DEBUG_MOONPHASESERVICE_CPP) */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  "errorcode.h"
+#include  "queryserver.h"
+#include  "QtService"
+
+#include  <QCoreApplication>
+
+#include  <stdlib.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Moon data service.
+*** \details Starts, pauses, resumes and stops the query server on requests
+***   from the service manager.
+**/
+class MOONPHASESERVICE_C : public QtService<QCoreApplication>
+{
+  public:
+    /**
+    *** \brief Constructor.
+    *** \details Constructor.
+    *** \param ArgC Number of command line arguments.
+    *** \param ppArgV Pointer to array of command line argument strings.
+    **/
+    MOONPHASESERVICE_C(int ArgC,char *ppArgV[]);
+
+    /**
+    *** \brief Destructor.
+    *** \details Destructor.
+    **/
+    ~MOONPHASESERVICE_C(void);
+
+  protected:
+    /**
+    *** \brief Starts the service.
+    *** \details Creates the query server and starts listening.
+    **/
+    void start(void);
+
+    /**
+    *** \brief Stops the service.
+    *** \details Deletes the query server.
+    **/
+    void stop(void);
+
+    /**
+    *** \brief Pauses the service.
+    *** \details Leaves requests unanswered.
+    **/
+    void pause(void);
+
+    /**
+    *** \brief Resumes the service.
+    *** \details Answers requests again.
+    **/
+    void resume(void);
+
+  private:
+    /**
+    *** \brief Query server.
+    *** \details Query server, NULL if the service is not running.
+    **/
+    QUERYSERVER_C *m_pServer;
+};
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+MOONPHASESERVICE_C::MOONPHASESERVICE_C(int ArgC,char *ppArgV[])
+    : QtService<QCoreApplication>(ArgC,ppArgV,MOONPHASESERVICE_DISPLAYNAME)
+{
+  DEBUGLOG_Printf2("MOONPHASESERVICE_C::MOONPHASESERVICE_C(%d,%p)",
+      ArgC,ppArgV);
+  DEBUGLOG_LogIn();
+
+  m_pServer=NULL;
+  setServiceDescription(MOONPHASESERVICE_DESCRIPTION);
+  setServiceFlags(QtServiceBase::CanBeSuspended);
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+MOONPHASESERVICE_C::~MOONPHASESERVICE_C(void)
+{
+  DEBUGLOG_Printf0("MOONPHASESERVICE_C::~MOONPHASESERVICE_C()");
+  DEBUGLOG_LogIn();
+
+  delete m_pServer;
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void MOONPHASESERVICE_C::start(void)
+{
+  QString Name;
+  char const *pName;
+
+
+  DEBUGLOG_Printf0("MOONPHASESERVICE_C::start()");
+  DEBUGLOG_LogIn();
+
+  QCoreApplication::setApplicationName(MOONPHASESERVICE_EXECUTABLENAME);
+  QCoreApplication::setOrganizationName(MOONPHASESERVICE_OWNER);
+
+  pName=getenv("MOONPHASE_QUERYSOCKET");
+  if ( (pName!=NULL) && (pName[0]!=0) )
+    Name=QString::fromLocal8Bit(pName);
+  else
+    Name=MOONQUERY_SOCKETPATHNAME;
+
+  try
+  {
+    m_pServer=new QUERYSERVER_C();
+    if (m_pServer->Listen(Name)==false)
+    {
+      logMessage(QString("Unable to listen on %1.").arg(Name),
+          QtServiceBase::Error);
+      delete m_pServer;
+      m_pServer=NULL;
+      application()->quit();
+    }
+  }
+  catch(ERRORCODE_T const &EC)
+  {
+    MESSAGELOG_LogError(EC);
+    m_pServer=NULL;
+    application()->quit();
+  }
+  catch(std::bad_alloc const &BadAllocation)
+  {
+    MESSAGELOG_LogError(ERRORCODE_OUTOFMEMORY);
+    m_pServer=NULL;
+    application()->quit();
+  }
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void MOONPHASESERVICE_C::stop(void)
+{
+  DEBUGLOG_Printf0("MOONPHASESERVICE_C::stop()");
+  DEBUGLOG_LogIn();
+
+  delete m_pServer;
+  m_pServer=NULL;
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void MOONPHASESERVICE_C::pause(void)
+{
+  DEBUGLOG_Printf0("MOONPHASESERVICE_C::pause()");
+  DEBUGLOG_LogIn();
+
+  if (m_pServer!=NULL)
+    m_pServer->Pause();
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void MOONPHASESERVICE_C::resume(void)
+{
+  DEBUGLOG_Printf0("MOONPHASESERVICE_C::resume()");
+  DEBUGLOG_LogIn();
+
+  if (m_pServer!=NULL)
+    m_pServer->Resume();
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+/**
+*** \brief Service starting point.
+*** \details Operating system entry function for the service. Installs,
+***   controls or runs the service depending on the command line (see
+***   QtServiceBase, -h lists the options).
+*** \param ArgC Number of command line arguments.
+*** \param ppArgV Pointer to array of command line argument strings.
+*** \retval 0 Success.
+*** \retval !0 Error.
+**/
+int main(int ArgC, char *ppArgV[])
+{
+  int Return;
+
+
+  /* Initialize the debug and message logs (possibly, depends on defines). */
+  DEBUGLOG_Initialize(!0);
+  MESSAGELOG_Initialize();
+
+  DEBUGLOG_Printf2("main(%d,%p)",ArgC,ppArgV);
+  DEBUGLOG_LogIn();
+
+  try
+  {
+    MOONPHASESERVICE_C Service(ArgC,ppArgV);
+
+    Return=Service.exec();
+  }
+  catch(ERRORCODE_T const &EC)
+  {
+    MESSAGELOG_LogError(EC);
+    Return=EXIT_FAILURE;
+  }
+  catch(std::bad_alloc const &BadAllocation)
+  {
+    MESSAGELOG_LogError(ERRORCODE_OUTOFMEMORY);
+    Return=EXIT_FAILURE;
+  }
+
+  DEBUGLOG_LogOut();
+  return(Return);
+}
+
+
+#undef    MOONPHASESERVICE_CPP
@@ -0,0 +1,265 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file queryserver.cpp
+*** \brief queryserver.h implementation.
+*** \details Implementation file for queryserver.h.
+**/
+
+
+/** Identifier for queryserver.cpp. **/
+#define   QUERYSERVER_CPP
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "queryserver.h"
+#if       defined(DEBUG_QUERYSERVER_CPP)
+#if       !defined(USE_DEBUGLOG)
+#define   USE_DEBUGLOG
+#endif    /* !defined(USE_DEBUGLOG) */
+#endif    /* defined(DEBUG_QUERYSERVER_CPP) */
+#include  "debuglog.h"
+#include  "messagelog.h"
+
+#include  <QLocalServer>
+#include  <QLocalSocket>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+QUERYSERVER_C::QUERYSERVER_C(QObject *pParent)
+    : QObject(pParent)
+{
+  ERRORCODE_T ErrorCode;
+
+
+  DEBUGLOG_Printf1("QUERYSERVER_C::QUERYSERVER_C(%p)",pParent);
+  DEBUGLOG_LogIn();
+
+  m_pServer=NULL;
+  m_PausedFlag=false;
+
+  ErrorCode=MoonQuery_Initialize(&m_Query);
+  MESSAGELOG_LogError(ErrorCode);
+  if (ErrorCode<0)
+    throw(ErrorCode);
+
+  m_pServer=new QLocalServer(this);
+  connect(m_pServer,SIGNAL(newConnection()),this,SLOT(NewConnectionSlot()));
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+QUERYSERVER_C::~QUERYSERVER_C(void)
+{
+  DEBUGLOG_Printf0("QUERYSERVER_C::~QUERYSERVER_C()");
+  DEBUGLOG_LogIn();
+
+  m_pServer->close();
+  MoonQuery_Uninitialize(&m_Query);
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+bool QUERYSERVER_C::Listen(QString const &Name)
+{
+  bool Flag;
+
+
+  DEBUGLOG_Printf2("QUERYSERVER_C::Listen(%p(%s))",&Name,qPrintable(Name));
+  DEBUGLOG_LogIn();
+
+  /* A socket left behind by a crashed server would make listen() fail. */
+  QLocalServer::removeServer(Name);
+  Flag=m_pServer->listen(Name);
+  if (Flag==false)
+    MESSAGELOG_Error(qPrintable(m_pServer->errorString()));
+
+  DEBUGLOG_LogOut();
+  return(Flag);
+}
+
+void QUERYSERVER_C::Pause(void)
+{
+  DEBUGLOG_Printf0("QUERYSERVER_C::Pause()");
+  DEBUGLOG_LogIn();
+
+  m_PausedFlag=true;
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void QUERYSERVER_C::Resume(void)
+{
+  QList<QLocalSocket*> Sockets;
+  int Index;
+
+
+  DEBUGLOG_Printf0("QUERYSERVER_C::Resume()");
+  DEBUGLOG_LogIn();
+
+  m_PausedFlag=false;
+
+  /* Answer what arrived in the meantime (the readyRead() signals are gone). */
+  Sockets=m_pServer->findChildren<QLocalSocket*>();
+  for(Index=0;Index<Sockets.count();Index++)
+    AnswerClient(Sockets[Index]);
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void QUERYSERVER_C::NewConnectionSlot(void)
+{
+  QLocalSocket *pSocket;
+
+
+  DEBUGLOG_Printf0("QUERYSERVER_C::NewConnectionSlot()");
+  DEBUGLOG_LogIn();
+
+  while((pSocket=m_pServer->nextPendingConnection())!=NULL)
+  {
+    connect(pSocket,SIGNAL(readyRead()),this,SLOT(ReadyReadSlot()));
+    connect(pSocket,SIGNAL(disconnected()),this,SLOT(DisconnectedSlot()));
+  }
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void QUERYSERVER_C::ReadyReadSlot(void)
+{
+  QLocalSocket *pSocket;
+
+
+  DEBUGLOG_Printf0("QUERYSERVER_C::ReadyReadSlot()");
+  DEBUGLOG_LogIn();
+
+  pSocket=qobject_cast<QLocalSocket*>(sender());
+  if (pSocket!=NULL)
+    AnswerClient(pSocket);
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void QUERYSERVER_C::DisconnectedSlot(void)
+{
+  QLocalSocket *pSocket;
+
+
+  DEBUGLOG_Printf0("QUERYSERVER_C::DisconnectedSlot()");
+  DEBUGLOG_LogIn();
+
+  pSocket=qobject_cast<QLocalSocket*>(sender());
+  if (pSocket!=NULL)
+    pSocket->deleteLater();
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+void QUERYSERVER_C::AnswerClient(QLocalSocket *pSocket)
+{
+  MOONQUERYHEADER_T Header;
+  qint64 Size;
+  ERRORCODE_T ErrorCode;
+
+
+  DEBUGLOG_Printf1("QUERYSERVER_C::AnswerClient(%p)",pSocket);
+  DEBUGLOG_LogIn();
+
+  /* Answer every complete batch, a client may send several at once. */
+  while( (m_PausedFlag==false) &&
+      (pSocket->bytesAvailable()>=(qint64)sizeof(Header)) )
+  {
+    pSocket->peek((char*)&Header,sizeof(Header));
+    if ( (Header.Magic!=MOONQUERY_MAGIC) ||
+        (Header.Count>MOONQUERY_MAXBATCH) )
+    {
+      MESSAGELOG_Error("Invalid batch.");
+      pSocket->abort();
+      break;
+    }
+    Size=Header.Count*(qint64)sizeof(MOONQUERYREQUEST_T);
+    if (pSocket->bytesAvailable()<(qint64)sizeof(Header)+Size)
+      break;      // Wait for the rest of the batch.
+
+    pSocket->read((char*)&Header,sizeof(Header));
+    pSocket->read((char*)m_pRequests,Size);
+    ErrorCode=MoonQuery_Answer(&m_Query,m_pRequests,Header.Count,m_pReplies);
+    MESSAGELOG_LogError(ErrorCode);
+    pSocket->write((char const*)&Header,sizeof(Header));
+    pSocket->write((char const*)m_pReplies,
+        Header.Count*(qint64)sizeof(MOONQUERYREPLY_T));
+  }
+
+  DEBUGLOG_LogOut();
+  return;
+}
+
+
+#undef    QUERYSERVER_CPP
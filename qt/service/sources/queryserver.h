@@ -0,0 +1,186 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file queryserver.h
+*** \brief Moon data query server.
+*** \details Answers batched moon data queries (see moonquery.h) from local
+***   clients.
+**/
+
+
+#ifndef   QUERYSERVER_H
+#define   QUERYSERVER_H
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moonquery.h"
+
+#include  <QObject>
+#include  <QString>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+class QLocalServer;
+class QLocalSocket;
+
+/**
+*** \brief Query server.
+*** \details Listens on a local (Unix domain) socket and answers batches of
+***   MOONQUERYREQUEST_T with batches of MOONQUERYREPLY_T. All clients share
+***   one query engine, so its observer profiles and rise/set caches stay
+***   warm between batches and between clients.
+**/
+class QUERYSERVER_C : public QObject
+{
+  Q_OBJECT
+
+  public:
+    /**
+    *** \brief Constructor.
+    *** \details Constructor.
+    *** \param pParent Pointer to parent object.
+    **/
+    QUERYSERVER_C(QObject *pParent=NULL);
+
+    /**
+    *** \brief Destructor.
+    *** \details Destructor.
+    **/
+    ~QUERYSERVER_C(void);
+
+    /**
+    *** \brief Starts listening.
+    *** \details Removes any stale socket and starts listening on it.
+    *** \param Name Socket pathname.
+    *** \retval true Success.
+    *** \retval false Failure.
+    **/
+    bool Listen(QString const &Name);
+
+    /**
+    *** \brief Pauses the server.
+    *** \details Requests are left unanswered until the server is resumed.
+    **/
+    void Pause(void);
+
+    /**
+    *** \brief Resumes the server.
+    *** \details Answers any requests received while the server was paused.
+    **/
+    void Resume(void);
+
+  private slots:
+    /**
+    *** \brief New connection.
+    *** \details A client connected to the server.
+    **/
+    void NewConnectionSlot(void);
+
+    /**
+    *** \brief Data received.
+    *** \details A client sent (part of) a batch.
+    **/
+    void ReadyReadSlot(void);
+
+    /**
+    *** \brief Connection closed.
+    *** \details A client disconnected from the server.
+    **/
+    void DisconnectedSlot(void);
+
+  private:
+    /**
+    *** \brief Answers a client.
+    *** \details Answers all the complete batches received from a client.
+    ***   A client that sends an invalid batch is disconnected.
+    *** \param pSocket Client connection.
+    **/
+    void AnswerClient(QLocalSocket *pSocket);
+
+    /**
+    *** \brief Server.
+    *** \details Local socket server.
+    **/
+    QLocalServer *m_pServer;
+
+    /**
+    *** \brief Paused flag.
+    *** \details If true, requests are not answered.
+    **/
+    bool m_PausedFlag;
+
+    /**
+    *** \brief Query engine.
+    *** \details Warm observer profiles.
+    **/
+    MOONQUERY_T m_Query;
+
+    /**
+    *** \brief Requests.
+    *** \details Requests of the batch being answered.
+    **/
+    MOONQUERYREQUEST_T m_pRequests[MOONQUERY_MAXBATCH];
+
+    /**
+    *** \brief Replies.
+    *** \details Replies of the batch being answered.
+    **/
+    MOONQUERYREPLY_T m_pReplies[MOONQUERY_MAXBATCH];
+};
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+
+#endif    /* QUERYSERVER_H */
@@ -0,0 +1,232 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file batchtest.c
+*** \brief CalcEphemBatch() test.
+*** \details Checks that CalcEphemBatch() gives the same results as
+***   CalcEphem_r() for every field mask, and for counts that leave a tail
+***   after the four sample groups.
+***   Usage: moonphase-batchtest
+**/
+
+
+/** Identifier for batchtest.c. **/
+#define   BATCHTEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "sysdefs.h"
+
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Sample count.
+*** \details Largest count checked (not a multiple of 4).
+**/
+#define   SAMPLE_COUNT        (23)
+
+/**
+*** \brief Field mask.
+*** \details All EPHEMFIELD_* flags.
+**/
+#define   FIELD_ALL           (EPHEMFIELD_RADEC|EPHEMFIELD_ALTAZ| \
+                                  EPHEMFIELD_PHASE|EPHEMFIELD_AGE| \
+                                  EPHEMFIELD_DISTANCE)
+
+/**
+*** \brief Unset value.
+*** \details Value the outputs start with, to see what was written.
+**/
+#define   UNSET               (-12345.0)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static int Differs(int Selected,double Value,double Expected);
+static int CheckBatch(int Fields,int Count,long const *pDates,
+    double const *pUTs,EphemContext const *pContext,
+    CTrans const *pExpected);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Compares an output.
+*** \details A selected output must equal the expected value exactly, an
+***   output that was not selected must be left alone.
+*** \param Selected Non-zero if the field was selected.
+*** \param Value Output.
+*** \param Expected Expected value.
+*** \returns Non-zero if the output is wrong.
+**/
+static int Differs(int Selected,double Value,double Expected)
+{
+  return(Selected!=0 ? Value!=Expected : Value!=UNSET);
+}
+
+/**
+*** \brief Checks a batch.
+*** \details Runs CalcEphemBatch() for the first Count samples with a field
+***   mask and compares it with the CalcEphem_r() results.
+*** \param Fields Field mask (EPHEMFIELD_*).
+*** \param Count Number of samples.
+*** \param pDates Dates (yyyymmdd).
+*** \param pUTs Times (in hours UT).
+*** \param pContext Observer.
+*** \param pExpected CalcEphem_r() results.
+*** \retval 0 Same results.
+*** \retval 1 Different results.
+**/
+static int CheckBatch(int Fields,int Count,long const *pDates,
+    double const *pUTs,EphemContext const *pContext,
+    CTrans const *pExpected)
+{
+  double pRA[SAMPLE_COUNT],pDEC[SAMPLE_COUNT];
+  double pH[SAMPLE_COUNT],pA[SAMPLE_COUNT];
+  double pPhase[SAMPLE_COUNT],pAge[SAMPLE_COUNT],pDistance[SAMPLE_COUNT];
+  EphemBatch Batch;
+  int Index;
+  int Result;
+
+
+  for(Index=0;Index<SAMPLE_COUNT;Index++)
+    pRA[Index]=pDEC[Index]=pH[Index]=pA[Index]=pPhase[Index]=pAge[Index]=
+        pDistance[Index]=UNSET;
+  Batch.RA_moon=pRA;
+  Batch.DEC_moon=pDEC;
+  Batch.h_moon=pH;
+  Batch.A_moon=pA;
+  Batch.MoonPhase=pPhase;
+  Batch.MoonAge=pAge;
+  Batch.EarthMoonDistance=pDistance;
+  CalcEphemBatch(pDates,pUTs,Count,pContext,Fields,&Batch);
+
+  Result=0;
+  for(Index=0;Index<SAMPLE_COUNT;Index++)
+  {
+    if (Index>=Count)
+      Fields=0;       /* Past the count nothing may be written. */
+    if ( Differs(Fields&EPHEMFIELD_RADEC,pRA[Index],
+        pExpected[Index].RA_moon) ||
+        Differs(Fields&EPHEMFIELD_RADEC,pDEC[Index],
+        pExpected[Index].DEC_moon) ||
+        Differs(Fields&EPHEMFIELD_ALTAZ,pH[Index],pExpected[Index].h_moon) ||
+        Differs(Fields&EPHEMFIELD_ALTAZ,pA[Index],pExpected[Index].A_moon) ||
+        Differs(Fields&EPHEMFIELD_PHASE,pPhase[Index],
+        pExpected[Index].MoonPhase) ||
+        Differs(Fields&EPHEMFIELD_AGE,pAge[Index],
+        pExpected[Index].MoonAge) ||
+        Differs(Fields&EPHEMFIELD_DISTANCE,pDistance[Index],
+        pExpected[Index].EarthMoonDistance) )
+      Result=1;
+  }
+  return(Result);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  long pDates[SAMPLE_COUNT];
+  double pUTs[SAMPLE_COUNT];
+  CTrans pExpected[SAMPLE_COUNT];
+  EphemContext Context;
+  int Index;
+  int Fields;
+  int Count;
+  int Failures;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  EphemContext_Set(&Context,-34.93,-138.6,-9.5);
+  for(Index=0;Index<SAMPLE_COUNT;Index++)
+  {
+    /* Spread over 1900-2100, with a Julian date among them. */
+    pDates[Index]=(Index==0) ? 15000229L :
+        10000L*(1900+9*Index)+100*(1+Index%12)+1+(7*Index)%28;
+    pUTs[Index]=0.37+(Index*5)%24;
+    CalcEphem_r(pDates[Index],pUTs[Index],&pExpected[Index],&Context);
+  }
+
+  Failures=0;
+  for(Fields=1;Fields<=FIELD_ALL;Fields++)
+    for(Count=1;Count<=SAMPLE_COUNT;Count++)
+      if (CheckBatch(Fields,Count,pDates,pUTs,&Context,pExpected)!=0)
+      {
+        if (Failures<10)
+          printf("fields 0x%02x, count %d FAILED\n",Fields,Count);
+        Failures++;
+      }
+
+  printf("%s, %d of %d batches differ from CalcEphem_r()\n",
+      Failures==0 ? "ok" : "FAILED",Failures,FIELD_ALL*SAMPLE_COUNT);
+  return(Failures==0 ? 0 : 1);
+}
+
+
+#undef    BATCHTEST_C
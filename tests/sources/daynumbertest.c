@@ -0,0 +1,327 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file daynumbertest.c
+*** \brief Calendar test.
+*** \details Checks the day number conversions: round trips over the whole
+***   range, the Gregorian reform (1582-10-04 is followed by 1582-10-15),
+***   Julian and Gregorian leap days, and the day of the year and of the
+***   week against the jd() based functions they replaced.
+***   Usage: moonphase-daynumbertest
+**/
+
+
+/** Identifier for daynumbertest.c. **/
+#define   DAYNUMBERTEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "daynumber.h"
+
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Reference years.
+*** \details Years compared against the jd() based functions.
+**/
+#define   REFERENCE_FIRSTYEAR (1)
+#define   REFERENCE_LASTYEAR  (2999)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Date step.
+*** \details Two consecutive dates.
+**/
+typedef struct structDATESTEP
+{
+  /**
+  *** \brief Date.
+  *** \details Year, month and day.
+  **/
+  int pDate[3];
+  /**
+  *** \brief Next date.
+  *** \details Year, month and day of the day after.
+  **/
+  int pNext[3];
+} DATESTEP_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double OldJD(int ny,int nm,int nd,double UT);
+static int OldDayOfYear(int Year,int Month,int Day);
+static int OldDayOfWeek(int Year,int Month,int Day);
+static int CheckRoundTrips(void);
+static int CheckSteps(void);
+static int CheckReference(void);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Steps.
+*** \details Days known to follow each other.
+**/
+static DATESTEP_T const f_pSteps[]=
+{
+  { { 1582, 10,  4 }, { 1582, 10, 15 } },   /* Gregorian reform */
+  { { 1500,  2, 28 }, { 1500,  2, 29 } },   /* Julian leap day */
+  { { 1500,  2, 29 }, { 1500,  3,  1 } },
+  { { 1600,  2, 28 }, { 1600,  2, 29 } },   /* Gregorian leap day */
+  { { 1700,  2, 28 }, { 1700,  3,  1 } },   /* Gregorian common year */
+  { { 1900,  2, 28 }, { 1900,  3,  1 } },
+  { { 2000,  2, 29 }, { 2000,  3,  1 } },
+  { {   -1, 12, 31 }, {    0,  1,  1 } },   /* 2 BC to 1 BC */
+  { { 1999, 12, 31 }, { 2000,  1,  1 } }
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Julian date.
+*** \details jd() of calcephem.c as it was before day numbers were used,
+***   kept as the reference.
+*** \param ny Year.
+*** \param nm Month (1-12).
+*** \param nd Day of the month.
+*** \param UT Hours after midnight.
+*** \returns Julian date.
+**/
+static double OldJD(int ny,int nm,int nd,double UT)
+{
+  double A, B, C, D, day;
+
+  day = nd + UT/24.0;
+  if ((nm == 1) || (nm == 2)){
+    ny = ny - 1;
+    nm = nm + 12;
+  }
+  if (((double)ny+nm/12.0+day/365.25)>=(1582.0+10.0/12.0+15.0/365.25)){
+    A = ((int)(ny / 100.0));
+    B = 2.0 - A + (int)(A/4.0);
+  }
+  else{
+    B = 0.0;
+  }
+  if (ny < 0.0){
+    C = (int)((365.25*(double)ny) - 0.75);
+  }
+  else{
+    C = (int)(365.25*(double)ny);
+  }
+  D = (int)(30.6001*(double)(nm+1));
+  return(B + C + D + day + 1720994.5);
+}
+
+/**
+*** \brief Day of the year.
+*** \details DayofYear() of calcephem.c as it was, kept as the reference.
+*** \param Year Year.
+*** \param Month Month (1-12).
+*** \param Day Day of the month.
+*** \returns Day of the year (1-366).
+**/
+static int OldDayOfYear(int Year,int Month,int Day)
+{
+  return((int)(OldJD(Year,Month,Day,0.0)-OldJD(Year,1,0,0.0)));
+}
+
+/**
+*** \brief Day of the week.
+*** \details DayofWeek() of calcephem.c as it was, kept as the reference.
+*** \param Year Year.
+*** \param Month Month (1-12).
+*** \param Day Day of the month.
+*** \returns Day of the week (0 Sunday - 6 Saturday).
+**/
+static int OldDayOfWeek(int Year,int Month,int Day)
+{
+  double A;
+
+
+  A=(OldJD(Year,Month,Day,0.0)+1.5)/7.0;
+  return((int)((A-(int)A)*7.0+0.5));
+}
+
+/**
+*** \brief Checks round trips.
+*** \details Converts every day number of the range to a date and back.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int CheckRoundTrips(void)
+{
+  long DayNumber;
+  long Errors;
+  int Year,Month,Day;
+  int PreviousYear,PreviousMonth,PreviousDay;
+
+
+  Errors=0;
+  DayNumber_ToDate(DAYNUMBER_MINIMUM,&PreviousYear,&PreviousMonth,
+      &PreviousDay);
+  for(DayNumber=DAYNUMBER_MINIMUM;DayNumber<DAYNUMBER_MAXIMUM;
+      DayNumber+=(DayNumber<4000000L ? 1 : 997))
+  {
+    DayNumber_ToDate(DayNumber,&Year,&Month,&Day);
+    if ( (DayNumber_FromDate(Year,Month,Day)!=DayNumber) ||
+        (Month<1) || (Month>12) || (Day<1) || (Day>31) )
+      Errors++;
+  }
+  printf("round trips %s, %ld errors\n",Errors==0 ? "ok" : "FAILED",Errors);
+  return(Errors==0 ? 0 : 1);
+}
+
+/**
+*** \brief Checks steps.
+*** \details Checks that the known pairs of dates are one day apart.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int CheckSteps(void)
+{
+  DATESTEP_T const *pStep;
+  long DayNumber;
+  int Year,Month,Day;
+  int Index;
+  int Result;
+
+
+  Result=0;
+  for(Index=0;Index<(int)(sizeof(f_pSteps)/sizeof(*f_pSteps));Index++)
+  {
+    pStep=&f_pSteps[Index];
+    DayNumber=DayNumber_FromDate(pStep->pDate[0],pStep->pDate[1],
+        pStep->pDate[2]);
+    DayNumber_ToDate(DayNumber+1,&Year,&Month,&Day);
+    if ( (Year!=pStep->pNext[0]) || (Month!=pStep->pNext[1]) ||
+        (Day!=pStep->pNext[2]) || (DayNumber_FromDate(pStep->pNext[0],
+        pStep->pNext[1],pStep->pNext[2])!=DayNumber+1) )
+    {
+      printf("step %d-%02d-%02d FAILED, next day %d-%02d-%02d\n",
+          pStep->pDate[0],pStep->pDate[1],pStep->pDate[2],Year,Month,Day);
+      Result=1;
+    }
+  }
+  if (DayNumber_FromDate(1582,10,15)!=DAYNUMBER_GREGORIAN)
+  {
+    printf("DAYNUMBER_GREGORIAN FAILED\n");
+    Result=1;
+  }
+  printf("steps %s\n",Result==0 ? "ok" : "FAILED");
+  return(Result);
+}
+
+/**
+*** \brief Checks against the reference.
+*** \details Compares the day number, day of the year and day of the week
+***   of every date in the reference years with the jd() based functions.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int CheckReference(void)
+{
+  long DayNumber;
+  long LastDayNumber;
+  long Errors;
+  int Year,Month,Day;
+
+
+  Errors=0;
+  LastDayNumber=DayNumber_FromDate(REFERENCE_LASTYEAR+1,1,1);
+  for(DayNumber=DayNumber_FromDate(REFERENCE_FIRSTYEAR,1,1);
+      DayNumber<LastDayNumber;DayNumber++)
+  {
+    DayNumber_ToDate(DayNumber,&Year,&Month,&Day);
+    if ( ((double)DayNumber!=OldJD(Year,Month,Day,12.0)) ||
+        (DayNumber_GetDayOfYear(DayNumber,Year)!=
+        OldDayOfYear(Year,Month,Day)) ||
+        (DayNumber_GetDayOfWeek(DayNumber)!=OldDayOfWeek(Year,Month,Day)) )
+    {
+      if (Errors<10)
+        printf("reference mismatch at %d-%02d-%02d\n",Year,Month,Day);
+      Errors++;
+    }
+  }
+  printf("reference %s, %ld errors\n",Errors==0 ? "ok" : "FAILED",Errors);
+  return(Errors==0 ? 0 : 1);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  Result=CheckRoundTrips();
+  Result|=CheckSteps();
+  Result|=CheckReference();
+  return(Result);
+}
+
+
+#undef    DAYNUMBERTEST_C
@@ -0,0 +1,188 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file moon4test.c
+*** \brief Moon4() kernel test.
+*** \details Forces each series kernel of Moon4() (scalar, SSE2, AVX2) in
+***   turn and checks its results against Moon() over 1900-2100. Kernels
+***   the build or CPU does not have are skipped.
+***   Usage: moonphase-moon4test
+**/
+
+
+/** Identifier for moon4test.c. **/
+#define   MOON4TEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "sysdefs.h"
+
+#include  <math.h>
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Sample count.
+*** \details Number of times checked per kernel (a multiple of 4).
+**/
+#define   SAMPLE_COUNT        (40000)
+
+/**
+*** \brief Tolerance.
+*** \details Largest difference allowed from Moon() (in degrees, earth
+***   radii or days).
+**/
+#define   TOLERANCE           (1e-9)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static int CheckKernel(int Kernel,char const *pName);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Checks a kernel.
+*** \details Compares Moon4() with the kernel forced against Moon(), at
+***   times spread over 1900-2100 (T from -1 to 1).
+*** \param Kernel Kernel (MOONKERNEL_*).
+*** \param pName Kernel name.
+*** \retval 0 Success (or kernel not available).
+*** \retval 1 Failure (a message has been printed).
+**/
+static int CheckKernel(int Kernel,char const *pName)
+{
+  double pT[4];
+  double pLambda[4];
+  double pBeta[4];
+  double pR[4];
+  double pAge[4];
+  double pPhase[4];
+  double Lambda;
+  double Beta;
+  double R;
+  double Age;
+  double Phase;
+  double Error;
+  double MaximumError;
+  int Sample;
+  int Lane;
+
+
+  if (SetMoonKernel(Kernel)==0)
+  {
+    printf("%-6s skipped (not available)\n",pName);
+    return(0);
+  }
+
+  MaximumError=0.0;
+  for(Sample=0;Sample<SAMPLE_COUNT;Sample+=4)
+  {
+    for(Lane=0;Lane<4;Lane++)
+      pT[Lane]=-1.0+2.0*(Sample+Lane)/SAMPLE_COUNT;
+    Moon4(pT,pLambda,pBeta,pR,pAge,pPhase);
+    for(Lane=0;Lane<4;Lane++)
+    {
+      Phase=Moon(pT[Lane],&Lambda,&Beta,&R,&Age);
+      Error=fabs(pLambda[Lane]-Lambda);
+      Error=fmax(Error,fabs(pBeta[Lane]-Beta));
+      Error=fmax(Error,fabs(pR[Lane]-R));
+      Error=fmax(Error,fabs(pAge[Lane]-Age));
+      Error=fmax(Error,fabs(pPhase[Lane]-Phase));
+      if (!(Error<=TOLERANCE))
+      {
+        printf("%-6s FAILED at T=%.9f: difference %g\n",
+            pName,pT[Lane],Error);
+        SetMoonKernel(MOONKERNEL_AUTO);
+        return(1);
+      }
+      MaximumError=fmax(MaximumError,Error);
+    }
+  }
+  printf("%-6s ok, largest difference %g\n",pName,MaximumError);
+
+  SetMoonKernel(MOONKERNEL_AUTO);
+  return(0);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  Result=CheckKernel(MOONKERNEL_SCALAR,"scalar");
+  Result|=CheckKernel(MOONKERNEL_SSE2,"SSE2");
+  Result|=CheckKernel(MOONKERNEL_AVX2,"AVX2");
+  return(Result);
+}
+
+
+#undef    MOON4TEST_C
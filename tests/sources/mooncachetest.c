@@ -0,0 +1,221 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file mooncachetest.c
+*** \brief Moon cache test.
+*** \details Checks MoonCache_Evaluate() against Moon() at jittered times
+***   in order over 1900-2100 (a few in every segment), and that both the differences seen and the
+***   error reported by MoonCache_GetMaximumError() are within the bounds
+***   documented in mooncache.h.
+***   Usage: moonphase-mooncachetest
+**/
+
+
+/** Identifier for mooncachetest.c. **/
+#define   MOONCACHETEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "mooncache.h"
+
+#include  <math.h>
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Sample count.
+*** \details Number of times checked.
+**/
+#define   SAMPLE_COUNT        (200000)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double Random(unsigned long *pState);
+static double Wrap(double Difference,double Period);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Quantity names.
+*** \details Names of the quantities (MOONCACHEQUANTITY_E).
+**/
+static char const *f_ppQuantityNames[MOONCACHEQUANTITY_COUNT]=
+    { "longitude", "latitude", "distance", "phase" };
+
+/**
+*** \brief Bounds.
+*** \details Documented error bound of each quantity.
+**/
+static double const f_pBounds[MOONCACHEQUANTITY_COUNT]=
+{
+  MOONCACHE_MAXERROR_LAMBDA,
+  MOONCACHE_MAXERROR_BETA,
+  MOONCACHE_MAXERROR_DISTANCE,
+  MOONCACHE_MAXERROR_PHASE
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Pseudo random number.
+*** \details Returns the next number of a fixed sequence (64 bit LCG), so
+***   every run checks the same times.
+*** \param pState Generator state.
+*** \returns Number (0-1).
+**/
+static double Random(unsigned long *pState)
+{
+  *pState=(*pState*6364136223846793005ULL+1442695040888963407ULL)&
+      0xFFFFFFFFFFFFFFFFULL;
+  return((double)(*pState>>11)/9007199254740992.0);
+}
+
+/**
+*** \brief Wraps a difference.
+*** \details Reduces a difference to half a period either side of zero.
+*** \param Difference Difference.
+*** \param Period Period, or 0 if the quantity does not wrap.
+*** \returns Wrapped difference.
+**/
+static double Wrap(double Difference,double Period)
+{
+  if (Period!=0.0)
+    Difference-=Period*floor(Difference/Period+0.5);
+  return(Difference);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  static MOONCACHE_T Cache;
+  double pCached[MOONCACHEQUANTITY_COUNT];
+  double pExact[MOONCACHEQUANTITY_COUNT];
+  double pMaximum[MOONCACHEQUANTITY_COUNT];
+  double Reported;
+  double Age;
+  double T;
+  unsigned long State;
+  int Sample;
+  int Quantity;
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  if (MoonCache_Initialize(&Cache)<0)
+  {
+    printf("MoonCache_Initialize() failed.\n");
+    return(1);
+  }
+
+  for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+    pMaximum[Quantity]=0.0;
+  State=1;
+  for(Sample=0;Sample<SAMPLE_COUNT;Sample++)
+  {
+    T=-1.0+2.0*(Sample+Random(&State))/SAMPLE_COUNT;
+    MoonCache_Evaluate(&Cache,T,
+        &pCached[MOONCACHEQUANTITY_LAMBDA],&pCached[MOONCACHEQUANTITY_BETA],
+        &pCached[MOONCACHEQUANTITY_DISTANCE],
+        &pCached[MOONCACHEQUANTITY_PHASE]);
+    pExact[MOONCACHEQUANTITY_PHASE]=Moon(T,
+        &pExact[MOONCACHEQUANTITY_LAMBDA],&pExact[MOONCACHEQUANTITY_BETA],
+        &pExact[MOONCACHEQUANTITY_DISTANCE],&Age);
+    pMaximum[MOONCACHEQUANTITY_LAMBDA]=fmax(pMaximum[MOONCACHEQUANTITY_LAMBDA],
+        fabs(Wrap(pCached[MOONCACHEQUANTITY_LAMBDA]-
+        pExact[MOONCACHEQUANTITY_LAMBDA],360.0)));
+    pMaximum[MOONCACHEQUANTITY_BETA]=fmax(pMaximum[MOONCACHEQUANTITY_BETA],
+        fabs(pCached[MOONCACHEQUANTITY_BETA]-pExact[MOONCACHEQUANTITY_BETA]));
+    pMaximum[MOONCACHEQUANTITY_DISTANCE]=
+        fmax(pMaximum[MOONCACHEQUANTITY_DISTANCE],
+        fabs(pCached[MOONCACHEQUANTITY_DISTANCE]-
+        pExact[MOONCACHEQUANTITY_DISTANCE]));
+    pMaximum[MOONCACHEQUANTITY_PHASE]=fmax(pMaximum[MOONCACHEQUANTITY_PHASE],
+        fabs(Wrap(pCached[MOONCACHEQUANTITY_PHASE]-
+        pExact[MOONCACHEQUANTITY_PHASE],1.0)));
+  }
+
+  Result=0;
+  for(Quantity=0;Quantity<MOONCACHEQUANTITY_COUNT;Quantity++)
+  {
+    MoonCache_GetMaximumError(&Cache,Quantity,&Reported);
+    printf("%-9s measured %.3g, reported %.3g, bound %.3g\n",
+        f_ppQuantityNames[Quantity],pMaximum[Quantity],Reported,
+        f_pBounds[Quantity]);
+    if ( !(pMaximum[Quantity]<=f_pBounds[Quantity]) ||
+        !(Reported<=f_pBounds[Quantity]) )
+    {
+      printf("%-9s FAILED\n",f_ppQuantityNames[Quantity]);
+      Result=1;
+    }
+  }
+
+  MoonCache_Uninitialize(&Cache);
+  return(Result);
+}
+
+
+#undef    MOONCACHETEST_C
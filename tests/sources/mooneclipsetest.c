@@ -0,0 +1,224 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file mooneclipsetest.c
+*** \brief MoonEclipse_Find() test.
+*** \details Checks MoonEclipse_Find() against the published list of solar
+***   and lunar eclipses from 2020 to 2026: same count, same dates and same
+***   types, including the 2023-04-20 hybrid solar eclipse.
+***   Usage: moonphase-mooneclipsetest
+**/
+
+
+/** Identifier for mooneclipsetest.c. **/
+#define   MOONECLIPSETEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "mooneclipse.h"
+#include  "daynumber.h"
+#include  "sysdefs.h"
+
+#include  <math.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Delta T.
+*** \details TDT-UT over 2020-2026 (in seconds).
+**/
+#define   DELTAT              (69.0)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Known eclipse.
+*** \details A published eclipse.
+**/
+typedef struct structKNOWNECLIPSE
+{
+  /**
+  *** \brief Date.
+  *** \details Year, month and day (UT).
+  **/
+  int pDate[3];
+  /**
+  *** \brief Type.
+  *** \details Eclipse type (MOONECLIPSETYPE_E).
+  **/
+  int Type;
+} KNOWNECLIPSE_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Type names.
+*** \details Indexed by MOONECLIPSETYPE_E.
+**/
+static char const *f_ppTypeNames[MOONECLIPSETYPE_COUNT]=
+{
+  "partial solar","annular solar","hybrid solar","total solar",
+  "penumbral lunar","partial lunar","total lunar"
+};
+
+/**
+*** \brief Known eclipses.
+*** \details All eclipses from 2020 to 2026, in time order.
+**/
+static KNOWNECLIPSE_T const f_pKnownEclipses[]=
+{
+  { { 2020,  1, 10 }, MOONECLIPSETYPE_LUNARPENUMBRAL },
+  { { 2020,  6,  5 }, MOONECLIPSETYPE_LUNARPENUMBRAL },
+  { { 2020,  6, 21 }, MOONECLIPSETYPE_SOLARANNULAR },
+  { { 2020,  7,  5 }, MOONECLIPSETYPE_LUNARPENUMBRAL },
+  { { 2020, 11, 30 }, MOONECLIPSETYPE_LUNARPENUMBRAL },
+  { { 2020, 12, 14 }, MOONECLIPSETYPE_SOLARTOTAL },
+  { { 2021,  5, 26 }, MOONECLIPSETYPE_LUNARTOTAL },
+  { { 2021,  6, 10 }, MOONECLIPSETYPE_SOLARANNULAR },
+  { { 2021, 11, 19 }, MOONECLIPSETYPE_LUNARPARTIAL },
+  { { 2021, 12,  4 }, MOONECLIPSETYPE_SOLARTOTAL },
+  { { 2022,  4, 30 }, MOONECLIPSETYPE_SOLARPARTIAL },
+  { { 2022,  5, 16 }, MOONECLIPSETYPE_LUNARTOTAL },
+  { { 2022, 10, 25 }, MOONECLIPSETYPE_SOLARPARTIAL },
+  { { 2022, 11,  8 }, MOONECLIPSETYPE_LUNARTOTAL },
+  { { 2023,  4, 20 }, MOONECLIPSETYPE_SOLARHYBRID },
+  { { 2023,  5,  5 }, MOONECLIPSETYPE_LUNARPENUMBRAL },
+  { { 2023, 10, 14 }, MOONECLIPSETYPE_SOLARANNULAR },
+  { { 2023, 10, 28 }, MOONECLIPSETYPE_LUNARPARTIAL },
+  { { 2024,  3, 25 }, MOONECLIPSETYPE_LUNARPENUMBRAL },
+  { { 2024,  4,  8 }, MOONECLIPSETYPE_SOLARTOTAL },
+  { { 2024,  9, 18 }, MOONECLIPSETYPE_LUNARPARTIAL },
+  { { 2024, 10,  2 }, MOONECLIPSETYPE_SOLARANNULAR },
+  { { 2025,  3, 14 }, MOONECLIPSETYPE_LUNARTOTAL },
+  { { 2025,  3, 29 }, MOONECLIPSETYPE_SOLARPARTIAL },
+  { { 2025,  9,  7 }, MOONECLIPSETYPE_LUNARTOTAL },
+  { { 2025,  9, 21 }, MOONECLIPSETYPE_SOLARPARTIAL },
+  { { 2026,  2, 17 }, MOONECLIPSETYPE_SOLARANNULAR },
+  { { 2026,  3,  3 }, MOONECLIPSETYPE_LUNARTOTAL },
+  { { 2026,  8, 12 }, MOONECLIPSETYPE_SOLARTOTAL },
+  { { 2026,  8, 28 }, MOONECLIPSETYPE_LUNARPARTIAL }
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  MOONECLIPSE_T *pEclipses;
+  long Count;
+  long Index;
+  long KnownCount;
+  long DayNumber;
+  int Year,Month,Day;
+  int Errors;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  if (MoonEclipse_Find(
+      (DayNumber_FromDate(2020,1,1)-0.5+DELTAT/86400.0-2451545.0)/36525.0,
+      (DayNumber_FromDate(2027,1,1)-0.5+DELTAT/86400.0-2451545.0)/36525.0,
+      &pEclipses,&Count)<0)
+  {
+    printf("MoonEclipse_Find() failed.\n");
+    return(1);
+  }
+
+  KnownCount=(long)(sizeof(f_pKnownEclipses)/sizeof(*f_pKnownEclipses));
+  Errors=0;
+  for(Index=0;(Index<Count) && (Index<KnownCount);Index++)
+  {
+    DayNumber=(long)floor(pEclipses[Index].T*36525.0+2451545.0+0.5-
+        DELTAT/86400.0);
+    DayNumber_ToDate(DayNumber,&Year,&Month,&Day);
+    if ( (Year!=f_pKnownEclipses[Index].pDate[0]) ||
+        (Month!=f_pKnownEclipses[Index].pDate[1]) ||
+        (Day!=f_pKnownEclipses[Index].pDate[2]) ||
+        (pEclipses[Index].Type!=f_pKnownEclipses[Index].Type) )
+    {
+      printf("%d-%02d-%02d %s FAILED, found %d-%02d-%02d %s\n",
+          f_pKnownEclipses[Index].pDate[0],f_pKnownEclipses[Index].pDate[1],
+          f_pKnownEclipses[Index].pDate[2],
+          f_ppTypeNames[f_pKnownEclipses[Index].Type],Year,Month,Day,
+          f_ppTypeNames[pEclipses[Index].Type]);
+      Errors++;
+    }
+  }
+  if (Count!=KnownCount)
+  {
+    printf("count FAILED, %ld eclipses instead of %ld\n",Count,KnownCount);
+    Errors++;
+  }
+  free(pEclipses);
+
+  printf("eclipses %s, %ld found, %d errors\n",Errors==0 ? "ok" : "FAILED",
+      Count,Errors);
+  return(Errors==0 ? 0 : 1);
+}
+
+
+#undef    MOONECLIPSETEST_C
@@ -0,0 +1,383 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file mooneventtest.c
+*** \brief MoonEvent_Find() test.
+*** \details Checks MoonEvent_Find() against published 2024 instants of
+***   phases, apsides, nodes and declination extremes, checks an empty
+***   range, and checks that an event on the edge between two chunks is
+***   returned exactly once.
+***   Usage: moonphase-mooneventtest
+**/
+
+
+/** Identifier for mooneventtest.c. **/
+#define   MOONEVENTTEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moonevent.h"
+#include  "daynumber.h"
+#include  "sysdefs.h"
+
+#include  <math.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Day.
+*** \details One day (in Julian centuries).
+**/
+#define   DAY                 (1.0/36525.0)
+
+/**
+*** \brief Minute.
+*** \details One minute (in Julian centuries).
+**/
+#define   MINUTE              (DAY/1440.0)
+
+/**
+*** \brief Delta T.
+*** \details TDT-UT in 2024 (in seconds).
+**/
+#define   DELTAT              (69.0)
+
+/**
+*** \brief Chunk length.
+*** \details Days per chunk of MoonEvent_Find() (CHUNK_STEPS in
+***   moonevent.c).
+**/
+#define   CHUNK_DAYS          (366)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Known event.
+*** \details A published event instant (UT, to the minute).
+**/
+typedef struct structKNOWNEVENT
+{
+  /**
+  *** \brief Type.
+  *** \details Event type (MOONEVENTTYPE_E).
+  **/
+  int Type;
+  /**
+  *** \brief Date.
+  *** \details Year, month, day, hour and minute (UT).
+  **/
+  int pDate[5];
+  /**
+  *** \brief Tolerance.
+  *** \details Allowed difference (in minutes).
+  **/
+  double Tolerance;
+} KNOWNEVENT_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double ToT(int const *pDate);
+static int CheckKnownEvents(void);
+static int CheckEmptyRange(void);
+static int CheckChunkEdge(MOONEVENT_T const *pEvent);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Type names.
+*** \details Indexed by MOONEVENTTYPE_E.
+**/
+static char const *f_ppTypeNames[MOONEVENTTYPE_COUNT]=
+{
+  "new moon","first quarter","full moon","last quarter","perigee",
+  "apogee","ascending node","descending node","north declination",
+  "south declination"
+};
+
+/**
+*** \brief Known events.
+*** \details Published 2024 instants. Apsides, nodes and declination
+***   extremes are flat or slow, so they get a wider tolerance.
+**/
+static KNOWNEVENT_T const f_pKnownEvents[]=
+{
+  { MOONEVENTTYPE_NEWMOON,          { 2024,  1, 11, 11, 57 }, 2.0 },
+  { MOONEVENTTYPE_FIRSTQUARTER,     { 2024,  1, 18,  3, 53 }, 2.0 },
+  { MOONEVENTTYPE_FULLMOON,         { 2024,  1, 25, 17, 54 }, 2.0 },
+  { MOONEVENTTYPE_LASTQUARTER,      { 2024,  2,  2, 23, 18 }, 2.0 },
+  { MOONEVENTTYPE_NEWMOON,          { 2024,  4,  8, 18, 21 }, 2.0 },
+  { MOONEVENTTYPE_FULLMOON,         { 2024, 10, 17, 11, 26 }, 2.0 },
+  { MOONEVENTTYPE_NEWMOON,          { 2024, 12, 30, 22, 27 }, 2.0 },
+  { MOONEVENTTYPE_PERIGEE,          { 2024,  1, 13, 10, 35 }, 5.0 },
+  { MOONEVENTTYPE_PERIGEE,          { 2024, 10, 17,  0, 51 }, 5.0 },
+  { MOONEVENTTYPE_APOGEE,           { 2024,  1,  1, 15, 28 }, 5.0 },
+  { MOONEVENTTYPE_APOGEE,           { 2024, 10,  2, 19, 39 }, 5.0 },
+  { MOONEVENTTYPE_ASCENDINGNODE,    { 2024,  1, 17, 14,  3 }, 5.0 },
+  { MOONEVENTTYPE_DESCENDINGNODE,   { 2024, 10,  2, 11, 51 }, 5.0 },
+  { MOONEVENTTYPE_NORTHDECLINATION, { 2024,  9, 24, 16, 52 }, 5.0 },
+  { MOONEVENTTYPE_SOUTHDECLINATION, { 2024, 10,  9, 11, 43 }, 5.0 }
+};
+
+/**
+*** \brief 2024 counts.
+*** \details Number of events of each type in 2024 (phases only).
+**/
+static int const f_pKnownCounts[MOONEVENTTYPE_PERIGEE]={ 13,12,12,13 };
+
+/**
+*** \brief 2024 start.
+*** \details Year, month, day, hour and minute (UT).
+**/
+static int const f_pYearStart[5]={ 2024,1,1,0,0 };
+
+/**
+*** \brief 2024 end.
+*** \details Year, month, day, hour and minute (UT).
+**/
+static int const f_pYearEnd[5]={ 2025,1,1,0,0 };
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Converts a date.
+*** \details Converts a UT date and time to TDT Julian centuries since
+***   J2000.
+*** \param pDate Year, month, day, hour and minute (UT).
+*** \returns Time (in Julian centuries (TDT) since J2000).
+**/
+static double ToT(int const *pDate)
+{
+  return((DayNumber_FromDate(pDate[0],pDate[1],pDate[2])-0.5-2451545.0+
+      (pDate[3]+pDate[4]/60.0)/24.0+DELTAT/86400.0)/36525.0);
+}
+
+/**
+*** \brief Checks known events.
+*** \details Searches 2024 and looks up each known event, then checks the
+***   phase counts and that the events are sorted.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int CheckKnownEvents(void)
+{
+  MOONEVENT_T *pEvents;
+  long Count;
+  long Index;
+  double T;
+  double Difference;
+  double Closest;
+  int pCounts[MOONEVENTTYPE_COUNT];
+  int Known;
+  int Type;
+  int Result;
+
+
+  if (MoonEvent_Find(ToT(f_pYearStart),ToT(f_pYearEnd),MOONEVENT_ALL,
+      &pEvents,&Count)<0)
+  {
+    printf("MoonEvent_Find() failed.\n");
+    return(1);
+  }
+
+  Result=0;
+  for(Known=0;Known<(int)(sizeof(f_pKnownEvents)/sizeof(*f_pKnownEvents));
+      Known++)
+  {
+    T=ToT(f_pKnownEvents[Known].pDate);
+    Closest=1.0;
+    for(Index=0;Index<Count;Index++)
+      if (pEvents[Index].Type==f_pKnownEvents[Known].Type)
+      {
+        Difference=fabs(pEvents[Index].T-T);
+        if (Difference<Closest)
+          Closest=Difference;
+      }
+    if (Closest>f_pKnownEvents[Known].Tolerance*MINUTE)
+    {
+      printf("%s %d-%02d-%02d FAILED, off by %.1f minutes\n",
+          f_ppTypeNames[f_pKnownEvents[Known].Type],
+          f_pKnownEvents[Known].pDate[0],f_pKnownEvents[Known].pDate[1],
+          f_pKnownEvents[Known].pDate[2],Closest/MINUTE);
+      Result=1;
+    }
+  }
+
+  for(Type=0;Type<MOONEVENTTYPE_COUNT;Type++)
+    pCounts[Type]=0;
+  for(Index=0;Index<Count;Index++)
+  {
+    pCounts[pEvents[Index].Type]++;
+    if ( (Index>0) && (pEvents[Index].T<pEvents[Index-1].T) )
+    {
+      printf("event %ld FAILED, out of order\n",Index);
+      Result=1;
+    }
+  }
+  for(Type=0;Type<MOONEVENTTYPE_PERIGEE;Type++)
+    if (pCounts[Type]!=f_pKnownCounts[Type])
+    {
+      printf("%s FAILED, %d events instead of %d\n",f_ppTypeNames[Type],
+          pCounts[Type],f_pKnownCounts[Type]);
+      Result=1;
+    }
+
+  printf("known events %s, %ld events in 2024\n",
+      Result==0 ? "ok" : "FAILED",Count);
+
+  /* Every type has an event inside each edge test range. */
+  for(Type=0;(Type<MOONEVENTTYPE_COUNT)&&(Result==0);Type++)
+  {
+    for(Index=0;pEvents[Index].Type!=Type;Index++);
+    Result|=CheckChunkEdge(&pEvents[Index]);
+  }
+
+  free(pEvents);
+  return(Result);
+}
+
+/**
+*** \brief Checks an empty range.
+*** \details First==Last must succeed with no events.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int CheckEmptyRange(void)
+{
+  MOONEVENT_T *pEvents;
+  long Count;
+  int Result;
+
+
+  pEvents=(MOONEVENT_T *)&Count;
+  Count=-1;
+  Result=(MoonEvent_Find(ToT(f_pYearStart),ToT(f_pYearStart),MOONEVENT_ALL,
+      &pEvents,&Count)<0) || (pEvents!=NULL) || (Count!=0) ? 1 : 0;
+  printf("empty range %s\n",Result==0 ? "ok" : "FAILED");
+  return(Result);
+}
+
+/**
+*** \brief Checks a chunk edge.
+*** \details Searches two chunks whose shared edge is exactly at an event.
+***   Both chunks see the event, so it must be kept by one and only one of
+***   them. Ranges with the edge a minute either side are checked too.
+*** \param pEvent Event to put on the edge.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int CheckChunkEdge(MOONEVENT_T const *pEvent)
+{
+  MOONEVENT_T *pEvents;
+  long Count;
+  long Index;
+  double First;
+  int Offset;
+  int Found;
+  int Result;
+
+
+  Result=0;
+  for(Offset=-1;Offset<=1;Offset++)
+  {
+    First=pEvent->T-CHUNK_DAYS*DAY+Offset*MINUTE;
+    if (MoonEvent_Find(First,First+2*CHUNK_DAYS*DAY,
+        MOONEVENT_MASK(pEvent->Type),&pEvents,&Count)<0)
+    {
+      printf("MoonEvent_Find() failed.\n");
+      return(1);
+    }
+    Found=0;
+    for(Index=0;Index<Count;Index++)
+      if (fabs(pEvents[Index].T-pEvent->T)<DAY)
+        Found++;
+    free(pEvents);
+    if (Found!=1)
+    {
+      printf("%s edge %+d minutes FAILED, found %d times\n",
+          f_ppTypeNames[pEvent->Type],Offset,Found);
+      Result=1;
+    }
+  }
+
+  printf("%s chunk edge %s\n",f_ppTypeNames[pEvent->Type],
+      Result==0 ? "ok" : "FAILED");
+  return(Result);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  Result=CheckKnownEvents();
+  Result|=CheckEmptyRange();
+  return(Result);
+}
+
+
+#undef    MOONEVENTTEST_C
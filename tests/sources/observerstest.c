@@ -0,0 +1,191 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file observerstest.c
+*** \brief CalcEphemObservers() test.
+*** \details Checks that the record CalcEphemObservers() gives for each
+***   observer equals what CalcEphemJD() gives for that observer alone, at
+***   every tier.
+***   Usage: moonphase-observerstest
+**/
+
+
+/** Identifier for observerstest.c. **/
+#define   OBSERVERSTEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "sysdefs.h"
+
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Instant count.
+*** \details Number of instants checked.
+**/
+#define   INSTANT_COUNT       (50)
+
+/**
+*** \brief Observer count.
+*** \details Number of observers.
+**/
+#define   OBSERVER_COUNT      ((int)(sizeof(f_pObservers)/sizeof(*f_pObservers)))
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Observer.
+*** \details Location of an observer.
+**/
+typedef struct structOBSERVER
+{
+  /**
+  *** \brief Latitude.
+  *** \details Latitude (in degrees, north positive).
+  **/
+  double Latitude;
+  /**
+  *** \brief Longitude.
+  *** \details Longitude (in degrees, west positive).
+  **/
+  double Longitude;
+} OBSERVER_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Observers.
+*** \details Observers checked, including both poles and the date line.
+**/
+static OBSERVER_T const f_pObservers[]=
+{
+  {  51.48,    0.0  },
+  {  40.71,   74.01 },
+  { -33.87, -151.21 },
+  {  64.15,   21.94 },
+  {  90.0,     0.0  },
+  { -90.0,     0.0  },
+  {   0.0,   180.0  },
+  {  35.68, -139.69 }
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  EphemContext pContexts[OBSERVER_COUNT];
+  EphemRecord pRecords[OBSERVER_COUNT];
+  CTrans Expected;
+  double JD;
+  int Tier;
+  int Instant;
+  int Index;
+  int Failures;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  for(Index=0;Index<OBSERVER_COUNT;Index++)
+    EphemContext_Set(&pContexts[Index],f_pObservers[Index].Latitude,
+        f_pObservers[Index].Longitude,0.0);
+
+  Failures=0;
+  for(Tier=0;Tier<EPHEMTIER_COUNT;Tier++)
+    for(Instant=0;Instant<INSTANT_COUNT;Instant++)
+    {
+      JD=2415020.5+Instant*1461.1+0.31*Instant;   /* 1900-2100 */
+      CalcEphemObservers(JD,Tier,pContexts,OBSERVER_COUNT,pRecords);
+      for(Index=0;Index<OBSERVER_COUNT;Index++)
+      {
+        CalcEphemJD(JD,&Expected,&pContexts[Index],Tier);
+        if ( (pRecords[Index].JD!=JD) ||
+            (pRecords[Index].RA_moon!=Expected.RA_moon) ||
+            (pRecords[Index].DEC_moon!=Expected.DEC_moon) ||
+            (pRecords[Index].h_moon!=Expected.h_moon) ||
+            (pRecords[Index].A_moon!=Expected.A_moon) ||
+            (pRecords[Index].MoonPhase!=Expected.MoonPhase) ||
+            (pRecords[Index].MoonAge!=Expected.MoonAge) ||
+            (pRecords[Index].EarthMoonDistance!=
+            Expected.EarthMoonDistance) )
+        {
+          if (Failures<10)
+            printf("tier %d, JD %.4f, observer %d FAILED\n",Tier,JD,Index);
+          Failures++;
+        }
+      }
+    }
+
+  printf("%s, %d of %d records differ from CalcEphemJD()\n",
+      Failures==0 ? "ok" : "FAILED",Failures,
+      EPHEMTIER_COUNT*INSTANT_COUNT*OBSERVER_COUNT);
+  return(Failures==0 ? 0 : 1);
+}
+
+
+#undef    OBSERVERSTEST_C
@@ -0,0 +1,183 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file recordstest.c
+*** \brief CalcEphemRecords() test.
+*** \details Checks that CalcEphemRecords() gives the same records as
+***   CalcEphemRecord() at every tier, for counts that leave a tail after
+***   the four sample groups, and that EphemRecord is one 64 byte line.
+***   Usage: moonphase-recordstest
+**/
+
+
+/** Identifier for recordstest.c. **/
+#define   RECORDSTEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "sysdefs.h"
+
+#include  <stddef.h>
+#include  <stdio.h>
+#include  <string.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Sample count.
+*** \details Largest count checked (not a multiple of 4).
+**/
+#define   SAMPLE_COUNT        (23)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Alignment probe.
+*** \details A record after a single byte starts at its alignment.
+**/
+typedef struct structALIGNMENTPROBE
+{
+  /**
+  *** \brief Byte.
+  *** \details Misaligning member.
+  **/
+  char Byte;
+  /**
+  *** \brief Record.
+  *** \details Record to place.
+  **/
+  EphemRecord Record;
+} ALIGNMENTPROBE_T;
+
+/**
+*** \brief Size check.
+*** \details Fails to compile unless an EphemRecord is 64 bytes.
+**/
+typedef char RECORDSIZE_CHECK_T[(sizeof(EphemRecord)==64) ? 1 : -1];
+
+/**
+*** \brief Alignment check.
+*** \details Fails to compile unless an EphemRecord is 64 byte aligned.
+**/
+typedef char RECORDALIGNMENT_CHECK_T[
+    (offsetof(ALIGNMENTPROBE_T,Record)==64) ? 1 : -1];
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Tier names.
+*** \details Names of the tiers (EPHEMTIER_*).
+**/
+static char const *f_ppTierNames[EPHEMTIER_COUNT]=
+    { "ICON", "DISPLAY", "PRECISE" };
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  double pJDs[SAMPLE_COUNT];
+  EphemRecord pExpected[SAMPLE_COUNT];
+  EphemRecord pRecords[SAMPLE_COUNT];
+  EphemContext Context;
+  int Tier;
+  int Count;
+  int Index;
+  int Failures;
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  EphemContext_Set(&Context,51.48,0.0,0.0);
+  for(Index=0;Index<SAMPLE_COUNT;Index++)
+    pJDs[Index]=2415020.5+Index*3187.3+0.0137*Index*Index;   /* 1900-2100 */
+
+  Result=0;
+  for(Tier=0;Tier<EPHEMTIER_COUNT;Tier++)
+  {
+    for(Index=0;Index<SAMPLE_COUNT;Index++)
+      CalcEphemRecord(pJDs[Index],&Context,Tier,&pExpected[Index],NULL);
+
+    Failures=0;
+    for(Count=1;Count<=SAMPLE_COUNT;Count++)
+    {
+      memset(pRecords,0,sizeof(pRecords));
+      CalcEphemRecords(pJDs,Count,&Context,Tier,pRecords);
+      for(Index=0;Index<Count;Index++)
+        if (memcmp(&pRecords[Index],&pExpected[Index],sizeof(EphemRecord))!=0)
+          Failures++;
+    }
+    printf("%-7s %s, %d records differ from CalcEphemRecord()\n",
+        f_ppTierNames[Tier],Failures==0 ? "ok" : "FAILED",Failures);
+    if (Failures!=0)
+      Result=1;
+  }
+  return(Result);
+}
+
+
+#undef    RECORDSTEST_C
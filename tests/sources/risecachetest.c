@@ -0,0 +1,245 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file risecachetest.c
+*** \brief MoonRiseCached() test.
+*** \details Checks that MoonRiseCached() returns what MoonRise_r() does
+***   while the day walks across month and year ends (yesterday, today and
+***   tomorrow, as the moon data asks), when days are asked for out of
+***   order, and when the observer or only its time zone changes; and that
+***   the walk is served from the cache as expected.
+***   Usage: moonphase-risecachetest
+**/
+
+
+/** Identifier for risecachetest.c. **/
+#define   RISECACHETEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "daynumber.h"
+#include  "sysdefs.h"
+
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Walk length.
+*** \details Number of days of each walk.
+**/
+#define   WALK_DAYS           (20)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Observer.
+*** \details Location and time zone of an observer.
+**/
+typedef struct structOBSERVER
+{
+  /**
+  *** \brief Latitude.
+  *** \details Latitude (in degrees, north positive).
+  **/
+  double Latitude;
+  /**
+  *** \brief Longitude.
+  *** \details Longitude (in degrees, west positive).
+  **/
+  double Longitude;
+  /**
+  *** \brief Time zone.
+  *** \details Hours to add to local time to get UT.
+  **/
+  double TimeZone;
+} OBSERVER_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static int Query(long DayNumber,EphemContext const *pContext,
+    RiseSetCache *pCache);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Observers.
+*** \details Observers checked; the last one differs from the first only
+***   in its time zone.
+**/
+static OBSERVER_T const f_pObservers[]=
+{
+  {  51.48,    0.0,   0.0 },
+  { -34.93, -138.6,  -9.5 },
+  {  69.65,  -18.96, -1.0 },
+  {  51.48,    0.0,  -1.0 }
+};
+
+/**
+*** \brief Out of order days.
+*** \details Offsets of days asked for out of order.
+**/
+static int const f_pJumps[]={ 0, 5, -3, 1, 5, -30, 0, 2, -1, 400, 0 };
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Checks one day.
+*** \details Compares MoonRiseCached() with MoonRise_r() for a day.
+*** \param DayNumber Day.
+*** \param pContext Observer.
+*** \param pCache Cache.
+*** \retval 0 Same times.
+*** \retval 1 Different times.
+**/
+static int Query(long DayNumber,EphemContext const *pContext,
+    RiseSetCache *pCache)
+{
+  int Year,Month,Day;
+  double Rise,Set;
+  double CachedRise,CachedSet;
+
+
+  DayNumber_ToDate(DayNumber,&Year,&Month,&Day);
+  MoonRise_r(Year,Month,Day,0.0,&Rise,&Set,pContext);
+  MoonRiseCached(Year,Month,Day,&CachedRise,&CachedSet,pContext,pCache);
+  if ( (CachedRise!=Rise) || (CachedSet!=Set) )
+  {
+    printf("%d-%02d-%02d FAILED, %f %f instead of %f %f\n",Year,Month,Day,
+        CachedRise,CachedSet,Rise,Set);
+    return(1);
+  }
+  return(0);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  EphemContext pContexts[sizeof(f_pObservers)/sizeof(*f_pObservers)];
+  RiseSetCache Cache;
+  long Start;
+  long DayNumber;
+  unsigned long Hits;
+  unsigned long Misses;
+  int ObserverCount;
+  int Index;
+  int Jump;
+  int Failures;
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  ObserverCount=(int)(sizeof(f_pObservers)/sizeof(*f_pObservers));
+  for(Index=0;Index<ObserverCount;Index++)
+    EphemContext_Set(&pContexts[Index],f_pObservers[Index].Latitude,
+        f_pObservers[Index].Longitude,f_pObservers[Index].TimeZone);
+  RiseSetCache_Init(&Cache);
+  Start=DayNumber_FromDate(2024,12,20);
+  Result=0;
+
+  /* Walks, the observer changing between them. Each walk starts with an
+      empty cache: three new days, then one new day per step. */
+  Failures=0;
+  for(Index=0;Index<2*ObserverCount;Index++)
+  {
+    Hits=Cache.Hits;
+    Misses=Cache.Misses;
+    for(DayNumber=Start;DayNumber<Start+WALK_DAYS;DayNumber++)
+    {
+      Failures+=Query(DayNumber-1,&pContexts[Index%ObserverCount],&Cache);
+      Failures+=Query(DayNumber,&pContexts[Index%ObserverCount],&Cache);
+      Failures+=Query(DayNumber+1,&pContexts[Index%ObserverCount],&Cache);
+    }
+    if ( (Cache.Misses-Misses!=WALK_DAYS+2) ||
+        (Cache.Hits-Hits!=2*WALK_DAYS-2) )
+    {
+      printf("walk %d FAILED, %lu hits, %lu misses\n",Index,
+          Cache.Hits-Hits,Cache.Misses-Misses);
+      Failures++;
+    }
+  }
+  printf("walks %s\n",Failures==0 ? "ok" : "FAILED");
+  Result|=(Failures!=0);
+
+  /* Days out of order, and the observer changing on every day. */
+  Failures=0;
+  DayNumber=Start;
+  for(Index=0;Index<(int)(sizeof(f_pJumps)/sizeof(*f_pJumps));Index++)
+  {
+    DayNumber+=f_pJumps[Index];
+    Failures+=Query(DayNumber,&pContexts[0],&Cache);
+  }
+  for(Index=0;Index<4*ObserverCount;Index++)
+    for(Jump=-1;Jump<=1;Jump++)
+      Failures+=Query(Start+Index/ObserverCount+Jump,
+          &pContexts[Index%ObserverCount],&Cache);
+  printf("jumps and observer changes %s\n",Failures==0 ? "ok" : "FAILED");
+  Result|=(Failures!=0);
+
+  return(Result);
+}
+
+
+#undef    RISECACHETEST_C
@@ -0,0 +1,260 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file riserangetest.c
+*** \brief MoonRiseRange() test.
+*** \details Checks MoonRiseRange() against MoonRise_r() day by day for
+***   sites from the equator to both polar regions, over ranges in four
+***   centuries; one of them runs across the 1582 calendar reform. Each day
+***   must have the same date, the same events, and times within the
+***   bounds given in calcephem.h.
+***   Usage: moonphase-riserangetest
+**/
+
+
+/** Identifier for riserangetest.c. **/
+#define   RISERANGETEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "daynumber.h"
+#include  "sysdefs.h"
+
+#include  <math.h>
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Range length.
+*** \details Number of days of each range.
+**/
+#define   RANGE_DAYS          (400)
+
+/**
+*** \brief No event.
+*** \details Times below this mean there is no event that day.
+**/
+#define   NOEVENT             (-900.0)
+
+/**
+*** \brief Polar latitude.
+*** \details Latitude (in degrees) beyond which the polar bound applies.
+**/
+#define   POLAR_LATITUDE      (60.0)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Site.
+*** \details Location and time zone of an observer.
+**/
+typedef struct structSITE
+{
+  /**
+  *** \brief Name.
+  *** \details Site name.
+  **/
+  char const *pName;
+  /**
+  *** \brief Latitude.
+  *** \details Latitude (in degrees, north positive).
+  **/
+  double Latitude;
+  /**
+  *** \brief Longitude.
+  *** \details Longitude (in degrees, west positive).
+  **/
+  double Longitude;
+  /**
+  *** \brief Time zone.
+  *** \details Hours to add to local time to get UT.
+  **/
+  double TimeZone;
+} SITE_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static int CompareTimes(double Range,double Exact,double *pWorst);
+static int CheckRange(SITE_T const *pSite,int Year,int Month,int Day);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Sites.
+*** \details Sites checked.
+**/
+static SITE_T const f_pSites[]=
+{
+  { "Greenwich",   51.48,    0.0,    0.0 },
+  { "Sydney",     -33.87, -151.21, -10.0 },
+  { "Quito",       -0.18,   78.47,   5.0 },
+  { "Tromso",      69.65,  -18.96,  -1.0 },
+  { "Longyearbyen",78.22,  -15.65,  -1.0 },
+  { "McMurdo",    -77.85, -166.67, -12.0 }
+};
+
+/**
+*** \brief Range starts.
+*** \details First day (year, month, day) of each range.
+**/
+static int const f_ppStarts[][3]=
+{
+  { 1582,  9,  1 },   /* Across the calendar reform */
+  { 1899, 12,  1 },
+  { 2024,  1,  1 },
+  { 2099,  6,  1 }
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Compares two times.
+*** \details Checks that both times are events or neither is, and keeps
+***   the largest difference (in seconds).
+*** \param Range Time from MoonRiseRange().
+*** \param Exact Time from MoonRise_r().
+*** \param pWorst Largest difference so far.
+*** \retval 0 Same event.
+*** \retval 1 Event missing from one of them.
+**/
+static int CompareTimes(double Range,double Exact,double *pWorst)
+{
+  if ((Range<NOEVENT)!=(Exact<NOEVENT))
+    return(1);
+  if (Exact>=NOEVENT)
+    *pWorst=fmax(*pWorst,3600.0*fabs(Range-Exact));
+  return(0);
+}
+
+/**
+*** \brief Checks a range.
+*** \details Compares a RANGE_DAYS range from a date with MoonRise_r().
+*** \param pSite Site.
+*** \param Year Year of the first day.
+*** \param Month Month of the first day.
+*** \param Day First day.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int CheckRange(SITE_T const *pSite,int Year,int Month,int Day)
+{
+  static RiseSetRecord pRecords[RANGE_DAYS];
+  EphemContext Context;
+  long First;
+  double Rise,Set;
+  double Worst;
+  double Bound;
+  int Index;
+  int DateErrors;
+  int EventErrors;
+  int Result;
+
+
+  EphemContext_Set(&Context,pSite->Latitude,pSite->Longitude,
+      pSite->TimeZone);
+  MoonRiseRangeBuffer(Year,Month,Day,RANGE_DAYS,&Context,pRecords);
+  First=DayNumber_FromDate(Year,Month,Day);
+  Worst=0.0;
+  DateErrors=EventErrors=0;
+  for(Index=0;Index<RANGE_DAYS;Index++)
+  {
+    DayNumber_ToDate(First+Index,&Year,&Month,&Day);
+    if (pRecords[Index].date!=10000L*Year+100*Month+Day)
+      DateErrors++;
+    MoonRise_r(Year,Month,Day,0.0,&Rise,&Set,&Context);
+    EventErrors+=CompareTimes(pRecords[Index].UTRise,Rise,&Worst);
+    EventErrors+=CompareTimes(pRecords[Index].UTSet,Set,&Worst);
+  }
+
+  Bound=(fabs(pSite->Latitude)<=POLAR_LATITUDE) ?
+      MOONRISERANGE_MAXERROR : MOONRISERANGE_MAXERROR_POLAR;
+  Result=(DateErrors==0) && (EventErrors==0) && (Worst<=Bound) ? 0 : 1;
+  printf("%-12s from %d %s, %d date errors, %d event errors, "
+      "largest difference %.1f s (%.0f s)\n",pSite->pName,
+      (int)(pRecords[0].date/10000),Result==0 ? "ok" : "FAILED",DateErrors,
+      EventErrors,Worst,Bound);
+  return(Result);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  int Site;
+  int Start;
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  Result=0;
+  for(Site=0;Site<(int)(sizeof(f_pSites)/sizeof(*f_pSites));Site++)
+    for(Start=0;Start<(int)(sizeof(f_ppStarts)/sizeof(*f_ppStarts));Start++)
+      Result|=CheckRange(&f_pSites[Site],f_ppStarts[Start][0],
+          f_ppStarts[Start][1],f_ppStarts[Start][2]);
+  return(Result);
+}
+
+
+#undef    RISERANGETEST_C
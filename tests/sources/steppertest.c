@@ -0,0 +1,231 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file steppertest.c
+*** \brief MoonStepper test.
+*** \details Runs a MoonStepper for 10^6 minute, hour and day steps at
+***   every tier and checks its samples against MoonTier() at the same tier,
+***   so that any drift left by the renormalization shows. The bounds are
+***   those given in calcephem.h.
+***   Usage: moonphase-steppertest
+**/
+
+
+/** Identifier for steppertest.c. **/
+#define   STEPPERTEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "sysdefs.h"
+
+#include  <math.h>
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Step count.
+*** \details Number of steps of each run.
+**/
+#define   STEP_COUNT          (1000000L)
+
+/**
+*** \brief Check interval.
+*** \details Every CHECK_INTERVAL-th sample is compared. It is prime to
+***   MOONSTEPPER_RENORMALIZE, so every position between renormalizations
+***   is visited.
+**/
+#define   CHECK_INTERVAL      (61)
+
+/**
+*** \brief Distance and age bound.
+*** \details Largest distance (earth radii) and age (days) difference.
+**/
+#define   MAXERROR_DISTANCEAGE  (1e-6)
+
+/**
+*** \brief Synodic month.
+*** \details Mean length of a lunation (in days), the period of the age.
+**/
+#define   SYNODIC_MONTH       (29.530588853)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Step.
+*** \details A step size and its bound.
+**/
+typedef struct structSTEP
+{
+  /**
+  *** \brief Name.
+  *** \details Step name.
+  **/
+  char const *pName;
+  /**
+  *** \brief Step.
+  *** \details Step (in days).
+  **/
+  double Days;
+  /**
+  *** \brief Bound.
+  *** \details Longitude and latitude bound (in arc seconds).
+  **/
+  double Bound;
+} STEP_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double Wrap(double Difference,double Period);
+static int CheckStepper(int Tier,STEP_T const *pStep);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Steps.
+*** \details Step sizes checked. Day steps start in 1900 and end in 4638.
+**/
+static STEP_T const f_pSteps[]=
+{
+  { "minute", 1.0/1440.0, MOONSTEPPER_MAXERROR_HOURLY },
+  { "hour",   1.0/24.0,   MOONSTEPPER_MAXERROR_HOURLY },
+  { "day",    1.0,        MOONSTEPPER_MAXERROR_DAILY }
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Wraps a difference.
+*** \details Reduces a difference to half a period either side of zero.
+*** \param Difference Difference.
+*** \param Period Period.
+*** \returns Wrapped difference.
+**/
+static double Wrap(double Difference,double Period)
+{
+  return(Difference-Period*floor(Difference/Period+0.5));
+}
+
+/**
+*** \brief Checks a stepper.
+*** \details Steps a stepper STEP_COUNT times and prints the largest
+***   differences from MoonTier().
+*** \param Tier Tier (EPHEMTIER_*).
+*** \param pStep Step size and bound.
+*** \retval 0 Within bounds.
+*** \retval 1 Out of bounds.
+**/
+static int CheckStepper(int Tier,STEP_T const *pStep)
+{
+  MoonStepper Stepper;
+  double T,Lambda,Beta,R,Age;
+  double ExactLambda,ExactBeta,ExactR,ExactAge;
+  double Longitude,Latitude,Distance,AgeError;
+  long Step;
+  int Result;
+
+
+  Longitude=Latitude=Distance=AgeError=0.0;
+  MoonStepper_Init(&Stepper,-1.0,pStep->Days/36525.0,Tier);
+  for(Step=0;Step<STEP_COUNT;Step++)
+  {
+    MoonStepper_Next(&Stepper,&T,&Lambda,&Beta,&R,&Age);
+    if ((Step%CHECK_INTERVAL)!=CHECK_INTERVAL-1)
+      continue;
+    MoonTier(T,Tier,&ExactLambda,&ExactBeta,&ExactR,&ExactAge);
+    Longitude=fmax(Longitude,3600.0*fabs(Wrap(Lambda-ExactLambda,360.0)));
+    Latitude=fmax(Latitude,3600.0*fabs(Beta-ExactBeta));
+    Distance=fmax(Distance,fabs(R-ExactR));
+    AgeError=fmax(AgeError,fabs(Wrap(Age-ExactAge,SYNODIC_MONTH)));
+  }
+
+  Result=(Longitude<=pStep->Bound) && (Latitude<=pStep->Bound) &&
+      (Distance<=MAXERROR_DISTANCEAGE) && (AgeError<=MAXERROR_DISTANCEAGE) ?
+      0 : 1;
+  printf("tier %d, %-6s steps %s, longitude %.4f\", latitude %.4f\" "
+      "(%.3f\"), distance %.2g, age %.2g\n",Tier,pStep->pName,
+      Result==0 ? "ok" : "FAILED",Longitude,Latitude,pStep->Bound,Distance,
+      AgeError);
+  return(Result);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  int Tier;
+  int Index;
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  Result=0;
+  for(Tier=0;Tier<EPHEMTIER_COUNT;Tier++)
+    for(Index=0;Index<(int)(sizeof(f_pSteps)/sizeof(*f_pSteps));Index++)
+      Result|=CheckStepper(Tier,&f_pSteps[Index]);
+  return(Result);
+}
+
+
+#undef    STEPPERTEST_C
@@ -0,0 +1,224 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file tiertest.c
+*** \brief Accuracy tier test.
+*** \details Checks MoonTier() at the ICON and DISPLAY tiers against Moon()
+***   over 1900-2100, and that the errors are within the bounds given for
+***   EPHEMTIER_* in calcephem.h.
+***   Usage: moonphase-tiertest
+**/
+
+
+/** Identifier for tiertest.c. **/
+#define   TIERTEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "calcephem.h"
+#include  "sysdefs.h"
+
+#include  <math.h>
+#include  <stdio.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Sample count.
+*** \details Number of times checked (about every 4 hours).
+**/
+#define   SAMPLE_COUNT        (400000)
+
+/**
+*** \brief Synodic month.
+*** \details Mean length of a lunation (in days), the period of the age.
+**/
+#define   SYNODIC_MONTH       (29.530588853)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+/**
+*** \brief Tier bounds.
+*** \details Documented error bounds of a tier.
+**/
+typedef struct structTIERBOUNDS
+{
+  /**
+  *** \brief Tier.
+  *** \details EPHEMTIER_*.
+  **/
+  int Tier;
+  /**
+  *** \brief Name.
+  *** \details Tier name.
+  **/
+  char const *pName;
+  /**
+  *** \brief Longitude.
+  *** \details Longitude bound (in arcseconds).
+  **/
+  double Longitude;
+  /**
+  *** \brief Latitude.
+  *** \details Latitude bound (in arcseconds).
+  **/
+  double Latitude;
+  /**
+  *** \brief Distance.
+  *** \details Distance bound (in earth radii).
+  **/
+  double Distance;
+  /**
+  *** \brief Age.
+  *** \details Age bound (in days).
+  **/
+  double Age;
+} TIERBOUNDS_T;
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static double Wrap(double Difference,double Period);
+static int CheckTier(TIERBOUNDS_T const *pBounds);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Bounds.
+*** \details Bounds of each tier, as documented in calcephem.h.
+**/
+static TIERBOUNDS_T const f_pBounds[]=
+{
+  { EPHEMTIER_ICON,     "ICON",     2.7*60.0, 1.5*60.0, 0.033, 0.004 },
+  { EPHEMTIER_DISPLAY,  "DISPLAY",  16.0,     2.0,      0.002, 0.0004 }
+};
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Wraps a difference.
+*** \details Reduces a difference to half a period either side of zero.
+*** \param Difference Difference.
+*** \param Period Period.
+*** \returns Wrapped difference.
+**/
+static double Wrap(double Difference,double Period)
+{
+  return(Difference-Period*floor(Difference/Period+0.5));
+}
+
+/**
+*** \brief Checks a tier.
+*** \details Compares a tier against Moon() and prints the largest errors.
+*** \param pBounds Tier and its bounds.
+*** \retval 0 Within bounds.
+*** \retval 1 Out of bounds.
+**/
+static int CheckTier(TIERBOUNDS_T const *pBounds)
+{
+  double Longitude,Latitude,Distance,Age;
+  double TierLambda,TierBeta,TierR,TierAge;
+  double Lambda,Beta,R,MoonAge;
+  double T;
+  int Sample;
+  int Result;
+
+
+  Longitude=Latitude=Distance=Age=0.0;
+  for(Sample=0;Sample<SAMPLE_COUNT;Sample++)
+  {
+    T=-1.0+2.0*(Sample+0.5)/SAMPLE_COUNT;
+    MoonTier(T,pBounds->Tier,&TierLambda,&TierBeta,&TierR,&TierAge);
+    Moon(T,&Lambda,&Beta,&R,&MoonAge);
+    Longitude=fmax(Longitude,3600.0*fabs(Wrap(TierLambda-Lambda,360.0)));
+    Latitude=fmax(Latitude,3600.0*fabs(TierBeta-Beta));
+    Distance=fmax(Distance,fabs(TierR-R));
+    Age=fmax(Age,fabs(Wrap(TierAge-MoonAge,SYNODIC_MONTH)));
+  }
+
+  Result=(Longitude<=pBounds->Longitude) && (Latitude<=pBounds->Latitude) &&
+      (Distance<=pBounds->Distance) && (Age<=pBounds->Age) ? 0 : 1;
+  printf("%-7s %s, longitude %.1f\" (%.1f\"), latitude %.1f\" (%.1f\"), "
+      "distance %.4f (%.4f), age %.5f (%.5f)\n",
+      pBounds->pName,Result==0 ? "ok" : "FAILED",
+      Longitude,pBounds->Longitude,Latitude,pBounds->Latitude,
+      Distance,pBounds->Distance,Age,pBounds->Age);
+  return(Result);
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  int Index;
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  Result=0;
+  for(Index=0;Index<(int)(sizeof(f_pBounds)/sizeof(*f_pBounds));Index++)
+    Result|=CheckTier(&f_pBounds[Index]);
+  return(Result);
+}
+
+
+#undef    TIERTEST_C
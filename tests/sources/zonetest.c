@@ -0,0 +1,218 @@
+/*
+** This file is part of moonphase.
+** Copyright (C) 2014-2015 by Alan Wise (alanwise@users.sourceforge.net)
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+*** \file zonetest.c
+*** \brief Time zone cache test.
+*** \details Checks the UTC offsets and local dates of the moon data zone
+***   cache against localtime_r() and mktime() every 10 minutes over a
+***   year, for zones with DST, a half hour offset, and both. The cache
+***   must be filled only once for the year, also when the year has more
+***   offset changes than it keeps (built with MOONDATA_ZONETRANSITIONS 1).
+***   Usage: moonphase-zonetest
+**/
+
+
+/** Identifier for zonetest.c. **/
+#define   ZONETEST_C
+
+
+/****
+*****
+***** INCLUDES
+*****
+****/
+
+#include  "moondata.h"
+#include  "daynumber.h"
+#include  "sysdefs.h"
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+
+/****
+*****
+***** DEFINES
+*****
+****/
+
+/**
+*** \brief Test year.
+*** \details Year checked.
+**/
+#define   TEST_YEAR           (2024)
+
+/**
+*** \brief Skip code.
+*** \details Exit code ctest takes as a skipped test.
+**/
+#define   SKIP_RETURNCODE     (77)
+
+
+/****
+*****
+***** DATA TYPES
+*****
+****/
+
+
+/****
+*****
+***** PROTOTYPES
+*****
+****/
+
+static int CheckZone(char const *pName);
+
+
+/****
+*****
+***** DATA
+*****
+****/
+
+/**
+*** \brief Zones.
+*** \details Zones checked: DST, a half hour offset without DST, and a
+***   half hour offset with southern DST.
+**/
+static char const *f_ppZones[]=
+    { "Europe/London", "Asia/Kolkata", "Australia/Adelaide" };
+
+
+/****
+*****
+***** VARIABLES
+*****
+****/
+
+
+/****
+*****
+***** FUNCTIONS
+*****
+****/
+
+/**
+*** \brief Checks a zone.
+*** \details Compares the zone cache with the C library over TEST_YEAR.
+*** \param pName Zone name (TZ).
+*** \retval 0 Success.
+*** \retval 1 Failure.
+**/
+static int CheckZone(char const *pName)
+{
+  MOONDATAZONE_T Zone;
+  struct tm LocalTime;
+  struct tm Midnight;
+  time_t Start;
+  time_t End;
+  time_t UTC;
+  long FirstDay;
+  long LastDay;
+  long DayNumber;
+  int Year,Month,Day;
+  long OffsetErrors;
+  long DateErrors;
+
+
+  setenv("TZ",pName,1);
+  tzset();
+  memset(&Zone,0,sizeof(Zone));
+  FirstDay=DayNumber_FromDate(TEST_YEAR,1,1);
+  LastDay=DayNumber_FromDate(TEST_YEAR+1,1,1);
+  Start=(time_t)(FirstDay-DayNumber_FromDate(1970,1,1))*86400;
+  End=(time_t)(LastDay-DayNumber_FromDate(1970,1,1))*86400;
+
+  /* Offsets. */
+  OffsetErrors=0;
+  for(UTC=Start;UTC<End;UTC+=600)
+  {
+    localtime_r(&UTC,&LocalTime);
+    if (MoonDataZone_GetOffset(&Zone,UTC)!=-LocalTime.tm_gmtoff)
+      OffsetErrors++;
+  }
+
+  /* UTC dates of the local midnights. */
+  DateErrors=0;
+  for(DayNumber=FirstDay;DayNumber<LastDay;DayNumber++)
+  {
+    memset(&Midnight,0,sizeof(Midnight));
+    DayNumber_ToDate(DayNumber,&Year,&Month,&Day);
+    Midnight.tm_year=Year-1900;
+    Midnight.tm_mon=Month-1;
+    Midnight.tm_mday=Day;
+    Midnight.tm_isdst=-1;
+    UTC=mktime(&Midnight);
+    gmtime_r(&UTC,&LocalTime);
+    MoonDataZone_GetLocalDate(&Zone,DayNumber,&Year,&Month,&Day);
+    if ( (Year!=LocalTime.tm_year+1900) || (Month!=LocalTime.tm_mon+1) ||
+        (Day!=LocalTime.tm_mday) )
+      DateErrors++;
+  }
+
+  printf("%-18s %s, %ld offset errors, %ld date errors, "
+      "%d transitions kept, %lu fills\n",pName,
+      (OffsetErrors==0) && (DateErrors==0) && (Zone.FillCount==1) ?
+      "ok" : "FAILED",OffsetErrors,DateErrors,Zone.TransitionCount,
+      Zone.FillCount);
+  return( (OffsetErrors==0) && (DateErrors==0) && (Zone.FillCount==1) ?
+      0 : 1 );
+}
+
+/**
+*** \brief Program entry.
+*** \details Runs the test.
+*** \param ArgC Argument count.
+*** \param ppArgV Arguments.
+*** \retval 0 Success.
+*** \retval 1 Failure.
+*** \retval SKIP_RETURNCODE No time zone database.
+**/
+int main(int ArgC,char *ppArgV[])
+{
+  time_t UTC;
+  struct tm LocalTime;
+  int Index;
+  int Result;
+  UNUSED(ArgC);
+  UNUSED(ppArgV);
+
+
+  /* Without the zone database every zone is UTC, which proves nothing. */
+  setenv("TZ","Asia/Kolkata",1);
+  tzset();
+  UTC=0;
+  localtime_r(&UTC,&LocalTime);
+  if (LocalTime.tm_gmtoff!=19800)
+  {
+    printf("No time zone database, skipped.\n");
+    return(SKIP_RETURNCODE);
+  }
+
+  Result=0;
+  for(Index=0;Index<(int)(sizeof(f_ppZones)/sizeof(*f_ppZones));Index++)
+    Result|=CheckZone(f_ppZones[Index]);
+  return(Result);
+}
+
+
+#undef    ZONETEST_C